@@ -20,9 +20,34 @@ GNU General Public License for more details.
 #include <QSettings>
 #include <QFileInfo>
 #include <QFileDialog>
+#include <QGridLayout>
+#include <QRunnable>
 
 #include "fileformat.h"
 #include "pencildef.h"
+#include "thumbnailcache.h"
+
+
+namespace
+{
+class FilmstripReadTask : public QRunnable
+{
+public:
+    FilmstripReadTask( QObject* preview, const QString& filePath ) : mPreview( preview ), mFilePath( filePath ) {}
+
+    void run() override
+    {
+        QImage filmstrip = ThumbnailCache::readFilmstrip( mFilePath );
+        QMetaObject::invokeMethod( mPreview, "filmstripLoaded", Qt::QueuedConnection,
+                                   Q_ARG( QString, mFilePath ),
+                                   Q_ARG( QImage, filmstrip ) );
+    }
+
+private:
+    QObject* mPreview;
+    QString mFilePath;
+};
+}
 
 FileDialog::FileDialog( QWidget* parent ) : QObject( parent )
 {
@@ -39,10 +64,18 @@ QString FileDialog::openFile(FileType fileType)
     QString strInitialFilePath = getLastOpenPath( fileType );
     QString strFilter = openFileFilters( fileType );
 
-    QString filePath = QFileDialog::getOpenFileName( mRoot,
-                                                     strTitle,
-                                                     strInitialFilePath,
-                                                     strFilter );
+    QString filePath;
+    if ( fileType == FileType::ANIMATION )
+    {
+        filePath = openProjectFile( strTitle, strInitialFilePath, strFilter );
+    }
+    else
+    {
+        filePath = QFileDialog::getOpenFileName( mRoot,
+                                                 strTitle,
+                                                 strInitialFilePath,
+                                                 strFilter );
+    }
     if ( !filePath.isEmpty() )
     {
         setLastOpenPath( fileType, filePath );
@@ -51,6 +84,27 @@ QString FileDialog::openFile(FileType fileType)
     return filePath;
 }
 
+QString FileDialog::openProjectFile( const QString& title, const QString& initialPath, const QString& filter )
+{
+    QFileDialog dialog( mRoot, title, initialPath, filter );
+    dialog.setFileMode( QFileDialog::ExistingFile );
+    dialog.setOption( QFileDialog::DontUseNativeDialog ); // native dialogs can't show the filmstrip
+
+    FilmstripPreview* preview = new FilmstripPreview( &dialog );
+    QGridLayout* layout = qobject_cast< QGridLayout* >( dialog.layout() );
+    if ( layout != nullptr )
+    {
+        layout->addWidget( preview, layout->rowCount(), 0, 1, layout->columnCount() );
+    }
+    connect( &dialog, &QFileDialog::currentChanged, preview, &FilmstripPreview::showProject );
+
+    if ( dialog.exec() != QDialog::Accepted || dialog.selectedFiles().isEmpty() )
+    {
+        return QString();
+    }
+    return dialog.selectedFiles().first();
+}
+
 QStringList FileDialog::openFiles(FileType fileType)
 {
     QString strTitle = openDialogTitle( fileType );
@@ -130,6 +184,7 @@ QString FileDialog::openDialogTitle( FileType fileType )
         case FileType::MOVIE: return tr( "Import movie" );
         case FileType::SOUND: return tr( "Import sound" );
         case FileType::PALETTE: return tr( "Import palette" );
+        case FileType::INPUT_RECORDING: return tr( "Replay input recording" );
         default: Q_ASSERT( false );
     }
     return "";
@@ -145,6 +200,7 @@ QString FileDialog::saveDialogTitle( FileType fileType )
         case FileType::MOVIE: return tr( "Export movie" );
         case FileType::SOUND: return tr( "Export sound" );
         case FileType::PALETTE: return tr( "Export palette" );
+        case FileType::INPUT_RECORDING: return tr( "Save input recording" );
         default: Q_ASSERT( false );
     }
     return "";
@@ -160,6 +216,7 @@ QString FileDialog::openFileFilters( FileType fileType )
         case FileType::MOVIE: return PENCIL_MOVIE_EXT;
         case FileType::SOUND: return tr( "Sounds (*.wav *.mp3);;WAV (*.wav);;MP3 (*.mp3)" );
         case FileType::PALETTE: return tr( "Palette (*.xml)" );
+        case FileType::INPUT_RECORDING: return PFF_INPUT_RECORDING_FILTER;
         default: Q_ASSERT( false );
     }
     return "";
@@ -175,6 +232,7 @@ QString FileDialog::saveFileFilters( FileType fileType )
         case FileType::MOVIE: return tr( "MP4 (*.mp4);;AVI (*.avi);;GIF (*.gif)" );
         case FileType::SOUND: return QString();
         case FileType::PALETTE: return tr( "Palette (*.xml)" );
+        case FileType::INPUT_RECORDING: return PFF_INPUT_RECORDING_FILTER;
         default: Q_ASSERT( false );
     }
     return "";
@@ -191,6 +249,7 @@ QString FileDialog::defaultFileName( FileType fileType )
         case FileType::MOVIE: return "untitled.mp4";
         case FileType::SOUND: return "untitled.wav";
         case FileType::PALETTE: return "untitled.xml";
+        case FileType::INPUT_RECORDING: return "recording" PFF_INPUT_RECORDING_EXTENSION;
         default: Q_ASSERT( false );
     }
     return "";
@@ -206,7 +265,44 @@ QString FileDialog::toSettingKey( FileType fileType )
         case FileType::MOVIE: return "Movie";
         case FileType::SOUND: return "Sound";
         case FileType::PALETTE: return "Palette";
+        case FileType::INPUT_RECORDING: return "InputRecording";
         default: Q_ASSERT( false );
     }
     return "";
 }
+
+FilmstripPreview::FilmstripPreview( QWidget* parent ) : QLabel( parent )
+{
+    setAlignment( Qt::AlignCenter );
+    setMinimumHeight( 56 );
+    mPool.setMaxThreadCount( 1 );
+}
+
+FilmstripPreview::~FilmstripPreview()
+{
+    // The read posts its result back to this widget
+    mPool.clear();
+    mPool.waitForDone();
+}
+
+void FilmstripPreview::showProject( const QString& filePath )
+{
+    mFilePath = filePath;
+    clear();
+
+    if ( filePath.endsWith( PFF_EXTENSION, Qt::CaseInsensitive ) )
+    {
+        mPool.clear(); // a file passed over while browsing isn't worth reading anymore
+        mPool.start( new FilmstripReadTask( this, filePath ) );
+    }
+}
+
+void FilmstripPreview::filmstripLoaded( const QString& filePath, const QImage& filmstrip )
+{
+    if ( filePath != mFilePath || filmstrip.isNull() )
+    {
+        return;
+    }
+    QSize size = filmstrip.size().boundedTo( QSize( width(), filmstrip.height() ) );
+    setPixmap( QPixmap::fromImage( filmstrip.scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation ) ) );
+}
@@ -19,6 +19,9 @@ GNU General Public License for more details.
 #define FILEDIALOGEX_H
 
 #include <QObject>
+#include <QLabel>
+#include <QImage>
+#include <QThreadPool>
 
 enum class FileType
 {
@@ -27,7 +30,8 @@ enum class FileType
     IMAGE_SEQUENCE,
     MOVIE,
     SOUND,
-    PALETTE
+    PALETTE,
+    INPUT_RECORDING
 };
 
 class FileDialog : public QObject
@@ -54,8 +58,27 @@ private:
     QString defaultFileName( FileType fileType );
 
     QString toSettingKey( FileType fileType);
+    QString openProjectFile( const QString& title, const QString& initialPath, const QString& filter );
 
     QWidget* mRoot = nullptr;
 };
 
+// Shows the filmstrip saved in a project, read on a worker thread
+class FilmstripPreview : public QLabel
+{
+    Q_OBJECT
+public:
+    FilmstripPreview( QWidget* parent );
+    ~FilmstripPreview();
+
+    void showProject( const QString& filePath );
+
+private slots:
+    void filmstripLoaded( const QString& filePath, const QImage& filmstrip );
+
+private:
+    QThreadPool mPool;
+    QString mFilePath;
+};
+
 #endif // FILEDIALOGEX_H
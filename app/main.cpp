@@ -22,6 +22,7 @@ GNU General Public License for more details.
 #include "editor.h"
 #include "mainwindow2.h"
 #include "pencilapplication.h"
+#include "tracer.h"
 #include <iostream>
 #include <cstring>
 
@@ -56,6 +57,20 @@ void installTranslator( PencilApplication& app )
     qDebug() << "Install translation = " << b;
 }
 
+void saveTrace( const QString& tracePath )
+{
+    if ( tracePath.isEmpty() )
+    {
+        return;
+    }
+
+    Status st = Tracer::instance()->exportChromeTrace( tracePath );
+    if ( !st.ok() )
+    {
+        qDebug() << PencilApplication::tr( "Error: cannot write the trace to '%1'" ).arg( tracePath );
+    }
+}
+
 int handleArguments( MainWindow2 & mainWindow )
 {
     QStringList args = PencilApplication::arguments();
@@ -63,6 +78,7 @@ int handleArguments( MainWindow2 & mainWindow )
     QStringList outputPaths;
     int width = -1, height = -1;
     bool transparency = false;
+    QString tracePath;
 
     QCommandLineParser parser;
     // TODO: Ignore -NSDocumentRevisionsDebugMode
@@ -91,6 +107,11 @@ int handleArguments( MainWindow2 & mainWindow )
                                            PencilApplication::tr( "Render transparency when possible" ) );
     parser.addOption( transparencyOption );
 
+    QCommandLineOption traceOption( QStringList() << "trace",
+                                    PencilApplication::tr( "Record rendering timings and save them to <trace_path> (Chrome trace format)" ),
+                                    PencilApplication::tr( "trace_path" ) );
+    parser.addOption( traceOption );
+
     parser.process( args );
 
     QStringList posArgs = parser.positionalArguments();
@@ -123,6 +144,12 @@ int handleArguments( MainWindow2 & mainWindow )
     }
     transparency = parser.isSet( transparencyOption );
 
+    tracePath = parser.value( traceOption );
+    if ( !tracePath.isEmpty() )
+    {
+        Tracer::instance()->setEnabled( true );
+    }
+
     // If there are no output paths, open up the GUI (to the input path if there is one)
     if ( outputPaths.isEmpty() )
     {
@@ -131,7 +158,9 @@ int handleArguments( MainWindow2 & mainWindow )
         {
             mainWindow.openFile(inputPath);
         }
-        return PencilApplication::exec();
+        int ret = PencilApplication::exec();
+        saveTrace( tracePath );
+        return ret;
     }
     else if ( inputPath.isEmpty() )
     {
@@ -181,6 +210,7 @@ int handleArguments( MainWindow2 & mainWindow )
     }
     qDebug() << PencilApplication::tr( "Done." );
 
+    saveTrace( tracePath );
     return 0;
 }
 
@@ -39,6 +39,8 @@ GNU General Public License for more details.
 #include "pencilsettings.h"
 #include "object.h"
 #include "filemanager.h"
+#include "projectsnapshot.h"
+#include "backgroundsaver.h"
 #include "editor.h"
 #include "colormanager.h"
 #include "layermanager.h"
@@ -46,6 +48,10 @@ GNU General Public License for more details.
 #include "toolmanager.h"
 #include "playbackmanager.h"
 #include "soundmanager.h"
+#include "preferencemanager.h"
+#include "thumbnailcache.h"
+#include "strokerecording.h"
+#include "strokereplayer.h"
 #include "actioncommands.h"
 
 #include "scribblearea.h"
@@ -123,7 +129,10 @@ MainWindow2::MainWindow2( QWidget *parent ) : QMainWindow( parent )
 
     readSettings();
 
-    connect( mEditor, &Editor::needSave, this, &MainWindow2::saveDocument );
+    mBackgroundSaver = new BackgroundSaver( this );
+    connect( mBackgroundSaver, &BackgroundSaver::saveFinished, this, &MainWindow2::backgroundSaveFinished );
+
+    connect( mEditor, &Editor::needSave, this, &MainWindow2::autoSave );
     connect( mToolBox, &ToolBoxWidget::clearButtonClicked, mEditor, &Editor::clearCurrentFrame );
 
     //connect( mScribbleArea, &ScribbleArea::refreshPreview, mPreview, &PreviewWidget::updateImage );
@@ -364,6 +373,16 @@ void MainWindow2::createMenus()
     connect( ui->actionHelp, &QAction::triggered, this, &MainWindow2::helpBox);
     connect( ui->actionAbout, &QAction::triggered, this, &MainWindow2::aboutPencil );
 
+    ui->menuHelp->addSeparator();
+    QAction* recordInputAction = new QAction( tr( "Record Drawing Input" ), ui->menuHelp );
+    recordInputAction->setCheckable( true );
+    ui->menuHelp->addAction( recordInputAction );
+    connect( recordInputAction, &QAction::toggled, this, &MainWindow2::recordInput );
+
+    QAction* replayInputAction = new QAction( tr( "Replay Drawing Input..." ), ui->menuHelp );
+    ui->menuHelp->addAction( replayInputAction );
+    connect( replayInputAction, &QAction::triggered, this, &MainWindow2::replayInput );
+
     // --------------- Menus ------------------
     mRecentFileMenu = new RecentFileMenu( tr("Open Recent"), this );
     mRecentFileMenu->loadFromDisk();
@@ -475,7 +494,7 @@ bool MainWindow2::saveAsNewDocument()
         return false;
     }
 
-    if ( !fileName.endsWith( PFF_OLD_EXTENSION ) && !fileName.endsWith( PFF_EXTENSION ) )
+    if ( !fileName.endsWith( PFF_OLD_EXTENSION ) && !fileName.endsWith( PFF_EXTENSION ) && !fileName.endsWith( PFF_BINARY_EXTENSION ) )
     {
         fileName = fileName + PFF_EXTENSION;
     }
@@ -549,6 +568,11 @@ bool MainWindow2::openObject( QString strFilePath )
 
 bool MainWindow2::saveObject( QString strSavedFileName )
 {
+    if ( strSavedFileName.endsWith( PFF_EXTENSION ) )
+    {
+        return saveInBackground( strSavedFileName );
+    }
+
     QProgressDialog progress( tr( "Saving document..." ), tr( "Abort" ), 0, 100, this );
     progress.setWindowModality( Qt::WindowModal );
     progress.show();
@@ -562,31 +586,87 @@ bool MainWindow2::saveObject( QString strSavedFileName )
 
     if ( !st.ok() )
     {
-        QDateTime dt = QDateTime::currentDateTime();
-        dt.setTimeSpec( Qt::UTC );
-#if QT_VERSION >= 0x050400
-        QDir errorLogFolder( QStandardPaths::writableLocation( QStandardPaths::AppLocalDataLocation ) );
-#else
-        QDir errorLogFolder( QStandardPaths::writableLocation( QStandardPaths::DataLocation ) );
-#endif
-        errorLogFolder.mkpath( "./logs" );
-        errorLogFolder.cd( "logs" );
-        QFile eLog( errorLogFolder.absoluteFilePath( QString( "error-%1.txt" ).arg( dt.toString( Qt::ISODate ) ) ) );
-        if ( eLog.open( QIODevice::WriteOnly | QIODevice::Text ) )
+        showSaveError( st );
+        return false;
+    }
+
+    documentSaved( strSavedFileName, mEditor->currentBackup() );
+    return true;
+}
+
+bool MainWindow2::saveInBackground( QString strSavedFileName )
+{
+    // One save at a time, e.g. a manual save right after an autosave
+    waitForBackgroundSave();
+
+    mEditor->prepareSave();
+
+    // Only the snapshot is taken here, the encoding and writing happen on the worker
+    ProjectSnapshot snapshot;
+    FileManager fm;
+    Status st = fm.createSnapshot( mEditor->object(), snapshot );
+    if ( !st.ok() )
+    {
+        showSaveError( st );
+        return false;
+    }
+
+    // Shown by the open dialog, from the thumbnails at hand, nothing is rendered here
+    if ( mEditor->preference()->isOn( SETTING::EMBED_THUMBNAILS ) )
+    {
+        QImage filmstrip = mEditor->thumbnails()->filmstrip();
+        if ( !filmstrip.isNull() )
         {
-            QTextStream out( &eLog );
-            out << st.details().replace( "<br>", "\n", Qt::CaseInsensitive );
+            snapshot.addImage( PFF_FILMSTRIP_FILE, filmstrip );
         }
+    }
 
-        ErrorDialog errorDialog( st.title(),
-                                 st.description().append( tr("<br><br>An error has occurred and your file may not have saved successfully."
-                                                             "If you believe that this error is an issue with Pencil2D, please create a new issue at:"
-                                                             "<br><a href='https://github.com/pencil2d/pencil/issues'>https://github.com/pencil2d/pencil/issues</a><br>"
-                                                             "Please be sure to include the following details in your issue:") ), st.details() );
-        errorDialog.exec();
-        return false;
+    mEditor->object()->setFilePath( strSavedFileName );
+    mBackupAtBackgroundSave = mEditor->currentBackup();
+    mIsBackgroundSavePending = true;
+    mBackgroundSaver->save( snapshot, strSavedFileName );
+    mBackgroundSaveId = mBackgroundSaver->saveId();
+
+    statusBar()->showMessage( tr( "Saving %1..." ).arg( QFileInfo( strSavedFileName ).fileName() ) );
+    return true;
+}
+
+void MainWindow2::backgroundSaveFinished( int saveId )
+{
+    if ( !mIsBackgroundSavePending || saveId != mBackgroundSaveId )
+    {
+        return; // already handled by waitForBackgroundSave(), the signal was still queued
+    }
+    mIsBackgroundSavePending = false;
+
+    Status st = mBackgroundSaver->status();
+    if ( !st.ok() )
+    {
+        statusBar()->clearMessage();
+        showSaveError( st );
+        return;
+    }
+
+    mEditor->object()->setModified( false );
+    documentSaved( mBackgroundSaver->fileName(), mBackupAtBackgroundSave );
+    statusBar()->showMessage( tr( "Saved %1" ).arg( QFileInfo( mBackgroundSaver->fileName() ).fileName() ), 3000 );
+}
+
+bool MainWindow2::waitForBackgroundSave()
+{
+    if ( !mIsBackgroundSavePending )
+    {
+        return true;
     }
+    mBackgroundSaver->wait();
+
+    bool isSaved = mBackgroundSaver->status().ok();
+    backgroundSaveFinished( mBackgroundSaveId );
+    return isSaved;
+}
 
+void MainWindow2::documentSaved( QString strSavedFileName, BackupElement* backup )
+{
     QSettings settings( PENCIL2D, PENCIL2D );
     settings.setValue( LAST_PCLX_PATH, strSavedFileName );
 
@@ -596,10 +676,34 @@ bool MainWindow2::saveObject( QString strSavedFileName )
     mTimeLine->updateContent();
 
     setWindowTitle( strSavedFileName.prepend("[*]") );
-    mBackupAtSave = mEditor->currentBackup();
+    mBackupAtSave = backup;
     updateSaveState();
+}
 
-    return true;
+void MainWindow2::showSaveError( Status st )
+{
+    QDateTime dt = QDateTime::currentDateTime();
+    dt.setTimeSpec( Qt::UTC );
+#if QT_VERSION >= 0x050400
+    QDir errorLogFolder( QStandardPaths::writableLocation( QStandardPaths::AppLocalDataLocation ) );
+#else
+    QDir errorLogFolder( QStandardPaths::writableLocation( QStandardPaths::DataLocation ) );
+#endif
+    errorLogFolder.mkpath( "./logs" );
+    errorLogFolder.cd( "logs" );
+    QFile eLog( errorLogFolder.absoluteFilePath( QString( "error-%1.txt" ).arg( dt.toString( Qt::ISODate ) ) ) );
+    if ( eLog.open( QIODevice::WriteOnly | QIODevice::Text ) )
+    {
+        QTextStream out( &eLog );
+        out << st.details().replace( "<br>", "\n", Qt::CaseInsensitive );
+    }
+
+    ErrorDialog errorDialog( st.title(),
+                             st.description().append( tr("<br><br>An error has occurred and your file may not have saved successfully."
+                                                         "If you believe that this error is an issue with Pencil2D, please create a new issue at:"
+                                                         "<br><a href='https://github.com/pencil2d/pencil/issues'>https://github.com/pencil2d/pencil/issues</a><br>"
+                                                         "Please be sure to include the following details in your issue:") ), st.details() );
+    errorDialog.exec();
 }
 
 void MainWindow2::saveDocument()
@@ -614,8 +718,22 @@ void MainWindow2::saveDocument()
     }
 }
 
+void MainWindow2::autoSave()
+{
+    // Untitled documents are only saved once the user has picked a file name
+    QString filePath = mEditor->object()->filePath();
+    if ( filePath.isEmpty() || mIsBackgroundSavePending || mEditor->currentBackup() == mBackupAtSave )
+    {
+        return;
+    }
+    saveObject( filePath );
+}
+
 bool MainWindow2::maybeSave()
 {
+    // An autosave may still be writing the document that is about to be closed
+    waitForBackgroundSave();
+
     if ( mEditor->currentBackup() != mBackupAtSave )
     {
         int ret = QMessageBox::warning( this, tr( "Warning" ),
@@ -626,7 +744,7 @@ bool MainWindow2::maybeSave()
         if ( ret == QMessageBox::Yes )
         {
             saveDocument();
-            return true;
+            return waitForBackgroundSave(); // keep the document open if it couldn't be written
         }
         else if ( ret == QMessageBox::Cancel )
         {
@@ -1083,6 +1201,66 @@ void MainWindow2::helpBox()
     QDesktopServices::openUrl( QUrl(url) );
 }
 
+void MainWindow2::recordInput( bool isRecording )
+{
+    if ( mStrokeRecorder == nullptr )
+    {
+        mStrokeRecorder = new StrokeRecorder( mEditor, mScribbleArea, this );
+    }
+
+    if ( isRecording )
+    {
+        mStrokeRecorder->start();
+        return;
+    }
+
+    mStrokeRecorder->stop();
+    if ( mStrokeRecorder->recording().strokes.isEmpty() )
+    {
+        return;
+    }
+
+    FileDialog fileDialog( this );
+    QString filePath = fileDialog.saveFile( FileType::INPUT_RECORDING );
+    if ( filePath.isEmpty() )
+    {
+        return;
+    }
+    Status st = mStrokeRecorder->recording().save( filePath );
+    if ( !st.ok() )
+    {
+        QMessageBox::warning( this, tr( "Warning" ), tr( "Cannot write the recording to %1" ).arg( filePath ) );
+    }
+}
+
+void MainWindow2::replayInput()
+{
+    FileDialog fileDialog( this );
+    QString filePath = fileDialog.openFile( FileType::INPUT_RECORDING );
+    if ( filePath.isEmpty() )
+    {
+        return;
+    }
+
+    StrokeRecording recording;
+    Status st = recording.load( filePath );
+    if ( !st.ok() )
+    {
+        QMessageBox::warning( this, tr( "Warning" ), tr( "Cannot read the recording %1" ).arg( filePath ) );
+        return;
+    }
+
+    StrokeReplayReport report;
+    StrokeReplayer replayer( mEditor, mScribbleArea );
+    st = replayer.replay( recording, report );
+    if ( !st.ok() )
+    {
+        QMessageBox::warning( this, st.title(), st.description() );
+        return;
+    }
+    QMessageBox::information( this, tr( "Replay" ), report.summary() );
+}
+
 void MainWindow2::makeConnections( Editor* editor )
 {
     connect( editor, &Editor::updateBackup, this, &MainWindow2::updateSaveState );
@@ -40,6 +40,9 @@ class RecentFileMenu;
 class Timeline2;
 class ActionCommands;
 class ImportImageSeqDialog;
+class BackgroundSaver;
+class StrokeRecorder;
+class Status;
 
 
 #define STRINGIFY(x) #x
@@ -81,6 +84,7 @@ public:
     void saveDocument();
     bool saveAsNewDocument();
     bool maybeSave();
+    void autoSave();
 
     // import/export
     void importImage();
@@ -97,6 +101,10 @@ public:
     void helpBox();
     void aboutPencil();
 
+    // Drawing input recordings, to reproduce lag reports
+    void recordInput( bool isRecording );
+    void replayInput();
+
     void openFile( QString filename );
 
     PreferencesDialog *getPrefDialog() {return mPrefDialog;}
@@ -111,6 +119,11 @@ protected:
 private:
     bool openObject( QString strFilename );
     bool saveObject( QString strFileName );
+    bool saveInBackground( QString strFileName );
+    void backgroundSaveFinished( int saveId );
+    bool waitForBackgroundSave();
+    void documentSaved( QString strSavedFileName, BackupElement* backup );
+    void showSaveError( Status st );
 
     void dockAllSubWidgets();
 
@@ -157,6 +170,14 @@ private:
     // backup
     BackupElement* mBackupAtSave = nullptr;
 
+    // pclx files are written on a worker thread
+    BackgroundSaver* mBackgroundSaver = nullptr;
+    BackupElement* mBackupAtBackgroundSave = nullptr;
+    bool mIsBackgroundSavePending = false;
+    int mBackgroundSaveId = 0;
+
+    StrokeRecorder* mStrokeRecorder = nullptr;
+
 private:
     ActionCommands* mCommands              = nullptr;
     QList< BaseDockWidget* > mDockWidgets;
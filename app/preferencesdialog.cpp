@@ -237,6 +237,7 @@ GeneralPage::GeneralPage(QWidget* parent) : QWidget(parent)
     mShadowsBox = new QCheckBox(tr("Shadows"));
     mToolCursorsBox = new QCheckBox(tr("Tool Cursors"));
     mAntialiasingBox = new QCheckBox(tr("Antialiasing"));
+    mPerformanceHudBox = new QCheckBox(tr("Show rendering statistics"));
     mDottedCursorBox = new QCheckBox(tr("Dotted Cursor"));
 
     QGridLayout* langLayout = new QGridLayout;
@@ -269,6 +270,7 @@ GeneralPage::GeneralPage(QWidget* parent) : QWidget(parent)
     QGridLayout* displayLayout = new QGridLayout();
     displayBox->setLayout(displayLayout);
     displayLayout->addWidget(mAntialiasingBox, 0, 0);
+    displayLayout->addWidget(mPerformanceHudBox, 1, 0);
 
     QGridLayout* gridLayout = new QGridLayout();
     gridBox->setLayout(gridLayout);
@@ -324,6 +326,7 @@ GeneralPage::GeneralPage(QWidget* parent) : QWidget(parent)
     connect( mDottedCursorBox,    &QCheckBox::stateChanged, this, &GeneralPage::dottedCursorCheckboxStateChanged );
     connect( mGridSizeInput, SIGNAL(valueChanged(int)), this, SLOT(gridSizeChange(int)));
     connect( mGridCheckBox,    &QCheckBox::stateChanged, this, &GeneralPage::gridCheckBoxStateChanged );
+    connect( mPerformanceHudBox, &QCheckBox::stateChanged, this, &GeneralPage::performanceHudCheckboxStateChanged );
 
     setLayout(lay);
 }
@@ -362,6 +365,7 @@ void GeneralPage::updateValues()
     mGridCheckBox->setChecked(mManager->isOn(SETTING::GRID));
 
     mHighResBox->setChecked(mManager->isOn(SETTING::HIGH_RESOLUTION));
+    mPerformanceHudBox->setChecked(mManager->isOn(SETTING::PERFORMANCE_HUD));
 
     QString bgName = mManager->getString(SETTING::BACKGROUND_STYLE);
     if (bgName == "checkerboard") {
@@ -436,6 +440,11 @@ void GeneralPage::antiAliasCheckboxStateChanged( bool b )
     mManager->set( SETTING::ANTIALIAS, b );
 }
 
+void GeneralPage::performanceHudCheckboxStateChanged( bool b )
+{
+    mManager->set( SETTING::PERFORMANCE_HUD, b );
+}
+
 void GeneralPage::toolCursorsCheckboxStateChanged(bool b)
 {
     mManager->set( SETTING::TOOL_CURSOR, b );
@@ -474,6 +483,7 @@ TimelinePage::TimelinePage(QWidget* parent) : QWidget(parent)
     mLengthSize->setValidator( lengthSizeValidator );
 
     mScrubBox = new QCheckBox(tr("Short scrub"));
+    mThumbnailsBox = new QCheckBox(tr("Show key frame thumbnails"));
 
     mFontSize->setRange(4, 20);
     mFrameSize->setRange(4, 20);
@@ -493,12 +503,14 @@ TimelinePage::TimelinePage(QWidget* parent) : QWidget(parent)
     connect(mLengthSize, SIGNAL(textChanged(QString)), this, SLOT(lengthSizeChange(QString)));
     connect( mDrawLabel, &QCheckBox::stateChanged, this, &TimelinePage::labelChange );
     connect( mScrubBox, &QCheckBox::stateChanged, this, &TimelinePage::scrubChange );
+    connect( mThumbnailsBox, &QCheckBox::stateChanged, this, &TimelinePage::thumbnailsChange );
 
     lay->addWidget(frameSizeLabel);
     lay->addWidget(mFrameSize);
     lay->addWidget(lengthSizeLabel);
     lay->addWidget(mLengthSize);
     lay->addWidget(mScrubBox);
+    lay->addWidget(mThumbnailsBox);
     timeLineBox->setLayout(lay);
 
     QVBoxLayout* lay2 = new QVBoxLayout();
@@ -514,6 +526,7 @@ void TimelinePage::updateValues()
     mFontSize->setValue(mManager->getInt(SETTING::LABEL_FONT_SIZE));
     mFrameSize->setValue(mManager->getInt(SETTING::FRAME_SIZE));
     mLengthSize->setText(mManager->getString(SETTING::TIMELINE_SIZE));
+    mThumbnailsBox->setChecked(mManager->isOn(SETTING::TIMELINE_THUMBNAILS));
 }
 
 void TimelinePage::lengthSizeChange(QString value)
@@ -542,6 +555,11 @@ void TimelinePage::scrubChange(bool value)
     mManager->set(SETTING::SHORT_SCRUB, value);
 }
 
+void TimelinePage::thumbnailsChange(bool value)
+{
+    mManager->set(SETTING::TIMELINE_THUMBNAILS, value);
+}
+
 FilesPage::FilesPage(QWidget* parent) : QWidget(parent)
 {
     QVBoxLayout *lay = new QVBoxLayout();
@@ -563,9 +581,23 @@ FilesPage::FilesPage(QWidget* parent) : QWidget(parent)
     mAutosaveNumberBox->setMaximum(200);
     mAutosaveNumberBox->setFixedWidth(50);
 
+    QGroupBox *previewBox = new QGroupBox( tr( "Project preview", "Preference" ) );
+    mEmbedThumbnailsBox = new QCheckBox( tr( "Save a filmstrip of the animation in the project, shown when opening files", "Preference" ) );
+
+    QGroupBox *memoryBox = new QGroupBox( tr( "Memory", "Preference" ) );
+    QLabel *memoryLimitLabel = new QLabel( tr( "Bitmap frames kept in memory before using the scratch file (MB, 0 for no limit):", "Preference" ) );
+    memoryLimitLabel->setWordWrap(true);
+    mBitmapMemoryLimitBox = new QSpinBox();
+    mBitmapMemoryLimitBox->setMinimum(0);
+    mBitmapMemoryLimitBox->setMaximum(65536);
+    mBitmapMemoryLimitBox->setSingleStep(256);
+    mBitmapMemoryLimitBox->setFixedWidth(80);
+
     connect(mAutosaveCheckBox, &QCheckBox::stateChanged, this, &FilesPage::autosaveChange);
     connect(mAutosaveNumberBox, SIGNAL(valueChanged(int)), this, SLOT(autosaveNumberChange(int)));
     connect(mClearRecentFilesBtn, SIGNAL(clicked(bool)), this, SLOT(clearRecentFilesList()));
+    connect(mBitmapMemoryLimitBox, SIGNAL(valueChanged(int)), this, SLOT(bitmapMemoryLimitChange(int)));
+    connect(mEmbedThumbnailsBox, &QCheckBox::stateChanged, this, &FilesPage::embedThumbnailsChange);
 
     lay->addWidget(mAutosaveCheckBox);
     lay->addWidget(autosaveNumberLabel);
@@ -576,9 +608,20 @@ FilesPage::FilesPage(QWidget* parent) : QWidget(parent)
     clearRecentChangesLay->addWidget(mClearRecentFilesBtn);
     clearRecentFilesBox->setLayout(clearRecentChangesLay);
 
+    QVBoxLayout *memoryLay = new QVBoxLayout();
+    memoryLay->addWidget(memoryLimitLabel);
+    memoryLay->addWidget(mBitmapMemoryLimitBox);
+    memoryBox->setLayout(memoryLay);
+
+    QVBoxLayout *previewLay = new QVBoxLayout();
+    previewLay->addWidget(mEmbedThumbnailsBox);
+    previewBox->setLayout(previewLay);
+
     QVBoxLayout* mainLayout = new QVBoxLayout();
     mainLayout->addWidget(autosaveBox);
     mainLayout->addWidget(clearRecentFilesBox);
+    mainLayout->addWidget(memoryBox);
+    mainLayout->addWidget(previewBox);
     mainLayout->addStretch(1);
     setLayout(mainLayout);
 }
@@ -587,6 +630,8 @@ void FilesPage::updateValues()
 {
     mAutosaveCheckBox->setChecked(mManager->isOn(SETTING::AUTO_SAVE));
     mAutosaveNumberBox->setValue(mManager->getInt(SETTING::AUTO_SAVE_NUMBER));
+    mBitmapMemoryLimitBox->setValue(mManager->getInt(SETTING::BITMAP_MEMORY_LIMIT));
+    mEmbedThumbnailsBox->setChecked(mManager->isOn(SETTING::EMBED_THUMBNAILS));
 }
 
 void FilesPage::updateClearRecentListButton()
@@ -605,6 +650,16 @@ void FilesPage::autosaveNumberChange(int number)
     mManager->set(SETTING::AUTO_SAVE_NUMBER, number);
 }
 
+void FilesPage::bitmapMemoryLimitChange(int megabytes)
+{
+    mManager->set(SETTING::BITMAP_MEMORY_LIMIT, megabytes);
+}
+
+void FilesPage::embedThumbnailsChange(bool b)
+{
+    mManager->set(SETTING::EMBED_THUMBNAILS, b);
+}
+
 void FilesPage::clearRecentFilesList()
 {
     emit clearRecentList();
@@ -669,10 +724,29 @@ ToolsPage::ToolsPage(QWidget* parent) : QWidget(parent)
 
     brushBox->setLayout(brushBoxLayout);
 
+    QGroupBox* eyedropperBox = new QGroupBox(tr("Eyedropper"));
+    QLabel* eyedropperSampleSizeLabel = new QLabel(tr("Average over a square of (pixels)"));
+    mEyedropperSampleSizeBox = new QSpinBox();
+    mEyedropperSampleSizeBox->setMinimum(1);
+    mEyedropperSampleSizeBox->setMaximum(31);
+    mEyedropperSampleSizeBox->setSingleStep(2);
+    mEyedropperSampleSizeBox->setFixedWidth(50);
+    mEyedropperAllLayersBox = new QCheckBox(tr("Pick from all layers"));
+    QVBoxLayout* eyedropperBoxLayout = new QVBoxLayout();
+    eyedropperBoxLayout->addWidget(eyedropperSampleSizeLabel);
+    eyedropperBoxLayout->addWidget(mEyedropperSampleSizeBox);
+    eyedropperBoxLayout->addWidget(mEyedropperAllLayersBox);
+
+    connect(mEyedropperSampleSizeBox, SIGNAL(valueChanged(int)), this, SLOT(eyedropperSampleSizeChange(int)));
+    connect( mEyedropperAllLayersBox, &QCheckBox::stateChanged, this, &ToolsPage::eyedropperAllLayersChange );
+
+    eyedropperBox->setLayout(eyedropperBoxLayout);
+
 
     QVBoxLayout* lay2 = new QVBoxLayout();
     lay2->addWidget(onionSkinBox);
     lay2->addWidget(brushBox);
+    lay2->addWidget(eyedropperBox);
     lay2->addStretch(1);
     setLayout(lay2);
 }
@@ -684,6 +758,8 @@ void ToolsPage::updateValues()
     mOnionPrevFramesNumBox->setValue(mManager->getInt(SETTING::ONION_PREV_FRAMES_NUM));
     mOnionNextFramesNumBox->setValue(mManager->getInt(SETTING::ONION_NEXT_FRAMES_NUM));
     mUseQuickSizingBox->setChecked(mManager->isOn(SETTING::QUICK_SIZING));
+    mEyedropperSampleSizeBox->setValue(mManager->getInt(SETTING::EYEDROPPER_SAMPLE_SIZE));
+    mEyedropperAllLayersBox->setChecked(mManager->isOn(SETTING::EYEDROPPER_ALL_LAYERS));
 }
 
 void ToolsPage::onionMaxOpacityChange(int value)
@@ -696,6 +772,16 @@ void ToolsPage::quickSizingChange( bool b )
     mManager->set(SETTING::QUICK_SIZING, b);
 }
 
+void ToolsPage::eyedropperSampleSizeChange(int value)
+{
+    mManager->set(SETTING::EYEDROPPER_SAMPLE_SIZE, value);
+}
+
+void ToolsPage::eyedropperAllLayersChange( bool b )
+{
+    mManager->set(SETTING::EYEDROPPER_ALL_LAYERS, b);
+}
+
 void ToolsPage::onionMinOpacityChange(int value)
 {
     mManager->set(SETTING::ONION_MIN_OPACITY, value);
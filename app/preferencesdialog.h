@@ -101,6 +101,7 @@ private:
     void toolCursorsCheckboxStateChanged( bool b );
     void dottedCursorCheckboxStateChanged( bool b );
     void highResCheckboxStateChanged(bool b);
+    void performanceHudCheckboxStateChanged(bool b);
     void gridCheckBoxStateChanged(bool b);
     void curveSmoothingChange(int value);
     void backgroundChange(int value);
@@ -116,6 +117,7 @@ private:
     QCheckBox* mToolCursorsBox;
     QCheckBox* mAntialiasingBox;
     QCheckBox* mHighResBox;
+    QCheckBox* mPerformanceHudBox;
     QButtonGroup *mBackgroundButtons;
     QCheckBox* mDottedCursorBox;
     QSpinBox* mGridSizeInput;
@@ -140,6 +142,7 @@ public slots:
     void frameSizeChange(int);
     void labelChange(bool);
     void scrubChange(bool);
+    void thumbnailsChange(bool);
 
 private:
     PreferenceManager* mManager = nullptr;
@@ -148,6 +151,7 @@ private:
     QSlider* mFrameSize;
     QLineEdit* mLengthSize;
     QCheckBox* mScrubBox;
+    QCheckBox* mThumbnailsBox;
 };
 
 class FilesPage : public QWidget
@@ -162,6 +166,8 @@ public slots:
     void updateValues();
     void autosaveChange(bool b);
     void autosaveNumberChange(int number);
+    void bitmapMemoryLimitChange(int megabytes);
+    void embedThumbnailsChange(bool b);
     void clearRecentFilesList();
     QPushButton *getClearRecentFilesBtn() { return mClearRecentFilesBtn; }
     void updateClearRecentListButton();
@@ -173,6 +179,8 @@ private:
     PreferenceManager *mManager = nullptr;
     QCheckBox *mAutosaveCheckBox;
     QSpinBox *mAutosaveNumberBox;
+    QSpinBox *mBitmapMemoryLimitBox;
+    QCheckBox *mEmbedThumbnailsBox;
     QPushButton *mClearRecentFilesBtn;
 
 };
@@ -192,6 +200,8 @@ public slots:
     void onionPrevFramesNumChange(int);
     void onionNextFramesNumChange(int);
     void quickSizingChange(bool);
+    void eyedropperSampleSizeChange(int);
+    void eyedropperAllLayersChange(bool);
 private:
     PreferenceManager* mManager = nullptr;
     QSpinBox* mOnionMaxOpacityBox;
@@ -199,6 +209,8 @@ private:
     QSpinBox* mOnionPrevFramesNumBox;
     QSpinBox* mOnionNextFramesNumBox;
     QCheckBox * mUseQuickSizingBox;
+    QSpinBox* mEyedropperSampleSizeBox;
+    QCheckBox* mEyedropperAllLayersBox;
 };
 
 #endif
@@ -27,9 +27,12 @@ PreviewCanvas::PreviewCanvas( QWidget* parent ) : QWidget( parent )
 void PreviewCanvas::paintEvent( QPaintEvent* )
 {
 	QPainter painter( this );
-	if ( mBitmapImage )
+	if ( mBitmapImage && !mBitmapImage->bounds().isEmpty() )
 	{
-		painter.drawImage( rect( ), *( mBitmapImage->image() ) );
+		// A mip level close to the widget size instead of the full image
+		qreal scale = qMin( qreal( width() ) / mBitmapImage->width(), qreal( height() ) / mBitmapImage->height() );
+		painter.setRenderHint( QPainter::SmoothPixmapTransform );
+		painter.drawImage( rect( ), mBitmapImage->mipmap( scale ) );
 	}
 	painter.end( );
 }
@@ -0,0 +1,81 @@
+#include "bench_bitmap.h"
+
+#include <cmath>
+#include <QRadialGradient>
+#include "bitmapimage.h"
+
+
+void BenchBitmap::brushDabs_data()
+{
+    QTest::addColumn< qreal >( "brushWidth" );
+    QTest::addColumn< bool >( "feather" );
+
+    QTest::newRow( "5px solid" ) << qreal( 5 ) << false;
+    QTest::newRow( "20px feathered" ) << qreal( 20 ) << true;
+    QTest::newRow( "80px feathered" ) << qreal( 80 ) << true;
+}
+
+void BenchBitmap::brushDabs()
+{
+    QFETCH( qreal, brushWidth );
+    QFETCH( bool, feather );
+
+    const int dabCount = 200;
+    QColor colour( 40, 60, 200 );
+
+    // The dabs of one stroke across the canvas per iteration, painted
+    // into the stroke buffer the way ScribbleArea::drawBrush does
+    QBENCHMARK
+    {
+        BitmapImage buffer;
+        for ( int i = 0; i < dabCount; ++i )
+        {
+            QPointF point( -400 + i * 4.0, 100 * std::sin( i * 0.05 ) );
+            QRectF rectangle( point.x() - 0.5 * brushWidth, point.y() - 0.5 * brushWidth, brushWidth, brushWidth );
+            if ( feather )
+            {
+                QRadialGradient radialGrad( point, 0.5 * brushWidth );
+                radialGrad.setColorAt( 0.0, QColor( colour.red(), colour.green(), colour.blue(), 64 ) );
+                radialGrad.setColorAt( 1.0, QColor( colour.red(), colour.green(), colour.blue(), 0 ) );
+
+                BitmapImage dab;
+                dab.drawEllipse( rectangle, Qt::NoPen, radialGrad, QPainter::CompositionMode_Source, false );
+                buffer.paste( &dab );
+            }
+            else
+            {
+                buffer.drawEllipse( rectangle, Qt::NoPen, QBrush( colour, Qt::SolidPattern ),
+                                    QPainter::CompositionMode_Source, true );
+            }
+        }
+    }
+}
+
+void BenchBitmap::floodFill_data()
+{
+    QTest::addColumn< int >( "size" );
+
+    QTest::newRow( "256x256 cell" ) << 256;
+    QTest::newRow( "1024x1024 cell" ) << 1024;
+}
+
+void BenchBitmap::floodFill()
+{
+    QFETCH( int, size );
+
+    // A white cell outlined in black, in the middle of the camera
+    QRect cameraRect( -size / 2 - 16, -size / 2 - 16, size + 32, size + 32 );
+    BitmapImage image( cameraRect, Qt::white );
+    image.drawRect( QRectF( -size / 2, -size / 2, size, size ), QPen( Qt::black, 3 ), Qt::NoBrush,
+                    QPainter::CompositionMode_SourceOver, false );
+
+    // Alternates the colours, so that every iteration fills the whole cell
+    QRgb colours[] = { qRgb( 255, 0, 0 ), qRgb( 0, 0, 255 ) };
+    int i = 0;
+    QBENCHMARK
+    {
+        BitmapImage::floodFill( &image, cameraRect, QPoint( 0, 0 ), Qt::transparent, colours[ i ], 0 );
+        i = 1 - i;
+    }
+    QCOMPARE( image.pixel( 0, 0 ), colours[ 1 - i ] );
+}
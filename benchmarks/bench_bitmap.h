@@ -0,0 +1,21 @@
+#ifndef BENCH_BITMAP_H
+#define BENCH_BITMAP_H
+
+#include "AutoTest.h"
+
+
+class BenchBitmap : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void brushDabs_data();
+    void brushDabs();
+
+    void floodFill_data();
+    void floodFill();
+};
+
+DECLARE_TEST( BenchBitmap );
+
+#endif // BENCH_BITMAP_H
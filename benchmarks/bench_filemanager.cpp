@@ -0,0 +1,76 @@
+#include "bench_filemanager.h"
+
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include "object.h"
+#include "filemanager.h"
+#include "fileformat.h"
+#include "projectgenerator.h"
+
+
+namespace
+{
+Object* createProject( const QString& type )
+{
+    if ( type == "bitmap" )
+    {
+        return ProjectGenerator::createBitmapProject( 4, 24, QSize( 640, 480 ) );
+    }
+    return ProjectGenerator::createVectorProject( 4, 24, 50 );
+}
+}
+
+
+void BenchFileManager::save_data()
+{
+    QTest::addColumn< QString >( "type" );
+    QTest::addColumn< QString >( "extension" );
+
+    QTest::newRow( "bitmap pclx" ) << "bitmap" << PFF_EXTENSION;
+    QTest::newRow( "vector pclx" ) << "vector" << PFF_EXTENSION;
+    QTest::newRow( "bitmap pclb" ) << "bitmap" << PFF_BINARY_EXTENSION;
+}
+
+void BenchFileManager::save()
+{
+    QFETCH( QString, type );
+    QFETCH( QString, extension );
+
+    QTemporaryDir testDir;
+    QVERIFY( testDir.isValid() );
+    QString fileName = testDir.path() + "/bench" + extension;
+
+    QScopedPointer< Object > object( createProject( type ) );
+    QBENCHMARK
+    {
+        FileManager fm;
+        QVERIFY( fm.save( object.data(), fileName ).ok() );
+    }
+}
+
+void BenchFileManager::load_data()
+{
+    save_data();
+}
+
+void BenchFileManager::load()
+{
+    QFETCH( QString, type );
+    QFETCH( QString, extension );
+
+    QTemporaryDir testDir;
+    QVERIFY( testDir.isValid() );
+    QString fileName = testDir.path() + "/bench" + extension;
+    {
+        QScopedPointer< Object > object( createProject( type ) );
+        FileManager fm;
+        QVERIFY( fm.save( object.data(), fileName ).ok() );
+    }
+
+    QBENCHMARK
+    {
+        FileManager fm;
+        QScopedPointer< Object > object( fm.load( fileName ) );
+        QVERIFY( object != nullptr );
+    }
+}
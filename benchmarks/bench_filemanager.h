@@ -0,0 +1,21 @@
+#ifndef BENCH_FILEMANAGER_H
+#define BENCH_FILEMANAGER_H
+
+#include "AutoTest.h"
+
+
+class BenchFileManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void save_data();
+    void save();
+
+    void load_data();
+    void load();
+};
+
+DECLARE_TEST( BenchFileManager );
+
+#endif // BENCH_FILEMANAGER_H
@@ -0,0 +1,97 @@
+#include "bench_rendering.h"
+
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QPixmap>
+#include "canvasrenderer.h"
+#include "object.h"
+#include "layercamera.h"
+#include "projectgenerator.h"
+
+
+namespace
+{
+// One paint() of the canvas per iteration, cycling through the frames
+void paintFrames( Object* object, int frameCount )
+{
+    QPixmap canvas( 1280, 720 );
+    CanvasRenderer renderer;
+    renderer.setCanvas( &canvas );
+    renderer.setViewTransform( QTransform::fromTranslate( canvas.width() / 2, canvas.height() / 2 ) );
+    renderer.setOptions( RenderOptions() );
+
+    int layer = object->getLayerCount() - 1;
+    int frame = 1;
+    QBENCHMARK
+    {
+        renderer.paint( object, layer, frame, canvas.rect() );
+        frame = frame % frameCount + 1;
+    }
+}
+}
+
+
+void BenchRendering::paintBitmapComposite_data()
+{
+    QTest::addColumn< int >( "layers" );
+    QTest::addColumn< int >( "frames" );
+
+    QTest::newRow( "1 layer x 24 frames" ) << 1 << 24;
+    QTest::newRow( "4 layers x 24 frames" ) << 4 << 24;
+    QTest::newRow( "16 layers x 8 frames" ) << 16 << 8;
+}
+
+void BenchRendering::paintBitmapComposite()
+{
+    QFETCH( int, layers );
+    QFETCH( int, frames );
+
+    QScopedPointer< Object > object( ProjectGenerator::createBitmapProject( layers, frames, QSize( 640, 480 ) ) );
+    paintFrames( object.data(), frames );
+}
+
+void BenchRendering::paintVectorComposite_data()
+{
+    QTest::addColumn< int >( "layers" );
+    QTest::addColumn< int >( "frames" );
+
+    QTest::newRow( "1 layer x 24 frames" ) << 1 << 24;
+    QTest::newRow( "4 layers x 24 frames" ) << 4 << 24;
+    QTest::newRow( "16 layers x 8 frames" ) << 16 << 8;
+}
+
+void BenchRendering::paintVectorComposite()
+{
+    QFETCH( int, layers );
+    QFETCH( int, frames );
+
+    QScopedPointer< Object > object( ProjectGenerator::createVectorProject( layers, frames, 50 ) );
+    paintFrames( object.data(), frames );
+}
+
+void BenchRendering::exportFrames_data()
+{
+    QTest::addColumn< QString >( "format" );
+
+    QTest::newRow( "png" ) << "PNG";
+    QTest::newRow( "jpg" ) << "JPG";
+}
+
+void BenchRendering::exportFrames()
+{
+    QFETCH( QString, format );
+
+    QTemporaryDir outputDir;
+    QVERIFY( outputDir.isValid() );
+
+    const int frameCount = 8;
+    QScopedPointer< Object > object( ProjectGenerator::createBitmapProject( 2, frameCount, QSize( 640, 480 ) ) );
+    LayerCamera* camera = static_cast< LayerCamera* >( object->getLayer( 0 ) );
+
+    // All the frames per iteration
+    QBENCHMARK
+    {
+        object->exportFrames( 1, frameCount, camera, QSize( 1280, 960 ), outputDir.path() + "/frame",
+                              format.toLatin1().constData(), -1, false, true, nullptr, 50 );
+    }
+}
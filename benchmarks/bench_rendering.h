@@ -0,0 +1,24 @@
+#ifndef BENCH_RENDERING_H
+#define BENCH_RENDERING_H
+
+#include "AutoTest.h"
+
+
+class BenchRendering : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void paintBitmapComposite_data();
+    void paintBitmapComposite();
+
+    void paintVectorComposite_data();
+    void paintVectorComposite();
+
+    void exportFrames_data();
+    void exportFrames();
+};
+
+DECLARE_TEST( BenchRendering );
+
+#endif // BENCH_RENDERING_H
@@ -0,0 +1,86 @@
+#include "bench_strokereplay.h"
+
+#include <QDir>
+#include "editor.h"
+#include "scribblearea.h"
+#include "toolmanager.h"
+#include "strokerecording.h"
+#include "strokereplayer.h"
+#include "fileformat.h"
+#include "projectgenerator.h"
+
+
+void BenchStrokeReplay::initTestCase()
+{
+    mScribbleArea = new ScribbleArea( nullptr );
+
+    mEditor = new Editor;
+    mEditor->setScribbleArea( mScribbleArea );
+    mEditor->init();
+    mEditor->setObject( ProjectGenerator::createBitmapProject( 1, 1, QSize( 640, 480 ) ) );
+
+    mScribbleArea->setCore( mEditor );
+    mScribbleArea->init();
+
+    mEditor->setCurrentLayer( 1 );
+    mEditor->tools()->setDefaultTool();
+}
+
+void BenchStrokeReplay::cleanupTestCase()
+{
+    delete mEditor;
+    delete mScribbleArea;
+}
+
+void BenchStrokeReplay::replay_data()
+{
+    QTest::addColumn< int >( "tool" );
+    QTest::addColumn< QString >( "recordingPath" );
+
+    QTest::newRow( "pencil" ) << int( PENCIL ) << QString();
+    QTest::newRow( "brush" ) << int( BRUSH ) << QString();
+    QTest::newRow( "eraser" ) << int( ERASER ) << QString();
+    QTest::newRow( "smudge" ) << int( SMUDGE ) << QString();
+
+    QDir recordingDir( qgetenv( "PENCIL2D_INPUT_RECORDINGS" ) );
+    if ( !qEnvironmentVariableIsEmpty( "PENCIL2D_INPUT_RECORDINGS" ) )
+    {
+        for ( const QFileInfo& info : recordingDir.entryInfoList( QStringList( "*" PFF_INPUT_RECORDING_EXTENSION ), QDir::Files ) )
+        {
+            QTest::newRow( qPrintable( info.fileName() ) ) << int( INVALID_TOOL ) << info.absoluteFilePath();
+        }
+    }
+}
+
+void BenchStrokeReplay::replay()
+{
+    QFETCH( int, tool );
+    QFETCH( QString, recordingPath );
+
+    StrokeRecording recording;
+    if ( recordingPath.isEmpty() )
+    {
+        // With the tool's own settings, wide enough to paint plenty of dabs
+        Properties properties = mEditor->tools()->getTool( static_cast< ToolType >( tool ) )->properties;
+        properties.width = 24;
+
+        std::mt19937 random( 1 );
+        recording = ProjectGenerator::createStrokeRecording( static_cast< ToolType >( tool ), properties, 10,
+                                                             QSize( 800, 600 ), random );
+    }
+    else
+    {
+        QVERIFY( recording.load( recordingPath ).ok() );
+    }
+
+    // Strokes pile up on the frame and in the undo stack, one replay is
+    // already thousands of events
+    StrokeReplayReport report;
+    StrokeReplayer replayer( mEditor, mScribbleArea );
+    QBENCHMARK_ONCE
+    {
+        QVERIFY( replayer.replay( recording, report ).ok() );
+    }
+
+    QCOMPARE( report.eventCount, recording.eventCount() );
+}
@@ -0,0 +1,31 @@
+#ifndef BENCH_STROKEREPLAY_H
+#define BENCH_STROKEREPLAY_H
+
+#include "AutoTest.h"
+
+class Editor;
+class ScribbleArea;
+
+
+// Replays drawing input through ScribbleArea and the tools, without showing it.
+// Recordings saved from Help > Record Drawing Input are replayed too when
+// PENCIL2D_INPUT_RECORDINGS names the folder they are in.
+class BenchStrokeReplay : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void replay_data();
+    void replay();
+
+private:
+    Editor* mEditor = nullptr;
+    ScribbleArea* mScribbleArea = nullptr;
+};
+
+DECLARE_TEST( BenchStrokeReplay );
+
+#endif // BENCH_STROKEREPLAY_H
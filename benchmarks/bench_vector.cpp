@@ -0,0 +1,63 @@
+#include "bench_vector.h"
+
+#include <QScopedPointer>
+#include "vectorimage.h"
+#include "beziercurve.h"
+#include "projectgenerator.h"
+
+
+void BenchVector::fill_data()
+{
+    QTest::addColumn< int >( "cells" );
+
+    QTest::newRow( "4x4 grid" ) << 4;
+    QTest::newRow( "16x16 grid" ) << 16;
+}
+
+void BenchVector::fill()
+{
+    QFETCH( int, cells );
+
+    QScopedPointer< VectorImage > grid( ProjectGenerator::createCurveGrid( cells, QRectF( -320, -240, 640, 480 ) ) );
+    QPointF insideCell( -320 + 0.5 * 640 / cells, -240 + 0.5 * 480 / cells );
+
+    // Filling adds an area, so each iteration fills a fresh copy
+    QBENCHMARK
+    {
+        VectorImage image( *grid );
+        image.fill( insideCell, 1, 3.0 );
+    }
+}
+
+void BenchVector::checkCurveIntersections_data()
+{
+    QTest::addColumn< int >( "curves" );
+
+    QTest::newRow( "50 curves" ) << 50;
+    QTest::newRow( "200 curves" ) << 200;
+    QTest::newRow( "800 curves" ) << 800;
+}
+
+void BenchVector::checkCurveIntersections()
+{
+    QFETCH( int, curves );
+
+    std::mt19937 random( 1 );
+    QRectF area( -320, -240, 640, 480 );
+
+    VectorImage scene;
+    for ( int i = 0; i < curves; ++i )
+    {
+        BezierCurve curve( ProjectGenerator::createStrokePoints( area, 16, random ) );
+        scene.addCurve( curve, 1.0, false );
+    }
+    BezierCurve stroke( ProjectGenerator::createStrokePoints( area, 64, random ) );
+
+    // What adding a stroke to the scene costs, the scene is modified so each iteration works on a copy
+    QBENCHMARK
+    {
+        VectorImage image( scene );
+        BezierCurve newCurve( stroke );
+        image.checkCurveIntersections( newCurve, 3.0 );
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef BENCH_VECTOR_H
+#define BENCH_VECTOR_H
+
+#include "AutoTest.h"
+
+
+class BenchVector : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fill_data();
+    void fill();
+
+    void checkCurveIntersections_data();
+    void checkCurveIntersections();
+};
+
+DECLARE_TEST( BenchVector );
+
+#endif // BENCH_VECTOR_H
@@ -0,0 +1,137 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+// Runs the benchmarks and writes their results to a json file, to compare builds:
+//
+//   benchmarks -json results.json
+//   benchmarks -json results.json -iterations 10 paintBitmapComposite
+//
+// Other arguments are passed to every QTest run (-callgrind, -tickcounter, function names...)
+// Drawing input recorded in the app is replayed too, from the folder in PENCIL2D_INPUT_RECORDINGS.
+
+#include <algorithm>
+#include <QApplication>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QXmlStreamReader>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include "AutoTest.h"
+
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+
+
+namespace
+{
+// The BenchmarkResult elements of a QTest xml log
+void readBenchmarkResults( const QString& xmlPath, const QString& benchName, QJsonArray& results )
+{
+    QFile file( xmlPath );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        return;
+    }
+
+    QString functionName;
+    QXmlStreamReader xml( &file );
+    while ( !xml.atEnd() )
+    {
+        if ( xml.readNext() != QXmlStreamReader::StartElement )
+        {
+            continue;
+        }
+
+        QXmlStreamAttributes attributes = xml.attributes();
+        if ( xml.name() == "TestFunction" )
+        {
+            functionName = attributes.value( "name" ).toString();
+        }
+        else if ( xml.name() == "BenchmarkResult" )
+        {
+            // The value is the total of all the iterations
+            double value = attributes.value( "value" ).toDouble();
+            int iterations = std::max( attributes.value( "iterations" ).toInt(), 1 );
+
+            QJsonObject result;
+            result[ "benchmark" ] = benchName;
+            result[ "function" ] = functionName;
+            result[ "tag" ] = attributes.value( "tag" ).toString();
+            result[ "metric" ] = attributes.value( "metric" ).toString();
+            result[ "value" ] = value / iterations;
+            result[ "iterations" ] = iterations;
+            results.append( result );
+        }
+    }
+}
+}
+
+
+int main( int argc, char* argv[] )
+{
+    QApplication app( argc, argv );
+    app.setAttribute( Qt::AA_Use96Dpi, true );
+
+    QStringList arguments = app.arguments();
+    QString jsonPath = "benchmarks.json";
+    int jsonIndex = arguments.indexOf( "-json" );
+    if ( jsonIndex > 0 && jsonIndex + 1 < arguments.size() )
+    {
+        jsonPath = arguments[ jsonIndex + 1 ];
+        arguments.erase( arguments.begin() + jsonIndex, arguments.begin() + jsonIndex + 2 );
+    }
+
+    QTemporaryDir logDir;
+    QJsonArray results;
+    int ret = 0;
+    for ( QObject* bench : AutoTest::testList() )
+    {
+        // Readable results on the console, the xml log is for the json file
+        QString xmlPath = logDir.path() + "/" + bench->objectName() + ".xml";
+        QStringList benchArguments = arguments;
+        benchArguments << "-o" << "-,txt" << "-o" << xmlPath + ",xml";
+
+        ret += QTest::qExec( bench, benchArguments );
+        readBenchmarkResults( xmlPath, bench->objectName(), results );
+    }
+
+    QJsonObject build;
+    build[ "qtVersion" ] = QString( qVersion() );
+    build[ "abi" ] = QSysInfo::buildAbi();
+    build[ "os" ] = QSysInfo::prettyProductName();
+#ifdef GIT_EXISTS
+    build[ "commit" ] = QString( TOSTRING( GIT_CURRENT_SHA1 ) );
+#endif
+
+    QJsonObject root;
+    root[ "build" ] = build;
+    root[ "date" ] = QDateTime::currentDateTimeUtc().toString( Qt::ISODate );
+    root[ "results" ] = results;
+
+    QFile jsonFile( jsonPath );
+    if ( !jsonFile.open( QIODevice::WriteOnly ) )
+    {
+        qWarning() << "Cannot write the results to" << jsonPath;
+        return 1;
+    }
+    jsonFile.write( QJsonDocument( root ).toJson() );
+    qDebug() << "\nResults written to" << jsonPath;
+
+    return ret;
+}
@@ -0,0 +1,223 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "projectgenerator.h"
+
+#include <algorithm>
+#include <QtMath>
+#include <QImage>
+#include <QPainter>
+#include <QPainterPath>
+#include <QTabletEvent>
+#include "object.h"
+#include "layerbitmap.h"
+#include "layervector.h"
+#include "bitmapimage.h"
+#include "vectorimage.h"
+#include "beziercurve.h"
+#include "layer.h"
+
+
+namespace
+{
+// The camera of a new project
+const QRectF CANVAS_AREA( -320, -240, 640, 480 );
+
+qreal uniform( std::mt19937& random, qreal from, qreal to )
+{
+    return std::uniform_real_distribution< qreal >( from, to )( random );
+}
+
+Object* createEmptyProject()
+{
+    Object* object = new Object;
+    object->init();
+
+    // Keep the camera layer only
+    while ( object->getLayerCount() > 1 )
+    {
+        object->deleteLayer( object->getLayerCount() - 1 );
+    }
+    return object;
+}
+}
+
+
+namespace ProjectGenerator
+{
+
+Object* createBitmapProject( int layerCount, int frameCount, QSize frameSize, unsigned int seed )
+{
+    std::mt19937 random( seed );
+    Object* object = createEmptyProject();
+
+    QRect bounds( QPoint( -frameSize.width() / 2, -frameSize.height() / 2 ), frameSize );
+    for ( int i = 0; i < layerCount; ++i )
+    {
+        LayerBitmap* layer = object->addNewBitmapLayer();
+        layer->removeKeyFrame( 1 );
+        for ( int frame = 1; frame <= frameCount; ++frame )
+        {
+            layer->addKeyFrame( frame, createScribbleImage( bounds, 20, random ) );
+        }
+    }
+    return object;
+}
+
+Object* createVectorProject( int layerCount, int frameCount, int curvesPerFrame, unsigned int seed )
+{
+    std::mt19937 random( seed );
+    Object* object = createEmptyProject();
+
+    for ( int i = 0; i < layerCount; ++i )
+    {
+        LayerVector* layer = object->addNewVectorLayer();
+        layer->removeKeyFrame( 1 );
+        for ( int frame = 1; frame <= frameCount; ++frame )
+        {
+            VectorImage* image = new VectorImage;
+            image->setObject( object );
+            for ( int c = 0; c < curvesPerFrame; ++c )
+            {
+                QList< QPointF > points = createStrokePoints( CANVAS_AREA, 32, random );
+                QList< qreal > pressures;
+                for ( int p = 0; p < points.size(); ++p )
+                {
+                    pressures << uniform( random, 0.3, 1.0 );
+                }
+                BezierCurve curve( points, pressures, 1.0 );
+                curve.setWidth( uniform( random, 1.0, 6.0 ) );
+                curve.setColourNumber( c % object->getColourCount() );
+                image->addCurve( curve, 1.0, false );
+            }
+            layer->addKeyFrame( frame, image );
+        }
+    }
+    return object;
+}
+
+BitmapImage* createScribbleImage( QRect bounds, int strokeCount, std::mt19937& random )
+{
+    QImage image( bounds.size(), QImage::Format_ARGB32_Premultiplied );
+    image.fill( Qt::transparent );
+
+    QPainter painter( &image );
+    painter.setRenderHint( QPainter::Antialiasing, true );
+    painter.translate( -bounds.topLeft() );
+    for ( int i = 0; i < strokeCount; ++i )
+    {
+        QList< QPointF > points = createStrokePoints( bounds, 32, random );
+        QPainterPath path( points.first() );
+        for ( const QPointF& point : points )
+        {
+            path.lineTo( point );
+        }
+        QColor colour = QColor::fromHsv( int( uniform( random, 0, 359 ) ), 200, 160 );
+        painter.setPen( QPen( colour, uniform( random, 1.0, 12.0 ), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin ) );
+        painter.drawPath( path );
+    }
+    painter.end();
+
+    return new BitmapImage( bounds, image );
+}
+
+VectorImage* createCurveGrid( int cellCount, QRectF area )
+{
+    VectorImage* image = new VectorImage;
+
+    qreal cellWidth = area.width() / cellCount;
+    qreal cellHeight = area.height() / cellCount;
+    for ( int i = 0; i <= cellCount; ++i )
+    {
+        qreal x = area.left() + i * cellWidth;
+        qreal y = area.top() + i * cellHeight;
+
+        BezierCurve horizontal( QList< QPointF >() << QPointF( area.left(), y ) << QPointF( area.right(), y ) );
+        BezierCurve vertical( QList< QPointF >() << QPointF( x, area.top() ) << QPointF( x, area.bottom() ) );
+        image->addCurve( horizontal, 1.0, true );
+        image->addCurve( vertical, 1.0, true );
+    }
+    return image;
+}
+
+QList< QPointF > createStrokePoints( QRectF area, int pointCount, std::mt19937& random )
+{
+    QList< QPointF > points;
+
+    QPointF point( uniform( random, area.left(), area.right() ), uniform( random, area.top(), area.bottom() ) );
+    qreal angle = uniform( random, 0, 2 * M_PI );
+    qreal step = std::max( area.width(), area.height() ) / pointCount / 2;
+    for ( int i = 0; i < pointCount; ++i )
+    {
+        points << point;
+
+        angle += uniform( random, -0.4, 0.4 );
+        point += QPointF( std::cos( angle ), std::sin( angle ) ) * step;
+        point.setX( qBound( area.left(), point.x(), area.right() ) );
+        point.setY( qBound( area.top(), point.y(), area.bottom() ) );
+    }
+    return points;
+}
+
+StrokeRecording createStrokeRecording( ToolType tool, const Properties& properties, int strokeCount,
+                                       QSize canvasSize, std::mt19937& random )
+{
+    const qint64 TABLET_INTERVAL = 5000; // microseconds
+
+    StrokeRecording recording;
+    qint64 time = 0;
+    for ( int i = 0; i < strokeCount; ++i )
+    {
+        RecordedStroke stroke;
+        stroke.tool = tool;
+        stroke.properties = properties;
+        stroke.colour = QColor::fromHsv( int( uniform( random, 0, 359 ) ), 200, 160 );
+        stroke.layerType = Layer::BITMAP;
+        stroke.canvasSize = canvasSize;
+
+        QList< QPointF > points = createStrokePoints( QRectF( QPointF( 0, 0 ), canvasSize ), 120, random );
+        for ( int p = 0; p < points.size(); ++p )
+        {
+            bool isFirst = ( p == 0 );
+            bool isLast = ( p == points.size() - 1 );
+
+            RecordedInputEvent tabletEvent;
+            tabletEvent.type = isFirst ? QEvent::TabletPress : ( isLast ? QEvent::TabletRelease : QEvent::TabletMove );
+            tabletEvent.time = time;
+            tabletEvent.pos = points[ p ];
+            tabletEvent.pressure = 0.3 + 0.6 * std::sin( M_PI * p / ( points.size() - 1 ) );
+            tabletEvent.button = ( isFirst || isLast ) ? Qt::LeftButton : Qt::NoButton;
+            tabletEvent.buttons = isLast ? Qt::NoButton : Qt::LeftButton;
+            tabletEvent.device = QTabletEvent::Stylus;
+            tabletEvent.pointerType = QTabletEvent::Pen;
+
+            // And the mouse event Qt makes of it
+            RecordedInputEvent mouseEvent = tabletEvent;
+            mouseEvent.type = isFirst ? QEvent::MouseButtonPress : ( isLast ? QEvent::MouseButtonRelease : QEvent::MouseMove );
+            mouseEvent.pressure = 1.0;
+            mouseEvent.device = 0;
+            mouseEvent.pointerType = 0;
+
+            stroke.events << tabletEvent << mouseEvent;
+            time += TABLET_INTERVAL;
+        }
+        recording.strokes << stroke;
+        time += 200 * 1000;
+    }
+    return recording;
+}
+
+}
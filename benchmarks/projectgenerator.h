@@ -0,0 +1,52 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef PROJECTGENERATOR_H
+#define PROJECTGENERATOR_H
+
+#include <random>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+#include "strokerecording.h"
+
+class Object;
+class BitmapImage;
+class VectorImage;
+
+
+// Synthetic projects for the benchmarks. The content only depends on the
+// arguments and the seed, so that timings of different builds compare.
+namespace ProjectGenerator
+{
+    // A camera layer and layerCount drawing layers, with a key on every frame
+    Object* createBitmapProject( int layerCount, int frameCount, QSize frameSize, unsigned int seed = 1 );
+    Object* createVectorProject( int layerCount, int frameCount, int curvesPerFrame, unsigned int seed = 1 );
+
+    BitmapImage* createScribbleImage( QRect bounds, int strokeCount, std::mt19937& random );
+    // cellCount x cellCount closed cells, the curves cut each other at the corners
+    VectorImage* createCurveGrid( int cellCount, QRectF area );
+
+    // A wobbly stroke, as drawn with a tablet
+    QList< QPointF > createStrokePoints( QRectF area, int pointCount, std::mt19937& random );
+
+    // Tablet strokes across the canvas, as ScribbleArea receives them from a 200Hz tablet
+    StrokeRecording createStrokeRecording( ToolType tool, const Properties& properties, int strokeCount,
+                                           QSize canvasSize, std::mt19937& random );
+}
+
+#endif // PROJECTGENERATOR_H
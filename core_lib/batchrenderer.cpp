@@ -0,0 +1,280 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "batchrenderer.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QImage>
+#include <QPainter>
+#include <QDir>
+#include <QFileInfo>
+#include "object.h"
+#include "layercamera.h"
+#include "filemanager.h"
+#include "util.h"
+#include "tracer.h"
+
+
+namespace
+{
+// Loading a copy of the project costs about as much as rendering a few frames,
+// so runs aren't split smaller than this.
+const int MIN_FRAMES_PER_RUN = 8;
+
+class RunTask : public QRunnable
+{
+public:
+    explicit RunTask( std::function< void() > f ) : mFunction( f ) {}
+    void run() override { mFunction(); }
+
+private:
+    std::function< void() > mFunction;
+};
+
+QString extensionOf( const QString& format )
+{
+    QString extension = format.toLower();
+    if ( extension == "jpeg" )
+    {
+        extension = "jpg";
+    }
+    return extension;
+}
+}
+
+
+BatchRenderer::BatchRenderer()
+{
+    mThreadCount = std::max( QThread::idealThreadCount(), 1 );
+}
+
+Status BatchRenderer::run( const std::vector< BatchRenderJob >& jobs, std::function< void( int, int ) > progress )
+{
+    TRACE_SCOPE( "BatchRenderer::run" );
+
+    mCanceled = false;
+    mFramesDone = 0;
+    mErrors.clear();
+    mProgress = progress;
+
+    std::vector< Run > runs;
+    for ( size_t i = 0; i < jobs.size(); ++i )
+    {
+        Status st = planJob( jobs[ i ], static_cast< int >( i ), runs );
+        if ( !st.ok() )
+        {
+            addError( st, jobs[ i ] );
+        }
+    }
+
+    mFramesTotal = 0;
+    for ( const Run& run : runs )
+    {
+        mFramesTotal += run.endFrame - run.startFrame + 1;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount( mThreadCount );
+    for ( const Run& run : runs )
+    {
+        const BatchRenderJob& job = jobs[ run.jobIndex ];
+        pool.start( new RunTask( [this, &job, run]
+        {
+            Status st = renderRun( job, run );
+            if ( !st.ok() )
+            {
+                addError( st, job );
+            }
+        } ) );
+    }
+    pool.waitForDone();
+
+    if ( mCanceled )
+    {
+        return Status::CANCELED;
+    }
+    if ( !mErrors.isEmpty() )
+    {
+        return Status( Status::FAIL, mErrors, QObject::tr( "Rendering failed" ),
+                       QObject::tr( "Some of the frames could not be rendered." ) );
+    }
+    return Status::OK;
+}
+
+QString BatchRenderer::frameFileName( const BatchRenderJob& job, int frame, const QString& format )
+{
+    return QString( "%1%2.%3" ).arg( job.outputPath ).arg( frame, 4, 10, QChar( '0' ) ).arg( extensionOf( format ) );
+}
+
+Status BatchRenderer::planJob( const BatchRenderJob& job, int jobIndex, std::vector< Run >& runs )
+{
+    if ( job.formats.isEmpty() || ( !job.exportSize.isValid() && job.scale <= 0 ) )
+    {
+        return Status::INVALID_ARGUMENT;
+    }
+
+    Status st;
+    Object* object = loadProject( job.projectPath, st );
+    if ( object == nullptr )
+    {
+        return st;
+    }
+
+    bool hasCamera = job.cameraName.isEmpty() || findCamera( object, job.cameraName ) != nullptr;
+    int lastFrame = object->getMaxKeyFramePosition();
+    deleteProject( object );
+
+    if ( !hasCamera )
+    {
+        return Status( Status::INVALID_ARGUMENT, QStringList(), QObject::tr( "Camera not found" ),
+                       QObject::tr( "There is no camera layer named \"%1\"." ).arg( job.cameraName ) );
+    }
+
+    int startFrame = std::max( job.startFrame, 1 );
+    int endFrame = ( job.endFrame > 0 ) ? job.endFrame : std::max( lastFrame, 1 );
+    if ( endFrame < startFrame )
+    {
+        return Status::ERROR_INVALID_FRAME_NUMBER;
+    }
+
+    // Contiguous runs, so that every copy of the project only decodes its own key frames
+    int frameCount = endFrame - startFrame + 1;
+    int runCount = std::max( 1, std::min( mThreadCount, frameCount / MIN_FRAMES_PER_RUN ) );
+    for ( int i = 0; i < runCount; ++i )
+    {
+        Run run;
+        run.jobIndex = jobIndex;
+        run.startFrame = startFrame + frameCount * i / runCount;
+        run.endFrame = startFrame + frameCount * ( i + 1 ) / runCount - 1;
+        runs.push_back( run );
+    }
+    return Status::OK;
+}
+
+Status BatchRenderer::renderRun( const BatchRenderJob& job, const Run& run )
+{
+    TRACE_SCOPE( "BatchRenderer::renderRun" );
+
+    Status st;
+    Object* object = loadProject( job.projectPath, st );
+    if ( object == nullptr )
+    {
+        return st;
+    }
+
+    LayerCamera* camera = findCamera( object, job.cameraName );
+    if ( camera != nullptr )
+    {
+        camera->cacheViews( run.startFrame, run.endFrame );
+    }
+
+    // Old .pcl files may not have a camera layer
+    QRect viewRect = ( camera != nullptr ) ? camera->getViewRect() : QRect( QPoint( -320, -240 ), QSize( 640, 480 ) );
+    QSize exportSize = job.exportSize.isValid() ? job.exportSize : ( QSizeF( viewRect.size() ) * job.scale ).toSize();
+
+    QStringList failedFiles;
+    for ( int frame = run.startFrame; frame <= run.endFrame && !mCanceled; ++frame )
+    {
+        QImage image( exportSize, QImage::Format_ARGB32_Premultiplied );
+        image.fill( job.transparency ? Qt::transparent : Qt::white );
+
+        QPainter painter( &image );
+        if ( camera != nullptr )
+        {
+            QTransform centralizeCamera;
+            centralizeCamera.translate( viewRect.width() / 2, viewRect.height() / 2 );
+            painter.setWorldTransform( camera->getViewAtFrame( frame ) * centralizeCamera );
+            painter.setWindow( QRect( QPoint( 0, 0 ), viewRect.size() ) );
+        }
+        else
+        {
+            painter.setWorldTransform( RectMapTransform( viewRect, QRectF( QPointF( 0, 0 ), exportSize ) ) );
+        }
+        object->paintImage( painter, frame, false, job.antialiasing );
+        painter.end();
+
+        for ( const QString& format : job.formats )
+        {
+            QImage output = image;
+            if ( job.transparency && extensionOf( format ) == "jpg" )
+            {
+                // No alpha in jpg, flatten on the default white background
+                output = QImage( exportSize, QImage::Format_RGB32 );
+                output.fill( Qt::white );
+                QPainter flatten( &output );
+                flatten.drawImage( 0, 0, image );
+            }
+
+            QString fileName = frameFileName( job, frame, format );
+            if ( !output.save( fileName, format.toUpper().toLatin1().constData(), job.quality ) )
+            {
+                failedFiles << fileName;
+            }
+        }
+
+        int done = ++mFramesDone;
+        if ( mProgress )
+        {
+            mProgress( done, mFramesTotal );
+        }
+    }
+
+    deleteProject( object );
+
+    if ( !failedFiles.isEmpty() )
+    {
+        return Status( Status::FAIL, failedFiles, QObject::tr( "Cannot write the frames" ) );
+    }
+    return Status::OK;
+}
+
+Object* BatchRenderer::loadProject( const QString& projectPath, Status& status )
+{
+    QMutexLocker locker( &mProjectMutex );
+
+    FileManager fileManager;
+    Object* object = fileManager.load( projectPath );
+    status = ( object != nullptr ) ? Status( Status::OK ) : fileManager.error();
+    return object;
+}
+
+void BatchRenderer::deleteProject( Object* object )
+{
+    // The destructor removes the working folder
+    QMutexLocker locker( &mProjectMutex );
+    delete object;
+}
+
+LayerCamera* BatchRenderer::findCamera( Object* object, const QString& cameraName )
+{
+    if ( !cameraName.isEmpty() )
+    {
+        return static_cast< LayerCamera* >( object->findLayerByName( cameraName, Layer::CAMERA ) );
+    }
+
+    std::vector< LayerCamera* > cameras = object->getLayersByType< LayerCamera >();
+    return cameras.empty() ? nullptr : cameras.front();
+}
+
+void BatchRenderer::addError( Status status, const BatchRenderJob& job )
+{
+    QMutexLocker locker( &mErrorMutex );
+    mErrors << QString( "%1: %2" ).arg( job.projectPath ).arg( status.title() );
+    mErrors << status.detailsList();
+}
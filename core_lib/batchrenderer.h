@@ -0,0 +1,95 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <QString>
+#include <QStringList>
+#include <QSize>
+#include <QMutex>
+#include "pencilerror.h"
+
+class Object;
+class LayerCamera;
+
+
+struct BatchRenderJob
+{
+    QString     projectPath;
+    QString     outputPath;           // frames go to <outputPath>0001.png, <outputPath>0002.png...
+    QStringList formats{ "PNG" };     // every frame is written once per format
+    int         startFrame = 1;
+    int         endFrame   = -1;      // -1 renders up to the last key frame
+    QString     cameraName;           // the first camera layer when empty
+    qreal       scale      = 1.0;     // of the camera size
+    QSize       exportSize;           // overrides the scale when valid
+    bool        transparency = false;
+    bool        antialiasing = true;
+    int         quality      = -1;
+};
+
+// Renders image sequences of one or more projects without any widget,
+// so it runs on machines without a display.
+//
+// Each job is split in runs of frames rendered on a thread pool. Painting
+// a project isn't thread safe (vector areas and mip levels are updated
+// while painting), so every run paints its own copy of the project.
+class BatchRenderer
+{
+public:
+    BatchRenderer();
+
+    void setThreadCount( int count ) { mThreadCount = std::max( count, 1 ); }
+    int  threadCount() const { return mThreadCount; }
+
+    // progress( framesDone, framesTotal ) is called from the render threads
+    Status run( const std::vector< BatchRenderJob >& jobs, std::function< void( int, int ) > progress );
+    void   cancel() { mCanceled = true; }
+
+    static QString frameFileName( const BatchRenderJob& job, int frame, const QString& format );
+
+private:
+    struct Run
+    {
+        int jobIndex;
+        int startFrame;
+        int endFrame;
+    };
+
+    Status  planJob( const BatchRenderJob& job, int jobIndex, std::vector< Run >& runs );
+    Status  renderRun( const BatchRenderJob& job, const Run& run );
+    Object* loadProject( const QString& projectPath, Status& status );
+    void    deleteProject( Object* object );
+    LayerCamera* findCamera( Object* object, const QString& cameraName );
+    void    addError( Status status, const BatchRenderJob& job );
+
+    int mThreadCount = 1;
+    std::atomic< bool > mCanceled{ false };
+    std::atomic< int >  mFramesDone{ 0 };
+    int mFramesTotal = 0;
+    std::function< void( int, int ) > mProgress;
+
+    QMutex mProjectMutex; // copies of a project share their working folder
+    QMutex mErrorMutex;
+    QStringList mErrors;
+};
+
+#endif // BATCHRENDERER_H
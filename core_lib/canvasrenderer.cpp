@@ -15,6 +15,7 @@ GNU General Public License for more details.
 */
 
 #include "canvasrenderer.h"
+#include <QPainterPath>
 #include "object.h"
 #include "layerbitmap.h"
 #include "layervector.h"
@@ -22,6 +23,7 @@ GNU General Public License for more details.
 #include "layercamera.h"
 #include "vectorimage.h"
 #include "util.h"
+#include "tracer.h"
 
 
 
@@ -69,13 +71,28 @@ void CanvasRenderer::ignoreTransformedSelection()
     mRenderTransform = false;
 }
 
+void CanvasRenderer::setStrokeBuffer( BitmapImage* buffer, QPainter::CompositionMode mode )
+{
+    mStrokeBuffer = buffer;
+    mStrokeMode = mode;
+}
+
+void CanvasRenderer::ignoreStrokeBuffer()
+{
+    mStrokeBuffer = nullptr;
+}
+
 void CanvasRenderer::paint( Object* object, int layer, int frame, QRect rect )
 {
+    TRACE_SCOPE( "CanvasRenderer::paint" );
+
     Q_ASSERT( object );
     mObject = object;
+    mLayersPainted = 0;
 
     mLayerIndex = layer;
     mFrameNumber = frame;
+    mPaintRect = mCanvas->rect();
 
     QPainter painter( mCanvas );
 
@@ -91,6 +108,43 @@ void CanvasRenderer::paint( Object* object, int layer, int frame, QRect rect )
     painter.setWorldMatrixEnabled( true );
 
     paintBackground();
+    paintLayers( painter );
+}
+
+void CanvasRenderer::repaint( Object* object, int layer, int frame, QRect rect )
+{
+    TRACE_SCOPE( "CanvasRenderer::repaint" );
+
+    Q_ASSERT( object );
+    mObject = object;
+    mLayersPainted = 0;
+
+    mLayerIndex = layer;
+    mFrameNumber = frame;
+    mPaintRect = rect & mCanvas->rect();
+    if ( mPaintRect.isEmpty() )
+    {
+        return;
+    }
+
+    QPainter painter( mCanvas );
+
+    // In canvas pixels, before the view transform
+    painter.setClipRect( mPaintRect );
+    painter.setCompositionMode( QPainter::CompositionMode_Source );
+    painter.fillRect( mPaintRect, Qt::transparent );
+    painter.setCompositionMode( QPainter::CompositionMode_SourceOver );
+
+    painter.setWorldTransform( mViewTransform );
+    painter.setRenderHint( QPainter::SmoothPixmapTransform, mOptions.bAntiAlias );
+    painter.setRenderHint( QPainter::Antialiasing, true );
+    painter.setWorldMatrixEnabled( true );
+
+    paintLayers( painter );
+}
+
+void CanvasRenderer::paintLayers( QPainter& painter )
+{
     paintOnionSkin( painter );
     paintCurrentFrame( painter );
     paintCameraBorder( painter );
@@ -114,6 +168,8 @@ void CanvasRenderer::paintBackground()
 
 void CanvasRenderer::paintOnionSkin( QPainter& painter )
 {
+    TRACE_SCOPE( "CanvasRenderer::paintOnionSkin" );
+
     Layer* layer = mObject->getLayer( mLayerIndex );
 
     if ( layer->keyFrameCount() == 0 )
@@ -198,6 +254,9 @@ void CanvasRenderer::paintBitmapFrame( QPainter& painter,
         return;
     }
 
+    TRACE_SCOPE( "CanvasRenderer::paintBitmapFrame" );
+    mLayersPainted += 1;
+
     LayerBitmap* bitmapLayer = dynamic_cast< LayerBitmap* >( layer );
     if ( bitmapLayer == nullptr )
     {
@@ -219,6 +278,24 @@ void CanvasRenderer::paintBitmapFrame( QPainter& painter,
         return;
     }
 
+    bool isTransformed = mRenderTransform && nFrame == mFrameNumber && layerId == mLayerIndex;
+
+    // Painting the key frame itself reuses its mip levels when zoomed out
+    if ( !colorize && !isTransformed )
+    {
+        painter.setWorldMatrixEnabled( true );
+        if (mRenderTransform && nFrame) {
+            painter.setOpacity( bitmapLayer->getOpacity() );
+        }
+        if ( mStrokeBuffer != nullptr && useLastKeyFrame && nFrame == mFrameNumber && layerId == mLayerIndex )
+        {
+            paintStrokeBuffer( painter, bitmapImage );
+            return;
+        }
+        bitmapImage->paintImage( painter );
+        return;
+    }
+
     BitmapImage* tempBitmapImage = new BitmapImage;
     tempBitmapImage->paste(bitmapImage);
 
@@ -244,7 +321,7 @@ void CanvasRenderer::paintBitmapFrame( QPainter& painter,
 
     // If the current frame on the current layer has a transformation, we apply it.
     //
-    if (mRenderTransform && nFrame == mFrameNumber && layerId == mLayerIndex ) {
+    if ( isTransformed ) {
         tempBitmapImage->clear(mSelection);
         paintTransformedSelection(painter);
     }
@@ -260,6 +337,45 @@ void CanvasRenderer::paintBitmapFrame( QPainter& painter,
     delete tempBitmapImage;
 }
 
+// Paints the key frame as it will be once the stroke is committed to it
+void CanvasRenderer::paintStrokeBuffer( QPainter& painter, BitmapImage* keyFrame )
+{
+    TRACE_SCOPE( "CanvasRenderer::paintStrokeBuffer" );
+
+    if ( mStrokeMode == QPainter::CompositionMode_SourceOver )
+    {
+        keyFrame->paintImage( painter );
+        mStrokeBuffer->paintImage( painter );
+        return;
+    }
+
+    // Erasing or preserving alpha changes the pixels of the key frame under the
+    // stroke. Those within the part of the canvas being painted are composited
+    // aside and painted in place of the key frame's.
+    QRect visibleRect = painter.worldTransform().inverted().mapRect( mPaintRect ).adjusted( -1, -1, 1, 1 );
+    QRect strokeRect = mStrokeBuffer->bounds() & keyFrame->bounds() & visibleRect;
+    if ( strokeRect.isEmpty() )
+    {
+        keyFrame->paintImage( painter );
+        return;
+    }
+
+    BitmapImage patch = keyFrame->copy( strokeRect );
+    BitmapImage stroke = mStrokeBuffer->copy( strokeRect );
+    patch.paste( &stroke, mStrokeMode );
+
+    QPainterPath outside; // odd-even filled, the stroke is a hole in the key frame
+    outside.addRect( keyFrame->bounds() );
+    outside.addRect( strokeRect );
+
+    painter.save();
+    painter.setClipPath( outside, Qt::IntersectClip );
+    keyFrame->paintImage( painter );
+    painter.restore();
+
+    patch.paintImage( painter );
+}
+
 void CanvasRenderer::paintVectorFrame( QPainter& painter,
                                        int layerId,
                                        int nFrame,
@@ -273,6 +389,9 @@ void CanvasRenderer::paintVectorFrame( QPainter& painter,
         return;
     }
 
+    TRACE_SCOPE( "CanvasRenderer::paintVectorFrame" );
+    mLayersPainted += 1;
+
     LayerVector* vectorLayer = dynamic_cast< LayerVector* >( layer );
     if ( vectorLayer == nullptr )
     {
@@ -295,19 +414,14 @@ void CanvasRenderer::paintVectorFrame( QPainter& painter,
         return;
     }
 
-    QImage* pImage = new QImage( mCanvas->size(), QImage::Format_ARGB32_Premultiplied );
-    vectorImage->outputImage( pImage, mViewTransform, mOptions.bOutlines, mOptions.bThinLines, mOptions.bAntiAlias );
-
-
-    //painter.drawImage( QPoint( 0, 0 ), *pImage );
-
-    // Go through a Bitmap image to paint the onion skin colour
-    //
-    BitmapImage* tempBitmapImage = new BitmapImage();
-    tempBitmapImage->setImage(pImage);
+    // Kept by the key frame, painted again only where it changed
+    const QImage& raster = vectorImage->rasterImage( mViewTransform, mCanvas->size(),
+                                                     mOptions.bOutlines, mOptions.bThinLines, mOptions.bAntiAlias );
 
+    painter.setWorldMatrixEnabled( false ); //Don't tranform the image here as we used the viewTransform in the image output
     if ( colorize )
     {
+        // The onion skin colour goes on a copy
         QBrush colorBrush = QBrush(Qt::transparent); //no color for the current frame
 
         if (nFrame < mFrameNumber)
@@ -319,17 +433,17 @@ void CanvasRenderer::paintVectorFrame( QPainter& painter,
             colorBrush = QBrush(Qt::blue);
         }
 
-        tempBitmapImage->drawRect(  pImage->rect(),
-                                    Qt::NoPen,
-                                    colorBrush,
-                                    QPainter::CompositionMode_SourceIn,
-                                    false);
+        QImage colorized = raster;
+        QPainter colorPainter( &colorized );
+        colorPainter.setCompositionMode( QPainter::CompositionMode_SourceIn );
+        colorPainter.fillRect( colorized.rect(), colorBrush );
+        colorPainter.end();
+        painter.drawImage( QPoint( 0, 0 ), colorized );
+    }
+    else
+    {
+        painter.drawImage( QPoint( 0, 0 ), raster );
     }
-
-    painter.setWorldMatrixEnabled( false ); //Don't tranform the image here as we used the viewTransform in the image output
-    tempBitmapImage->paintImage( painter );
-
-    delete tempBitmapImage;
 }
 
 void CanvasRenderer::paintTransformedSelection( QPainter& painter )
@@ -360,6 +474,8 @@ void CanvasRenderer::paintTransformedSelection( QPainter& painter )
 
 void CanvasRenderer::paintCurrentFrame( QPainter& painter )
 {
+    TRACE_SCOPE( "CanvasRenderer::paintCurrentFrame" );
+
     bool isCamera = mObject->getLayer(mLayerIndex)->type() == Layer::CAMERA;
     for ( int i = 0; i < mObject->getLayerCount(); ++i )
     {
@@ -27,6 +27,7 @@ GNU General Public License for more details.
 
 class Object;
 class Layer;
+class BitmapImage;
 
 
 struct RenderOptions
@@ -63,17 +64,25 @@ public:
     void setOptions( RenderOptions p ) { mOptions = p; }
     void setTransformedSelection( QRect selection, QTransform transform );
     void ignoreTransformedSelection();
+    // A stroke in progress on the current bitmap frame, composited over it with mode
+    void setStrokeBuffer( BitmapImage* buffer, QPainter::CompositionMode mode );
+    void ignoreStrokeBuffer();
     QRect getCameraRect();
+    int layersPainted() const { return mLayersPainted; } // by the last paint()
 
     void paint( Object* object, int layer, int frame, QRect rect );
+    // Only rect of the canvas, the rest stays as it was painted last
+    void repaint( Object* object, int layer, int frame, QRect rect );
 
 private:
+    void paintLayers( QPainter& painter );
     void paintBackground();
     void paintOnionSkin( QPainter& painter );
     void paintCurrentFrame( QPainter& painter );
 
     void paintBitmapFrame( QPainter&, int layerId, int nFrame, bool colorize = false , bool useLastKeyFrame = true );
     void paintVectorFrame(QPainter&, int layerId, int nFrame, bool colorize = false , bool useLastKeyFrame = true );
+    void paintStrokeBuffer( QPainter&, BitmapImage* keyFrame );
 
     void paintTransformedSelection( QPainter& painter );
     void paintGrid( QPainter& painter );
@@ -88,6 +97,7 @@ private:
 
     int mLayerIndex = 0;
     int mFrameNumber = 0;
+    int mLayersPainted = 0;
 
     bool bMultiLayerOnionSkin = false;
     
@@ -99,6 +109,10 @@ private:
     QRect mSelection;
     QTransform mSelectionTransform;
 
+    BitmapImage* mStrokeBuffer = nullptr;
+    QPainter::CompositionMode mStrokeMode = QPainter::CompositionMode_SourceOver;
+    QRect mPaintRect; // of the canvas, being painted
+
     QLoggingCategory mLog;
 
 };
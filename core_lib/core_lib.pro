@@ -31,10 +31,15 @@ INCLUDEPATH += . \
 # Input
 HEADERS +=  \
     graphics/bitmap/bitmapimage.h \
+    graphics/bitmap/bitmapresidency.h \
+    graphics/bitmap/colorsampler.h \
+    graphics/bitmap/smudgekernel.h \
+    graphics/bitmap/strokerasterizer.h \
     graphics/vector/bezierarea.h \
     graphics/vector/beziercurve.h \
     graphics/vector/colourref.h \
     graphics/vector/vectorimage.h \
+    graphics/vector/vectorrastercache.h \
     graphics/vector/vectorselection.h \
     graphics/vector/vertexref.h \
     interface/backupelement.h \
@@ -58,6 +63,7 @@ HEADERS +=  \
     managers/preferencemanager.h \
     managers/soundmanager.h \
     structure/camera.h \
+    structure/camerapath.h \
     structure/keyframe.h \
     structure/layer.h \
     structure/layerbitmap.h \
@@ -66,9 +72,14 @@ HEADERS +=  \
     structure/layervector.h \
     structure/keyframefactory.h \
     structure/soundclip.h \
+    structure/soundtimeline.h \
     structure/object.h \
     structure/objectdata.h \
     structure/filemanager.h \
+    structure/pclxreader.h \
+    structure/binaryprojectfile.h \
+    structure/projectsnapshot.h \
+    structure/backgroundsaver.h \
     tool/basetool.h \
     tool/brushtool.h \
     tool/buckettool.h \
@@ -82,6 +93,8 @@ HEADERS +=  \
     tool/selecttool.h \
     tool/smudgetool.h \
     tool/strokemanager.h \
+    tool/strokerecording.h \
+    tool/strokereplayer.h \
     tool/stroketool.h \
     util/blitrect.h \
     util/fileformat.h \
@@ -90,16 +103,25 @@ HEADERS +=  \
     util/pencilsettings.h \
     util/util.h \
     util/log.h \
+    util/tracer.h \
     canvasrenderer.h \
+    playbackcache.h \
     soundplayer.h \
-    movieexporter.h
+    movieexporter.h \
+    batchrenderer.h \
+    thumbnailcache.h
 
 
 SOURCES +=  graphics/bitmap/bitmapimage.cpp \
+    graphics/bitmap/bitmapresidency.cpp \
+    graphics/bitmap/colorsampler.cpp \
+    graphics/bitmap/smudgekernel.cpp \
+    graphics/bitmap/strokerasterizer.cpp \
     graphics/vector/bezierarea.cpp \
     graphics/vector/beziercurve.cpp \
     graphics/vector/colourref.cpp \
     graphics/vector/vectorimage.cpp \
+    graphics/vector/vectorrastercache.cpp \
     graphics/vector/vectorselection.cpp \
     graphics/vector/vertexref.cpp \
     interface/editor.cpp \
@@ -121,6 +143,7 @@ SOURCES +=  graphics/bitmap/bitmapimage.cpp \
     managers/playbackmanager.cpp \
     managers/viewmanager.cpp \
     structure/camera.cpp \
+    structure/camerapath.cpp \
     structure/keyframe.cpp \
     structure/layer.cpp \
     structure/layerbitmap.cpp \
@@ -130,8 +153,13 @@ SOURCES +=  graphics/bitmap/bitmapimage.cpp \
     structure/object.cpp \
     structure/keyframefactory.cpp \
     structure/soundclip.cpp \
+    structure/soundtimeline.cpp \
     structure/objectdata.cpp \
     structure/filemanager.cpp \
+    structure/pclxreader.cpp \
+    structure/binaryprojectfile.cpp \
+    structure/projectsnapshot.cpp \
+    structure/backgroundsaver.cpp \
     tool/basetool.cpp \
     tool/brushtool.cpp \
     tool/buckettool.cpp \
@@ -145,16 +173,22 @@ SOURCES +=  graphics/bitmap/bitmapimage.cpp \
     tool/selecttool.cpp \
     tool/smudgetool.cpp \
     tool/strokemanager.cpp \
+    tool/strokerecording.cpp \
+    tool/strokereplayer.cpp \
     tool/stroketool.cpp \
     util/blitrect.cpp \
     util/fileformat.cpp \
     util/pencilerror.cpp \
     util/pencilsettings.cpp \
     util/util.cpp \
+    util/tracer.cpp \
     canvasrenderer.cpp \
+    playbackcache.cpp \
     soundplayer.cpp \
     managers/soundmanager.cpp \
-    movieexporter.cpp
+    movieexporter.cpp \
+    batchrenderer.cpp \
+    thumbnailcache.cpp
 
 VERSION = 0.5.4
 DEFINES += APP_VERSION=\\\"$$VERSION\\\"
@@ -15,19 +15,67 @@ GNU General Public License for more details.
 
 */
 #include <cmath>
+#include <QBuffer>
+#include <QImageReader>
 #include "bitmapimage.h"
+#include "bitmapresidency.h"
+#include "smudgekernel.h"
 #include "util.h"
 
+
+namespace
+{
+// Averages each 2x2 block of a premultiplied ARGB image into one pixel of dst,
+// at dstTopLeft. The last row and column are repeated when the size is odd.
+void halveInto( const QImage& src, QImage& dst, QPoint dstTopLeft )
+{
+    Q_ASSERT( src.format() == QImage::Format_ARGB32_Premultiplied );
+
+    const int srcWidth = src.width();
+    const int srcHeight = src.height();
+    const int width = std::min( ( srcWidth + 1 ) / 2, dst.width() - dstTopLeft.x() );
+    const int height = std::min( ( srcHeight + 1 ) / 2, dst.height() - dstTopLeft.y() );
+
+    for ( int y = 0; y < height; ++y )
+    {
+        const QRgb* line0 = reinterpret_cast< const QRgb* >( src.constScanLine( 2 * y ) );
+        const QRgb* line1 = reinterpret_cast< const QRgb* >( src.constScanLine( std::min( 2 * y + 1, srcHeight - 1 ) ) );
+        QRgb* out = reinterpret_cast< QRgb* >( dst.scanLine( dstTopLeft.y() + y ) ) + dstTopLeft.x();
+
+        for ( int x = 0; x < width; ++x )
+        {
+            const int x0 = 2 * x;
+            const int x1 = std::min( x0 + 1, srcWidth - 1 );
+            const quint32 p[ 4 ] = { line0[ x0 ], line0[ x1 ], line1[ x0 ], line1[ x1 ] };
+
+            // Two channels at a time, each sum of four fits in 10 bits
+            quint32 rb = 0x00020002;
+            quint32 ag = 0x00020002;
+            for ( quint32 c : p )
+            {
+                rb += c & 0x00ff00ff;
+                ag += ( c >> 8 ) & 0x00ff00ff;
+            }
+            out[ x ] = ( ( rb >> 2 ) & 0x00ff00ff ) | ( ( ( ag >> 2 ) & 0x00ff00ff ) << 8 );
+        }
+    }
+}
+}
+
 BitmapImage::BitmapImage()
 {
     mImage = std::make_shared< QImage >(); // null image
     mBounds = QRect( 0, 0, 0, 0 );
+    BitmapResidency::instance()->touch( this );
 }
 
 BitmapImage::BitmapImage( const BitmapImage& a )
 {
+    const_cast< BitmapImage& >( a ).pageIn();
     mBounds = a.mBounds;
     mImage = std::make_shared< QImage >( *a.mImage );
+    mEncodedImage = a.mEncodedImage;
+    BitmapResidency::instance()->touch( this );
 }
 
 BitmapImage::BitmapImage( const QRect& rectangle, const QColor& colour)
@@ -35,6 +83,7 @@ BitmapImage::BitmapImage( const QRect& rectangle, const QColor& colour)
     mBounds = rectangle;
     mImage = std::make_shared< QImage >( mBounds.size(), QImage::Format_ARGB32_Premultiplied);
     mImage->fill(colour.rgba());
+    BitmapResidency::instance()->touch( this );
 }
 
 BitmapImage::BitmapImage( const QRect& rectangle, const QImage& image )
@@ -46,6 +95,7 @@ BitmapImage::BitmapImage( const QRect& rectangle, const QImage& image )
     {
         qDebug() << "Error instancing bitmapImage.";
     }
+    BitmapResidency::instance()->touch( this );
 }
 
 BitmapImage::BitmapImage( const QString& path, const QPoint& topLeft )
@@ -56,40 +106,196 @@ BitmapImage::BitmapImage( const QString& path, const QPoint& topLeft )
         qDebug() << "ERROR: Image " << path << " not loaded";
     }
     mBounds = QRect( topLeft, mImage->size() );
+    BitmapResidency::instance()->touch( this );
+}
+
+BitmapImage::BitmapImage( const QByteArray& encodedImage, const QPoint& topLeft )
+{
+    mImage = std::make_shared< QImage >(); // decoded by image() when first needed
+    mEncodedImage = encodedImage;
+
+    // Only the image header is read to get the size
+    QBuffer buffer( &mEncodedImage );
+    QImageReader reader( &buffer );
+    QSize size = reader.size();
+    if ( !size.isValid() )
+    {
+        decodeImage();
+        size = mImage->size();
+    }
+    mBounds = QRect( topLeft, size );
+    BitmapResidency::instance()->touch( this );
 }
 
 BitmapImage::~BitmapImage()
 {
+    BitmapResidency::instance()->release( this );
 }
 
 void BitmapImage::setImage( QImage* img )
 {
     Q_CHECK_PTR( img );
+    BitmapResidency::instance()->discardPage( this );
     mImage.reset( img );
+    mEncodedImage.clear();
+    dropMipmaps();
+}
+
+QImage* BitmapImage::image()
+{
+    decodeImage();
+    pageIn();
+    BitmapResidency::instance()->touch( this );
+    return mImage.get();
+}
+
+void BitmapImage::pageIn()
+{
+    if ( mIsPagedOut )
+    {
+        BitmapResidency::instance()->pageIn( this );
+    }
+}
+
+void BitmapImage::decodeImage()
+{
+    if ( mEncodedImage.isEmpty() )
+    {
+        return;
+    }
+
+    mImage = std::make_shared< QImage >( QImage::fromData( mEncodedImage ) );
+    if ( mImage->isNull() )
+    {
+        qDebug() << "ERROR: Image data not decoded";
+    }
+    mEncodedImage.clear();
 }
 
 BitmapImage& BitmapImage::operator=(const BitmapImage& a)
 {
+    const_cast< BitmapImage& >( a ).pageIn();
+    BitmapResidency::instance()->discardPage( this );
     mBounds = a.mBounds;
     mImage = std::make_shared< QImage >( *a.mImage );
+    mEncodedImage = a.mEncodedImage;
+    dropMipmaps();
     return *this;
 }
 
 void BitmapImage::paintImage(QPainter& painter)
 {
-    painter.drawImage(topLeft(), *mImage);
+    qreal scale = 1.0;
+    if ( painter.worldMatrixEnabled() )
+    {
+        scale = std::sqrt( std::abs( painter.combinedTransform().determinant() ) );
+    }
+
+    int level = mipLevelFor( scale );
+    if ( level == 0 )
+    {
+        painter.drawImage(topLeft(), *image());
+        return;
+    }
+
+    // Each pixel of level n covers 2^n x 2^n pixels of the image
+    updateMipmaps( level );
+    const QImage& mip = mMipmaps[ level - 1 ];
+    painter.drawImage( QRectF( topLeft(), QSizeF( mip.size() * ( 1 << level ) ) ), mip );
+}
+
+QImage BitmapImage::mipmap( qreal scale )
+{
+    int level = mipLevelFor( scale );
+    if ( level == 0 )
+    {
+        return *image();
+    }
+    updateMipmaps( level );
+    return mMipmaps[ level - 1 ];
+}
+
+QImage BitmapImage::builtMipmap( qreal scale )
+{
+    int level = std::min( mipLevelFor( scale ), static_cast< int >( mMipmaps.size() ) );
+    if ( level == 0 || !mMipmapDirtyRect.isEmpty() )
+    {
+        return *image();
+    }
+    return mMipmaps[ level - 1 ];
+}
+
+int BitmapImage::mipLevelFor( qreal scale )
+{
+    if ( scale <= 0.0 || scale > 0.5 )
+    {
+        return 0;
+    }
+
+    // Stop before a level gets smaller than a pixel
+    int level = static_cast< int >( std::floor( std::log2( 1.0 / scale ) ) );
+    int maxLevel = 0;
+    QSize size = image()->size();
+    for ( int side = std::min( size.width(), size.height() ); side > 1; side = ( side + 1 ) / 2 )
+    {
+        maxLevel += 1;
+    }
+    return std::min( level, maxLevel );
+}
+
+void BitmapImage::updateMipmaps( int level )
+{
+    QImage* base = image();
+
+    // Resample what changed since the last paint, level by level
+    QRect dirty = mMipmapDirtyRect.intersected( base->rect() );
+    mMipmapDirtyRect = QRect();
+
+    for ( size_t i = 0; i < mMipmaps.size() && !dirty.isEmpty(); ++i )
+    {
+        const QImage& src = ( i == 0 ) ? *base : mMipmaps[ i - 1 ];
+        QImage& dst = mMipmaps[ i ];
+
+        QRect dstRect( QPoint( dirty.left() / 2, dirty.top() / 2 ), QPoint( dirty.right() / 2, dirty.bottom() / 2 ) );
+        QRect srcRect = QRect( dstRect.topLeft() * 2, dstRect.size() * 2 ).intersected( src.rect() );
+        halveInto( src.copy( srcRect ).convertToFormat( QImage::Format_ARGB32_Premultiplied ), dst, dstRect.topLeft() );
+
+        dirty = dstRect;
+    }
+
+    while ( static_cast< int >( mMipmaps.size() ) < level )
+    {
+        const QImage& src = mMipmaps.empty() ? *base : mMipmaps.back();
+        QImage dst( ( src.width() + 1 ) / 2, ( src.height() + 1 ) / 2, QImage::Format_ARGB32_Premultiplied );
+        halveInto( src.convertToFormat( QImage::Format_ARGB32_Premultiplied ), dst, QPoint( 0, 0 ) );
+        mMipmaps.push_back( dst );
+    }
+}
+
+void BitmapImage::modified( QRect rectangle )
+{
+    if ( !mMipmaps.empty() )
+    {
+        mMipmapDirtyRect |= rectangle.translated( -topLeft() );
+    }
+}
+
+void BitmapImage::dropMipmaps()
+{
+    mMipmaps.clear();
+    mMipmapDirtyRect = QRect();
 }
 
 BitmapImage BitmapImage::copy()
 {
-    return BitmapImage(mBounds, QImage(*mImage));
+    return BitmapImage(mBounds, QImage(*image()));
 }
 
 BitmapImage BitmapImage::copy(QRect rectangle)
 {
     //QRect intersection = boundaries.intersected( rectangle );
     QRect intersection2  = rectangle.translated( -topLeft() );
-    BitmapImage result = BitmapImage(rectangle, mImage->copy(intersection2));
+    BitmapImage result = BitmapImage(rectangle, image()->copy(intersection2));
     return result;
 }
 
@@ -101,7 +307,7 @@ void BitmapImage::paste(BitmapImage* bitmapImage)
 void BitmapImage::paste(BitmapImage* bitmapImage, QPainter::CompositionMode cm)
 {
     QRect newBoundaries;
-    if ( mImage->width() == 0 || mImage->height() == 0 )
+    if ( image()->width() == 0 || image()->height() == 0 )
     {
         newBoundaries = bitmapImage->mBounds;
     }
@@ -113,10 +319,11 @@ void BitmapImage::paste(BitmapImage* bitmapImage, QPainter::CompositionMode cm)
 
     QImage* image2 = bitmapImage->image();
 
-    QPainter painter( mImage.get() );
+    QPainter painter( image() );
     painter.setCompositionMode(cm);
     painter.drawImage( bitmapImage->mBounds.topLeft() - mBounds.topLeft(), *image2);
     painter.end();
+    modified( bitmapImage->mBounds );
 }
 
 void BitmapImage::add(BitmapImage* bitmapImage)
@@ -124,7 +331,7 @@ void BitmapImage::add(BitmapImage* bitmapImage)
     QImage* image2 = bitmapImage->image();
 
     QRect newBoundaries;
-    if ( mImage->width() == 0 || mImage->height() == 0 )
+    if ( image()->width() == 0 || image()->height() == 0 )
     {
         newBoundaries = bitmapImage->mBounds;
     }
@@ -138,7 +345,7 @@ void BitmapImage::add(BitmapImage* bitmapImage)
     {
         for (int x = 0; x < image2->width(); x++)
         {
-            QRgb p1  = mImage->pixel(offset.x()+x,offset.y()+y);
+            QRgb p1  = image()->pixel(offset.x()+x,offset.y()+y);
             QRgb p2 = image2->pixel(x,y);
 
             int a1 = qAlpha(p1);
@@ -159,10 +366,11 @@ void BitmapImage::add(BitmapImage* bitmapImage)
             QRgb mix = qRgba(r, g, b, a);
             if (a2 != 0)
             {
-                mImage->setPixel(offset.x()+x,offset.y()+y, mix);
+                image()->setPixel(offset.x()+x,offset.y()+y, mix);
             }
         }
     }
+    modified( bitmapImage->mBounds );
 }
 
 void BitmapImage::compareAlpha(BitmapImage* bitmapImage) // this function picks the greater alpha value
@@ -170,7 +378,7 @@ void BitmapImage::compareAlpha(BitmapImage* bitmapImage) // this function picks
     QImage* image2 = bitmapImage->image();
 
     QRect newBoundaries;
-    if ( mImage->width() == 0 || mImage->height() == 0 )
+    if ( image()->width() == 0 || image()->height() == 0 )
     {
         newBoundaries = bitmapImage->mBounds;
     }
@@ -184,7 +392,7 @@ void BitmapImage::compareAlpha(BitmapImage* bitmapImage) // this function picks
     {
         for (int x = 0; x < image2->width(); x++)
         {
-            QRgb p1  = mImage->pixel(offset.x()+x,offset.y()+y);
+            QRgb p1  = image()->pixel(offset.x()+x,offset.y()+y);
             QRgb p2 = image2->pixel(x,y);
 
             int a1 = qAlpha(p1);
@@ -193,10 +401,11 @@ void BitmapImage::compareAlpha(BitmapImage* bitmapImage) // this function picks
             if (a1 <= a2)
             {
             QRgb mix = qRgba(qRed(p2), qGreen(p2), qBlue(p2), a2);
-            mImage->setPixel(offset.x()+x,offset.y()+y, mix);
+            image()->setPixel(offset.x()+x,offset.y()+y, mix);
             }
         }
     }
+    modified( bitmapImage->mBounds );
 }
 
 void BitmapImage::moveTopLeft(QPoint point)
@@ -215,9 +424,10 @@ void BitmapImage::transform(QRect newBoundaries, bool smoothTransform)
     painter.setCompositionMode(QPainter::CompositionMode_Source);
     painter.fillRect( newImage->rect(), QColor(0,0,0,0) );
     painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-    painter.drawImage(newBoundaries, *mImage );
+    painter.drawImage(newBoundaries, *image() );
     painter.end();
     mImage.reset( newImage );
+    dropMipmaps();
 }
 
 BitmapImage BitmapImage::transformed(QRect selection, QTransform transform, bool smoothTransform)
@@ -245,7 +455,7 @@ BitmapImage BitmapImage::transformed(QRect newBoundaries, bool smoothTransform)
     QPainter painter(transformedImage.image());
     painter.setRenderHint(QPainter::SmoothPixmapTransform, smoothTransform);
     newBoundaries.moveTopLeft( QPoint(0,0) );
-    painter.drawImage(newBoundaries, *mImage );
+    painter.drawImage(newBoundaries, *image() );
     painter.end();
     return transformedImage;
 }
@@ -280,11 +490,12 @@ void BitmapImage::extend(QRect rectangle)
         if (!newImage->isNull())
         {
             QPainter painter(newImage);
-            painter.drawImage(mBounds.topLeft() - newBoundaries.topLeft(), *mImage);
+            painter.drawImage(mBounds.topLeft() - newBoundaries.topLeft(), *image());
             painter.end();
         }
         mImage.reset( newImage );
         mBounds = newBoundaries;
+        dropMipmaps();
     }
 }
 
@@ -296,7 +507,7 @@ QRgb BitmapImage::pixel(int x, int y)
 QRgb BitmapImage::pixel(QPoint P)
 {
     QRgb result = qRgba(0,0,0,0); // black
-    if ( mBounds.contains( P ) ) result = mImage->pixel(P - topLeft());
+    if ( mBounds.contains( P ) ) result = image()->pixel(P - topLeft());
     return result;
 }
 
@@ -309,7 +520,10 @@ void BitmapImage::setPixel(QPoint P, QRgb colour)
 {
     extend( P );
     if ( mBounds.contains(P) )
-        mImage->setPixel(P-topLeft(), colour);
+    {
+        image()->setPixel(P-topLeft(), colour);
+        modified( QRect( P, QSize( 1, 1 ) ) );
+    }
     //drawLine( QPointF(P), QPointF(P), QPen(QColor(colour)), QPainter::CompositionMode_SourceOver, false);
 }
 
@@ -318,14 +532,15 @@ void BitmapImage::drawLine( QPointF P1, QPointF P2, QPen pen, QPainter::Composit
 {
     int width = 2+pen.width();
     extend( QRect(P1.toPoint(), P2.toPoint()).normalized().adjusted(-width,-width,width,width) );
-    if (mImage != NULL && !mImage->isNull() )
+    if (!image()->isNull() )
     {
-        QPainter painter( mImage.get() );
+        QPainter painter( image() );
         painter.setCompositionMode(cm);
         painter.setRenderHint(QPainter::Antialiasing, antialiasing);
         painter.setPen(pen);
         painter.drawLine( P1-topLeft(), P2-topLeft());
         painter.end();
+        modified( QRect(P1.toPoint(), P2.toPoint()).normalized().adjusted(-width,-width,width,width) );
     }
 }
 
@@ -339,15 +554,16 @@ void BitmapImage::drawRect( QRectF rectangle, QPen pen, QBrush brush, QPainter::
         gradient->setCenter( gradient->center() - topLeft() );
         gradient->setFocalPoint( gradient->focalPoint() - topLeft() );
     }
-    if ( mImage && !mImage->isNull() )
+    if ( !image()->isNull() )
     {
-        QPainter painter( mImage.get() );
+        QPainter painter( image() );
         painter.setCompositionMode(cm);
         painter.setRenderHint(QPainter::Antialiasing, antialiasing);
         painter.setPen(pen);
         painter.setBrush(brush);
         painter.drawRect( rectangle.translated(-topLeft()) );
         painter.end();
+        modified( rectangle.adjusted(-width,-width,width,width).toAlignedRect() );
     }
 }
 
@@ -361,9 +577,9 @@ void BitmapImage::drawEllipse( QRectF rectangle, QPen pen, QBrush brush, QPainte
         gradient->setCenter( gradient->center() - topLeft() );
         gradient->setFocalPoint( gradient->focalPoint() - topLeft() );
     }
-    if ( mImage && !mImage->isNull() )
+    if ( !image()->isNull() )
     {
-        QPainter painter( mImage.get() );
+        QPainter painter( image() );
 
         painter.setRenderHint(QPainter::Antialiasing, antialiasing);
         painter.setPen(pen);
@@ -374,6 +590,7 @@ void BitmapImage::drawEllipse( QRectF rectangle, QPen pen, QBrush brush, QPainte
         painter.drawEllipse( rectangle.translated(-topLeft()) );
 
         painter.end();
+        modified( rectangle.adjusted(-width,-width,width,width).toAlignedRect() );
     }
 }
 
@@ -385,9 +602,9 @@ void BitmapImage::drawPath( QPainterPath path, QPen pen, QBrush brush,
     //if (inc<1) { inc=1.0; }
     extend( path.controlPointRect().adjusted(-width,-width,width,width).toRect() );
 
-    if ( mImage != NULL && !mImage->isNull() )
+    if ( !image()->isNull() )
     {
-        QPainter painter( mImage.get() );
+        QPainter painter( image() );
         painter.setCompositionMode(cm);
         painter.setRenderHint( QPainter::Antialiasing, antialiasing );
         painter.setPen(pen);
@@ -419,19 +636,38 @@ void BitmapImage::drawPath( QPainterPath path, QPen pen, QBrush brush,
             painter.drawPoint( path.elementAt(0).x, path.elementAt(0).y );
         }
         painter.end();
+        modified( path.controlPointRect().adjusted(-width,-width,width,width).toAlignedRect() );
+    }
+}
+
+void BitmapImage::smudge( const SmudgeDab& dab )
+{
+    QRect rectangle = dab.bounds();
+    extend( rectangle );
+    if ( !image()->isNull() )
+    {
+        if ( mImage->format() != QImage::Format_ARGB32_Premultiplied )
+        {
+            *mImage = mImage->convertToFormat( QImage::Format_ARGB32_Premultiplied );
+        }
+        SmudgeKernel::apply( *mImage, topLeft(), dab );
+        modified( rectangle );
     }
 }
 
 void BitmapImage::clear()
 {
+    BitmapResidency::instance()->discardPage( this );
     mImage = std::make_shared< QImage >(); // null image
+    mEncodedImage.clear();
     mBounds = QRect(0,0,0,0);
+    dropMipmaps();
 }
 
 QRgb BitmapImage::constScanLine(int x, int y) {
     QRgb result = qRgba( 0, 0, 0, 0 );
     if ( mBounds.contains( QPoint( x, y ) ) ) {
-        result = *( reinterpret_cast< const QRgb* >( mImage->constScanLine( y - topLeft().y() ) ) + x - topLeft().x() );
+        result = *( reinterpret_cast< const QRgb* >( image()->constScanLine( y - topLeft().y() ) ) + x - topLeft().x() );
     }
 
     return result;
@@ -443,12 +679,13 @@ void BitmapImage::scanLine(int x, int y, QRgb colour)
     if( mBounds.contains( QPoint( x, y ) ) ) {
 
         // Make sure color is premultiplied before calling
-        *( reinterpret_cast< QRgb* >( mImage->scanLine( y - topLeft().y() ) ) + x - topLeft().x() ) =
+        *( reinterpret_cast< QRgb* >( image()->scanLine( y - topLeft().y() ) ) + x - topLeft().x() ) =
                  qRgba(
                        qRed( colour ),
                        qGreen( colour ),
                        qBlue( colour ),
                        qAlpha( colour ) );
+        modified( QRect( x, y, 1, 1 ) );
     }
 }
 
@@ -457,10 +694,11 @@ void BitmapImage::clear(QRect rectangle)
     QRect clearRectangle = mBounds.intersected( rectangle );
     clearRectangle.moveTopLeft( clearRectangle.topLeft() - topLeft() );
 
-    QPainter painter( mImage.get() );
+    QPainter painter( image() );
     painter.setCompositionMode(QPainter::CompositionMode_Clear);
     painter.fillRect( clearRectangle, QColor(0,0,0,0) );
     painter.end();
+    modified( rectangle );
 }
 
 int BitmapImage::pow(int n)   // pow of a number
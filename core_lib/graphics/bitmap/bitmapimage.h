@@ -17,11 +17,14 @@ GNU General Public License for more details.
 #ifndef BITMAP_IMAGE_H
 #define BITMAP_IMAGE_H
 
+#include <atomic>
 #include <memory>
+#include <vector>
 #include <QtXml>
 #include <QPainter>
 #include "keyframe.h"
 
+struct SmudgeDab;
 
 class BitmapImage : public KeyFrame
 {
@@ -31,15 +34,22 @@ public:
     BitmapImage( const QRect& boundaries, const QColor& colour );
     BitmapImage( const QRect& boundaries, const QImage& image );
     BitmapImage( const QString& path, const QPoint& topLeft );
+    BitmapImage( const QByteArray& encodedImage, const QPoint& topLeft ); // decoded on first use
 
     ~BitmapImage();
     BitmapImage& operator=( const BitmapImage& a );
 
-    void paintImage( QPainter& painter );
+    void paintImage( QPainter& painter ); // from the mip level closest to the painter's scale
 
-    QImage* image() { return mImage.get(); }
+    QImage* image();
+    QImage  mipmap( qreal scale ); // the smallest level at least as large as the image at this scale
+    QImage  builtMipmap( qreal scale ); // same, but only from the levels already up to date, never builds one
     void    setImage( QImage* pImg );
 
+    // The file data of an image that hasn't been decoded (nor changed) since it was loaded
+    bool hasEncodedImage() const { return !mEncodedImage.isEmpty(); }
+    const QByteArray& encodedImage() const { return mEncodedImage; }
+
     BitmapImage copy();
     BitmapImage copy( QRect rectangle );
     void paste( BitmapImage* );
@@ -78,6 +88,7 @@ public:
     void drawRect( QRectF rectangle, QPen pen, QBrush brush, QPainter::CompositionMode cm, bool antialiasing );
     void drawEllipse( QRectF rectangle, QPen pen, QBrush brush, QPainter::CompositionMode cm, bool antialiasing );
     void drawPath( QPainterPath path, QPen pen, QBrush brush, QPainter::CompositionMode cm, bool antialiasing );
+    void smudge( const SmudgeDab& dab ); // in place, see SmudgeKernel
 
     QPoint topLeft() { return mBounds.topLeft(); }
     QPoint topRight() { return mBounds.topRight(); }
@@ -93,9 +104,30 @@ public:
     QRect& bounds() { return mBounds; }
 
 private:
+    void decodeImage();
+    void pageIn();
+
+    int  mipLevelFor( qreal scale );
+    void updateMipmaps( int level );
+    void modified( QRect rectangle );
+    void dropMipmaps();
+
     std::shared_ptr< QImage > mImage;
+    QByteArray mEncodedImage;
     QRect   mBounds;
     bool    mExtendable = true;
+
+    // Level n, built when first painted that small, is 1/2^n of the image (level 0).
+    // Changes are collected in image coordinates and resampled at the next paint.
+    std::vector< QImage > mMipmaps; // levels 1, 2, ...
+    QRect   mMipmapDirtyRect;
+
+    // Bookkeeping of BitmapResidency, stamped without its lock by every image() call
+    std::atomic< quint64 > mLastUse { 0 };
+    std::atomic< bool >    mIsTracked { false };
+    bool    mIsPagedOut = false;
+
+    friend class BitmapResidency;
 };
 
 #endif
@@ -0,0 +1,414 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "bitmapresidency.h"
+
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <QFile>
+#include <QDir>
+#include <QMutexLocker>
+#include "bitmapimage.h"
+#include "fileformat.h"
+#include "tracer.h"
+
+
+BitmapResidency* BitmapResidency::instance()
+{
+    // Never deleted, key frames in static storage may outlive any other static.
+    static BitmapResidency* residency = new BitmapResidency;
+    return residency;
+}
+
+BitmapResidency::BitmapResidency() : QObject( nullptr )
+    , mMutex( QMutex::Recursive )
+    , mLog( "BitmapResidency" )
+{
+    ENABLE_DEBUG_LOG( mLog, false );
+}
+
+BitmapResidency::~BitmapResidency()
+{
+}
+
+void BitmapResidency::setMemoryLimit( qint64 bytes )
+{
+    QMutexLocker locker( &mMutex );
+    mMemoryLimit = std::max( bytes, qint64( 0 ) );
+    scheduleEviction();
+}
+
+void BitmapResidency::setScratchDir( const QString& dirPath )
+{
+    // Pages already written stay where they are, the new folder is used
+    // once the current scratch file has emptied out.
+    QMutexLocker locker( &mMutex );
+    mScratchDir = dirPath;
+}
+
+QString BitmapResidency::scratchFilePath() const
+{
+    QMutexLocker locker( &mMutex );
+    if ( mScratchFile )
+    {
+        return mScratchFile->fileName();
+    }
+    QString dirPath = mScratchDir.isEmpty() ? QDir::tempPath() : mScratchDir;
+    return QDir( dirPath ).filePath( PFF_SCRATCH_FILE );
+}
+
+void BitmapResidency::touch( BitmapImage* bitmapImage )
+{
+    bitmapImage->mLastUse.store( ++mClock, std::memory_order_relaxed );
+    if ( !bitmapImage->mIsTracked.load( std::memory_order_acquire ) )
+    {
+        QMutexLocker locker( &mMutex );
+        if ( !bitmapImage->mIsTracked.load( std::memory_order_relaxed ) )
+        {
+            mImages.insert( bitmapImage );
+            bitmapImage->mIsTracked.store( true, std::memory_order_release );
+        }
+    }
+    scheduleEviction();
+}
+
+void BitmapResidency::release( BitmapImage* bitmapImage )
+{
+    QMutexLocker locker( &mMutex );
+    discardPage( bitmapImage );
+    mImages.remove( bitmapImage );
+    bitmapImage->mIsTracked = false;
+}
+
+bool BitmapResidency::pageOut( BitmapImage* bitmapImage )
+{
+    QMutexLocker locker( &mMutex );
+    if ( bitmapImage->mIsPagedOut )
+    {
+        return true;
+    }
+
+    if ( bitmapImage->mImage == nullptr || bitmapImage->mImage->isNull() )
+    {
+        return false;
+    }
+
+    // Pages are read back into a fresh image, so they need its line size.
+    QImage image = *bitmapImage->mImage;
+    int packedBytesPerLine = ( ( image.width() * image.depth() + 31 ) >> 5 ) << 2;
+    if ( image.bytesPerLine() != packedBytesPerLine )
+    {
+        image = image.copy();
+    }
+
+    Page page;
+    page.width = image.width();
+    page.height = image.height();
+    page.bytesPerLine = image.bytesPerLine();
+    page.format = image.format();
+    page.size = qint64( page.bytesPerLine ) * page.height;
+    page.offset = allocate( page.size );
+    if ( page.offset < 0 )
+    {
+        return false;
+    }
+    if ( !writeAt( page.offset, image ) )
+    {
+        deallocate( page.offset, page.size );
+        return false;
+    }
+
+    mPages.insert( bitmapImage, page );
+    bitmapImage->mImage = std::make_shared< QImage >();
+    bitmapImage->dropMipmaps(); // rebuilt when painted small again
+    bitmapImage->mIsPagedOut = true;
+    return true;
+}
+
+bool BitmapResidency::pageIn( BitmapImage* bitmapImage )
+{
+    TRACE_SCOPE( "BitmapResidency::pageIn" );
+
+    QMutexLocker locker( &mMutex );
+    if ( !bitmapImage->mIsPagedOut )
+    {
+        return true;
+    }
+
+    const Page page = mPages.value( bitmapImage );
+    auto image = std::make_shared< QImage >( page.width, page.height, page.format );
+    bool isOk = readAt( page.offset, *image );
+    if ( !isOk )
+    {
+        qWarning() << "ERROR: Key frame could not be read back from" << mScratchFile->fileName();
+        image->fill( Qt::transparent );
+    }
+
+    bitmapImage->mImage = image;
+    discardPage( bitmapImage );
+    return isOk;
+}
+
+void BitmapResidency::discardPage( BitmapImage* bitmapImage )
+{
+    QMutexLocker locker( &mMutex );
+    if ( !bitmapImage->mIsPagedOut )
+    {
+        return;
+    }
+
+    const Page page = mPages.take( bitmapImage );
+    bitmapImage->mIsPagedOut = false;
+    deallocate( page.offset, page.size );
+
+    if ( mPages.isEmpty() )
+    {
+        closeScratchFile();
+    }
+}
+
+BitmapResidency::Stats BitmapResidency::stats() const
+{
+    QMutexLocker locker( &mMutex );
+
+    Stats s;
+    for ( BitmapImage* bitmapImage : mImages )
+    {
+        if ( bitmapImage->mIsPagedOut )
+        {
+            s.pagedOutCount += 1;
+            s.pagedOutBytes += mPages.value( bitmapImage ).size;
+        }
+        else
+        {
+            qint64 bytes = residentBytesOf( bitmapImage );
+            if ( bytes > 0 )
+            {
+                s.residentCount += 1;
+                s.residentBytes += bytes;
+            }
+        }
+    }
+    return s;
+}
+
+void BitmapResidency::evict()
+{
+    TRACE_SCOPE( "BitmapResidency::evict" );
+
+    QMutexLocker locker( &mMutex );
+    mIsEvictionScheduled = false;
+    if ( mMemoryLimit <= 0 )
+    {
+        return;
+    }
+
+    struct Resident
+    {
+        BitmapImage* bitmapImage;
+        qint64 bytes;
+        quint64 lastUse; // read once, touch() doesn't wait for the sort
+    };
+    std::vector< Resident > residents;
+    qint64 totalBytes = 0;
+    for ( BitmapImage* bitmapImage : mImages )
+    {
+        qint64 bytes = residentBytesOf( bitmapImage );
+        if ( bytes > 0 )
+        {
+            residents.push_back( Resident{ bitmapImage, bytes, bitmapImage->mLastUse.load( std::memory_order_relaxed ) } );
+            totalBytes += bytes;
+        }
+    }
+    if ( totalBytes <= mMemoryLimit )
+    {
+        return;
+    }
+
+    // Least recently used first, the one in use right now always stays.
+    std::sort( residents.begin(), residents.end(), []( const Resident& a, const Resident& b )
+    {
+        return a.lastUse < b.lastUse;
+    } );
+    residents.pop_back();
+
+    int pagedOut = 0;
+    for ( const auto& resident : residents )
+    {
+        if ( totalBytes <= mMemoryLimit )
+        {
+            break;
+        }
+        if ( pageOut( resident.bitmapImage ) )
+        {
+            totalBytes -= resident.bytes;
+            pagedOut += 1;
+        }
+    }
+    qCDebug( mLog ) << "Paged out" << pagedOut << "key frames," << totalBytes / 1024 << "KB left in memory";
+}
+
+void BitmapResidency::scheduleEviction()
+{
+    if ( mMemoryLimit > 0 && !mIsEvictionScheduled.exchange( true ) )
+    {
+        QMetaObject::invokeMethod( this, "evict", Qt::QueuedConnection );
+    }
+}
+
+qint64 BitmapResidency::residentBytesOf( BitmapImage* bitmapImage ) const
+{
+    const QImage* image = bitmapImage->mImage.get();
+    if ( bitmapImage->mIsPagedOut || image == nullptr )
+    {
+        return 0;
+    }
+    return qint64( image->bytesPerLine() ) * image->height();
+}
+
+bool BitmapResidency::openScratchFile()
+{
+    if ( mScratchFile )
+    {
+        return true;
+    }
+
+    QString dirPath = mScratchDir.isEmpty() ? QDir::tempPath() : mScratchDir;
+    QDir().mkpath( dirPath );
+
+    std::unique_ptr< QFile > file( new QFile( QDir( dirPath ).filePath( PFF_SCRATCH_FILE ) ) );
+    if ( !file->open( QIODevice::ReadWrite | QIODevice::Truncate ) )
+    {
+        qWarning() << "ERROR: Cannot open the scratch file" << file->fileName();
+        return false;
+    }
+
+    mScratchFile = std::move( file );
+    mScratchFileSize = 0;
+    mFreeSlots.clear();
+    return true;
+}
+
+void BitmapResidency::closeScratchFile()
+{
+    if ( mScratchFile )
+    {
+        mScratchFile->close();
+        mScratchFile->remove();
+        mScratchFile.reset();
+    }
+    mScratchFileSize = 0;
+    mFreeSlots.clear();
+}
+
+qint64 BitmapResidency::allocate( qint64 size )
+{
+    if ( !openScratchFile() )
+    {
+        return -1;
+    }
+
+    // First fit, the pages of one shot are mostly the same size.
+    for ( auto it = mFreeSlots.begin(); it != mFreeSlots.end(); ++it )
+    {
+        if ( it->second >= size )
+        {
+            qint64 offset = it->first;
+            qint64 remaining = it->second - size;
+            mFreeSlots.erase( it );
+            if ( remaining > 0 )
+            {
+                mFreeSlots[ offset + size ] = remaining;
+            }
+            return offset;
+        }
+    }
+
+    qint64 offset = mScratchFileSize;
+    if ( !mScratchFile->resize( offset + size ) )
+    {
+        qWarning() << "ERROR: Cannot grow the scratch file" << mScratchFile->fileName();
+        return -1;
+    }
+    mScratchFileSize = offset + size;
+    return offset;
+}
+
+void BitmapResidency::deallocate( qint64 offset, qint64 size )
+{
+    auto it = mFreeSlots.emplace( offset, size ).first;
+
+    auto next = std::next( it );
+    if ( next != mFreeSlots.end() && it->first + it->second == next->first )
+    {
+        it->second += next->second;
+        mFreeSlots.erase( next );
+    }
+    if ( it != mFreeSlots.begin() )
+    {
+        auto prev = std::prev( it );
+        if ( prev->first + prev->second == it->first )
+        {
+            prev->second += it->second;
+            mFreeSlots.erase( it );
+            it = prev;
+        }
+    }
+
+    // Give the space back when the tail of the file is free
+    if ( mScratchFile && it->first + it->second == mScratchFileSize )
+    {
+        mScratchFileSize = it->first;
+        mScratchFile->resize( mScratchFileSize );
+        mFreeSlots.erase( it );
+    }
+}
+
+bool BitmapResidency::writeAt( qint64 offset, const QImage& image )
+{
+    const qint64 size = qint64( image.bytesPerLine() ) * image.height();
+
+    uchar* mapped = mScratchFile->map( offset, size );
+    if ( mapped != nullptr )
+    {
+        std::memcpy( mapped, image.constBits(), size );
+        return mScratchFile->unmap( mapped );
+    }
+
+    // Not every file system can map files
+    return mScratchFile->seek( offset )
+        && mScratchFile->write( reinterpret_cast< const char* >( image.constBits() ), size ) == size;
+}
+
+bool BitmapResidency::readAt( qint64 offset, QImage& image )
+{
+    if ( image.isNull() )
+    {
+        return false;
+    }
+    const qint64 size = qint64( image.bytesPerLine() ) * image.height();
+
+    uchar* mapped = mScratchFile->map( offset, size );
+    if ( mapped != nullptr )
+    {
+        std::memcpy( image.bits(), mapped, size );
+        return mScratchFile->unmap( mapped );
+    }
+
+    return mScratchFile->seek( offset )
+        && mScratchFile->read( reinterpret_cast< char* >( image.bits() ), size ) == size;
+}
@@ -0,0 +1,117 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef BITMAPRESIDENCY_H
+#define BITMAPRESIDENCY_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QImage>
+#include <QMutex>
+#include "log.h"
+
+class QFile;
+class BitmapImage;
+
+
+// Keeps the decoded bitmap key frames under a memory limit.
+//
+// Every access to a bitmap image marks it as recently used. When the images
+// in memory add up to more than the limit, the least recently used ones are
+// paged out, raw and uncompressed, to a scratch file in the working folder,
+// and read back the next time they are accessed.
+//
+// Eviction runs from the event loop, never in the middle of an operation
+// that may still hold a pointer to the image of a key frame.
+class BitmapResidency : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        int    residentCount = 0;
+        qint64 residentBytes = 0;
+        int    pagedOutCount = 0;
+        qint64 pagedOutBytes = 0;
+    };
+
+    static BitmapResidency* instance();
+
+    void   setMemoryLimit( qint64 bytes ); // 0 means no limit
+    qint64 memoryLimit() const { return mMemoryLimit; }
+    void   setScratchDir( const QString& dirPath );
+    QString scratchFilePath() const;
+
+    void touch( BitmapImage* bitmapImage );
+    void release( BitmapImage* bitmapImage );
+    bool pageOut( BitmapImage* bitmapImage );
+    bool pageIn( BitmapImage* bitmapImage );
+    void discardPage( BitmapImage* bitmapImage ); // the image has been replaced
+
+    Stats stats() const;
+
+public slots:
+    void evict();
+
+private:
+    struct Page
+    {
+        qint64 offset = 0;
+        qint64 size = 0;
+        int width = 0;
+        int height = 0;
+        int bytesPerLine = 0;
+        QImage::Format format = QImage::Format_Invalid;
+    };
+
+    BitmapResidency();
+    ~BitmapResidency();
+
+    void   scheduleEviction();
+    qint64 residentBytesOf( BitmapImage* bitmapImage ) const;
+
+    bool   openScratchFile();
+    void   closeScratchFile();
+    qint64 allocate( qint64 size );
+    void   deallocate( qint64 offset, qint64 size );
+    bool   writeAt( qint64 offset, const QImage& image );
+    bool   readAt( qint64 offset, QImage& image );
+
+    mutable QMutex mMutex;
+
+    // touch() runs for every access to an image, e.g. a few times per pixel
+    // of a flood fill, so it only takes the lock the first time
+    std::atomic< qint64 > mMemoryLimit { 0 };
+    std::atomic< quint64 > mClock { 0 };
+    std::atomic< bool > mIsEvictionScheduled { false };
+
+    QSet< BitmapImage* > mImages;
+    QHash< BitmapImage*, Page > mPages;
+
+    QString mScratchDir;
+    std::unique_ptr< QFile > mScratchFile;
+    qint64 mScratchFileSize = 0;
+    std::map< qint64, qint64 > mFreeSlots; // offset -> size
+
+    QLoggingCategory mLog;
+};
+
+#endif // BITMAPRESIDENCY_H
@@ -0,0 +1,65 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "colorsampler.h"
+
+#include <QImage>
+#include <QRect>
+
+
+QRgb ColorSampler::average( const QImage& image, QPoint centre, int size )
+{
+    Q_ASSERT( image.isNull() || image.format() == QImage::Format_ARGB32_Premultiplied ||
+              image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_RGB32 );
+
+    size = qBound( 1, size, MAX_SIZE );
+    const int half = ( size - 1 ) / 2;
+    const QRect rect = QRect( centre.x() - half, centre.y() - half, size, size ) & image.rect();
+    if ( rect.isEmpty() )
+    {
+        return qRgba( 0, 0, 0, 0 );
+    }
+
+    // Two channels per 32 bit word, 16 bits each. A row is at most 255
+    // pixels wide so its sums can't carry into the next channel, they are
+    // moved to the totals at the end of every row.
+    // Frames decoded from PNG files are not premultiplied until they are
+    // drawn on, their pixels are premultiplied one by one as they are read.
+    const bool isPremultiplied = ( image.format() != QImage::Format_ARGB32 );
+
+    quint32 sumA = 0, sumR = 0, sumG = 0, sumB = 0;
+    for ( int y = rect.top(); y <= rect.bottom(); ++y )
+    {
+        const quint32* line = reinterpret_cast< const quint32* >( image.constScanLine( y ) ) + rect.left();
+        quint32 rb = 0;
+        quint32 ag = 0;
+        for ( int x = 0; x < rect.width(); ++x )
+        {
+            const quint32 pixel = isPremultiplied ? line[ x ] : qPremultiply( line[ x ] );
+            rb += pixel & 0x00ff00ff;
+            ag += ( pixel >> 8 ) & 0x00ff00ff;
+        }
+        sumR += rb >> 16;
+        sumB += rb & 0xffff;
+        sumA += ag >> 16;
+        sumG += ag & 0xffff;
+    }
+
+    const quint32 count = quint32( rect.width() * rect.height() );
+    const quint32 round = count / 2;
+    return qRgba( int( ( sumR + round ) / count ), int( ( sumG + round ) / count ),
+                  int( ( sumB + round ) / count ), int( ( sumA + round ) / count ) );
+}
@@ -0,0 +1,37 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef COLORSAMPLER_H
+#define COLORSAMPLER_H
+
+#include <QPoint>
+#include <QRgb>
+
+class QImage;
+
+
+namespace ColorSampler
+{
+    // The largest square that can be averaged
+    const int MAX_SIZE = 255;
+
+    // Average of the size x size pixels centred on `centre` of an ARGB image,
+    // premultiplied or not, as a premultiplied pixel. Only the pixels inside the image
+    // count, transparent black when there are none.
+    QRgb average( const QImage& image, QPoint centre, int size );
+}
+
+#endif // COLORSAMPLER_H
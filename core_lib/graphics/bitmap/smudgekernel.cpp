@@ -0,0 +1,132 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "smudgekernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <QImage>
+
+
+namespace
+{
+// a * x + b * y for each channel of two premultiplied pixels, with a + b == 256.
+// Two channels at a time, each product fits in 16 bits.
+inline quint32 interpolate256( quint32 x, quint32 a, quint32 y, quint32 b )
+{
+    quint32 rb = ( x & 0x00ff00ff ) * a + ( y & 0x00ff00ff ) * b;
+    quint32 ag = ( ( x >> 8 ) & 0x00ff00ff ) * a + ( ( y >> 8 ) & 0x00ff00ff ) * b;
+    return ( ( rb >> 8 ) & 0x00ff00ff ) | ( ag & 0xff00ff00 );
+}
+}
+
+QRect SmudgeDab::bounds() const
+{
+    return QRectF( to.x() - radius, to.y() - radius, 2 * radius, 2 * radius ).toAlignedRect();
+}
+
+void SmudgeKernel::apply( QImage& image, QPoint imageTopLeft, const SmudgeDab& dab )
+{
+    Q_ASSERT( image.format() == QImage::Format_ARGB32_Premultiplied );
+
+    const QRect imageRect( QPoint( 0, 0 ), image.size() );
+    const QRect dabRect = dab.bounds().translated( -imageTopLeft ) & imageRect;
+    if ( dabRect.isEmpty() || dab.radius <= 0 || dab.strength <= 0 )
+    {
+        return;
+    }
+
+    // The dab reads what it writes, so the pixels it can sample are copied
+    // first. The copy has a transparent margin at least as wide as the
+    // displacement, no sample needs a bounds check.
+    const QPointF delta = dab.to - dab.from;
+    const qint64 dx = qRound64( delta.x() * 65536 ); // 16.16 fixed point
+    const qint64 dy = qRound64( delta.y() * 65536 );
+    const int margin = int( std::ceil( std::max( std::abs( delta.x() ), std::abs( delta.y() ) ) ) ) + 2;
+
+    const QRect snapshotRect = dabRect.adjusted( -margin, -margin, margin, margin );
+    const int snapshotWidth = snapshotRect.width();
+    std::vector< quint32 > snapshot( size_t( snapshotWidth ) * snapshotRect.height(), 0 );
+
+    const QRect copied = snapshotRect & imageRect;
+    for ( int y = copied.top(); y <= copied.bottom(); ++y )
+    {
+        const QRgb* line = reinterpret_cast< const QRgb* >( image.constScanLine( y ) );
+        std::memcpy( &snapshot[ size_t( y - snapshotRect.top() ) * snapshotWidth + ( copied.left() - snapshotRect.left() ) ],
+                     line + copied.left(), copied.width() * sizeof( quint32 ) );
+    }
+
+    const qreal centreX = dab.to.x() - imageTopLeft.x();
+    const qreal centreY = dab.to.y() - imageTopLeft.y();
+    const qreal radius2 = dab.radius * dab.radius;
+    const qreal innerRadius = dab.radius * ( 1.0 - qBound( 0.0, dab.softness, 1.0 ) );
+    const qreal innerRadius2 = innerRadius * innerRadius;
+    const qreal rampWidth = dab.radius - innerRadius;
+    const qreal strength = 256 * qMin( dab.strength, 1.0 );
+
+    for ( int y = dabRect.top(); y <= dabRect.bottom(); ++y )
+    {
+        const qreal py = y + 0.5 - centreY;
+        const qreal py2 = py * py;
+        if ( py2 >= radius2 )
+        {
+            continue;
+        }
+
+        // Only the span of the row inside the circle
+        const qreal halfSpan = std::sqrt( radius2 - py2 );
+        const int left = std::max( dabRect.left(), int( std::floor( centreX - halfSpan - 0.5 ) ) );
+        const int right = std::min( dabRect.right(), int( std::ceil( centreX + halfSpan - 0.5 ) ) );
+
+        QRgb* out = reinterpret_cast< QRgb* >( image.scanLine( y ) );
+        const qint64 rowY = qint64( y - snapshotRect.top() ) << 16;
+
+        for ( int x = left; x <= right; ++x )
+        {
+            const qreal px = x + 0.5 - centreX;
+            const qreal d2 = px * px + py2;
+            if ( d2 >= radius2 )
+            {
+                continue;
+            }
+            qreal falloff = 1.0;
+            if ( d2 > innerRadius2 )
+            {
+                falloff = ( dab.radius - std::sqrt( d2 ) ) / rampWidth;
+            }
+            const quint32 weight = quint32( strength * falloff + 0.5 );
+            if ( weight == 0 )
+            {
+                continue;
+            }
+
+            const qint64 k = dab.isDisplacementWeighted ? weight : 256;
+            const qint64 sx = ( qint64( x - snapshotRect.left() ) << 16 ) - ( ( k * dx ) >> 8 );
+            const qint64 sy = rowY - ( ( k * dy ) >> 8 );
+            const quint32 fx = quint32( sx >> 8 ) & 0xff;
+            const quint32 fy = quint32( sy >> 8 ) & 0xff;
+
+            const quint32* p = &snapshot[ size_t( sy >> 16 ) * snapshotWidth + size_t( sx >> 16 ) ];
+            const quint32 top = interpolate256( p[ 0 ], 256 - fx, p[ 1 ], fx );
+            const quint32 bottom = interpolate256( p[ snapshotWidth ], 256 - fx, p[ snapshotWidth + 1 ], fx );
+            const quint32 sample = interpolate256( top, 256 - fy, bottom, fy );
+
+            out[ x ] = interpolate256( sample, weight, out[ x ], 256 - weight );
+        }
+    }
+}
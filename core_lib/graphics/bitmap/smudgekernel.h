@@ -0,0 +1,53 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef SMUDGEKERNEL_H
+#define SMUDGEKERNEL_H
+
+#include <QPointF>
+#include <QRect>
+
+class QImage;
+
+
+// One dab of the smudge tool: the pixels around `to` are pulled from where
+// they were around `from`, blended in by a round weight that is `strength`
+// in the middle and falls linearly to 0 over the outer `softness` of the radius.
+struct SmudgeDab
+{
+    QPointF from;
+    QPointF to;
+    qreal   radius = 0;
+    qreal   strength = 1.0;   // 0 to 1
+    qreal   softness = 0;     // 0 to 1, fraction of the radius
+
+    // Liquify moves each pixel as far as it is weighted, so the middle of the
+    // dab drags the most. Otherwise every pixel is pulled the whole way, which
+    // smears the image along the stroke.
+    bool    isDisplacementWeighted = true;
+
+    QRect   bounds() const; // the pixels the dab can change
+};
+
+namespace SmudgeKernel
+{
+    // Applies the dab in place to a premultiplied ARGB image whose top left
+    // pixel is at imageTopLeft. The pixels are sampled bilinearly from the
+    // image as it was before the dab, outside of it they are transparent.
+    void apply( QImage& image, QPoint imageTopLeft, const SmudgeDab& dab );
+}
+
+#endif // SMUDGEKERNEL_H
@@ -0,0 +1,229 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "strokerasterizer.h"
+
+#include <algorithm>
+#include <QThread>
+#include <QRunnable>
+#include <QMutexLocker>
+#include "bitmapimage.h"
+#include "tracer.h"
+
+
+struct StrokeRasterizer::Tile
+{
+    QPoint origin;    // canvas position of the top left pixel
+    QImage image;     // only touched by the thread drawing the tile
+
+    QMutex mutex;     // guards the two below
+    QList< StrokeDab > dabs;
+    bool   isScheduled = false; // a thread is on it, and will take the dabs added meanwhile
+};
+
+class TileTask : public QRunnable
+{
+public:
+    TileTask( StrokeRasterizer* rasterizer, StrokeRasterizer::Tile* tile ) : mRasterizer( rasterizer ), mTile( tile ) {}
+    void run() override { mRasterizer->drawTile( mTile ); }
+
+private:
+    StrokeRasterizer* mRasterizer;
+    StrokeRasterizer::Tile* mTile;
+};
+
+namespace
+{
+inline int tileIndexOf( int coordinate )
+{
+    // Rounded down, the canvas goes negative
+    return ( coordinate >= 0 ) ? coordinate / StrokeRasterizer::TILE_SIZE
+                               : -( ( -coordinate - 1 ) / StrokeRasterizer::TILE_SIZE ) - 1;
+}
+}
+
+
+StrokeRasterizer::StrokeRasterizer( QObject* parent ) : QObject( parent )
+{
+    // The gui thread keeps a core for the input and the canvas
+    mPool.setMaxThreadCount( std::max( QThread::idealThreadCount() - 1, 1 ) );
+}
+
+StrokeRasterizer::~StrokeRasterizer()
+{
+    clear();
+}
+
+void StrokeRasterizer::submit()
+{
+    TRACE_SCOPE( "StrokeRasterizer::submit" );
+
+    if ( mQueuedDabs.isEmpty() )
+    {
+        return;
+    }
+
+    // Sorted out per tile first, so each tile is locked once
+    std::unordered_map< Tile*, QList< StrokeDab > > batches;
+    for ( const StrokeDab& dab : mQueuedDabs )
+    {
+        // With a pixel around for the antialiasing
+        QRect bounds = dab.rect.toAlignedRect().adjusted( -1, -1, 1, 1 );
+        for ( int row = tileIndexOf( bounds.top() ); row <= tileIndexOf( bounds.bottom() ); ++row )
+        {
+            for ( int column = tileIndexOf( bounds.left() ); column <= tileIndexOf( bounds.right() ); ++column )
+            {
+                batches[ tileAt( column, row ) ].append( dab );
+            }
+        }
+    }
+    mQueuedDabs.clear();
+
+    for ( auto& batch : batches )
+    {
+        Tile* tile = batch.first;
+        bool isNew = false;
+        {
+            QMutexLocker locker( &tile->mutex );
+            tile->dabs.append( batch.second );
+            isNew = !tile->isScheduled;
+            tile->isScheduled = true;
+        }
+        if ( isNew )
+        {
+            mPool.start( new TileTask( this, tile ) );
+        }
+    }
+}
+
+QRect StrokeRasterizer::collect( BitmapImage* buffer )
+{
+    TRACE_SCOPE( "StrokeRasterizer::collect" );
+
+    QList< DrawnTile > drawnTiles;
+    {
+        QMutexLocker locker( &mDrawnMutex );
+        drawnTiles.swap( mDrawnTiles );
+    }
+
+    // A tile holds everything drawn on it so far, it replaces what the buffer had there
+    QRect rect;
+    for ( const DrawnTile& drawn : drawnTiles )
+    {
+        BitmapImage tileImage( drawn.rect, drawn.image );
+        buffer->paste( &tileImage, QPainter::CompositionMode_Source );
+        rect |= drawn.rect;
+    }
+    return rect;
+}
+
+QRect StrokeRasterizer::finish( BitmapImage* buffer )
+{
+    TRACE_SCOPE( "StrokeRasterizer::finish" );
+
+    submit();
+    mPool.waitForDone();
+    return collect( buffer );
+}
+
+void StrokeRasterizer::clear()
+{
+    mQueuedDabs.clear();
+    for ( auto& entry : mTiles )
+    {
+        QMutexLocker locker( &entry.second->mutex );
+        entry.second->dabs.clear();
+    }
+    mPool.waitForDone();
+    mTiles.clear();
+
+    QMutexLocker locker( &mDrawnMutex );
+    mDrawnTiles.clear();
+}
+
+StrokeRasterizer::Tile* StrokeRasterizer::tileAt( int column, int row )
+{
+    std::unique_ptr< Tile >& tile = mTiles[ tileKeyOf( column, row ) ];
+    if ( !tile )
+    {
+        tile.reset( new Tile );
+        tile->origin = QPoint( column * TILE_SIZE, row * TILE_SIZE );
+    }
+    return tile.get();
+}
+
+void StrokeRasterizer::drawTile( Tile* tile )
+{
+    TRACE_SCOPE( "StrokeRasterizer::drawTile" );
+
+    const QRect tileRect( tile->origin, QSize( TILE_SIZE, TILE_SIZE ) );
+    for ( ;; )
+    {
+        QList< StrokeDab > dabs;
+        {
+            QMutexLocker locker( &tile->mutex );
+            if ( tile->dabs.isEmpty() )
+            {
+                tile->isScheduled = false;
+                return;
+            }
+            dabs.swap( tile->dabs );
+        }
+
+        if ( tile->image.isNull() )
+        {
+            tile->image = QImage( TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied );
+            tile->image.fill( Qt::transparent );
+        }
+
+        // Same as BitmapImage::drawEllipse(), moved by whole pixels the rasterization doesn't change
+        QRect drawnRect;
+        QPainter painter( &tile->image );
+        painter.translate( -tile->origin );
+        painter.setPen( Qt::NoPen );
+        for ( const StrokeDab& dab : dabs )
+        {
+            painter.setRenderHint( QPainter::Antialiasing, dab.isAntialiased );
+            painter.setBrush( dab.brush );
+            painter.setCompositionMode( dab.mode );
+            painter.drawEllipse( dab.rect );
+            drawnRect |= dab.rect.toAlignedRect().adjusted( -1, -1, 1, 1 );
+        }
+        painter.end();
+
+        drawnRect &= tileRect;
+        if ( drawnRect.isEmpty() )
+        {
+            continue;
+        }
+
+        DrawnTile drawn;
+        drawn.rect = drawnRect;
+        drawn.image = tile->image.copy( drawnRect.translated( -tile->origin ) );
+
+        bool isFirst = false;
+        {
+            QMutexLocker locker( &mDrawnMutex );
+            isFirst = mDrawnTiles.isEmpty();
+            mDrawnTiles.append( drawn );
+        }
+        if ( isFirst )
+        {
+            // Once for all the tiles done until the gui thread collects them
+            QMetaObject::invokeMethod( this, "tilesReady", Qt::QueuedConnection );
+        }
+    }
+}
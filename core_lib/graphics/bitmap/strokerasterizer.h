@@ -0,0 +1,97 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef STROKERASTERIZER_H
+#define STROKERASTERIZER_H
+
+#include <memory>
+#include <unordered_map>
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QImage>
+#include <QBrush>
+#include <QPainter>
+#include <QThreadPool>
+
+class BitmapImage;
+
+
+// One dab of a painted stroke, an ellipse in canvas coordinates.
+// A gradient brush is in canvas coordinates too.
+struct StrokeDab
+{
+    QRectF rect;
+    QBrush brush;
+    QPainter::CompositionMode mode = QPainter::CompositionMode_SourceOver;
+    bool   isAntialiased = false;
+};
+
+// Draws the dabs of the stroke in progress on worker threads.
+//
+// The canvas is cut in square tiles. A tile is drawn by one thread at a time,
+// in the order its dabs came in, while different tiles are drawn in parallel.
+// The tools queue dabs on the gui thread and submit() hands them over without
+// waiting. tilesReady() is emitted as tiles are done, collect() then pastes
+// them into the stroke buffer, which is only ever touched by the gui thread.
+class StrokeRasterizer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StrokeRasterizer( QObject* parent = 0 );
+    virtual ~StrokeRasterizer();
+
+    void queueDab( const StrokeDab& dab ) { mQueuedDabs.append( dab ); }
+    bool hasQueuedDabs() const { return !mQueuedDabs.isEmpty(); }
+    void submit();
+
+    // Pastes the tiles drawn since the last call into buffer, returns the canvas rect they cover
+    QRect collect( BitmapImage* buffer );
+    // Waits for all the dabs of the stroke to be drawn, then collects them
+    QRect finish( BitmapImage* buffer );
+    // Drops the stroke, drawn or not
+    void  clear();
+
+    static const int TILE_SIZE = 64;
+
+signals:
+    void tilesReady();
+
+private:
+    struct Tile;
+    struct DrawnTile
+    {
+        QRect  rect; // in canvas coordinates
+        QImage image;
+    };
+
+    friend class TileTask;
+    void  drawTile( Tile* tile ); // on a worker thread
+    Tile* tileAt( int column, int row );
+
+    static qint64 tileKeyOf( int column, int row ) { return ( qint64( column ) << 32 ) | quint32( row ); }
+
+    QList< StrokeDab > mQueuedDabs;
+    std::unordered_map< qint64, std::unique_ptr< Tile > > mTiles; // only changed by the gui thread
+
+    QMutex mDrawnMutex;
+    QList< DrawnTile > mDrawnTiles;
+
+    QThreadPool mPool;
+};
+
+#endif // STROKERASTERIZER_H
@@ -19,19 +19,20 @@ GNU General Public License for more details.
 #include "bezierarea.h"
 
 #include "pencilerror.h"
+#include "vectorimage.h"
 
 BezierArea::BezierArea()
 {
 }
 
-BezierArea::BezierArea(QList<VertexRef> vertexList, int colour)
+BezierArea::BezierArea(QList<AreaVertex> vertexList, int colour)
 {
     mVertex = vertexList;
     mColourNumber = colour;
     mSelected = false;
 }
 
-VertexRef BezierArea::getVertexRef(int i)
+AreaVertex BezierArea::getVertexRef(int i)
 {
     while (i >= mVertex.size() )
     {
@@ -49,7 +50,7 @@ void BezierArea::setSelected(bool YesOrNo)
     mSelected = YesOrNo;
 }
 
-Status BezierArea::createDomElement( QXmlStreamWriter& xmlStream )
+Status BezierArea::createDomElement( QXmlStreamWriter& xmlStream, const VectorImage& image )
 {
     xmlStream.writeStartElement( "area" );
     xmlStream.writeAttribute( "colourNumber", QString::number( mColourNumber ) );
@@ -58,7 +59,7 @@ Status BezierArea::createDomElement( QXmlStreamWriter& xmlStream )
     for ( int i = 0; i < mVertex.size(); i++ )
     {
         xmlStream.writeEmptyElement( "vertex" );
-        xmlStream.writeAttribute( "curve", QString::number( mVertex.at( i ).curveNumber ) );
+        xmlStream.writeAttribute( "curve", QString::number( image.getCurveNumber( mVertex.at( i ).curve ) ) );
         xmlStream.writeAttribute( "vertex", QString::number( mVertex.at( i ).vertexNumber ) );
 
         if ( errorLocation < 0 && xmlStream.hasError() )
@@ -74,7 +75,7 @@ Status BezierArea::createDomElement( QXmlStreamWriter& xmlStream )
         QStringList debugInfo = QStringList() << "BezierArea::createDomElement"
                                               << QString( "colourNumber = %1" ).arg( mColourNumber )
                                               << QString( "- mVertex[%1] has failed to write" ).arg( errorLocation )
-                                              << QString( "&nbsp;&nbsp;curve = %1" ).arg( mVertex.at( errorLocation ).curveNumber )
+                                              << QString( "&nbsp;&nbsp;curve = %1" ).arg( image.getCurveNumber( mVertex.at( errorLocation ).curve ) )
                                               << QString( "&nbsp;&nbsp;vertex = %1 " ).arg( mVertex.at( errorLocation ).vertexNumber );
 
         return Status( Status::FAIL, debugInfo );
@@ -83,7 +84,7 @@ Status BezierArea::createDomElement( QXmlStreamWriter& xmlStream )
     return Status::OK;
 }
 
-void BezierArea::loadDomElement(QDomElement element)
+void BezierArea::loadDomElement(QDomElement element, const VectorImage& image)
 {
     mColourNumber = element.attribute("colourNumber").toInt();
 
@@ -95,9 +96,48 @@ void BezierArea::loadDomElement(QDomElement element)
         {
             if (vertexElement.tagName() == "vertex")
             {
-                mVertex.append( VertexRef(vertexElement.attribute("curve").toInt() , vertexElement.attribute("vertex").toInt() )  );
+                mVertex.append( AreaVertex(image.getCurveId(vertexElement.attribute("curve").toInt()), vertexElement.attribute("vertex").toInt() )  );
             }
         }
         vertexTag = vertexTag.nextSibling();
     }
 }
+
+void BezierArea::loadDomElement(QXmlStreamReader& xmlStream, const VectorImage& image)
+{
+    mColourNumber = xmlStream.attributes().value("colourNumber").toInt();
+
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == "vertex")
+        {
+            QXmlStreamAttributes attributes = xmlStream.attributes();
+            mVertex.append( AreaVertex(image.getCurveId(attributes.value("curve").toInt()), attributes.value("vertex").toInt()) );
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
+
+void BezierArea::writeBinary(QDataStream& out, const VectorImage& image) const
+{
+    out << qint32(mColourNumber) << qint32(mVertex.size());
+    for (const AreaVertex& ref : mVertex)
+    {
+        out << qint32(image.getCurveNumber(ref.curve)) << qint32(ref.vertexNumber);
+    }
+}
+
+void BezierArea::readBinary(QDataStream& in, const VectorImage& image)
+{
+    qint32 colour = 0, n = 0;
+    in >> colour >> n;
+    mColourNumber = colour;
+
+    mVertex.clear();
+    for (int i = 0; i < n && in.status() == QDataStream::Ok; i++)
+    {
+        qint32 curve = 0, vertex = 0;
+        in >> curve >> vertex;
+        mVertex.append(AreaVertex(image.getCurveId(curve), vertex));
+    }
+}
@@ -24,24 +24,29 @@ GNU General Public License for more details.
 #include "vertexref.h"
 
 class Status;
+class VectorImage;
 
 class BezierArea
 {
 public:
     BezierArea();
-    BezierArea(QList<VertexRef> vertexList, int colour);
+    BezierArea(QList<AreaVertex> vertexList, int colour);
 
-    Status createDomElement(QXmlStreamWriter& xmlStream);
-    void loadDomElement(QDomElement element);
+    // The files refer to curves by their number in the image
+    Status createDomElement(QXmlStreamWriter& xmlStream, const VectorImage& image);
+    void loadDomElement(QDomElement element, const VectorImage& image);
+    void loadDomElement(QXmlStreamReader& xmlStream, const VectorImage& image);
+    void writeBinary(QDataStream& out, const VectorImage& image) const;
+    void readBinary(QDataStream& in, const VectorImage& image);
 
-    VertexRef getVertexRef(int i);
+    AreaVertex getVertexRef(int i);
     int getColourNumber() { return mColourNumber; }
     void decreaseColourNumber() { mColourNumber--; }
     void setSelected(bool YesOrNo);
     bool isSelected() const { return mSelected; }
     void setColourNumber(int cn) { mColourNumber = cn; }
 
-    QList<VertexRef> mVertex;
+    QList<AreaVertex> mVertex;
     QPainterPath mPath;
     int mColourNumber;
 
@@ -16,11 +16,43 @@ GNU General Public License for more details.
 */
 
 #include <cmath>
+#include <algorithm>
 #include <QList>
 #include "beziercurve.h"
 #include "object.h"
 #include "pencilerror.h"
 
+
+namespace
+{
+// Bernstein weights of the cubic at t = k / CUBIC_STEPS
+struct CubicWeights
+{
+    qreal w0[BezierCurve::CUBIC_STEPS + 1];
+    qreal w1[BezierCurve::CUBIC_STEPS + 1];
+    qreal w2[BezierCurve::CUBIC_STEPS + 1];
+    qreal w3[BezierCurve::CUBIC_STEPS + 1];
+
+    CubicWeights()
+    {
+        for (int k = 0; k <= BezierCurve::CUBIC_STEPS; k++)
+        {
+            qreal t = (k+0.0)/BezierCurve::CUBIC_STEPS;
+            w0[k] = (1.0-t)*(1.0-t)*(1.0-t);
+            w1[k] = 3*t*(1.0-t)*(1.0-t);
+            w2[k] = 3*t*t*(1.0-t);
+            w3[k] = t*t*t;
+        }
+    }
+};
+
+const CubicWeights& cubicWeights()
+{
+    static const CubicWeights weights;
+    return weights;
+}
+}
+
 BezierCurve::BezierCurve()
 {
 }
@@ -83,20 +115,20 @@ Status BezierCurve::createDomElement( QXmlStreamWriter& xmlStream )
     if (feather>0) xmlStream.writeAttribute( "feather", QString::number( feather ) );
     xmlStream.writeAttribute( "invisible", invisible ? "true" : "false" );
     xmlStream.writeAttribute( "colourNumber", QString::number( colourNumber ) );
-    xmlStream.writeAttribute( "originX", QString::number( origin.x() ) );
-    xmlStream.writeAttribute( "originY", QString::number( origin.y() ) );
+    xmlStream.writeAttribute( "originX", QString::number( getOrigin().x() ) );
+    xmlStream.writeAttribute( "originY", QString::number( getOrigin().y() ) );
     xmlStream.writeAttribute( "originPressure", QString::number( pressure.at(0) ) );
 
     int errorLocation = -1;
-    for ( int i = 0; i < c1.size() ; i++ )
+    for ( int i = 0; i < getVertexSize() ; i++ )
     {
         xmlStream.writeEmptyElement( "segment" );
-        xmlStream.writeAttribute( "c1x", QString::number( c1.at( i ).x() ) );
-        xmlStream.writeAttribute( "c1y", QString::number( c1.at( i ).y() ) );
-        xmlStream.writeAttribute( "c2x", QString::number( c2.at( i ).x() ) );
-        xmlStream.writeAttribute( "c2y", QString::number( c2.at( i ).y() ) );
-        xmlStream.writeAttribute( "vx", QString::number( vertex.at( i ).x() ) );
-        xmlStream.writeAttribute( "vy", QString::number( vertex.at( i ).y() ) );
+        xmlStream.writeAttribute( "c1x", QString::number( getC1( i ).x() ) );
+        xmlStream.writeAttribute( "c1y", QString::number( getC1( i ).y() ) );
+        xmlStream.writeAttribute( "c2x", QString::number( getC2( i ).x() ) );
+        xmlStream.writeAttribute( "c2y", QString::number( getC2( i ).y() ) );
+        xmlStream.writeAttribute( "vx", QString::number( getVertex( i ).x() ) );
+        xmlStream.writeAttribute( "vy", QString::number( getVertex( i ).y() ) );
         xmlStream.writeAttribute( "pressure", QString::number( pressure.at( i + 1 ) ) );
         if ( errorLocation < 0 && xmlStream.hasError() )
         {
@@ -114,16 +146,16 @@ Status BezierCurve::createDomElement( QXmlStreamWriter& xmlStream )
                                               << QString( "feather = %1" ).arg( feather )
                                               << QString( "invisible = %1" ).arg( invisible )
                                               << QString( "colourNumber = %1" ).arg( colourNumber )
-                                              << QString( "originX = %1" ).arg( origin.x() )
-                                              << QString( "originY = %1" ).arg( origin.y() )
+                                              << QString( "originX = %1" ).arg( getOrigin().x() )
+                                              << QString( "originY = %1" ).arg( getOrigin().y() )
                                               << QString( "originPressure = %1" ).arg( pressure.at( 0 ) )
                                               << QString( "- segmentTag[%1] has failed to write" ).arg( errorLocation )
-                                              << QString( "&nbsp;&nbsp;c1x = %1" ).arg( c1.at( errorLocation ).x() )
-                                              << QString( "&nbsp;&nbsp;c1y = %1" ).arg( c1.at( errorLocation ).y() )
-                                              << QString( "&nbsp;&nbsp;c2x = %1" ).arg( c2.at( errorLocation ).x() )
-                                              << QString( "&nbsp;&nbsp;c2y = %1" ).arg( c2.at( errorLocation ).y() )
-                                              << QString( "&nbsp;&nbsp;vx = %1" ).arg( vertex.at( errorLocation ).x() )
-                                              << QString( "&nbsp;&nbsp;vy = %1" ).arg( vertex.at( errorLocation ).y() )
+                                              << QString( "&nbsp;&nbsp;c1x = %1" ).arg( getC1( errorLocation ).x() )
+                                              << QString( "&nbsp;&nbsp;c1y = %1" ).arg( getC1( errorLocation ).y() )
+                                              << QString( "&nbsp;&nbsp;c2x = %1" ).arg( getC2( errorLocation ).x() )
+                                              << QString( "&nbsp;&nbsp;c2y = %1" ).arg( getC2( errorLocation ).y() )
+                                              << QString( "&nbsp;&nbsp;vx = %1" ).arg( getVertex( errorLocation ).x() )
+                                              << QString( "&nbsp;&nbsp;vy = %1" ).arg( getVertex( errorLocation ).y() )
                                               << QString( "&nbsp;&nbsp;pressure = %1" ).arg( pressure.at( errorLocation + 1 ) );
 
         return Status( Status::FAIL, debugInfo );
@@ -140,7 +172,7 @@ void BezierCurve::loadDomElement(QDomElement element)
     invisible = (element.attribute("invisible") == "1");
     if (width == 0) invisible = true;
     colourNumber = element.attribute("colourNumber").toInt();
-    origin = QPointF( element.attribute("originX").toFloat(), element.attribute("originY").toFloat() );
+    setOrigin( QPointF( element.attribute("originX").toFloat(), element.attribute("originY").toFloat() ) );
     pressure.append( element.attribute("originPressure").toFloat() );
     selected.append(false);
 
@@ -163,24 +195,108 @@ void BezierCurve::loadDomElement(QDomElement element)
     }
 }
 
+// Reads the curve the reader is positioned on, up to its end element
+void BezierCurve::loadDomElement(QXmlStreamReader& xmlStream)
+{
+    QXmlStreamAttributes attributes = xmlStream.attributes();
+    width = attributes.value("width").toDouble();
+    variableWidth = (attributes.value("variableWidth") == "1");
+    feather = attributes.value("feather").toDouble();
+    invisible = (attributes.value("invisible") == "1");
+    if (width == 0) invisible = true;
+    colourNumber = attributes.value("colourNumber").toInt();
+    setOrigin( QPointF( attributes.value("originX").toFloat(), attributes.value("originY").toFloat() ) );
+    pressure.append( attributes.value("originPressure").toFloat() );
+    selected.append(false);
+
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == "segment")
+        {
+            QXmlStreamAttributes segment = xmlStream.attributes();
+            QPointF c1Point = QPointF(segment.value("c1x").toFloat(), segment.value("c1y").toFloat());
+            QPointF c2Point = QPointF(segment.value("c2x").toFloat(), segment.value("c2y").toFloat());
+            QPointF vertexPoint = QPointF(segment.value("vx").toFloat(), segment.value("vy").toFloat());
+            qreal pressureValue = segment.value("pressure").toFloat();
+            appendCubic(c1Point, c2Point, vertexPoint, pressureValue);
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
+
+// Same content as the xml element, with the control points packed in arrays of floats
+void BezierCurve::writeBinary(QDataStream& out) const
+{
+    out << qint32(colourNumber) << width << feather << variableWidth << invisible;
+    out << points.at(0) << points.at(1);
+
+    qint32 n = getVertexSize();
+    out << n;
+    for (int offset : { 2, 4, 6 }) // all the c1, then all the c2 and the vertices
+    {
+        for (int i = 0; i < n; i++)
+        {
+            out << points.at(offset + 6*i) << points.at(offset + 6*i + 1);
+        }
+    }
+    for (float p : pressure)
+    {
+        out << p;
+    }
+}
+
+void BezierCurve::readBinary(QDataStream& in)
+{
+    qint32 colour = 0;
+    float x = 0, y = 0;
+    in >> colour >> width >> feather >> variableWidth >> invisible;
+    in >> x >> y;
+    colourNumber = colour;
+    points.resize(2);
+    points[0] = x;
+    points[1] = y;
+
+    qint32 n = 0;
+    in >> n;
+    if (n < 0 || in.status() != QDataStream::Ok) return;
+
+    points.resize(2 + 6*n);
+    for (int offset : { 2, 4, 6 })
+    {
+        for (int i = 0; i < n; i++)
+        {
+            in >> points[offset + 6*i] >> points[offset + 6*i + 1];
+        }
+    }
+    pressure.clear();
+    pressure.reserve(n + 1);
+    for (int i = 0; i <= n; i++)
+    {
+        float p = 0;
+        in >> p;
+        pressure.append(p);
+    }
+    selected.fill(false, n + 1);
+    selectedCount = 0;
+}
 
 void BezierCurve::setOrigin(const QPointF& point)
 {
-    origin = point;
+    setPointAt(0, point);
 }
 
 void BezierCurve::setOrigin(const QPointF& point, const qreal& pressureValue, const bool& trueOrFalse)
 {
-    origin = point;
+    setPointAt(0, point);
     pressure[0] = pressureValue;
-    selected[0] = trueOrFalse;
+    setSelected(-1, trueOrFalse);
 }
 
 void BezierCurve::setC1(int i, const QPointF& point)
 {
-    if ( i >= 0 || i < c1.size() )
+    if ( i >= 0 || i < getVertexSize() )
     {
-        c1[i] = point;
+        setPointAt(2 + 6*i, point);
     }
     else
     {
@@ -190,9 +306,9 @@ void BezierCurve::setC1(int i, const QPointF& point)
 
 void BezierCurve::setC2(int i, const QPointF& point)
 {
-    if ( i >= 0 || i < c2.size() )
+    if ( i >= 0 || i < getVertexSize() )
     {
-        c2[i] = point;
+        setPointAt(4 + 6*i, point);
     }
     else
     {
@@ -202,12 +318,12 @@ void BezierCurve::setC2(int i, const QPointF& point)
 
 void BezierCurve::setVertex(int i, const QPointF& point)
 {
-    if (i==-1) { origin = point; }
+    if (i==-1) { setOrigin(point); }
     else
     {
-        if ( i >= 0 || i < vertex.size() )
+        if ( i >= 0 || i < getVertexSize() )
         {
-            vertex[i] = point;
+            setPointAt(6*(i+1), point);
         }
         else
         {
@@ -218,9 +334,9 @@ void BezierCurve::setVertex(int i, const QPointF& point)
 
 void BezierCurve::setLastVertex(const QPointF& point)
 {
-    if (vertex.size()>0)
+    if (getVertexSize()>0)
     {
-        vertex[vertex.size()-1] = point;
+        setPointAt(points.size()-2, point);
     }
     else
     {
@@ -251,52 +367,30 @@ void BezierCurve::setInvisibility(bool YesOrNo)
 
 void BezierCurve::setSelected(int i, bool YesOrNo)
 {
-    selected[i+1] = YesOrNo;
+    if (selected.at(i+1) != YesOrNo)
+    {
+        selected[i+1] = YesOrNo;
+        selectedCount += YesOrNo ? 1 : -1;
+    }
 }
 
-BezierCurve BezierCurve::transformed(QTransform transformation)
+BezierCurve BezierCurve::transformed(QTransform transformation) const
 {
     BezierCurve transformedCurve = *this; // copy the curve
-    if (isSelected(-1)) { transformedCurve.setOrigin(transformation.map(origin)); }
-    for(int i=0; i< vertex.size(); i++)
-    {
-        if (isSelected(i-1)) { transformedCurve.setC1(i, transformation.map(c1.at(i))); }
-        if (isSelected(i))
-        {
-            transformedCurve.setC2(i, transformation.map(c2.at(i)));
-            transformedCurve.setVertex(i, transformation.map(vertex.at(i)));
-        }
-    }
-    //transformedCurve.smoothCurve();
-    /*QPointF newOrigin = origin;
-    if (isSelected(-1)) { newOrigin =  transformation.map(newOrigin); }
-    transformedCurve.setOrigin( newOrigin );
-    for(int i=0; i< vertex.size(); i++) {
-    	QPointF newC1 = c1.at(i);
-    	QPointF newC2 = c2.at(i);
-    	QPointF newVertex = vertex.at(i);
-    	if (isSelected(i-1)) { newC1 = transformation.map(newC1); }
-    	if (isSelected(i)) { newC2 = transformation.map(newC2);  newVertex = transformation.map(newVertex); }
-    	transformedCurve.appendCubic( newC1, newC2, newVertex, pressure.at(i) );
-    	if (isSelected(i)) { transformedCurve.setSelected(i, true); }
-    }
-    transformedCurve.setWidth( width);
-    transformedCurve.setVariableWidth( variableWidth );
-    //transformedCurve.setSelected(true); // or select only the selected elements of the orginal curve?
-    */
+    transformedCurve.transform(transformation);
     return transformedCurve;
 }
 
 void BezierCurve::transform(QTransform transformation)
 {
-    if (isSelected(-1)) setOrigin( transformation.map(origin) );
-    for(int i=0; i< vertex.size(); i++)
+    if (isSelected(-1)) setOrigin( transformation.map(getOrigin()) );
+    for(int i=0; i< getVertexSize(); i++)
     {
-        if (isSelected(i-1)) c1[i] = transformation.map(c1.at(i));
+        if (isSelected(i-1)) setC1(i, transformation.map(getC1(i)));
         if (isSelected(i))
         {
-            c2[i] = transformation.map(c2.at(i));
-            vertex[i] = transformation.map(vertex.at(i));
+            setC2(i, transformation.map(getC2(i)));
+            setVertex(i, transformation.map(getVertex(i)));
         }
     }
     //smoothCurve();
@@ -304,13 +398,20 @@ void BezierCurve::transform(QTransform transformation)
 
 void BezierCurve::appendCubic(const QPointF& c1Point, const QPointF& c2Point, const QPointF& vertexPoint, qreal pressureValue)
 {
-    c1.append(c1Point);
-    c2.append(c2Point);
-    vertex.append(vertexPoint);
+    insertSection(getVertexSize(), c1Point, c2Point, vertexPoint);
     pressure.append(pressureValue);
     selected.append(false);
 }
 
+void BezierCurve::insertSection(int i, const QPointF& c1Point, const QPointF& c2Point, const QPointF& vertexPoint)
+{
+    const float section[6] = { float(c1Point.x()), float(c1Point.y()),
+                               float(c2Point.x()), float(c2Point.y()),
+                               float(vertexPoint.x()), float(vertexPoint.y()) };
+    points.insert(2 + 6*i, 6, 0.f);
+    std::copy(section, section + 6, points.begin() + 2 + 6*i);
+}
+
 void BezierCurve::addPoint(int position, const QPointF point)
 {
     if ( position > -1 && position < getVertexSize() )
@@ -320,14 +421,15 @@ void BezierCurve::addPoint(int position, const QPointF point)
         QPointF c1o = getC1(position);
         QPointF c2o = getC2(position);
 
-        c1[position] = point + 0.2*(v2-v1);
-        c2[position] = v2 + (c2o-v2)*(0.5);
+        setC1(position, point + 0.2*(v2-v1));
+        setC2(position, v2 + (c2o-v2)*(0.5));
 
-        c1.insert(position, v1 + (c1o-v1)*(0.5) );
-        c2.insert(position, point - 0.2*(v2-v1));
-        vertex.insert(position, point);
-        pressure.insert(position, getPressure(position));
-        selected.insert(position, isSelected(position) && isSelected(position-1));
+        insertSection(position, v1 + (c1o-v1)*(0.5), point - 0.2*(v2-v1), point);
+        float pressureValue = getPressure(position);
+        pressure.insert(position, pressureValue);
+        bool isPointSelected = isSelected(position) && isSelected(position-1);
+        selected.insert(position, isPointSelected);
+        if (isPointSelected) selectedCount++;
 
         //smoothCurve();
     }
@@ -358,11 +460,12 @@ void BezierCurve::addPoint(int position, const qreal t)    // t is the fraction
         setC1(position, cB1);
         setC2(position, cB2);
 
-        c1.insert(position, cA1);
-        c2.insert(position, cA2);
-        vertex.insert(position, vM);
-        pressure.insert(position, getPressure(position));
-        selected.insert(position, isSelected(position) && isSelected(position-1));
+        insertSection(position, cA1, cA2, vM);
+        float pressureValue = getPressure(position);
+        pressure.insert(position, pressureValue);
+        bool isPointSelected = isSelected(position) && isSelected(position-1);
+        selected.insert(position, isPointSelected);
+        if (isPointSelected) selectedCount++;
 
         //smoothCurve();
     }
@@ -374,43 +477,38 @@ void BezierCurve::addPoint(int position, const qreal t)    // t is the fraction
 
 void BezierCurve::removeVertex(int i)
 {
-    int n = vertex.size();
+    int n = getVertexSize();
     if (i>-2 && i< n)
     {
+        if (selected.at(i+1)) selectedCount--;
+        pressure.remove(i+1);
+        selected.remove(i+1);
+
         if (i== -1)
         {
-            origin = vertex.at(0);
-            vertex.removeAt(0);
-            c1.removeAt(0);
-            c2.removeAt(0);
-            pressure.removeAt(0);
-            selected.removeAt(0);
+            // the first vertex becomes the origin
+            points.remove(0, 6);
+        }
+        else if ( i != n-1 )
+        {
+            // c2 and the vertex of section i, and c1 of section i+1 are next to each other
+            points.remove(4 + 6*i, 6);
         }
         else
         {
-            vertex.removeAt(i);
-            c2.removeAt(i);
-            pressure.removeAt(i+1);
-            selected.removeAt(i+1);
-            if ( i != n-1 )
-            {
-                c1.removeAt(i+1);
-            }
-            else
-            {
-                c1.removeAt(i);
-            }
+            points.remove(2 + 6*i, 6);
         }
     }
 }
 
-void BezierCurve::drawPath(QPainter& painter, Object* object, QTransform transformation, bool simplified, bool showThinLines )
+void BezierCurve::drawPath(QPainter& painter, Object* object, QTransform transformation, bool simplified, bool showThinLines ) const
 {
     QColor colour = object->getColour(colourNumber).colour;
 
-    BezierCurve myCurve;
-    if (isPartlySelected()) { myCurve = (transformed(transformation)); }
-    else { myCurve = *this; }
+    // Only a curve with selected points is copied, to be drawn transformed
+    BezierCurve transformedCurve;
+    if (isPartlySelected()) { transformedCurve = transformed(transformation); }
+    const BezierCurve& myCurve = isPartlySelected() ? transformedCurve : *this;
 
     if ( variableWidth && !simplified && !invisible)
     {
@@ -464,7 +562,7 @@ void BezierCurve::drawPath(QPainter& painter, Object* object, QTransform transfo
         if (isSelected()) painter.drawPath(myCurve.getSimplePath());
 
 
-        for(int i=-1; i< vertex.size(); i++)
+        for(int i=-1; i< getVertexSize(); i++)
         {
             if (isSelected(i))
             {
@@ -486,47 +584,48 @@ void BezierCurve::drawPath(QPainter& painter, Object* object, QTransform transfo
 }
 
 // Without curve fitting
-QPainterPath BezierCurve::getStraightPath()
+QPainterPath BezierCurve::getStraightPath() const
 {
     QPainterPath path;
-    path.moveTo(origin);
-    for(int i=0; i<vertex.size(); i++)
+    path.moveTo(getOrigin());
+    for(int i=0; i<getVertexSize(); i++)
     {
-        path.lineTo(vertex[i]);
+        path.lineTo(getVertex(i));
     }
     return path;
 }
 
 // With bezier curve fitting
-QPainterPath BezierCurve::getSimplePath()
+QPainterPath BezierCurve::getSimplePath() const
 {
     QPainterPath path;
-    path.moveTo(origin);
-    for(int i=0; i<vertex.size(); i++)
+    path.moveTo(getOrigin());
+    for(int i=0; i<getVertexSize(); i++)
     {
-        path.cubicTo(c1.at(i), c2.at(i), vertex.at(i));
+        path.cubicTo(getC1(i), getC2(i), getVertex(i));
     }
     return path;
 }
 
-QPainterPath BezierCurve::getStrokedPath()
+QPainterPath BezierCurve::getStrokedPath() const
 {
     return getStrokedPath( width );
 }
 
-QPainterPath BezierCurve::getStrokedPath(qreal width)
+QPainterPath BezierCurve::getStrokedPath(qreal width) const
 {
     return getStrokedPath(width, true);
 }
 
-QPainterPath BezierCurve::getStrokedPath(qreal width, bool usePressure)
+QPainterPath BezierCurve::getStrokedPath(qreal width, bool usePressure) const
 {
     QPainterPath path;
     QPointF tangentVec, normalVec, normalVec2, normalVec2_1, normalVec2_2;
     qreal width2 = width;
     path.setFillRule(Qt::WindingFill);
-    int n = vertex.size();
-    normalVec = QPointF(-(c1.at(0) - origin).y(), (c1.at(0) - origin).x());
+    int n = getVertexSize();
+    QPointF origin = getOrigin();
+    normalVec = QPointF(-(getC1(0) - origin).y(), (getC1(0) - origin).x());
     normalise(normalVec);
     if (usePressure) width2 = width * 0.5 * pressure.at(0);
     if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
@@ -535,13 +634,13 @@ QPainterPath BezierCurve::getStrokedPath(qreal width, bool usePressure)
     {
         if (i==n-1)
         {
-            normalVec2 = QPointF(-(vertex.at(i) - c2.at(i)).y(), (vertex.at(i) - c2.at(i)).x());
+            normalVec2 = QPointF(-(getVertex(i) - getC2(i)).y(), (getVertex(i) - getC2(i)).x());
         }
         else
         {
-            normalVec2_1 = QPointF(-(vertex.at(i) - c2.at(i)).y(), (vertex.at(i) - c2.at(i)).x());
+            normalVec2_1 = QPointF(-(getVertex(i) - getC2(i)).y(), (getVertex(i) - getC2(i)).x());
             normalise(normalVec2_1);
-            normalVec2_2 = QPointF(-(c1.at(i+1) - vertex.at(i)).y(), (c1.at(i+1) - vertex.at(i)).x());
+            normalVec2_2 = QPointF(-(getC1(i+1) - getVertex(i)).y(), (getC1(i+1) - getVertex(i)).x());
             normalise(normalVec2_2);
             normalVec2 = normalVec2_1 + normalVec2_2;
         }
@@ -549,39 +648,39 @@ QPainterPath BezierCurve::getStrokedPath(qreal width, bool usePressure)
         if (usePressure) width2 = width * 0.5 * pressure.at(i);
         if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
         //if (i==n-1) width2 = 0.0;
-        path.cubicTo(c1.at(i) + width2*normalVec, c2.at(i) + width2*normalVec2, vertex.at(i) + width2*normalVec2);
-        //path.moveTo(vertex.at(i) + width*normalVec2);
-        //path.lineTo(vertex.at(i) - width*normalVec2);
+        path.cubicTo(getC1(i) + width2*normalVec, getC2(i) + width2*normalVec2, getVertex(i) + width2*normalVec2);
+        //path.moveTo(getVertex(i) + width*normalVec2);
+        //path.lineTo(getVertex(i) - width*normalVec2);
         normalVec = normalVec2;
     }
     if (usePressure) width2 = width * 0.5 * pressure.at(n-1);
     if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
 
-    //path.lineTo(vertex.at(n-1) - width2*normalVec);
-    tangentVec = (vertex.at(n-1)-c2.at(n-1));
+    //path.lineTo(getVertex(n-1) - width2*normalVec);
+    tangentVec = (getVertex(n-1)-getC2(n-1));
     normalise(tangentVec);
-    path.cubicTo(vertex.at(n-1) + width2*(normalVec+1.8*tangentVec), vertex.at(n-1) + width2*(-normalVec+1.8*tangentVec), vertex.at(n-1) - width2*normalVec);
+    path.cubicTo(getVertex(n-1) + width2*(normalVec+1.8*tangentVec), getVertex(n-1) + width2*(-normalVec+1.8*tangentVec), getVertex(n-1) - width2*normalVec);
 
     for(int i=n-2; i>=0; i--)
     {
-        normalVec2_1 = QPointF((vertex.at(i) - c1.at(i+1)).y(), -(vertex.at(i) - c1.at(i+1)).x());
+        normalVec2_1 = QPointF((getVertex(i) - getC1(i+1)).y(), -(getVertex(i) - getC1(i+1)).x());
         normalise(normalVec2_1);
-        normalVec2_2 = QPointF((c2.at(i) - vertex.at(i)).y(), -(c2.at(i) - vertex.at(i)).x());
+        normalVec2_2 = QPointF((getC2(i) - getVertex(i)).y(), -(getC2(i) - getVertex(i)).x());
         normalise(normalVec2_2);
         normalVec2 = normalVec2_1 + normalVec2_2;
         normalise(normalVec2);
         if (usePressure) width2 = width * 0.5 * pressure.at(i);
         if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
-        path.cubicTo(c2.at(i+1) - width2*normalVec, c1.at(i+1) - width2*normalVec2, vertex.at(i) - width2*normalVec2);
+        path.cubicTo(getC2(i+1) - width2*normalVec, getC1(i+1) - width2*normalVec2, getVertex(i) - width2*normalVec2);
         normalVec = normalVec2;
     }
-    normalVec2 = QPointF((origin - c1.at(0)).y(), -(origin - c1.at(0)).x());
+    normalVec2 = QPointF((origin - getC1(0)).y(), -(origin - getC1(0)).x());
     normalise(normalVec2);
     if (usePressure) width2 = width * 0.5 * pressure.at(0);
     if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
-    path.cubicTo(c2.at(0) - width2*normalVec, c1.at(0) - width2*normalVec2, origin - width2*normalVec2);
+    path.cubicTo(getC2(0) - width2*normalVec, getC1(0) - width2*normalVec2, origin - width2*normalVec2);
 
-    tangentVec = (origin-c1.at(0));
+    tangentVec = (origin-getC1(0));
     normalise(tangentVec);
     path.cubicTo(origin + width2*(-normalVec+1.8*tangentVec), origin + width2*(normalVec+1.8*tangentVec), origin + width2*normalVec);
 
@@ -589,7 +688,7 @@ QPainterPath BezierCurve::getStrokedPath(qreal width, bool usePressure)
     return path;
 }
 
-QRectF BezierCurve::getBoundingRect()
+QRectF BezierCurve::getBoundingRect() const
 {
     return getSimplePath().boundingRect();
 }
@@ -600,11 +699,14 @@ void BezierCurve::createCurve(QList<QPointF>& pointList, QList<qreal>& pressureL
     int n = pointList.size();
     // generate the Bezier (cubic) curve from the simplified path and mouse pressure
     // first, empty everything
-    while (c1.size()>0) c1.removeAt(0);
-    while (c2.size()>0) c2.removeAt(0);
-    while (vertex.size()>0) vertex.removeAt(0);
-    while (selected.size()>0) selected.removeAt(0);
-    while (pressure.size()>0) pressure.removeAt(0);
+    points.resize(2);
+    pressure.clear();
+    selected.clear();
+    selectedCount = 0;
+
+    points.reserve(2 + 6*(n-1));
+    pressure.reserve(n);
+    selected.reserve(n);
 
     setOrigin( pointList.at(0) );
     selected.append(false);
@@ -612,12 +714,7 @@ void BezierCurve::createCurve(QList<QPointF>& pointList, QList<qreal>& pressureL
 
     for(p=1; p<n; p++)
     {
-        c1.append(pointList.at(p));
-        c2.append(pointList.at(p));
-        vertex.append(pointList.at(p));
-        pressure.append(pressureList.at(p));
-        selected.append(false);
-
+        appendCubic(pointList.at(p), pointList.at(p), pointList.at(p), pressureList.at(p));
     }
     smoothCurve();
     //colourNumber = 0;
@@ -628,7 +725,7 @@ void BezierCurve::createCurve(QList<QPointF>& pointList, QList<qreal>& pressureL
 void BezierCurve::smoothCurve()
 {
     QPointF c1, c2, c2old, tangentVec, normalVec;
-    int n = vertex.size();
+    int n = getVertexSize();
     c2old = QPointF(-100,-100); // bogus point
     for(int p=0; p<n-1; p++)
     {
@@ -655,18 +752,18 @@ void BezierCurve::smoothCurve()
 
         if (p==0)
         {
-            c2old  = 0.5*(vertex.at(0)+c1);
+            c2old  = 0.5*(getVertex(0)+c1);
         }
 
-        this->c1[p] = c2old;
-        this->c2[p] = c1;
+        setC1(p, c2old);
+        setC2(p, c1);
         //appendCubic(c2old, c1, D, pressureList->at(p));
         c2old = c2;
     }
     if (n>2)
     {
-        this->c1[n-1] = c2old;
-        this->c2[n-1] = 0.5*(c2old+vertex.at(n-1));
+        setC1(n-1, c2old);
+        setC2(n-1, 0.5*(c2old+getVertex(n-1)));
     }
 }
 
@@ -743,10 +840,13 @@ void BezierCurve::normalise(QPointF& point)
     }
 }
 
-qreal BezierCurve::findDistance(BezierCurve curve, int i, QPointF P, QPointF& nearestPoint, qreal& t)   //finds the distance between a cubic section and a point
+qreal BezierCurve::findDistance(const BezierCurve& curve, int i, QPointF P, QPointF& nearestPoint, qreal& t)   //finds the distance between a cubic section and a point
 {
     //qDebug() << "---- INTER CUBIC SEGMENT";
-    int nSteps = 24;
+    int nSteps = CUBIC_STEPS;
+    qreal xs[CUBIC_STEPS + 1], ys[CUBIC_STEPS + 1];
+    curve.sampleCubic(i, xs, ys);
+
     QPointF Q;
     Q = curve.getVertex(i-1);
     qreal distMin = eLength(Q-P);
@@ -755,7 +855,7 @@ qreal BezierCurve::findDistance(BezierCurve curve, int i, QPointF P, QPointF& ne
     for(int k=1; k<=nSteps; k++)
     {
         qreal s = (k+0.0)/nSteps;
-        Q = curve.getPointOnCubic(i, s);
+        Q = QPointF(xs[k], ys[k]);
         qreal dist = eLength(Q-P);
         if (dist <= distMin)
         {
@@ -768,7 +868,7 @@ qreal BezierCurve::findDistance(BezierCurve curve, int i, QPointF P, QPointF& ne
     return distMin;
 }
 
-QPointF BezierCurve::getPointOnCubic(int i, qreal t)
+QPointF BezierCurve::getPointOnCubic(int i, qreal t) const
 {
     return (1.0-t)*(1.0-t)*(1.0-t)*getVertex(i-1)
            + 3*t*(1.0-t)*(1.0-t)*getC1(i)
@@ -776,8 +876,21 @@ QPointF BezierCurve::getPointOnCubic(int i, qreal t)
            + t*t*t*getVertex(i);
 }
 
+// Same points as getPointOnCubic(i, k / CUBIC_STEPS), all at once. The section is
+// read in place and the loop has no dependencies between steps, it vectorises.
+void BezierCurve::sampleCubic(int i, qreal* xs, qreal* ys) const
+{
+    const CubicWeights& w = cubicWeights();
+    const float* section = getSection(i);
+    for (int k = 0; k <= CUBIC_STEPS; k++)
+    {
+        xs[k] = w.w0[k]*section[0] + w.w1[k]*section[2] + w.w2[k]*section[4] + w.w3[k]*section[6];
+        ys[k] = w.w0[k]*section[1] + w.w1[k]*section[3] + w.w2[k]*section[5] + w.w3[k]*section[7];
+    }
+}
 
-bool BezierCurve::intersects(QPointF point, qreal distance)
+
+bool BezierCurve::intersects(QPointF point, qreal distance) const
 {
     bool result = false;
     if ( getStrokedPath(distance, false).contains(point) )
@@ -788,12 +901,12 @@ bool BezierCurve::intersects(QPointF point, qreal distance)
     return result;
 }
 
-bool BezierCurve::intersects(QRectF rectangle)
+bool BezierCurve::intersects(QRectF rectangle) const
 {
     bool result = false;
     if ( getSimplePath().controlPointRect().intersects(rectangle))
     {
-        for(int i=0; i<vertex.size(); i++)
+        for(int i=0; i<getVertexSize(); i++)
         {
             if ( rectangle.contains( getVertex(i) ) ) return true;
         }
@@ -801,7 +914,7 @@ bool BezierCurve::intersects(QRectF rectangle)
     return result;
 }
 
-bool BezierCurve::findIntersection(BezierCurve curve1, int i1, BezierCurve curve2, int i2, QList<Intersection>& intersections)   //finds the intersection between two cubic sections
+bool BezierCurve::findIntersection(const BezierCurve& curve1, int i1, const BezierCurve& curve2, int i2, QList<Intersection>& intersections)   //finds the intersection between two cubic sections
 {
     bool result = false;
     //qDebug() << "---- INTER CUBIC CUBIC"  << i1 << i2;
@@ -833,17 +946,28 @@ bool BezierCurve::findIntersection(BezierCurve curve1, int i1, BezierCurve curve
         //if (intersectionPoint != curve1.getVertex(i1-1) && intersectionPoint != curve1.getVertex(i1)) {
         //	qDebug() << "                   it's not one of the points ";
         // find the cubic intersection
-        int nSteps = 24;
+        // Both sections are sampled once, rather than for every pair of steps
+        int nSteps = CUBIC_STEPS;
+        qreal xs1[CUBIC_STEPS + 1], ys1[CUBIC_STEPS + 1];
+        qreal xs2[CUBIC_STEPS + 1], ys2[CUBIC_STEPS + 1];
+        curve1.sampleCubic(i1, xs1, ys1);
+        curve2.sampleCubic(i2, xs2, ys2);
+
         P1 = curve1.getVertex(i1-1);
         for(int i=1; i<=nSteps; i++)
         {
-            qreal s = (i+0.0)/nSteps;
-            Q1 = curve1.getPointOnCubic(i1, s);
+            Q1 = QPointF(xs1[i], ys1[i]);
             P2 = curve2.getVertex(i2-1);
             for(int j=1; j<=nSteps; j++)
             {
-                qreal t = (j+0.0)/nSteps;
-                Q2 = curve2.getPointOnCubic(i2, t);
+                Q2 = QPointF(xs2[j], ys2[j]);
+                // steps whose boxes are apart can't cross
+                if ( qMax(P1.x(), Q1.x()) < qMin(P2.x(), Q2.x()) || qMax(P2.x(), Q2.x()) < qMin(P1.x(), Q1.x()) ||
+                     qMax(P1.y(), Q1.y()) < qMin(P2.y(), Q2.y()) || qMax(P2.y(), Q2.y()) < qMin(P1.y(), Q1.y()) )
+                {
+                    P2 = Q2;
+                    continue;
+                }
                 L1 = QLineF(P1, Q1);
                 L2 = QLineF(P2, Q2);
                 if (L2.intersect(L1, cubicIntersection) == QLineF::BoundedIntersection)
@@ -18,6 +18,8 @@ GNU General Public License for more details.
 
 #include <QtXml>
 #include <QPainter>
+#include <QVector>
+#include "vertexref.h"
 
 class Object;
 class Status;
@@ -37,24 +39,31 @@ public:
 
     Status createDomElement(QXmlStreamWriter &xmlStream);
     void loadDomElement(QDomElement element);
+    void loadDomElement(QXmlStreamReader& xmlStream);
+    void writeBinary(QDataStream& out) const;
+    void readBinary(QDataStream& in);
 
     qreal getWidth() const { return width; }
     qreal getFeather() const { return feather; }
     bool getVariableWidth() const { return variableWidth; }
     int getColourNumber() const { return colourNumber; }
     void decreaseColourNumber() { colourNumber--; }
-    int getVertexSize() const { return vertex.size(); }
-    QPointF getOrigin() const {	return origin; }
-    QPointF getVertex(int i) const { if (i==-1) { return origin; } else { return vertex.at(i);} }
-    QPointF getC1(int i) const { return c1.at(i); }
-    QPointF getC2(int i) const { return c2.at(i); }
+    int getVertexSize() const { return (points.size() - 2) / 6; }
+    QPointF getOrigin() const { return pointAt(0); }
+    QPointF getVertex(int i) const { return pointAt(6*(i+1)); }
+    QPointF getC1(int i) const { return pointAt(2 + 6*i); }
+    QPointF getC2(int i) const { return pointAt(4 + 6*i); }
     qreal getPressure(int i) const { return pressure.at(i); }
     bool isSelected(int i) const { return selected.at(i+1); }
-    bool isSelected() const { bool result=true; for(int i=0; i<selected.size(); i++) result = result && selected[i]; return result; }
-    bool isPartlySelected() const { bool result=false; for(int i=0; i<selected.size(); i++) result = result || selected[i]; return result; }
+    bool isSelected() const { return selectedCount == selected.size(); }
+    bool isPartlySelected() const { return selectedCount > 0; }
     bool isInvisible() const { return invisible; }
-    bool intersects(QPointF point, qreal distance);
-    bool intersects(QRectF rectangle);
+    CurveId getId() const { return id; }
+    bool intersects(QPointF point, qreal distance) const;
+    bool intersects(QRectF rectangle) const;
+
+    // The cubic section i as 8 floats: start vertex, c1, c2 and end vertex (x, y each)
+    const float* getSection(int i) const { return points.constData() + 6*i; }
 
     void setOrigin(const QPointF& point);
     void setOrigin(const QPointF& point, const qreal& pressureValue, const bool& trueOrFalse);
@@ -67,25 +76,27 @@ public:
     void setVariableWidth(bool YesOrNo);
     void setInvisibility(bool YesOrNo);
     void setColourNumber(int colourNumber) { this->colourNumber = colourNumber; }
-    void setSelected(bool YesOrNo) { for(int i=0; i<selected.size(); i++) { selected[i] = YesOrNo; } }
+    void setId(CurveId curveId) { id = curveId; } // given by the VectorImage the curve is in
+    void setSelected(bool YesOrNo) { selected.fill(YesOrNo); selectedCount = YesOrNo ? selected.size() : 0; }
     void setSelected(int i, bool YesOrNo);
 
-    BezierCurve transformed(QTransform transformation);
+    BezierCurve transformed(QTransform transformation) const;
     void transform(QTransform transformation);
 
     void appendCubic(const QPointF& c1Point, const QPointF& c2Point, const QPointF& vertexPoint, qreal pressureValue);
     void addPoint(int position, const QPointF point);
     void addPoint(int position, const qreal t);
-    QPointF getPointOnCubic(int i, qreal t);
+    QPointF getPointOnCubic(int i, qreal t) const;
+    void sampleCubic(int i, qreal* xs, qreal* ys) const;
     void removeVertex(int i);
-    QPainterPath getStraightPath();
-    QPainterPath getSimplePath();
-    QPainterPath getStrokedPath();
-    QPainterPath getStrokedPath(qreal width);
-    QPainterPath getStrokedPath(qreal width, bool pressure);
-    QRectF getBoundingRect();
-
-    void drawPath(QPainter& painter, Object* object, QTransform transformation, bool simplified, bool showThinLines );
+    QPainterPath getStraightPath() const;
+    QPainterPath getSimplePath() const;
+    QPainterPath getStrokedPath() const;
+    QPainterPath getStrokedPath(qreal width) const;
+    QPainterPath getStrokedPath(qreal width, bool pressure) const;
+    QRectF getBoundingRect() const;
+
+    void drawPath(QPainter& painter, Object* object, QTransform transformation, bool simplified, bool showThinLines ) const;
     void createCurve(QList<QPointF>& pointList, QList<qreal>& pressureList );
     void smoothCurve();
 
@@ -95,21 +106,28 @@ public:
     static qreal eLength(const QPointF point); // returns the Euclidean length of a point (seen as a vector)
     static qreal mLength(const QPointF point); // returns the Manhattan length of a point (seen as a vector)
     static void normalise(QPointF& point); // normalises a point (seen as a vector);
-    static qreal findDistance(BezierCurve curve, int i, QPointF P, QPointF& nearestPoint, qreal& t); //finds the distance between a cubic section and a point
-    static bool findIntersection(BezierCurve curve1, int i1, BezierCurve curve2, int i2, QList<Intersection>& intersections); //finds the intersection between two cubic sections
+    static qreal findDistance(const BezierCurve& curve, int i, QPointF P, QPointF& nearestPoint, qreal& t); //finds the distance between a cubic section and a point
+    static bool findIntersection(const BezierCurve& curve1, int i1, const BezierCurve& curve2, int i2, QList<Intersection>& intersections); //finds the intersection between two cubic sections
+
+    static const int CUBIC_STEPS = 24; // sampleCubic() gives CUBIC_STEPS + 1 points
 
 private:
-    QPointF origin;
-    QList<QPointF> c1;
-    QList<QPointF> c2;
-    QList<QPointF> vertex;
-    QList<float> pressure; // this list has one more element than the other list (the first element is for the origin)
-    int colourNumber;
-    float width;
-    float feather;
-    bool variableWidth;
-    bool invisible;
-    QList<bool> selected; // this list has one more element than the other list (the first element is for the origin)
+    QPointF pointAt(int index) const { return QPointF(points.at(index), points.at(index+1)); }
+    void setPointAt(int index, const QPointF& point) { points[index] = point.x(); points[index+1] = point.y(); }
+    void insertSection(int i, const QPointF& c1Point, const QPointF& c2Point, const QPointF& vertexPoint);
+
+    // Packed, the origin then c1, c2 and vertex of each cubic section. Section i
+    // starts at 6*i and is followed by its end vertex, it can be evaluated in place.
+    QVector<float> points = QVector<float>(2, 0.f);
+    QVector<float> pressure; // this list has one more element than the number of sections (the first element is for the origin)
+    QVector<bool> selected; // this list has one more element than the number of sections (the first element is for the origin)
+    int selectedCount = 0; // selected elements, so that whole curve queries don't walk the list
+    CurveId id;
+    int colourNumber = 0;
+    float width = 0.f;
+    float feather = 0.f;
+    bool variableWidth = false;
+    bool invisible = false;
 };
 
 #endif
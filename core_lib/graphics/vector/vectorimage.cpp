@@ -15,6 +15,7 @@ GNU General Public License for more details.
 
 */
 #include <cmath>
+#include <algorithm>
 #include "object.h"
 #include "vectorimage.h"
 
@@ -42,22 +43,33 @@ bool VectorImage::read(QString filePath)
         //QMessageBox::warning(this, "Warning", "Cannot read file");
         return false;
     }
+    return read(&file);
+}
 
-    QDomDocument doc;
-    if (!doc.setContent(&file)) return false; // this is not a XML file
-    QDomDocumentType type = doc.doctype();
-    if (type.name() != "PencilVectorImage") return false; // this is not a Pencil document
+bool VectorImage::read(QIODevice* device)
+{
+    // Parsed straight into the curves, no dom tree is built for the file
+    QXmlStreamReader xmlStream(device);
+    bool isPencilDocument = false;
+    while (xmlStream.readNext() != QXmlStreamReader::StartElement)
+    {
+        if (xmlStream.hasError()) return false; // this is not a XML file
+        if (xmlStream.isDTD())
+        {
+            isPencilDocument = (xmlStream.dtdName() == "PencilVectorImage");
+        }
+    }
+    if (!isPencilDocument) return false; // this is not a Pencil document
 
-    QDomElement element = doc.documentElement();
-    if (element.tagName() == "image")
+    if (xmlStream.name() == "image")
     {
         // --- vector image ---
-        if (element.attribute("type") == "vector")
+        if (xmlStream.attributes().value("type") == "vector")
         {
-            loadDomElement( element );
+            loadDomElement( xmlStream );
         }
     }
-    return true;
+    return !xmlStream.hasError();
 }
 
 Status VectorImage::write(QString filePath, QString format)
@@ -74,27 +86,11 @@ Status VectorImage::write(QString filePath, QString format)
 
     if (format == "VEC")
     {
-        QXmlStreamWriter xmlStream( &file );
-        xmlStream.setAutoFormatting( true);
-        xmlStream.writeStartDocument();
-        xmlStream.writeDTD( "<!DOCTYPE PencilVectorImage>" );
-
-        xmlStream.writeStartElement( "image" );
-        xmlStream.writeAttribute( "type", "vector" );
-        Status st = createDomElement( xmlStream );
+        Status st = write( &file );
         if( !st.ok() )
         {
-            QStringList xmlDetails = st.detailsList();
-            for ( QString detail : xmlDetails )
-            {
-                detail.prepend( "&nbsp;&nbsp;" );
-            }
-            return Status( Status::FAIL, debugInfo << "- xml creation failed" << xmlDetails );
+            return Status( Status::FAIL, debugInfo << st.detailsList() );
         }
-
-        xmlStream.writeEndElement(); // Close image element
-        xmlStream.writeEndDocument();
-
         return Status::OK;
     }
     else
@@ -104,6 +100,33 @@ Status VectorImage::write(QString filePath, QString format)
     }
 }
 
+// Writes the vec file content, e.g. to a buffer for a project snapshot
+Status VectorImage::write(QIODevice* device)
+{
+    QXmlStreamWriter xmlStream( device );
+    xmlStream.setAutoFormatting( true);
+    xmlStream.writeStartDocument();
+    xmlStream.writeDTD( "<!DOCTYPE PencilVectorImage>" );
+
+    xmlStream.writeStartElement( "image" );
+    xmlStream.writeAttribute( "type", "vector" );
+    Status st = createDomElement( xmlStream );
+    if( !st.ok() )
+    {
+        QStringList xmlDetails = st.detailsList();
+        for ( QString detail : xmlDetails )
+        {
+            detail.prepend( "&nbsp;&nbsp;" );
+        }
+        return Status( Status::FAIL, QStringList() << "VectorImage::write" << "- xml creation failed" << xmlDetails );
+    }
+
+    xmlStream.writeEndElement(); // Close image element
+    xmlStream.writeEndDocument();
+
+    return Status::OK;
+}
+
 Status VectorImage::createDomElement( QXmlStreamWriter& xmlStream )
 {
     QStringList debugInfo = QStringList() << "VectorImage::createDomElement";
@@ -122,7 +145,7 @@ Status VectorImage::createDomElement( QXmlStreamWriter& xmlStream )
     }
     for ( int i = 0; i < area.size(); i++ )
     {
-        Status st = area[ i ].createDomElement( xmlStream );
+        Status st = area[ i ].createDomElement( xmlStream, *this );
         if ( !st.ok() )
         {
             QStringList areaDetails = st.detailsList();
@@ -148,12 +171,12 @@ void VectorImage::loadDomElement(QDomElement element)
             {
                 BezierCurve newCurve = BezierCurve();
                 newCurve.loadDomElement(atomElement);
-                m_curves.append(newCurve);
+                appendCurve(newCurve);
             }
             if (atomElement.tagName() == "area")
             {
                 BezierArea newArea = BezierArea();
-                newArea.loadDomElement(atomElement);
+                newArea.loadDomElement(atomElement, *this);
                 addArea(newArea);
             }
         }
@@ -163,57 +186,200 @@ void VectorImage::loadDomElement(QDomElement element)
     modification();
 }
 
+void VectorImage::loadDomElement(QXmlStreamReader& xmlStream)
+{
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == "curve")
+        {
+            BezierCurve newCurve = BezierCurve();
+            newCurve.loadDomElement(xmlStream);
+            appendCurve(newCurve);
+        }
+        else if (xmlStream.name() == "area")
+        {
+            BezierArea newArea = BezierArea();
+            newArea.loadDomElement(xmlStream, *this);
+            addArea(newArea);
+        }
+        else
+        {
+            xmlStream.skipCurrentElement();
+        }
+    }
+    clean();
+    modification();
+}
+
+// Binary counterpart of the vec file, used by the binary project format
+void VectorImage::writeBinary(QDataStream& out) const
+{
+    out << qint32(m_curves.size());
+    for (const BezierCurve& curve : m_curves)
+    {
+        curve.writeBinary(out);
+    }
+    out << qint32(area.size());
+    for (const BezierArea& bezierArea : area)
+    {
+        bezierArea.writeBinary(out, *this);
+    }
+}
+
+void VectorImage::readBinary(QDataStream& in)
+{
+    qint32 curveCount = 0;
+    in >> curveCount;
+    for (int i = 0; i < curveCount && in.status() == QDataStream::Ok; i++)
+    {
+        BezierCurve newCurve;
+        newCurve.readBinary(in);
+        appendCurve(newCurve);
+    }
+
+    qint32 areaCount = 0;
+    in >> areaCount;
+    for (int i = 0; i < areaCount && in.status() == QDataStream::Ok; i++)
+    {
+        BezierArea newArea;
+        newArea.readBinary(in, *this);
+        addArea(newArea);
+    }
+    clean();
+    modification();
+}
+
 void VectorImage::addPoint(int curveNumber, int vertexNumber, qreal t)
 {
     //curve[curveNumber].addPoint(vertexNumber, point);
     m_curves[curveNumber].addPoint(vertexNumber, t);
-    // updates the bezierAreas
-    for(int j=0; j < area.size(); j++)
+    // updates the bezierAreas which use the curve
+    CurveId curveId = getCurveId(curveNumber);
+    for(int j : getAreasUsingCurve(curveId))
     {
+        QList<AreaVertex>& vertices = area[j].mVertex;
         // shift the references of all the points beyond the new point
-        for(int k=0; k< area.at(j).mVertex.size(); k++)
+        for(int k=0; k< vertices.size(); k++)
         {
-            if (area[j].getVertexRef(k).curveNumber == curveNumber)
+            if (vertices.at(k).curve == curveId && vertices.at(k).vertexNumber >= vertexNumber)
             {
-                if (area[j].getVertexRef(k).vertexNumber >= vertexNumber)
-                {
-                    area[j].mVertex[k].vertexNumber++;
-                }
+                vertices[k].vertexNumber++;
             }
         }
         // insert the new point in the area if necessary
-        for(int k=1; k< area.at(j).mVertex.size(); k++)
+        for(int k=1; k< vertices.size(); k++)
         {
-            if ( VertexRef(curveNumber, vertexNumber+1) == area.at(j).mVertex.at(k) )   // area[j].vertex[k] == VertexRef(curveNumber, vertexNumber+1)
+            if ( AreaVertex(curveId, vertexNumber+1) == vertices.at(k) )
             {
-                if ( VertexRef(curveNumber, vertexNumber-1) == area.at(j).mVertex.at(k-1) )
+                if ( AreaVertex(curveId, vertexNumber-1) == vertices.at(k-1) )
                 {
-                    area[j].mVertex.insert(k, VertexRef(curveNumber, vertexNumber) );
+                    vertices.insert(k, AreaVertex(curveId, vertexNumber) );
                 }
             }
-            if ( VertexRef(curveNumber, vertexNumber-1) == area.at(j).mVertex.at(k) )
+            if ( AreaVertex(curveId, vertexNumber-1) == vertices.at(k) )
             {
-                if ( VertexRef(curveNumber, vertexNumber+1) == area.at(j).mVertex.at(k-1) )
+                if ( AreaVertex(curveId, vertexNumber+1) == vertices.at(k-1) )
                 {
-                    area[j].mVertex.insert(k, VertexRef(curveNumber, vertexNumber) );
+                    vertices.insert(k, AreaVertex(curveId, vertexNumber) );
                 }
             }
         }
     }
 }
 
+// Areas keep the ids of their curves, which the removal doesn't change
 void VectorImage::removeCurveAt(int i)
 {
-    // first change the curve numbers in the areas
-    for(int j=0; j < area.size(); j++)
+    QRectF rect = paintedRect(i);
+    releaseCurveId(getCurveId(i));
+    m_curves.removeAt(i);
+    updateCurveNumbers(i);
+    modification(rect);
+}
+
+void VectorImage::appendCurve(const BezierCurve& curve)
+{
+    m_curves.append(curve);
+    assignCurveId(m_curves.size() - 1);
+}
+
+CurveId VectorImage::getCurveId(int curveNumber) const
+{
+    if (curveNumber < 0 || curveNumber >= m_curves.size())
     {
-        for(int k=0; k< area.at(j).mVertex.size(); k++)
+        return CurveId();
+    }
+    return m_curves.at(curveNumber).getId();
+}
+
+int VectorImage::getCurveNumber(CurveId curveId) const
+{
+    if (curveId.slot < 0 || curveId.slot >= mCurveSlots.size() || mSlotGenerations.at(curveId.slot) != curveId.generation)
+    {
+        return -1;
+    }
+    return mCurveSlots.at(curveId.slot);
+}
+
+void VectorImage::assignCurveId(int curveNumber)
+{
+    int slot = -1;
+    if (!mFreeSlots.isEmpty())
+    {
+        slot = mFreeSlots.takeLast();
+    }
+    else
+    {
+        slot = mCurveSlots.size();
+        mCurveSlots.append(-1);
+        mSlotGenerations.append(0);
+    }
+    mCurveSlots[slot] = curveNumber;
+    m_curves[curveNumber].setId(CurveId(slot, mSlotGenerations.at(slot)));
+}
+
+void VectorImage::releaseCurveId(CurveId curveId)
+{
+    if (getCurveNumber(curveId) < 0) return;
+
+    mCurveSlots[curveId.slot] = -1;
+    mSlotGenerations[curveId.slot]++;
+    mFreeSlots.append(curveId.slot);
+}
+
+// After curves were inserted or removed, from firstCurveNumber on
+void VectorImage::updateCurveNumbers(int firstCurveNumber)
+{
+    for(int i = firstCurveNumber; i < m_curves.size(); i++)
+    {
+        mCurveSlots[m_curves.at(i).getId().slot] = i;
+    }
+}
+
+// The list can also have areas which used an earlier curve of the same slot,
+// compare the ids of their vertices
+const QVector<int>& VectorImage::getAreasUsingCurve(CurveId curveId)
+{
+    if (!mIsAreaIndexValid || mAreasOfSlot.size() != mCurveSlots.size())
+    {
+        mAreasOfSlot.fill(QVector<int>(), mCurveSlots.size());
+        for(int j = 0; j < area.size(); j++)
         {
-            if (area.at(j).mVertex[k].curveNumber > i) { area[j].mVertex[k].curveNumber--; }
+            for(const AreaVertex& vertex : area.at(j).mVertex)
+            {
+                int slot = vertex.curve.slot;
+                if (slot < 0 || slot >= mAreasOfSlot.size()) continue;
+
+                QVector<int>& areas = mAreasOfSlot[slot];
+                if (areas.isEmpty() || areas.last() != j) areas.append(j);
+            }
         }
+        mIsAreaIndexValid = true;
     }
-    // then remove curve
-    m_curves.removeAt(i);
+
+    static const QVector<int> noAreas;
+    if (getCurveNumber(curveId) < 0) return noAreas;
+    return mAreasOfSlot.at(curveId.slot);
 }
 
 void VectorImage::insertCurve(int position, BezierCurve& newCurve, qreal factor, bool interacts)
@@ -241,26 +407,20 @@ void VectorImage::insertCurve(int position, BezierCurve& newCurve, qreal factor,
     // Append or insert the curve in the list
     //
     if (position < 0 || position > m_curves.size() - 1) {
-        m_curves.append(newCurve);
+        appendCurve(newCurve);
+        position = m_curves.size() - 1;
     }
     else {
-        // If it's an insert we have to shift the curve numbers in the areas
+        // The areas refer to curves by id, only the curve numbers shift
         //
-        for(int i=0; i < area.size(); i++)
-        {
-            for(int j=0; j< area.at(i).mVertex.size(); j++)
-            {
-                if (area.at(i).mVertex[j].curveNumber >= position) {
-                    area[i].mVertex[j].curveNumber++;
-                }
-            }
-        }
         m_curves.insert(position, newCurve);
+        assignCurveId(position);
+        updateCurveNumbers(position + 1);
     }
 
 
     updateImageSize(newCurve);
-    modification();
+    modification(paintedRect(position));
     //QPainter painter(&image);
     //painter.setRenderHint(QPainter::Antialiasing, true);
     //newCurve.drawPath(&painter);
@@ -308,7 +468,7 @@ void VectorImage::checkCurveExtremity(BezierCurve& newCurve, qreal tolerance)
                     {
                         QPointF nearestPoint = P;
                         qreal t = -1.0;
-                        qreal distance = BezierCurve::findDistance(m_curves[i], j, P, nearestPoint, t);
+                        qreal distance = BezierCurve::findDistance(m_curves.at(i), j, P, nearestPoint, t);
                         if (distance < tolerance)
                         {
                             newCurve.setOrigin(nearestPoint); //qDebug() << "--d " << nearestPoint;
@@ -338,7 +498,7 @@ void VectorImage::checkCurveExtremity(BezierCurve& newCurve, qreal tolerance)
                     {
                         QPointF nearestPoint = Q;
                         qreal t = -1.0;;
-                        qreal distance = BezierCurve::findDistance(m_curves[i], j, Q, nearestPoint, t);
+                        qreal distance = BezierCurve::findDistance(m_curves.at(i), j, Q, nearestPoint, t);
                         if (distance < tolerance)
                         {
                             newCurve.setLastVertex(nearestPoint); //qDebug() << "--g " << nearestPoint;
@@ -545,17 +705,19 @@ void VectorImage::select(QRectF rectangle)
 
 void VectorImage::setSelected(int curveNumber, bool YesOrNo)
 {
+    QRectF rect = paintedRect(curveNumber);
     m_curves[curveNumber].setSelected(YesOrNo);
     if (YesOrNo) mSelectionRect |= m_curves[curveNumber].getBoundingRect();
-    modification();
+    modification(rect | paintedRect(curveNumber));
 }
 
 void VectorImage::setSelected(int curveNumber, int vertexNumber, bool YesOrNo)
 {
+    QRectF rect = paintedRect(curveNumber);
     m_curves[curveNumber].setSelected(vertexNumber, YesOrNo);
     QPointF vertex = getVertex(curveNumber, vertexNumber);
     if (YesOrNo) mSelectionRect |= QRectF(vertex.x(), vertex.y(), 0.0, 0.0);
-    modification();
+    modification(rect | paintedRect(curveNumber));
 }
 
 void VectorImage::setSelected(VertexRef vertexRef, bool YesOrNo)
@@ -583,7 +745,7 @@ void VectorImage::setAreaSelected(int areaNumber, bool YesOrNo)
 {
     area[areaNumber].setSelected(YesOrNo);
     if (YesOrNo) mSelectionRect |= area[areaNumber].mPath.boundingRect();
-    modification();
+    modification(area[areaNumber].mPath.boundingRect());
 }
 
 bool VectorImage::isAreaSelected(int areaNumber)
@@ -689,71 +851,60 @@ void VectorImage::calculateSelectionRect()
 
 void VectorImage::setSelectionTransformation(QTransform transform)
 {
+    // Only the selected curves and their areas move
+    QRectF rect = paintedRectOfSelection();
     mSelectionTransformation = transform;
-    modification();
+    modification(rect | paintedRectOfSelection());
 }
 
 void VectorImage::deleteSelection()
 {
-    // ---- deletes areas
-    for(int i=0; i< area.size(); i++)
+    // ---- deletes curves, marking their slots for the areas below
+    QVector<bool> isSlotDeleted(mCurveSlots.size(), false);
+    for(int i=0; i< m_curves.size(); i++)
     {
-        if ( area[i].isSelected())
+        if ( m_curves.at(i).isSelected())
         {
-            area.removeAt(i);
-            i--;
+            CurveId curveId = getCurveId(i);
+            if (curveId.isNull()) continue;
+            isSlotDeleted[curveId.slot] = true;
+            releaseCurveId(curveId);
         }
     }
-    // ---- deletes curves
-    for(int i=0; i< m_curves.size(); i++)
+    auto curvesEnd = std::remove_if(m_curves.begin(), m_curves.end(), [](const BezierCurve& curve) { return curve.isSelected(); });
+    m_curves.erase(curvesEnd, m_curves.end());
+    updateCurveNumbers(0);
+
+    // ---- deletes areas, the selected ones and those which used deleted curves
+    auto areasEnd = std::remove_if(area.begin(), area.end(), [&](const BezierArea& bezierArea)
     {
-        if ( m_curves[i].isSelected())
+        if (bezierArea.isSelected()) return true;
+        for(const AreaVertex& vertex : bezierArea.mVertex)
         {
-            // eliminates areas which are associated to this curve
-            for(int j=0; j < area.size(); j++)
-            {
-                bool toBeDeleted = false;
-                for(int k=0; k< area.at(j).mVertex.size(); k++)
-                {
-                    if (area.at(j).mVertex[k].curveNumber == i) { toBeDeleted = true; }
-                    if (area.at(j).mVertex[k].curveNumber > i) { area[j].mVertex[k].curveNumber = area[j].mVertex[k].curveNumber - 1; }
-                }
-                if (toBeDeleted)
-                {
-                    area.removeAt(j);
-                    j--;
-                }
-            }
-            m_curves.removeAt(i);
-            i--;
+            int slot = vertex.curve.slot;
+            if (slot >= 0 && slot < isSlotDeleted.size() && isSlotDeleted.at(slot)) return true;
         }
-        else
-        {
-            /*for(int j=-1; j<curve.at(i).size(); j++) {
-                if (curve.at(i).isSelected(j)) {
-                    curve.at(i).removeVertex(j);
-                }
-            }*/
-        }
-    }
+        return false;
+    });
+    area.erase(areasEnd, area.end());
+    mIsAreaIndexValid = false;
+
     modification();
 }
 
 void VectorImage::removeVertex(int i, int m)   // curve number i and vertex number m
 {
+    CurveId curveId = getCurveId(i);
+    QRectF changedRect = paintedRect(i); // the parts stay in it
+
     // first eliminates areas which are associated to this point
-    for(int j=0; j < area.size(); j++)
+    QVector<int> areasUsingCurve = getAreasUsingCurve(curveId);
+    for(int j = areasUsingCurve.size() - 1; j >= 0; j--)
     {
-        bool toBeDeleted = false;
-        for(int k=0; k< area.at(j).mVertex.size(); k++)
-        {
-            if (area.at(j).mVertex[k].curveNumber == i && area.at(j).mVertex[k].vertexNumber == m) { toBeDeleted = true; }
-            //if (area.at(j).vertex[k].curveNumber > i) { area[j].vertex[k].curveNumber = area[j].vertex[k].curveNumber - 1; }
-        }
-        if (toBeDeleted)
+        if (area.at(areasUsingCurve.at(j)).mVertex.contains(AreaVertex(curveId, m)))
         {
-            area.removeAt(j);
-            j--;
+            area.removeAt(areasUsingCurve.at(j));
+            mIsAreaIndexValid = false;
         }
     }
     // then eliminates the point
@@ -769,11 +920,12 @@ void VectorImage::removeVertex(int i, int m)   // curve number i and vertex numb
             m_curves[i].removeVertex(m);
             m--;
             // we also need to update the areas
-            for(int j=0; j < area.size(); j++)
+            for(int j : getAreasUsingCurve(curveId))
             {
-                for(int k=0; k< area.at(j).mVertex.size(); k++)
+                QList<AreaVertex>& vertices = area[j].mVertex;
+                for(int k=0; k< vertices.size(); k++)
                 {
-                    if (area.at(j).mVertex[k].curveNumber == i && area.at(j).mVertex[k].vertexNumber > m) { area[j].mVertex[k].vertexNumber--; }
+                    if (vertices.at(k).curve == curveId && vertices.at(k).vertexNumber > m) { vertices[k].vertexNumber--; }
                 }
             }
         }
@@ -790,18 +942,23 @@ void VectorImage::removeVertex(int i, int m)   // curve number i and vertex numb
                 newCurve.removeVertex(-1);
             }
             //if (newCurve.getVertexSize() > 0) curve.insert(i+1, newCurve);
-            if (newCurve.getVertexSize() > 0) m_curves.append( newCurve); // insert the right part if it has more than one point
-            // we also need to update the areas
-            for(int j=0; j < area.size(); j++)
+            if (newCurve.getVertexSize() > 0) // insert the right part if it has more than one point
             {
-                for(int k=0; k< area.at(j).mVertex.size(); k++)
+                appendCurve(newCurve);
+                CurveId newCurveId = getCurveId(m_curves.size()-1);
+                // we also need to update the areas
+                for(int j : getAreasUsingCurve(curveId))
                 {
-                    if (area.at(j).mVertex[k].curveNumber == i && area.at(j).mVertex[k].vertexNumber > m)
+                    QList<AreaVertex>& vertices = area[j].mVertex;
+                    for(int k=0; k< vertices.size(); k++)
                     {
-                        area[j].mVertex[k].curveNumber = m_curves.size()-1;
-                        area[j].mVertex[k].vertexNumber = area[j].mVertex[k].vertexNumber-m-1;
+                        if (vertices.at(k).curve == curveId && vertices.at(k).vertexNumber > m)
+                        {
+                            vertices[k] = AreaVertex(newCurveId, vertices.at(k).vertexNumber-m-1);
+                        }
                     }
                 }
+                mIsAreaIndexValid = false;
             }
 
             if ( getCurveSize(i) < 1)   // the left part has less than two points so we remove it
@@ -818,6 +975,7 @@ void VectorImage::removeVertex(int i, int m)   // curve number i and vertex numb
         removeCurveAt(i);
         i--;
     }
+    modification(changedRect);
 }
 
 void VectorImage::deleteSelectedPoints()
@@ -838,8 +996,8 @@ void VectorImage::deleteSelectedPoints()
 void VectorImage::paste(VectorImage& vectorImage)
 {
     mSelectionRect = QRect(0,0,0,0);
-    int n = m_curves.size();
-    QList<int> selectedCurves;
+    // the ids the pasted curves got here, by their number in the other image
+    QVector<CurveId> pastedCurveIds(vectorImage.m_curves.size());
 
     bool hasSelection = getFirstSelectedCurve() < -1;
 
@@ -849,9 +1007,9 @@ void VectorImage::paste(VectorImage& vectorImage)
         //
         if ( !hasSelection || vectorImage.m_curves.at(i).isSelected() )
         {
-            m_curves.append( vectorImage.m_curves.at(i) );
-            selectedCurves << i;
-            mSelectionRect |= vectorImage.m_curves[i].getBoundingRect();
+            appendCurve( vectorImage.m_curves.at(i) );
+            pastedCurveIds[i] = getCurveId(m_curves.size() - 1);
+            mSelectionRect |= vectorImage.m_curves.at(i).getBoundingRect();
         }
     }
     for(int i=0; i < vectorImage.area.size() ; i++)
@@ -860,14 +1018,11 @@ void VectorImage::paste(VectorImage& vectorImage)
         bool ok = true;
         for(int j=0; j < newArea.mVertex.size(); j++)
         {
-            int curveNumber = newArea.mVertex.at(j).curveNumber;
-            int vertexNumber = newArea.mVertex.at(j).vertexNumber;
-
-            // If nothing is selected, paste everything
-            //
-            if ( !hasSelection || vectorImage.m_curves.at(curveNumber).isSelected() )
+            int curveNumber = vectorImage.getCurveNumber(newArea.mVertex.at(j).curve);
+            CurveId pastedCurveId = (curveNumber >= 0) ? pastedCurveIds.at(curveNumber) : CurveId();
+            if ( !pastedCurveId.isNull() )
             {
-                newArea.mVertex[j] = VertexRef( selectedCurves.indexOf(curveNumber) + n, vertexNumber );
+                newArea.mVertex[j].curve = pastedCurveId;
             }
             else
             {
@@ -876,6 +1031,7 @@ void VectorImage::paste(VectorImage& vectorImage)
         }
         if (ok) area.append( newArea );
     }
+    mIsAreaIndexValid = false;
     modification();
 }
 
@@ -918,6 +1074,7 @@ void VectorImage::removeColour(int index)
     {
         if (m_curves[i].getColourNumber() > index) m_curves[i].decreaseColourNumber();
     }
+    modification();
 }
 
 void VectorImage::paintImage(QPainter& painter,
@@ -931,8 +1088,10 @@ void VectorImage::paintImage(QPainter& painter,
     painter.setOpacity(1.0);
     QTransform painterMatrix = painter.transform();
 
-    QRect mappedViewRect = QRect(0,0, painter.device()->width(), painter.device()->height() );
-    painterMatrix.inverted().mapRect( mappedViewRect );
+    QRectF mappedViewRect = painterMatrix.inverted().mapRect( QRectF(0,0, painter.device()->width(), painter.device()->height()) );
+    // The thin lines and the highlight are a pixel or two wide whatever the scale
+    qreal scale = std::sqrt( std::abs( painterMatrix.determinant() ) );
+    qreal pixelMargin = ( scale > 0 ) ? 2.0 / scale : 0.0;
 
     // --- draw filled areas ----
     if (!simplified)
@@ -970,8 +1129,18 @@ void VectorImage::paintImage(QPainter& painter,
     //simplified = true;
     //painter.setClipRect( viewRect );
     //painter.setClipping(true);
-    for ( BezierCurve curve : m_curves )
+    for ( int i = 0; i < m_curves.size(); i++ )
     {
+        // Curves out of the device are skipped, to paint a small part of the frame quickly
+        const BezierCurve& curve = m_curves.at( i );
+        if ( pixelMargin > 0 && !curve.isPartlySelected() )
+        {
+            qreal margin = curve.getWidth() + pixelMargin;
+            if ( !curve.getBoundingRect().adjusted( -margin, -margin, margin, margin ).intersects( mappedViewRect ) )
+            {
+                continue;
+            }
+        }
         curve.drawPath( painter, mObject, mSelectionTransformation, simplified, showThinCurves );
         painter.setClipping(false);
     }
@@ -989,10 +1158,83 @@ void VectorImage::outputImage(QImage* image,
     paintImage( painter, simplified, showThinCurves, antialiasing );
 }
 
+const QImage& VectorImage::rasterImage(QTransform view,
+                                       QSize size,
+                                       bool simplified,
+                                       bool showThinCurves,
+                                       bool antialiasing,
+                                       QColor background)
+{
+    VectorRasterCache::Options options;
+    options.view = view;
+    options.size = size;
+    options.background = background;
+    options.simplified = simplified;
+    options.showThinCurves = showThinCurves;
+    options.antialiasing = antialiasing;
+    return mRasterCache.raster(this, options);
+}
+
+void VectorImage::invalidateRasters()
+{
+    mRasterCache.invalidate();
+}
+
+void VectorImage::modification()
+{
+    KeyFrame::modification();
+    mRasterCache.invalidate();
+}
+
+void VectorImage::modification(const QRectF& changedRect)
+{
+    KeyFrame::modification();
+    mRasterCache.invalidate(changedRect);
+}
+
+QRectF VectorImage::paintedRect(int curveNumber)
+{
+    if (curveNumber < 0 || curveNumber >= m_curves.size())
+    {
+        return QRectF();
+    }
+
+    // As wide as the curve can be painted, with the variable width
+    const BezierCurve& curve = m_curves.at(curveNumber);
+    QRectF rect = curve.isPartlySelected() ? curve.transformed(mSelectionTransformation).getBoundingRect()
+                                           : curve.getBoundingRect();
+    qreal margin = curve.getWidth();
+    rect.adjust(-margin, -margin, margin, margin);
+
+    // Where the areas were painted last, and where they are now
+    for (int areaNumber : getAreasUsingCurve(curve.getId()))
+    {
+        BezierArea& bezierArea = area[areaNumber];
+        rect |= bezierArea.mPath.boundingRect();
+        updateArea(bezierArea);
+        rect |= bezierArea.mPath.boundingRect();
+    }
+    return rect;
+}
+
+QRectF VectorImage::paintedRectOfSelection()
+{
+    QRectF rect;
+    for (int i = 0; i < m_curves.size(); i++)
+    {
+        if (m_curves.at(i).isPartlySelected()) rect |= paintedRect(i);
+    }
+    return rect;
+}
+
 void VectorImage::clear()
 {
     while (m_curves.size() > 0) { m_curves.removeAt(0); }
     while (area.size() > 0) { area.removeAt(0); }
+    mCurveSlots.clear();
+    mSlotGenerations.clear();
+    mFreeSlots.clear();
+    mIsAreaIndexValid = false;
     modification();
 }
 
@@ -1000,7 +1242,7 @@ void VectorImage::clean()
 {
     for(int i=0; i<m_curves.size(); i++)
     {
-        if (m_curves.at(i).getVertexSize() == 0) { qDebug() << "CLEAN " << i; m_curves.removeAt(i); i--; }
+        if (m_curves.at(i).getVertexSize() == 0) { qDebug() << "CLEAN " << i; removeCurveAt(i); i--; }
     }
 }
 
@@ -1088,13 +1330,14 @@ QList<int> VectorImage::getCurvesCloseTo(QPointF P1, qreal maxDistance)
     QList<int> result;
     for(int j=0; j<m_curves.size(); j++)
     {
-        BezierCurve myCurve;
-        if (m_curves[j].isPartlySelected()) {
-            myCurve = m_curves[j].transformed(mSelectionTransformation);
+        const BezierCurve& curve = m_curves.at(j);
+        bool isClose = false;
+        if (curve.isPartlySelected()) {
+            isClose = curve.transformed(mSelectionTransformation).intersects(P1, maxDistance);
         } else {
-            myCurve = m_curves[j];
+            isClose = curve.intersects(P1, maxDistance);
         }
-        if ( myCurve.intersects(P1, maxDistance) ) {
+        if ( isClose ) {
             result.append( j );
         }
     }
@@ -1196,11 +1439,12 @@ QPointF VectorImage::getVertex(int curveNumber, int vertexNumber)
     QPointF result = QPointF(11.11, 11.11); // bogus point
     if (curveNumber > -1 && curveNumber < m_curves.size())
     {
-        BezierCurve myCurve = m_curves.at(curveNumber);
-        if ( myCurve.isPartlySelected() ) myCurve = myCurve.transformed(mSelectionTransformation);
-        if ( vertexNumber > -2 && vertexNumber < myCurve.getVertexSize())
+        // Selected points are where the selection transformation moves them
+        const BezierCurve& curve = m_curves.at(curveNumber);
+        if ( vertexNumber > -2 && vertexNumber < curve.getVertexSize())
         {
-            result = myCurve.getVertex(vertexNumber);
+            result = curve.getVertex(vertexNumber);
+            if ( curve.isSelected(vertexNumber) ) result = mSelectionTransformation.map(result);
         }
     }
     return result;
@@ -1216,11 +1460,11 @@ QPointF VectorImage::getC1(int curveNumber, int vertexNumber)
     QPointF result = QPointF(11.11, 11.11); // bogus point
     if (curveNumber > -1 && curveNumber < m_curves.size())
     {
-        BezierCurve myCurve = m_curves.at(curveNumber);
-        if ( myCurve.isPartlySelected() ) myCurve = myCurve.transformed(mSelectionTransformation);
-        if ( vertexNumber > -1 && vertexNumber < myCurve.getVertexSize())
+        const BezierCurve& curve = m_curves.at(curveNumber);
+        if ( vertexNumber > -1 && vertexNumber < curve.getVertexSize())
         {
-            result = myCurve.getC1(vertexNumber);
+            result = curve.getC1(vertexNumber);
+            if ( curve.isSelected(vertexNumber-1) ) result = mSelectionTransformation.map(result);
         }
     }
     return result;
@@ -1236,11 +1480,11 @@ QPointF VectorImage::getC2(int curveNumber, int vertexNumber)
     QPointF result = QPointF(11.11, 11.11); // bogus point
     if (curveNumber > -1 && curveNumber < m_curves.size())
     {
-        BezierCurve myCurve = m_curves.at(curveNumber);
-        if ( myCurve.isPartlySelected() ) myCurve = myCurve.transformed(mSelectionTransformation);
-        if ( vertexNumber > -1 && vertexNumber < myCurve.getVertexSize())
+        const BezierCurve& curve = m_curves.at(curveNumber);
+        if ( vertexNumber > -1 && vertexNumber < curve.getVertexSize())
         {
-            result = myCurve.getC2(vertexNumber);
+            result = curve.getC2(vertexNumber);
+            if ( curve.isSelected(vertexNumber) ) result = mSelectionTransformation.map(result);
         }
     }
     return result;
@@ -1257,9 +1501,7 @@ QList<VertexRef> VectorImage::getCurveVertices(int curveNumber)
 
     if (curveNumber > -1 && curveNumber < m_curves.size())
     {
-        BezierCurve myCurve = m_curves.at(curveNumber);
-
-        for(int k=-1; k<myCurve.getVertexSize(); k++)
+        for(int k=-1; k<m_curves.at(curveNumber).getVertexSize(); k++)
         {
             VertexRef vertexRef = VertexRef(curveNumber, k);
             result.append(vertexRef);
@@ -1298,12 +1540,13 @@ int VectorImage::getCurveSize(int curveNumber)
 
 void VectorImage::fillPath(QList<QPointF> contourPath, int colour, float tolerance)
 {
-    QList<VertexRef> vertexPath;
+    QList<AreaVertex> vertexPath;
 
     for (QPointF point : contourPath) {
         VertexRef vertex = getClosestVertexTo(point, tolerance);
-        if (vertex.curveNumber != -1 && !vertexPath.contains(vertex)) {
-            vertexPath.append(vertex);
+        AreaVertex areaVertex(getCurveId(vertex.curveNumber), vertex.vertexNumber);
+        if (vertex.curveNumber != -1 && !vertexPath.contains(areaVertex)) {
+            vertexPath.append(areaVertex);
         }
     }
 
@@ -1315,15 +1558,13 @@ void VectorImage::fillPath(QList<QPointF> contourPath, int colour, float toleran
 QList<QPointF> VectorImage::getfillContourPoints(QPoint point)
 {
     // We get the contour points from a bitmap version of the vector layer as it is much faster to process
-    QImage* image = new QImage( mSize, QImage::Format_ARGB32_Premultiplied );
-    image->fill(Qt::white);
-    QPainter painter( image );
-
     // Adapt the QWidget view coordinates to the QImage coordinates
     QTransform translate;
     translate.translate( mSize.width() / 2.f , mSize.height() / 2.f );
-    painter.setTransform( translate );
-    paintImage( painter, true, true, false );
+
+    // The fill marks the pixels it went through on a copy, the raster is kept
+    QImage fillImage = rasterImage( translate, mSize, true, true, false, Qt::white );
+    QImage* image = &fillImage;
 
     QList<QPoint> queue; // queue all the pixels of the filled area (as they are found)
     QList<QPointF> contourPoints; // refs of points near the contour pixels
@@ -1565,6 +1806,7 @@ void VectorImage::fill(QPointF point, int colour, float tolerance)
         for (int i = 0; i < closestCurves.size(); i++) {
             int curveNumber = closestCurves[i];
             m_curves[curveNumber].setColourNumber(colour);
+            modification(paintedRect(curveNumber));
         }
 
         return;
@@ -1684,6 +1926,7 @@ void VectorImage::addArea(BezierArea bezierArea)
 {
     updateArea(bezierArea);
     area.append( bezierArea );
+    mIsAreaIndexValid = false;
     modification();
 }
 
@@ -1730,6 +1973,7 @@ void VectorImage::removeArea(QPointF point)
     if ( areaNumber != -1)
     {
         area.removeAt(areaNumber);
+        mIsAreaIndexValid = false;
     }
     modification();
 }
@@ -1737,9 +1981,12 @@ void VectorImage::removeArea(QPointF point)
 void VectorImage::updateArea(BezierArea& bezierArea)
 {
     QPainterPath newPath;
+    VertexRef previousRef;
     for(int i=0; i<bezierArea.mVertex.size(); i++)
     {
-        QPointF myPoint = getVertex(bezierArea.mVertex[i]);
+        const AreaVertex& vertex = bezierArea.mVertex.at(i);
+        VertexRef vertexRef(getCurveNumber(vertex.curve), vertex.vertexNumber);
+        QPointF myPoint = getVertex(vertexRef);
         QPointF myC1;
         QPointF myC2;
 
@@ -1749,23 +1996,23 @@ void VectorImage::updateArea(BezierArea& bezierArea)
         }
         else
         {
-            if (bezierArea.mVertex[i-1].curveNumber == bezierArea.mVertex[i].curveNumber )   // the two points are on the same curve
+            if (previousRef.curveNumber == vertexRef.curveNumber )   // the two points are on the same curve
             {
-                if (bezierArea.mVertex[i-1].vertexNumber < bezierArea.mVertex[i].vertexNumber )   // the points follow the curve progression
+                if (previousRef.vertexNumber < vertexRef.vertexNumber )   // the points follow the curve progression
                 {
-                    myC1 =  getC1(bezierArea.mVertex[i]);
-                    myC2 =  getC2(bezierArea.mVertex[i]);
+                    myC1 =  getC1(vertexRef);
+                    myC2 =  getC2(vertexRef);
                 }
                 else
                 {
-                    myC1 = getC2(bezierArea.mVertex[i-1]);
-                    myC2 = getC1(bezierArea.mVertex[i-1]);
+                    myC1 = getC2(previousRef);
+                    myC2 = getC1(previousRef);
                 }
                 newPath.cubicTo(myC1, myC2, myPoint);
             }
             else // the two points are not the same curve
             {
-                if ( bezierArea.mVertex[i].vertexNumber == -1)   // the current point is the first point in the new curve
+                if ( vertexRef.vertexNumber == -1)   // the current point is the first point in the new curve
                 {
                     newPath.lineTo( myPoint );
                 }
@@ -1775,6 +2022,7 @@ void VectorImage::updateArea(BezierArea& bezierArea)
                 }
             }
         }
+        previousRef = vertexRef;
     }
     newPath.closeSubpath();
     bezierArea.mPath = newPath;
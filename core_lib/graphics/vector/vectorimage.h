@@ -28,6 +28,7 @@ GNU General Public License for more details.
 #include "beziercurve.h"
 #include "vertexref.h"
 #include "keyframe.h"
+#include "vectorrastercache.h"
 
 class Object;
 class QPainter;
@@ -41,10 +42,15 @@ public:
     void setObject( Object* pObj ) { mObject = pObj; }
 
     bool read(QString filePath);
+    bool read(QIODevice* device);
     Status write(QString filePath, QString format);
+    Status write(QIODevice* device);
 
     Status createDomElement(QXmlStreamWriter& doc);
     void loadDomElement(QDomElement element);
+    void loadDomElement(QXmlStreamReader& xmlStream);
+    void writeBinary(QDataStream& out) const;
+    void readBinary(QDataStream& in);
 
     void insertCurve(int position, BezierCurve& newCurve, qreal factor, bool interacts);
     void addCurve(BezierCurve& newCurve, qreal factor, bool interacts = true);
@@ -83,6 +89,12 @@ public:
 
     void paintImage(QPainter& painter, bool simplified, bool showThinCurves, bool antialiasing);
     void outputImage(QImage* image, QTransform myView, bool simplified, bool showThinCurves, bool antialiasing); // uses paintImage
+    // As outputImage() paints it, kept between calls and only painted again where the frame changed
+    const QImage& rasterImage(QTransform view, QSize size, bool simplified, bool showThinCurves, bool antialiasing,
+                              QColor background = Qt::transparent);
+    void invalidateRasters(); // the colours of the palette changed
+
+    void modification() override;
 
     void clear();
     void clean();
@@ -122,6 +134,9 @@ public:
     QList<VertexRef> getAllVertices();
     int getCurveSize(int curveNumber);
 
+    CurveId getCurveId(int curveNumber) const;
+    int getCurveNumber(CurveId curveId) const; // -1 once the curve is removed
+
     QList<BezierCurve> m_curves;
     QList<BezierArea> area;
     QList<int> m_curveDisplayOrders;
@@ -132,6 +147,16 @@ public:
 
 private:
     void addPoint( int curveNumber, int vertexNumber, qreal t );
+
+    void modification(const QRectF& changedRect); // only changed there
+    QRectF paintedRect(int curveNumber); // of the curve and the areas using it
+    QRectF paintedRectOfSelection();
+
+    void appendCurve(const BezierCurve& curve);
+    void assignCurveId(int curveNumber);
+    void releaseCurveId(CurveId curveId);
+    void updateCurveNumbers(int firstCurveNumber);
+    const QVector<int>& getAreasUsingCurve(CurveId curveId);
 	
 	void checkCurveExtremity(BezierCurve& newCurve, qreal tolerance);
 	void checkCurveIntersections(BezierCurve& newCurve, qreal tolerance);
@@ -144,6 +169,18 @@ private:
     QRectF mSelectionRect;
     QTransform mSelectionTransformation;
     QSize mSize;
+
+    // Slot map behind the curve ids: the curve number in each slot (-1 when
+    // free) and the generation of the id it was last given out with
+    QVector<int> mCurveSlots;
+    QVector<int> mSlotGenerations;
+    QVector<int> mFreeSlots;
+
+    // The areas which use the curves of each slot, rebuilt after areas change
+    QVector<QVector<int>> mAreasOfSlot;
+    bool mIsAreaIndexValid = false;
+
+    VectorRasterCache mRasterCache;
 };
 
 #endif
@@ -0,0 +1,307 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "vectorrastercache.h"
+
+#include <cmath>
+#include <limits>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QSet>
+#include "vectorimage.h"
+#include "tracer.h"
+
+
+namespace
+{
+const int MAX_RASTERS = 3;     // per key frame
+const int MAX_DIRTY_RECTS = 8; // painted one by one, more than that are painted as their bounds
+
+// All the caches, for the memory budget. Key frames are also made and
+// deleted on worker threads, they just never have rasters there.
+QMutex gCachesMutex;
+QSet< VectorRasterCache* > gCaches;
+qint64 gMemoryBudget = 256 * 1024 * 1024;
+quint64 gClock = 0;
+
+bool isSameLinearPart( const QTransform& a, const QTransform& b )
+{
+    return a.m11() == b.m11() && a.m12() == b.m12() && a.m13() == b.m13()
+        && a.m21() == b.m21() && a.m22() == b.m22() && a.m23() == b.m23()
+        && a.m33() == b.m33();
+}
+
+inline bool isWhole( qreal x )
+{
+    return x == std::floor( x );
+}
+}
+
+
+VectorRasterCache::VectorRasterCache()
+{
+    QMutexLocker locker( &gCachesMutex );
+    gCaches.insert( this );
+}
+
+VectorRasterCache::VectorRasterCache( const VectorRasterCache& ) : VectorRasterCache()
+{
+}
+
+VectorRasterCache& VectorRasterCache::operator=( const VectorRasterCache& )
+{
+    // The key frame now has other content
+    clear();
+    return *this;
+}
+
+VectorRasterCache::~VectorRasterCache()
+{
+    QMutexLocker locker( &gCachesMutex );
+    gCaches.remove( this );
+}
+
+const QImage& VectorRasterCache::raster( VectorImage* vectorImage, const Options& options )
+{
+    Raster& raster = findRaster( options );
+    if ( !raster.dirtyRegion.isEmpty() )
+    {
+        paint( vectorImage, raster );
+    }
+    return raster.image;
+}
+
+void VectorRasterCache::invalidate()
+{
+    for ( Raster& raster : mRasters )
+    {
+        raster.dirtyRegion = QRegion( raster.image.rect() );
+    }
+}
+
+void VectorRasterCache::invalidate( const QRectF& canvasRect )
+{
+    for ( Raster& raster : mRasters )
+    {
+        // With a couple of pixels around for the antialiasing, the thin
+        // lines and the selection highlight, which don't scale with the view
+        QRect rect = raster.options.view.mapRect( canvasRect ).toAlignedRect().adjusted( -2, -2, 2, 2 );
+        raster.dirtyRegion |= rect;
+    }
+}
+
+void VectorRasterCache::clear()
+{
+    mRasters.clear();
+}
+
+qint64 VectorRasterCache::memoryUsage() const
+{
+    qint64 bytes = 0;
+    for ( const Raster& raster : mRasters )
+    {
+        bytes += raster.image.byteCount();
+    }
+    return bytes;
+}
+
+void VectorRasterCache::setMemoryBudget( qint64 bytes )
+{
+    {
+        QMutexLocker locker( &gCachesMutex );
+        gMemoryBudget = bytes;
+    }
+    evict( nullptr );
+}
+
+qint64 VectorRasterCache::totalMemoryUsage()
+{
+    QMutexLocker locker( &gCachesMutex );
+    qint64 bytes = 0;
+    for ( VectorRasterCache* cache : gCaches )
+    {
+        bytes += cache->memoryUsage();
+    }
+    return bytes;
+}
+
+VectorRasterCache::Raster& VectorRasterCache::findRaster( const Options& options )
+{
+    quint64 now = 0;
+    {
+        QMutexLocker locker( &gCachesMutex );
+        now = ++gClock;
+    }
+
+    Raster* panned = nullptr;
+    QPoint offset;
+    for ( Raster& raster : mRasters )
+    {
+        const Options& o = raster.options;
+        if ( o.size != options.size || o.background != options.background || o.simplified != options.simplified
+             || o.showThinCurves != options.showThinCurves || o.antialiasing != options.antialiasing
+             || !isSameLinearPart( o.view, options.view ) )
+        {
+            continue;
+        }
+        qreal dx = options.view.dx() - o.view.dx();
+        qreal dy = options.view.dy() - o.view.dy();
+        if ( dx == 0 && dy == 0 )
+        {
+            raster.lastUse = now;
+            return raster;
+        }
+        if ( isWhole( dx ) && isWhole( dy ) )
+        {
+            panned = &raster;
+            offset = QPoint( int( dx ), int( dy ) );
+        }
+    }
+
+    if ( panned != nullptr )
+    {
+        // Panned by whole pixels: what stays in view only moves, the rest is painted
+        Raster& raster = *panned;
+        QImage scrolled( raster.image.size(), QImage::Format_ARGB32_Premultiplied );
+        scrolled.fill( Qt::transparent );
+        QPainter painter( &scrolled );
+        painter.setCompositionMode( QPainter::CompositionMode_Source );
+        painter.drawImage( offset, raster.image );
+        painter.end();
+
+        raster.image = scrolled;
+        raster.dirtyRegion.translate( offset );
+        raster.dirtyRegion |= QRegion( scrolled.rect() ) - QRegion( scrolled.rect().translated( offset ) );
+        raster.options = options;
+        raster.lastUse = now;
+        return raster;
+    }
+
+    // A new way of painting the frame, it takes the place of the least recently used
+    size_t index = mRasters.size();
+    if ( mRasters.size() >= MAX_RASTERS )
+    {
+        index = 0;
+        for ( size_t i = 1; i < mRasters.size(); ++i )
+        {
+            if ( mRasters[ i ].lastUse < mRasters[ index ].lastUse )
+            {
+                index = i;
+            }
+        }
+    }
+    else
+    {
+        mRasters.emplace_back();
+    }
+
+    Raster& raster = mRasters[ index ];
+    raster.options = options;
+    if ( raster.image.size() != options.size )
+    {
+        raster.image = QImage( options.size, QImage::Format_ARGB32_Premultiplied );
+    }
+    raster.dirtyRegion = QRegion( raster.image.rect() );
+    raster.lastUse = now;
+
+    evict( this );
+    return raster;
+}
+
+void VectorRasterCache::paint( VectorImage* vectorImage, Raster& raster )
+{
+    TRACE_SCOPE( "VectorRasterCache::paint" );
+
+    QRegion dirtyRegion = raster.dirtyRegion & raster.image.rect();
+    raster.dirtyRegion = QRegion();
+    if ( dirtyRegion.isEmpty() )
+    {
+        return;
+    }
+
+    QVector< QRect > rects = dirtyRegion.rects();
+    if ( rects.size() > MAX_DIRTY_RECTS )
+    {
+        rects = QVector< QRect >( 1, dirtyRegion.boundingRect() );
+    }
+
+    const Options& options = raster.options;
+    for ( const QRect& rect : rects )
+    {
+        // paintImage() turns the clipping off, a part is painted on an image of its own
+        bool isWholeImage = ( rect == raster.image.rect() );
+        QImage part;
+        if ( !isWholeImage )
+        {
+            part = QImage( rect.size(), QImage::Format_ARGB32_Premultiplied );
+        }
+        QImage& target = isWholeImage ? raster.image : part;
+
+        target.fill( options.background );
+        QPainter painter( &target );
+        painter.setTransform( options.view * QTransform::fromTranslate( -rect.x(), -rect.y() ) );
+        vectorImage->paintImage( painter, options.simplified, options.showThinCurves, options.antialiasing );
+        painter.end();
+
+        if ( !isWholeImage )
+        {
+            QPainter copier( &raster.image );
+            copier.setCompositionMode( QPainter::CompositionMode_Source );
+            copier.drawImage( rect.topLeft(), part );
+        }
+    }
+}
+
+void VectorRasterCache::evict( const VectorRasterCache* inUse )
+{
+    QMutexLocker locker( &gCachesMutex );
+
+    qint64 total = 0;
+    for ( VectorRasterCache* cache : gCaches )
+    {
+        total += cache->memoryUsage();
+    }
+
+    while ( gMemoryBudget > 0 && total > gMemoryBudget )
+    {
+        VectorRasterCache* oldestCache = nullptr;
+        size_t oldestIndex = 0;
+        quint64 oldestUse = std::numeric_limits< quint64 >::max();
+        for ( VectorRasterCache* cache : gCaches )
+        {
+            if ( cache == inUse )
+            {
+                continue;
+            }
+            for ( size_t i = 0; i < cache->mRasters.size(); ++i )
+            {
+                if ( cache->mRasters[ i ].lastUse < oldestUse )
+                {
+                    oldestCache = cache;
+                    oldestIndex = i;
+                    oldestUse = cache->mRasters[ i ].lastUse;
+                }
+            }
+        }
+        if ( oldestCache == nullptr )
+        {
+            break;
+        }
+        total -= oldestCache->mRasters[ oldestIndex ].image.byteCount();
+        oldestCache->mRasters.erase( oldestCache->mRasters.begin() + oldestIndex );
+    }
+}
@@ -0,0 +1,85 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef VECTORRASTERCACHE_H
+#define VECTORRASTERCACHE_H
+
+#include <vector>
+#include <QImage>
+#include <QColor>
+#include <QRegion>
+#include <QTransform>
+
+class VectorImage;
+
+
+// Rasters of a vector key frame, so that painting an untouched frame is a blit.
+//
+// There's one raster per way the frame is painted: the canvas at the current
+// view, the playback cache, the bucket fill. Changes to the frame are recorded
+// as dirty rects, and only those parts of the rasters are painted again when
+// they're next asked for. Panning keeps the raster and only paints what
+// scrolled in.
+//
+// The rasters of all the key frames share a memory budget, the least recently
+// used are dropped first. Rasters are only made and used on the gui thread.
+class VectorRasterCache
+{
+public:
+    struct Options
+    {
+        QTransform view;
+        QSize  size;
+        QColor background = Qt::transparent;
+        bool   simplified = false;
+        bool   showThinCurves = false;
+        bool   antialiasing = false;
+    };
+
+    VectorRasterCache();
+    VectorRasterCache( const VectorRasterCache& ); // a copy starts empty
+    VectorRasterCache& operator=( const VectorRasterCache& );
+    ~VectorRasterCache();
+
+    // Up to date with vectorImage, painted as VectorImage::outputImage() would
+    const QImage& raster( VectorImage* vectorImage, const Options& options );
+
+    void invalidate();
+    void invalidate( const QRectF& canvasRect );
+    void clear();
+
+    qint64 memoryUsage() const;
+
+    static void   setMemoryBudget( qint64 bytes ); // 0 means no limit
+    static qint64 totalMemoryUsage();
+
+private:
+    struct Raster
+    {
+        Options options;
+        QImage  image;
+        QRegion dirtyRegion; // in raster coordinates
+        quint64 lastUse = 0;
+    };
+
+    Raster& findRaster( const Options& options );
+    void    paint( VectorImage* vectorImage, Raster& raster );
+    static void evict( const VectorRasterCache* inUse );
+
+    std::vector< Raster > mRasters;
+};
+
+#endif // VECTORRASTERCACHE_H
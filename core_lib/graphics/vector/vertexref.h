@@ -31,5 +31,32 @@ public:
     int vertexNumber;
 };
 
+// Stable handle of a curve in its VectorImage. Curve numbers shift when the
+// curves before them are removed, ids don't. The slot of a removed curve is
+// given out again with the next generation, so an old id never finds another curve.
+class CurveId
+{
+public:
+    CurveId() {}
+    CurveId(int s, int g) : slot(s), generation(g) {}
+    bool isNull() const { return slot < 0; }
+    bool operator==(const CurveId& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const CurveId& other) const { return !(*this == other); }
+    int slot = -1;
+    int generation = 0;
+};
+
+// A vertex of a BezierArea, on a curve referred to by its id
+class AreaVertex
+{
+public:
+    AreaVertex() {}
+    AreaVertex(CurveId c, int vertexN) : curve(c), vertexNumber(vertexN) {}
+    bool operator==(const AreaVertex& other) const { return curve == other.curve && vertexNumber == other.vertexNumber; }
+    bool operator!=(const AreaVertex& other) const { return !(*this == other); }
+    CurveId curve;
+    int vertexNumber = -1;
+};
+
 #endif
 
@@ -39,6 +39,7 @@ GNU General Public License for more details.
 #include "objectdata.h"
 #include "vectorimage.h"
 #include "bitmapimage.h"
+#include "bitmapresidency.h"
 #include "layerbitmap.h"
 #include "layervector.h"
 #include "layersound.h"
@@ -55,6 +56,7 @@ GNU General Public License for more details.
 
 #include "scribblearea.h"
 #include "timeline.h"
+#include "thumbnailcache.h"
 #include "util.h"
 
 #define MIN(a,b) ((a)>(b)?(b):(a))
@@ -106,11 +108,15 @@ bool Editor::init()
 	}
     //setAcceptDrops( true ); // TODO: drop event
 
+    mThumbnailCache = new ThumbnailCache( this );
+
     makeConnections();
 
     mIsAutosave = mPreferenceManager->isOn(SETTING::AUTO_SAVE);
     autosaveNumber = mPreferenceManager->getInt(SETTING::AUTO_SAVE_NUMBER);
 
+    updateBitmapMemoryLimit();
+
     //onionPrevFramesNum = mPreferenceManager->getInt(SETTING::ONION_PREV_FRAMES_NUM);
     //onionNextFramesNum = mPreferenceManager->getInt(SETTING::ONION_NEXT_FRAMES_NUM);
 
@@ -131,6 +137,7 @@ void Editor::makeConnections()
 {
     connect( mPreferenceManager, &PreferenceManager::optionChanged, this, &Editor::settingUpdated );
 	connect( QApplication::clipboard(), &QClipboard::dataChanged, this, &Editor::clipboardChanged );
+    connect( mSoundManager, &SoundManager::soundClipDurationChanged, mPlaybackManager, &PlaybackManager::soundClipsChanged );
 }
 
 void Editor::dragEnterEvent( QDragEnterEvent* event )
@@ -165,6 +172,9 @@ void Editor::settingUpdated(SETTING setting)
     case SETTING::AUTO_SAVE_NUMBER:
         autosaveNumber = mPreferenceManager->getInt( SETTING::AUTO_SAVE_NUMBER );
         break;
+    case SETTING::BITMAP_MEMORY_LIMIT:
+        updateBitmapMemoryLimit();
+        break;
     case SETTING::ONION_TYPE:
         mScribbleArea->updateAllFrames();
         emit updateTimeLine();
@@ -174,6 +184,12 @@ void Editor::settingUpdated(SETTING setting)
     }
 }
 
+void Editor::updateBitmapMemoryLimit()
+{
+    qint64 limitMB = mPreferenceManager->getInt( SETTING::BITMAP_MEMORY_LIMIT );
+    BitmapResidency::instance()->setMemoryLimit( limitMB * 1024 * 1024 );
+}
+
 BackupElement* Editor::currentBackup()
 {
     if ( mBackupIndex >= 0 )
@@ -248,6 +264,13 @@ void Editor::backup( int backupLayer, int backupFrame, QString undoText )
 		}
 	}
     emit updateBackup();
+
+    numberOfModifications++;
+    if ( mIsAutosave && numberOfModifications >= autosaveNumber )
+    {
+        numberOfModifications = 0;
+        emit needSave();
+    }
 }
 
 void BackupBitmapElement::restore( Editor* editor )
@@ -265,7 +288,7 @@ void BackupBitmapElement::restore( Editor* editor )
 	editor->getScribbleArea()->myTransformedSelection = this->myTransformedSelection;
 	editor->getScribbleArea()->myTempTransformedSelection = this->myTempTransformedSelection;
 
-	editor->updateFrame( this->frame );
+	editor->getScribbleArea()->updateKeyFrameSpan( this->layer, this->frame );
 	editor->scrubTo( this->frame );
 }
 
@@ -408,7 +431,7 @@ void Editor::paste()
 			//((LayerVector*)layer)->getLastVectorImageAtFrame(backupFrame, 0)->modification(); ????
 		}
 	}
-	mScribbleArea->updateCurrentFrame();
+	mScribbleArea->updateKeyFrameSpan( layers()->currentLayerIndex(), currentFrame() );
 }
 
 void Editor::deselectAll()
@@ -483,6 +506,12 @@ Status Editor::setObject( Object* newObject )
         return Status::SAFE;
     }
 
+    // Key frames paged out from now on go to the working folder of the new project
+    BitmapResidency::instance()->setScratchDir( newObject->workingDir() );
+
+    // Before the old object is deleted
+    mThumbnailCache->setObject( newObject );
+
     mObject.reset( newObject );
 
 
@@ -781,6 +810,7 @@ KeyFrame* Editor::addKeyFame( int layerNumber, int frameIndex )
 
 	if ( isOK )
 	{
+        mScribbleArea->updateKeyFrameSpan( layerNumber, frameIndex );
         scrubTo( frameIndex ); // currentFrameChanged() emit inside.
         //getScribbleArea()->updateCurrentFrame();
 	}
@@ -38,6 +38,7 @@ class PreferenceManager;
 class SoundManager;
 class ScribbleArea;
 class TimeLine;
+class ThumbnailCache;
 
 enum class SETTING;
 
@@ -79,6 +80,8 @@ public:
     void setScribbleArea( ScribbleArea* pScirbbleArea ) { mScribbleArea = pScirbbleArea; }
     ScribbleArea* getScribbleArea() { return mScribbleArea; }
 
+    ThumbnailCache* thumbnails() const { return mThumbnailCache; }
+
     int  currentFrame();
     int  fps();
 
@@ -162,6 +165,7 @@ protected:
 private:
     bool importBitmapImage( QString );
     bool importVectorImage( QString );
+    void updateBitmapMemoryLimit();
 
     // the object to be edited by the editor
     std::shared_ptr<Object> mObject = nullptr;
@@ -169,6 +173,7 @@ private:
     int mFrame = 1; // current frame number.
 
     ScribbleArea* mScribbleArea = nullptr;
+    ThumbnailCache* mThumbnailCache = nullptr;
 
     ColorManager*      mColorManager      = nullptr;
     ToolManager*       mToolManager       = nullptr;
@@ -21,6 +21,8 @@ GNU General Public License for more details.
 #include <QScopedPointer>
 #include <QMessageBox>
 #include <QPixmapCache>
+#include <QGuiApplication>
+#include <QScreen>
 
 #include "beziercurve.h"
 #include "object.h"
@@ -29,11 +31,15 @@ GNU General Public License for more details.
 #include "layervector.h"
 #include "layercamera.h"
 #include "bitmapimage.h"
+#include "bitmapresidency.h"
+#include "smudgekernel.h"
 #include "pencilsettings.h"
 #include "toolmanager.h"
 #include "strokemanager.h"
 #include "layermanager.h"
 #include "playbackmanager.h"
+#include "thumbnailcache.h"
+#include "tracer.h"
 
 #define round(f) ((int)(f + 0.5))
 
@@ -87,7 +93,19 @@ bool ScribbleArea::init()
 
     setMouseTracking( true ); // reacts to mouse move events, even if the button is not pressed
 
-    mDebugRect = QRectF( 0, 0, 0, 0 );
+    QScreen* screen = QGuiApplication::primaryScreen();
+    if ( screen != nullptr && screen->refreshRate() > 1 )
+    {
+        mInputFrameInterval = qRound( 1000 / screen->refreshRate() );
+    }
+    mInputFlushTimer.setSingleShot( true );
+    connect( &mInputFlushTimer, &QTimer::timeout, this, &ScribbleArea::flushInput );
+    connect( &mStrokeRasterizer, &StrokeRasterizer::tilesReady, this, &ScribbleArea::showRasterizedDabs );
+    mInputFlushClock.start();
+
+    mDebugRect = QRectF( 8, 8, 240, 114 );
+    mShowPerformanceHud = mPrefs->isOn( SETTING::PERFORMANCE_HUD );
+    mDebugClock.start();
 
     setSizePolicy( QSizePolicy( QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding ) );
 
@@ -98,6 +116,8 @@ bool ScribbleArea::init()
 
     mNeedUpdateAll = false;
 
+    connect( mEditor->playback(), &PlaybackManager::playStateChanged, this, &ScribbleArea::playStateChanged );
+
     return true;
 }
 
@@ -129,6 +149,11 @@ void ScribbleArea::settingUpdated(SETTING setting)
     case SETTING::QUICK_SIZING:
         mQuickSizing = mPrefs->isOn( SETTING::QUICK_SIZING );
         break;
+    case SETTING::PERFORMANCE_HUD:
+        mShowPerformanceHud = mPrefs->isOn( SETTING::PERFORMANCE_HUD );
+        mDebugTimeQue.clear();
+        update();
+        break;
     case SETTING::MULTILAYER_ONION:
         mMultiLayerOnionSkin = mPrefs->isOn( SETTING::MULTILAYER_ONION );
         updateAllFrames();
@@ -181,6 +206,27 @@ void ScribbleArea::updateFrame( int frame )
 }
 
 void ScribbleArea::updateAllFrames()
+{
+    mPlaybackCache.clear();
+    updatePlaybackCacheState();
+    mPlaybackCache.scheduleWarmUp();
+
+    clearPixmapCache();
+}
+
+void ScribbleArea::updateKeyFrameSpan( int layerNumber, int frame )
+{
+    Layer* layer = mEditor->object()->getLayer( layerNumber );
+    if ( layer != nullptr )
+    {
+        updatePlaybackCacheState();
+        mPlaybackCache.invalidateKeyFrameSpan( layer, frame );
+        mEditor->thumbnails()->invalidate( layer, frame );
+    }
+    updateFrame( frame );
+}
+
+void ScribbleArea::clearPixmapCache()
 {
     QPixmapCache::clear();
 	std::fill( mPixmapCacheKeys.begin(), mPixmapCacheKeys.end(), QPixmapCache::Key() );
@@ -189,6 +235,41 @@ void ScribbleArea::updateAllFrames()
     mNeedUpdateAll = false;
 }
 
+void ScribbleArea::updatePlaybackCacheState()
+{
+    if ( mEditor->object() == nullptr )
+    {
+        return;
+    }
+
+    PlaybackManager* playback = mEditor->playback();
+    if ( playback->isRangedPlaybackOn() )
+    {
+        mPlaybackCache.setRange( playback->markInFrame(), playback->markOutFrame() );
+    }
+    else
+    {
+        mPlaybackCache.setRange( 1, mEditor->layers()->projectLength() );
+    }
+
+    mPlaybackCache.setRenderState( mEditor->object(),
+                                   mEditor->layers()->currentLayerIndex(),
+                                   mEditor->view()->getView(),
+                                   size(),
+                                   renderOptions() );
+}
+
+void ScribbleArea::playStateChanged( bool isPlaying )
+{
+    if ( isPlaying )
+    {
+        PlaybackManager* playback = mEditor->playback();
+        updatePlaybackCacheState();
+        mPlaybackCache.setRange( playback->startFrame(), playback->endFrame() );
+        mPlaybackCache.startWarmUp( mEditor->currentFrame() );
+    }
+}
+
 void ScribbleArea::updateAllVectorLayersAtCurrentFrame()
 {
     updateAllVectorLayersAt( mEditor->currentFrame() );
@@ -203,6 +284,8 @@ void ScribbleArea::updateAllVectorLayersAt( int frameNumber )
         {
             auto vecLayer = static_cast< LayerVector* >( layer );
             vecLayer->getLastVectorImageAtFrame( frameNumber, 0 )->modification();
+            mPlaybackCache.invalidateKeyFrameSpan( layer, frameNumber );
+            mEditor->thumbnails()->invalidate( layer, frameNumber );
         }
     }
     updateFrame( mEditor->currentFrame() );
@@ -215,7 +298,10 @@ void ScribbleArea::updateAllVectorLayers()
         Layer *layer = mEditor->object()->getLayer( i );
         if ( layer->type() == Layer::VECTOR )
         {
-            //( ( LayerVector * )layer )->setModified( true );
+            layer->foreachKeyFrame( []( KeyFrame* key )
+            {
+                static_cast< VectorImage* >( key )->invalidateRasters();
+            } );
         }
     }
     updateAllFrames();
@@ -235,7 +321,12 @@ void ScribbleArea::setModified( int layerNumber, int frameNumber )
 
     emit modification( layerNumber );
 
-    updateAllFrames();
+    // Only the frames showing this key frame need to be rendered again for playback.
+    updatePlaybackCacheState();
+    mPlaybackCache.invalidateKeyFrameSpan( layer, frameNumber );
+    mEditor->thumbnails()->invalidate( layer, frameNumber );
+
+    clearPixmapCache();
 }
 
 /************************************************************************/
@@ -432,13 +523,8 @@ void ScribbleArea::tabletEvent( QTabletEvent *event )
     mStrokeManager->tabletEvent( event );
 
     // Some tablets return "NoDevice" and Cursor.
-    if (event->device() == QTabletEvent::NoDevice) {
-        currentTool()->adjustPressureSensitiveProperties( mStrokeManager->getPressure(),
-                                                      false );
-    } else {
-        currentTool()->adjustPressureSensitiveProperties( mStrokeManager->getPressure(),
-                                                      event->pointerType() == QTabletEvent::Cursor );
-    }
+    mIsTabletMouseDevice = ( event->device() != QTabletEvent::NoDevice && event->pointerType() == QTabletEvent::Cursor );
+    currentTool()->adjustPressureSensitiveProperties( mStrokeManager->getPressure(), mIsTabletMouseDevice );
 
     if ( event->pointerType() == QTabletEvent::Eraser )
     {
@@ -482,6 +568,7 @@ bool ScribbleArea::areLayersSane() const
 void ScribbleArea::mousePressEvent( QMouseEvent* event )
 {
     mMouseInUse = true;
+    mPlaybackCache.holdWarmUp( true );
 
     mStrokeManager->mousePressEvent( event );
 
@@ -589,9 +676,97 @@ void ScribbleArea::mouseMoveEvent( QMouseEvent *event )
         return;
     }
 
+    // A tablet reports a few hundred times a second, more than can be drawn
+    if ( isCoalescingInput( event ) )
+    {
+        mStrokeManager->queueMoveEvent( event );
+        mQueuedButtons = event->buttons();
+        mQueuedModifiers = event->modifiers();
+
+        int sinceFlush = int( mInputFlushClock.elapsed() );
+        if ( sinceFlush >= mInputFrameInterval )
+        {
+            flushInput();
+        }
+        else if ( !mInputFlushTimer.isActive() )
+        {
+            mInputFlushTimer.start( mInputFrameInterval - sinceFlush );
+        }
+        return;
+    }
+
     Q_EMIT refreshPreview();
 
     mStrokeManager->mouseMoveEvent( event );
+    moveTool( event );
+}
+
+bool ScribbleArea::isCoalescingInput( QMouseEvent* event )
+{
+    if ( !mMouseInUse || event->buttons() != Qt::LeftButton || currentTool()->isAdjusting )
+    {
+        return false;
+    }
+    switch ( currentTool()->type() )
+    {
+        case PENCIL:
+        case PEN:
+        case BRUSH:
+        case ERASER:
+        case SMUDGE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Hands the tool the queued moves, resampled along the stroke, and redraws once
+void ScribbleArea::flushInput()
+{
+    TRACE_SCOPE( "ScribbleArea::flushInput" );
+
+    mInputFlushTimer.stop();
+    mInputFlushClock.restart();
+
+    QList<StrokeSample> moves = mStrokeManager->takeResampledMoves();
+    if ( moves.isEmpty() )
+    {
+        return;
+    }
+
+    Q_EMIT refreshPreview();
+
+    mIsRedrawDeferred = true;
+    for ( const StrokeSample& move : moves )
+    {
+        mStrokeManager->setPressure( float( move.pressure ) );
+        if ( mStrokeManager->isTabletInUse() )
+        {
+            currentTool()->adjustPressureSensitiveProperties( move.pressure, mIsTabletMouseDevice );
+        }
+        mStrokeManager->moveTo( move.pos );
+
+        QMouseEvent event( QEvent::MouseMove, move.pos, Qt::NoButton, mQueuedButtons, mQueuedModifiers );
+        moveTool( &event );
+    }
+    mIsRedrawDeferred = false;
+    mStrokeRasterizer.submit();
+
+    if ( mIsKeyFrameChangeDeferred )
+    {
+        mIsKeyFrameChangeDeferred = false;
+        keyFrameChanged();
+    }
+    if ( !mDeferredRedrawRect.isEmpty() )
+    {
+        redrawCanvasRect( mDeferredRedrawRect );
+        update( mDeferredRedrawRect );
+        mDeferredRedrawRect = QRect();
+    }
+}
+
+void ScribbleArea::moveTool( QMouseEvent* event )
+{
     mCurrentPixel = mStrokeManager->getCurrentPixel();
     mCurrentPoint = mEditor->view()->mapScreenToCanvas( mCurrentPixel );
 
@@ -616,29 +791,16 @@ void ScribbleArea::mouseMoveEvent( QMouseEvent *event )
     }
 
     currentTool()->mouseMoveEvent( event );
-
-#ifdef DEBUG_FPS
-    // debug fps count.
-    clock_t curTime = clock();
-    mDebugTimeQue.push_back( curTime );
-
-    while ( mDebugTimeQue.size() > 100 )
-    {
-        mDebugTimeQue.pop_front();
-    }
-
-    if ( mDebugTimeQue.size() > 2 )
-    {
-        clock_t interval = mDebugTimeQue.back() - mDebugTimeQue.front();
-        double fps = mDebugTimeQue.size() / ( ( double )interval ) * CLOCKS_PER_SEC;
-        //qDebug() << fps;
-    }
-#endif
 }
 
 void ScribbleArea::mouseReleaseEvent( QMouseEvent *event )
 {
+    if ( mStrokeManager->hasQueuedMoves() )
+    {
+        flushInput();
+    }
     mMouseInUse = false;
+    mPlaybackCache.holdWarmUp( false );
 
     // ---- checks ------
     if ( currentTool()->isAdjusting )
@@ -701,26 +863,10 @@ void ScribbleArea::paintBitmapBuffer( )
 
     // Clear the temporary pixel path
     BitmapImage *targetImage = ( ( LayerBitmap * )layer )->getLastBitmapImageAtFrame( mEditor->currentFrame(), 0 );
+    mStrokeRasterizer.finish( mBufferImg );
     if ( targetImage != NULL )
     {
-        QPainter::CompositionMode cm = QPainter::CompositionMode_SourceOver;
-        switch ( currentTool()->type() )
-        {
-            case ERASER:
-                cm = QPainter::CompositionMode_DestinationOut;
-                break;
-            case BRUSH:
-            case PEN:
-            case PENCIL:
-                if ( getTool( currentTool()->type() )->properties.preserveAlpha )
-                {
-                    cm = QPainter::CompositionMode_SourceAtop;
-                }
-                break;
-            default: //nothing
-                break;
-        }
-        targetImage->paste( mBufferImg, cm );
+        targetImage->paste( mBufferImg, bufferCompositionMode() );
     }
 
     qCDebug( mLog ) << "Paste Rect" << mBufferImg->bounds();
@@ -729,6 +875,9 @@ void ScribbleArea::paintBitmapBuffer( )
 
     // Clear the buffer
     mBufferImg->clear();
+    mStrokeRasterizer.clear();
+    mCanvasRenderer.ignoreStrokeBuffer();
+    mIsBufferInCanvas = false;
 
     layer->setModified( mEditor->currentFrame(), true );
     emit modification();
@@ -736,6 +885,8 @@ void ScribbleArea::paintBitmapBuffer( )
 	int frameNumber = mEditor->currentFrame();
 	QPixmapCache::remove( mPixmapCacheKeys[frameNumber] );
 	mPixmapCacheKeys[frameNumber] = QPixmapCache::Key();
+    mPlaybackCache.invalidateKeyFrameSpan( layer, frameNumber );
+    mEditor->thumbnails()->invalidate( layer, frameNumber );
 
     drawCanvas( mEditor->currentFrame(), rect.adjusted( -1, -1, 1, 1 ) );
     update( rect );
@@ -751,47 +902,134 @@ void ScribbleArea::paintBitmapBufferRect( QRect rect )
 
     BitmapImage *targetImage = ( ( LayerBitmap * )layer )->getLastBitmapImageAtFrame( mEditor->currentFrame(), 0 );
     // Clear the temporary pixel path
+    mStrokeRasterizer.finish( mBufferImg );
     if ( targetImage != NULL )
     {
-        QPainter::CompositionMode cm = QPainter::CompositionMode_SourceOver;
-        switch ( currentTool()->type() )
-        {
-            case ERASER:
-                cm = QPainter::CompositionMode_DestinationOut;
-                break;
-            case BRUSH:
-            case PEN:
-            case PENCIL:
-                if ( getTool( currentTool()->type() )->properties.preserveAlpha )
-                {
-                    cm = QPainter::CompositionMode_SourceAtop;
-                }
-                break;
-            default: //nothing
-                break;
-        }
-        targetImage->paste( mBufferImg, cm );
+        targetImage->paste( mBufferImg, bufferCompositionMode() );
     }
 
     qCDebug( mLog ) << "Paste Rect" << mBufferImg->bounds();
 
     // Clear the buffer
     mBufferImg->clear();
+    mStrokeRasterizer.clear();
+    mCanvasRenderer.ignoreStrokeBuffer();
+    mIsBufferInCanvas = false;
 
+    if ( mIsRedrawDeferred )
+    {
+        // The smudge tool changes the key frame at every resampled point,
+        // flushInput() invalidates the caches and redraws once for all of them
+        mIsKeyFrameChangeDeferred = true;
+        mDeferredRedrawRect |= rect.adjusted( -1, -1, 1, 1 );
+        return;
+    }
+    keyFrameChanged();
+
+    drawCanvas( mEditor->currentFrame(), rect.adjusted( -1, -1, 1, 1 ) );
+    update( rect );
+}
+
+// The key frame under the current frame was painted into
+void ScribbleArea::keyFrameChanged()
+{
+    Layer* layer = mEditor->layers()->currentLayer();
     layer->setModified( mEditor->currentFrame(), true );
     emit modification();
 
     int frameNumber = mEditor->currentFrame();
-	QPixmapCache::remove( mPixmapCacheKeys[frameNumber] );
-	mPixmapCacheKeys[frameNumber] = QPixmapCache::Key();
-
-    drawCanvas( mEditor->currentFrame(), rect.adjusted( -1, -1, 1, 1 ) );
-    update( rect );
+    QPixmapCache::remove( mPixmapCacheKeys[frameNumber] );
+    mPixmapCacheKeys[frameNumber] = QPixmapCache::Key();
+    mPlaybackCache.invalidateKeyFrameSpan( layer, frameNumber );
+    mEditor->thumbnails()->invalidate( layer, frameNumber );
 }
 
 void ScribbleArea::clearBitmapBuffer()
 {
+    mStrokeRasterizer.clear();
     mBufferImg->clear();
+
+    if ( mIsBufferInCanvas )
+    {
+        // A stroke dropped before it was committed
+        mCanvasRenderer.ignoreStrokeBuffer();
+        mIsBufferInCanvas = false;
+        drawCanvas( mEditor->currentFrame(), rect() );
+        update();
+    }
+}
+
+void ScribbleArea::updateBitmapBuffer( const QRectF& rect, int rad )
+{
+    TRACE_SCOPE( "ScribbleArea::updateBitmapBuffer" );
+
+    if ( mStrokeRasterizer.hasQueuedDabs() )
+    {
+        // The canvas is updated as the worker threads are done with the dabs
+        if ( !mIsRedrawDeferred )
+        {
+            mStrokeRasterizer.submit();
+        }
+        return;
+    }
+
+    if ( rect.isEmpty() && mIsBufferInCanvas )
+    {
+        return; // no new dabs
+    }
+    showBitmapBuffer( rect.normalized().adjusted( -rad, -rad, +rad, +rad ) );
+}
+
+void ScribbleArea::showRasterizedDabs()
+{
+    QRect rect = mStrokeRasterizer.collect( mBufferImg );
+    if ( !rect.isEmpty() )
+    {
+        showBitmapBuffer( rect );
+    }
+}
+
+void ScribbleArea::showBitmapBuffer( const QRectF& rect )
+{
+    QRectF canvasRect = rect;
+    if ( !mIsBufferInCanvas )
+    {
+        // Until now the buffer was painted over the canvas, the whole of it moves in
+        canvasRect |= mBufferImg->bounds();
+        mCanvasRenderer.setStrokeBuffer( mBufferImg, bufferCompositionMode() );
+        mIsBufferInCanvas = true;
+    }
+
+    QRect updatedRect = mEditor->view()->mapCanvasToScreen( canvasRect ).toAlignedRect();
+    if ( mIsRedrawDeferred )
+    {
+        mDeferredRedrawRect |= updatedRect;
+        return;
+    }
+    redrawCanvasRect( updatedRect );
+    update( updatedRect );
+}
+
+QPainter::CompositionMode ScribbleArea::bufferCompositionMode()
+{
+    QPainter::CompositionMode cm = QPainter::CompositionMode_SourceOver;
+    switch ( currentTool()->type() )
+    {
+        case ERASER:
+            cm = QPainter::CompositionMode_DestinationOut;
+            break;
+        case BRUSH:
+        case PEN:
+        case PENCIL:
+            if ( getTool( currentTool()->type() )->properties.preserveAlpha )
+            {
+                cm = QPainter::CompositionMode_SourceAtop;
+            }
+            break;
+        default: //nothing
+            break;
+    }
+    return cm;
 }
 
 void ScribbleArea::drawLine( QPointF P1, QPointF P2, QPen pen, QPainter::CompositionMode cm )
@@ -823,6 +1061,36 @@ void ScribbleArea::refreshVector( const QRectF& rect, int rad )
 
 void ScribbleArea::paintEvent( QPaintEvent* event )
 {
+    TRACE_SCOPE( "ScribbleArea::paintEvent" );
+
+    if ( mShowPerformanceHud )
+    {
+        mDebugTimeQue.push_back( mDebugClock.elapsed() );
+        while ( mDebugTimeQue.size() > 60 )
+        {
+            mDebugTimeQue.pop_front();
+        }
+    }
+
+    bool isPlaying = mEditor->playback()->isPlaying();
+
+    QPixmap playbackFrame;
+    if ( isPlaying && mPlaybackCache.find( mEditor->currentFrame(), playbackFrame ) )
+    {
+        // Pre-rendered frame, may be at a reduced resolution
+        QPainter painter( this );
+        painter.setRenderHint( QPainter::SmoothPixmapTransform, mPlaybackCache.scale() < 1.0 );
+        painter.drawPixmap( rect(), playbackFrame );
+
+        mCacheHits += 1;
+        if ( mShowPerformanceHud )
+        {
+            paintPerformanceHud( painter );
+        }
+        event->accept();
+        return;
+    }
+
     if ( !mMouseInUse || currentTool()->type() == MOVE || currentTool()->type() == HAND )
     {
         // --- we retrieve the canvas from the cache; we create it if it doesn't exist
@@ -831,11 +1099,21 @@ void ScribbleArea::paintEvent( QPaintEvent* event )
 
 		QPixmapCache::Key cachedKey = mPixmapCacheKeys[frameNumber];
 
-        if ( !QPixmapCache::find( cachedKey, &mCanvas ) )
+        if ( QPixmapCache::find( cachedKey, &mCanvas ) )
+        {
+            mCacheHits += 1;
+        }
+        else
         {
+            mCacheMisses += 1;
             drawCanvas( mEditor->currentFrame(), event->rect() );
             
 			mPixmapCacheKeys[frameNumber] = QPixmapCache::insert( mCanvas );
+
+            if ( isPlaying )
+            {
+                mPlaybackCache.insert( curIndex, mCanvas );
+            }
             
 			//qDebug() << "Repaint canvas!";
         }
@@ -943,12 +1221,10 @@ void ScribbleArea::paintEvent( QPaintEvent* event )
                             // safety check
                             continue;
                         }
-                        BezierCurve myCurve = vectorImage->m_curves[ mClosestCurves[ k ] ];
-                        if ( myCurve.isPartlySelected() )
-                        {
-                            myCurve.transform( selectionTransformation );
-                        }
-                        QPainterPath path = myCurve.getStrokedPath( 1.2 / scale, false );
+                        const BezierCurve& curve = vectorImage->m_curves.at( idx );
+                        QPainterPath path = curve.isPartlySelected()
+                            ? curve.transformed( selectionTransformation ).getStrokedPath( 1.2 / scale, false )
+                            : curve.getStrokedPath( 1.2 / scale, false );
                         mBufferImg->drawPath( mEditor->view()->mapCanvasToScreen( path ),
                                               pen2,
                                               colour,
@@ -978,7 +1254,10 @@ void ScribbleArea::paintEvent( QPaintEvent* event )
             {
                 painter.setWorldMatrixEnabled( false );
             }
-            mBufferImg->paintImage( painter );
+            if ( !mIsBufferInCanvas )
+            {
+                mBufferImg->paintImage( painter );
+            }
         }
 
         // paints the selection outline
@@ -1025,13 +1304,97 @@ void ScribbleArea::paintEvent( QPaintEvent* event )
     painter.drawRect( QRect( 0, 0, width(), height() ) );
 #endif
 
+    if ( mShowPerformanceHud )
+    {
+        paintPerformanceHud( painter );
+    }
+
     event->accept();
 }
 
+void ScribbleArea::paintPerformanceHud( QPainter& painter )
+{
+    // Frame time is the average interval between the recent paint events
+    double frameTimeMs = 0.0;
+    if ( mDebugTimeQue.size() > 1 )
+    {
+        frameTimeMs = double( mDebugTimeQue.back() - mDebugTimeQue.front() ) / ( mDebugTimeQue.size() - 1 );
+    }
+
+    QStringList lines;
+    lines << tr( "Frame time: %1 ms" ).arg( frameTimeMs, 0, 'f', 1 );
+    lines << tr( "Canvas render: %1 ms" ).arg( mLastCanvasTimeUs / 1000.0, 0, 'f', 1 );
+    lines << tr( "Layers re-rendered: %1" ).arg( mLastLayersPainted );
+    lines << tr( "Cache hits: %1 / %2" ).arg( mCacheHits ).arg( mCacheHits + mCacheMisses );
+    lines << tr( "Playback cache: %1 frames, %2 MB" )
+        .arg( mPlaybackCache.cachedFrameCount() )
+        .arg( mPlaybackCache.memoryUsage() / ( 1024 * 1024 ) );
+
+    BitmapResidency::Stats residency = BitmapResidency::instance()->stats();
+    lines << tr( "Bitmap keys in memory: %1, %2 MB" )
+        .arg( residency.residentCount )
+        .arg( residency.residentBytes / ( 1024 * 1024 ) );
+    lines << tr( "Bitmap keys paged out: %1, %2 MB" )
+        .arg( residency.pagedOutCount )
+        .arg( residency.pagedOutBytes / ( 1024 * 1024 ) );
+
+    painter.save();
+    painter.setWorldMatrixEnabled( false );
+    painter.setOpacity( 1.0 );
+    painter.setPen( Qt::NoPen );
+    painter.setBrush( QColor( 0, 0, 0, 160 ) );
+    painter.drawRect( mDebugRect );
+    painter.setPen( Qt::white );
+    painter.drawText( mDebugRect.adjusted( 6, 4, -6, -4 ), Qt::AlignLeft | Qt::AlignTop, lines.join( "\n" ) );
+    painter.restore();
+}
+
 void ScribbleArea::drawCanvas( int frame, QRect rect )
 {
+    TRACE_SCOPE( "ScribbleArea::drawCanvas" );
+
+    QElapsedTimer timer;
+    timer.start();
+
     Object* object = mEditor->object();
 
+    mCanvasRenderer.setOptions( renderOptions() );
+
+    //qDebug() << "Antialias=" << options.bAntiAlias;
+
+    mCanvasRenderer.setCanvas( &mCanvas );
+    mCanvasRenderer.setViewTransform( mEditor->view()->getView() );
+    mCanvasRenderer.paint( object, mEditor->layers()->currentLayerIndex(), frame, rect );
+
+    mLastCanvasTimeUs = timer.nsecsElapsed() / 1000;
+    mLastLayersPainted = mCanvasRenderer.layersPainted();
+}
+
+void ScribbleArea::redrawCanvasRect( QRect rect )
+{
+    TRACE_SCOPE( "ScribbleArea::redrawCanvasRect" );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    mCanvasRenderer.setOptions( renderOptions() );
+    mCanvasRenderer.setCanvas( &mCanvas );
+    mCanvasRenderer.setViewTransform( mEditor->view()->getView() );
+    mCanvasRenderer.repaint( mEditor->object(), mEditor->layers()->currentLayerIndex(), mEditor->currentFrame(), rect );
+
+    mLastCanvasTimeUs = timer.nsecsElapsed() / 1000;
+    mLastLayersPainted = mCanvasRenderer.layersPainted();
+}
+
+const QImage& ScribbleArea::vectorRaster( VectorImage* vectorImage )
+{
+    RenderOptions options = renderOptions();
+    return vectorImage->rasterImage( mEditor->view()->getView(), size(),
+                                     options.bOutlines, options.bThinLines, options.bAntiAlias );
+}
+
+RenderOptions ScribbleArea::renderOptions()
+{
     RenderOptions options;
     options.bPrevOnionSkin = mPrefs->isOn( SETTING::PREV_ONION );
     options.bNextOnionSkin = mPrefs->isOn( SETTING::NEXT_ONION );
@@ -1050,15 +1413,7 @@ void ScribbleArea::drawCanvas( int frame, QRect rect )
     options.nShowAllLayers = mShowAllLayers;
     options.bIsOnionAbsolute = (mPrefs->getString( SETTING::ONION_TYPE ) == "absolute");
 
-    mCanvasRenderer.setOptions( options );
-
-    //qDebug() << "Antialias=" << options.bAntiAlias;
-
-    mCanvasRenderer.setCanvas( &mCanvas );
-    mCanvasRenderer.setViewTransform( mEditor->view()->getView() );
-    mCanvasRenderer.paint( object, mEditor->layers()->currentLayerIndex(), frame, rect );
-
-    return;
+    return options;
 }
 
 void ScribbleArea::setGaussianGradient( QGradient &gradient, QColor colour, qreal opacity, qreal mOffset )
@@ -1087,106 +1442,84 @@ void ScribbleArea::setGaussianGradient( QGradient &gradient, QColor colour, qrea
 
 void ScribbleArea::drawPen( QPointF thePoint, qreal brushWidth, QColor fillColour, bool useAA )
 {
-    QRectF rectangle( thePoint.x() - 0.5 * brushWidth, thePoint.y() - 0.5 * brushWidth, brushWidth, brushWidth );
+    TRACE_SCOPE( "ScribbleArea::drawPen" );
+    mDabCount++;
 
-    mBufferImg->drawEllipse( rectangle, Qt::NoPen, QBrush(fillColour, Qt::SolidPattern),
-                               QPainter::CompositionMode_Source, useAA );
+    StrokeDab dab;
+    dab.rect = QRectF( thePoint.x() - 0.5 * brushWidth, thePoint.y() - 0.5 * brushWidth, brushWidth, brushWidth );
+    dab.brush = QBrush( fillColour, Qt::SolidPattern );
+    dab.mode = QPainter::CompositionMode_Source;
+    dab.isAntialiased = useAA;
+    mStrokeRasterizer.queueDab( dab );
 }
 
 void ScribbleArea::drawPencil( QPointF thePoint, qreal brushWidth, QColor fillColour, qreal opacity )
 {
+    TRACE_SCOPE( "ScribbleArea::drawPencil" );
+
     drawBrush(thePoint, brushWidth, 50, fillColour, opacity, true);
 }
 
 void ScribbleArea::drawBrush( QPointF thePoint, qreal brushWidth, qreal mOffset, QColor fillColour, qreal opacity, bool usingFeather, int useAA )
 {
-    QRectF rectangle( thePoint.x() - 0.5 * brushWidth, thePoint.y() - 0.5 * brushWidth, brushWidth, brushWidth );
+    TRACE_SCOPE( "ScribbleArea::drawBrush" );
+    mDabCount++;
 
-    BitmapImage tempBitmapImage;
+    StrokeDab dab;
+    dab.rect = QRectF( thePoint.x() - 0.5 * brushWidth, thePoint.y() - 0.5 * brushWidth, brushWidth, brushWidth );
     if (usingFeather==true)
     {
         QRadialGradient radialGrad( thePoint, 0.5 * brushWidth );
         setGaussianGradient( radialGrad, fillColour, opacity, mOffset );
 
-        tempBitmapImage.drawEllipse( rectangle, Qt::NoPen, radialGrad,
-                                   QPainter::CompositionMode_Source, false );
+        dab.brush = radialGrad;
+        dab.mode = QPainter::CompositionMode_SourceOver;
+        dab.isAntialiased = false;
     }
     else
     {
-        mBufferImg->drawEllipse( rectangle, Qt::NoPen, QBrush(fillColour, Qt::SolidPattern),
-                                   QPainter::CompositionMode_Source, useAA );
+        dab.brush = QBrush( fillColour, Qt::SolidPattern );
+        dab.mode = QPainter::CompositionMode_Source;
+        dab.isAntialiased = ( useAA != 0 );
     }
-    mBufferImg->paste( &tempBitmapImage );
+    mStrokeRasterizer.queueDab( dab );
 }
 
-void ScribbleArea::blurBrush( BitmapImage *bmiSource_, QPointF srcPoint_, QPointF thePoint_, qreal brushWidth_, qreal mOffset_, qreal opacity_ )
+// The dab weights follow setGaussianGradient(), for the same feel as the painted brushes
+void ScribbleArea::blurBrush( BitmapImage *targetImage, QPointF srcPoint_, QPointF thePoint_, qreal brushWidth_, qreal mOffset_, qreal opacity_ )
 {
-    QRadialGradient radialGrad( thePoint_, 0.5 * brushWidth_ );
-    setGaussianGradient( radialGrad, QColor( 255, 255, 255, 127 ), opacity_, mOffset_ );
-
-    QRectF srcRect( srcPoint_.x() - 0.5 * brushWidth_, srcPoint_.y() - 0.5 * brushWidth_, brushWidth_, brushWidth_ );
-    QRectF trgRect( thePoint_.x() - 0.5 * brushWidth_, thePoint_.y() - 0.5 * brushWidth_, brushWidth_, brushWidth_ );
+    TRACE_SCOPE( "ScribbleArea::blurBrush" );
+    mDabCount++;
 
-    BitmapImage bmiSrcClip = bmiSource_->copy( srcRect.toRect() );
-    BitmapImage bmiTmpClip = bmiSrcClip; // todo: find a shorter way
+    qreal offset = qBound( 0.0, mOffset_, 100.0 );
+    int mainAlpha = qRound( 127 * opacity_ );
 
-    bmiTmpClip.drawRect( srcRect, Qt::NoPen, radialGrad, QPainter::CompositionMode_Source, mPrefs->isOn( SETTING::ANTIALIAS ) );
-    bmiSrcClip.bounds().moveTo( trgRect.topLeft().toPoint() );
-    bmiTmpClip.paste( &bmiSrcClip, QPainter::CompositionMode_SourceAtop );
-    mBufferImg->paste( &bmiTmpClip );
+    SmudgeDab dab;
+    dab.from = srcPoint_;
+    dab.to = thePoint_;
+    dab.radius = 0.5 * brushWidth_;
+    dab.strength = ( mainAlpha - qRound( mainAlpha * offset / 100 ) ) / 255.0;
+    dab.softness = offset / 100;
+    dab.isDisplacementWeighted = false;
+    targetImage->smudge( dab );
 }
 
-void ScribbleArea::liquifyBrush( BitmapImage *bmiSource_, QPointF srcPoint_, QPointF thePoint_, qreal brushWidth_, qreal mOffset_, qreal opacity_ )
+void ScribbleArea::liquifyBrush( BitmapImage *targetImage, QPointF srcPoint_, QPointF thePoint_, qreal brushWidth_, qreal mOffset_, qreal opacity_ )
 {
-    QPointF delta = ( thePoint_ - srcPoint_ ); // increment vector
-    QRectF trgRect( thePoint_.x() - 0.5 * brushWidth_, thePoint_.y() - 0.5 * brushWidth_, brushWidth_, brushWidth_ );
+    TRACE_SCOPE( "ScribbleArea::liquifyBrush" );
+    mDabCount++;
 
-    QRadialGradient radialGrad( thePoint_, 0.5 * brushWidth_ );
-    setGaussianGradient( radialGrad, QColor( 255, 255, 255, 255 ), opacity_, mOffset_ );
+    qreal offset = qBound( 0.0, mOffset_, 100.0 );
+    int mainAlpha = qRound( 255 * opacity_ );
 
-    // Create gradient brush
-    BitmapImage* bmiTmpClip = new BitmapImage;
-    bmiTmpClip->drawRect( trgRect, Qt::NoPen, radialGrad, QPainter::CompositionMode_Source, mPrefs->isOn( SETTING::ANTIALIAS ) );
-
-    // Slide texture/pixels of the source image
-    qreal factor, factorGrad;
-    int xb, yb, xa, ya;
-
-    for ( yb = bmiTmpClip->bounds().top(); yb < bmiTmpClip->bounds().bottom(); yb++ )
-    {
-        for ( xb = bmiTmpClip->bounds().left(); xb < bmiTmpClip->bounds().right(); xb++ )
-        {
-            QColor color;
-            color.setRgba( bmiTmpClip->pixel( xb, yb ) );
-            factorGrad = color.alphaF(); // any from r g b a is ok
-
-            xa = xb - factorGrad*delta.x();
-            ya = yb - factorGrad*delta.y();
-
-            color.setRgba( bmiSource_->pixel( xa, ya ) );
-            factor = color.alphaF();
-
-            if ( factor > 0.0 )
-            {
-                color.setRed( color.red() / factor );
-                color.setGreen( color.green() / factor );
-                color.setBlue( color.blue() / factor );
-                color.setAlpha( 255 ); // Premultiplied color
-
-                color.setRed( color.red()*factorGrad );
-                color.setGreen( color.green()*factorGrad );
-                color.setBlue( color.blue()*factorGrad );
-                color.setAlpha( 255 * factorGrad ); // Premultiplied color
-
-                bmiTmpClip->setPixel( xb, yb, color.rgba() );
-            }
-            else {
-                bmiTmpClip->setPixel( xb, yb, qRgba( 255, 255, 255, 255 ) );
-            }
-        }
-    }
-    mBufferImg->paste( bmiTmpClip );
-    delete bmiTmpClip;
+    SmudgeDab dab;
+    dab.from = srcPoint_;
+    dab.to = thePoint_;
+    dab.radius = 0.5 * brushWidth_;
+    dab.strength = ( mainAlpha - qRound( mainAlpha * offset / 100 ) ) / 255.0;
+    dab.softness = offset / 100;
+    dab.isDisplacementWeighted = true;
+    targetImage->smudge( dab );
 }
 
 void ScribbleArea::drawPolyline(QPainterPath path, QPen pen, bool useAA)
@@ -1589,6 +1922,7 @@ void ScribbleArea::deleteSelection()
         mClosestCurves.clear();
         if ( layer->type() == Layer::VECTOR ) { ( ( LayerVector * )layer )->getLastVectorImageAtFrame( mEditor->currentFrame(), 0 )->deleteSelection(); }
         if ( layer->type() == Layer::BITMAP ) { ( ( LayerBitmap * )layer )->getLastBitmapImageAtFrame( mEditor->currentFrame(), 0 )->clear( mySelection ); }
+        mEditor->thumbnails()->invalidate( layer, mEditor->currentFrame() );
         updateAllFrames();
     }
 }
@@ -1629,6 +1963,8 @@ void ScribbleArea::paletteColorChanged(QColor color)
 {
     Q_UNUSED(color);
     updateAllVectorLayersAtCurrentFrame();
+    // The strokes of the colour are on other frames too
+    updateAllVectorLayers();
 }
 
 
@@ -20,7 +20,6 @@ GNU General Public License for more details.
 #define SCRIBBLEAREA_H
 
 #include <cstdint>
-#include <ctime>
 #include <deque>
 #include <memory>
 
@@ -28,6 +27,8 @@ GNU General Public License for more details.
 #include <QTransform>
 #include <QPoint>
 #include <QWidget>
+#include <QElapsedTimer>
+#include <QTimer>
 #include <QPixmapCache>
 
 #include "log.h"
@@ -39,6 +40,8 @@ GNU General Public License for more details.
 #include "colormanager.h"
 #include "viewmanager.h"
 #include "canvasrenderer.h"
+#include "playbackcache.h"
+#include "strokerasterizer.h"
 #include "preferencemanager.h"
 
 
@@ -94,6 +97,7 @@ public:
     void updateCurrentFrame();
     void updateFrame( int frame );
     void updateAllFrames();
+    void updateKeyFrameSpan( int layerNumber, int frame );
     void updateAllVectorLayersAtCurrentFrame();
     void updateAllVectorLayersAt( int frame );
     void updateAllVectorLayers();
@@ -114,6 +118,13 @@ public:
     void floodFillError( int errorType );
 
     bool isMouseInUse() { return mMouseInUse; }
+    int  dabCount() const { return mDabCount; } // brush dabs painted since the start, for input replays
+
+    // All the layers as shown, in widget pixels, without the tool overlays.
+    // Shares its pixels with the canvas until the canvas is painted again.
+    QImage canvasImage() const { return mCanvas.toImage(); }
+    // The vector image as the canvas paints it, in widget pixels
+    const QImage& vectorRaster( VectorImage* vectorImage );
 
 signals:
     void modification();
@@ -162,12 +173,18 @@ public:
     void drawPen( QPointF thePoint, qreal brushWidth, QColor fillColour, bool useAA = true );
     void drawPencil( QPointF thePoint, qreal brushWidth, QColor fillColour, qreal opacity );
     void drawBrush( QPointF thePoint, qreal brushWidth, qreal offset, QColor fillColour, qreal opacity, bool usingFeather = true, int useAA = 0 );
-    void blurBrush( BitmapImage *bmiSource_, QPointF srcPoint_, QPointF thePoint_, qreal brushWidth_, qreal offset_, qreal opacity_ );
-    void liquifyBrush( BitmapImage *bmiSource_, QPointF srcPoint_, QPointF thePoint_, qreal brushWidth_, qreal offset_, qreal opacity_ );
+    // These two change targetImage in place rather than drawing into the buffer
+    void blurBrush( BitmapImage *targetImage, QPointF srcPoint_, QPointF thePoint_, qreal brushWidth_, qreal offset_, qreal opacity_ );
+    void liquifyBrush( BitmapImage *targetImage, QPointF srcPoint_, QPointF thePoint_, qreal brushWidth_, qreal offset_, qreal opacity_ );
 
     void paintBitmapBuffer();
     void paintBitmapBufferRect( QRect rect );
     void clearBitmapBuffer();
+    // Shows the stroke drawn into the buffer so far over the current layer,
+    // redrawing only rect. The key frame is left as it is until paintBitmapBuffer().
+    // Dabs queued since the last call are handed to the stroke rasterizer instead,
+    // the canvas follows when they are drawn.
+    void updateBitmapBuffer( const QRectF& rect, int rad );
     void refreshBitmap( const QRectF& rect, int rad );
     void refreshVector( const QRectF& rect, int rad );
     void setGaussianGradient( QGradient &gradient, QColor colour, qreal opacity, qreal offset );
@@ -176,8 +193,22 @@ public:
     BitmapImage* mStrokeImg = nullptr; // used for brush strokes before they are finalized
 
 private:
+    bool isCoalescingInput( QMouseEvent* event );
+    void flushInput();
+    void keyFrameChanged();
+    void moveTool( QMouseEvent* event );
+
     void drawCanvas( int frame, QRect rect );
+    void redrawCanvasRect( QRect rect );
+    void showBitmapBuffer( const QRectF& rect );
+    void showRasterizedDabs();
+    QPainter::CompositionMode bufferCompositionMode();
+    RenderOptions renderOptions();
     void settingUpdated(SETTING setting);
+    void clearPixmapCache();
+    void updatePlaybackCacheState();
+    void playStateChanged( bool isPlaying );
+    void paintPerformanceHud( QPainter& painter );
 
     MoveMode mMoveMode = MIDDLE;
     ToolType mPrevTemporalToolType;
@@ -207,6 +238,19 @@ private:
 private: 
     bool mKeyboardInUse = false;
     bool mMouseInUse    = false;
+    int  mDabCount      = 0;
+    bool mIsBufferInCanvas = false; // the renderer composites the stroke buffer into the current layer
+
+    // The moves of a stroke are handed to the tool once per frame
+    QTimer mInputFlushTimer;
+    QElapsedTimer mInputFlushClock; // since the last flush
+    int  mInputFrameInterval = 16;  // ms
+    Qt::MouseButtons mQueuedButtons = Qt::NoButton;
+    Qt::KeyboardModifiers mQueuedModifiers = Qt::NoModifier;
+    bool mIsTabletMouseDevice = false;
+    bool mIsRedrawDeferred = false; // while flushing, the canvas is redrawn once at the end
+    QRect mDeferredRedrawRect;
+    bool mIsKeyFrameChangeDeferred = false;
     QPointF mLastPixel;
     QPointF mCurrentPixel;
     QPointF mLastPoint;
@@ -231,10 +275,24 @@ private:
 	// Pixmap Cache keys
 	std::vector<QPixmapCache::Key> mPixmapCacheKeys;
 
+    // Pre-rendered frames of the playback range
+    PlaybackCache mPlaybackCache;
+
+    // Draws the brush, pencil, pen and eraser dabs into mBufferImg off the gui thread
+    StrokeRasterizer mStrokeRasterizer;
+
     // debug
     QRectF mDebugRect;
     QLoggingCategory mLog;
-    std::deque< clock_t > mDebugTimeQue;
+    std::deque< qint64 > mDebugTimeQue; // time of the recent paint events, in ms
+
+    // rendering statistics, shown when SETTING::PERFORMANCE_HUD is on
+    bool mShowPerformanceHud = false;
+    QElapsedTimer mDebugClock;
+    qint64 mLastCanvasTimeUs = 0;
+    int mLastLayersPainted = 0;
+    int mCacheHits = 0;
+    int mCacheMisses = 0;
 };
 
 #endif
@@ -18,6 +18,7 @@ GNU General Public License for more details.
 #include "timelinecells.h"
 
 #include <QSettings>
+#include <QTimer>
 #include <QResizeEvent>
 #include <QMouseEvent>
 #include "object.h"
@@ -27,6 +28,8 @@ GNU General Public License for more details.
 #include "playbackmanager.h"
 #include "preferencemanager.h"
 #include "toolmanager.h"
+#include "scribblearea.h"
+#include "thumbnailcache.h"
 
 
 TimeLineCells::TimeLineCells( TimeLine* parent, Editor* editor, TIMELINE_CELL_TYPE type ) : QWidget( parent )
@@ -43,6 +46,7 @@ TimeLineCells::TimeLineCells( TimeLine* parent, Editor* editor, TIMELINE_CELL_TY
     frameSize = mPrefs->getInt(SETTING::FRAME_SIZE);
     shortScrub = mPrefs->isOn(SETTING::SHORT_SCRUB);
     drawFrameNumber = mPrefs->isOn(SETTING::DRAW_LABEL);
+    showThumbnails = mPrefs->isOn(SETTING::TIMELINE_THUMBNAILS);
 
     startY = 0;
     endY = 0;
@@ -58,6 +62,11 @@ TimeLineCells::TimeLineCells( TimeLine* parent, Editor* editor, TIMELINE_CELL_TY
     setAttribute( Qt::WA_OpaquePaintEvent, false );
 
     connect( mPrefs, &PreferenceManager::optionChanged, this, &TimeLineCells::loadSetting );
+
+    if ( m_eType == TIMELINE_CELL_TYPE::Tracks )
+    {
+        connect( mEditor->thumbnails(), &ThumbnailCache::thumbnailUpdated, this, &TimeLineCells::thumbnailUpdated );
+    }
 }
 
 TimeLineCells::~TimeLineCells()
@@ -86,12 +95,41 @@ void TimeLineCells::loadSetting(SETTING setting)
     case SETTING::DRAW_LABEL:
         drawFrameNumber = mPrefs->isOn(SETTING::DRAW_LABEL);
         break;
+    case SETTING::TIMELINE_THUMBNAILS:
+        showThumbnails = mPrefs->isOn(SETTING::TIMELINE_THUMBNAILS);
+        break;
     default:
         break;
     }
     updateContent();
 }
 
+QImage TimeLineCells::keyFrameThumbnail( Layer* layer, int framePos )
+{
+    if ( !showThumbnails || frameSize < minThumbnailFrameSize )
+    {
+        return QImage();
+    }
+    return mEditor->thumbnails()->thumbnail( layer, framePos );
+}
+
+void TimeLineCells::thumbnailUpdated( int layerId )
+{
+    mTrackRows.remove( layerId );
+
+    // Thumbnails come in bunches, redraw once for all of them
+    if ( !isRedrawScheduled )
+    {
+        isRedrawScheduled = true;
+        QTimer::singleShot( 40, this, [this]
+        {
+            isRedrawScheduled = false;
+            drawContent();
+            update();
+        } );
+    }
+}
+
 int TimeLineCells::getFrameNumber( int x )
 {
     int frameNumber = frameOffset + 1 + ( x - m_offsetX ) / frameSize;
@@ -150,6 +188,7 @@ void TimeLineCells::updateFrame( int frameNumber )
 
 void TimeLineCells::updateContent()
 {
+    mTrackRows.clear();
     drawContent();
     update();
 }
@@ -180,28 +219,30 @@ void TimeLineCells::drawContent()
     painter.setBrush( Qt::lightGray );
     painter.drawRect( QRect( 0, 0, width(), height() ) );
 
-    // --- draw layers of the current object
+    // --- draw layers of the current object, only the rows in view
+    int currentLayerIndex = mEditor->layers()->currentLayerIndex();
     for ( int i = 0; i < object->getLayerCount(); i++ )
     {
-        if ( i != mEditor->layers()->currentLayerIndex() )
+        int y = getLayerY( i );
+        if ( i == currentLayerIndex || y + getLayerHeight() < m_offsetY || y > height() )
         {
-            Layer* layeri = object->getLayer( i );
-            if ( layeri != NULL )
+            continue;
+        }
+
+        Layer* layeri = object->getLayer( i );
+        if ( layeri != NULL )
+        {
+            switch ( m_eType )
             {
-                switch ( m_eType )
-                {
-                case TIMELINE_CELL_TYPE::Tracks:
-                    layeri->paintTrack( painter, this, m_offsetX,
-                                        getLayerY( i ), width() - m_offsetX,
-                                        getLayerHeight(), false, frameSize );
-                    break;
-
-                case TIMELINE_CELL_TYPE::Layers:
-                    layeri->paintLabel( painter, this, 0,
-                                        getLayerY( i ), width() - 1,
-                                        getLayerHeight(), false, mEditor->allLayers() );
-                    break;
-                }
+            case TIMELINE_CELL_TYPE::Tracks:
+                paintTrackRow( painter, layeri, y, false );
+                break;
+
+            case TIMELINE_CELL_TYPE::Layers:
+                layeri->paintLabel( painter, this, 0,
+                                    y, width() - 1,
+                                    getLayerHeight(), false, mEditor->allLayers() );
+                break;
             }
         }
     }
@@ -209,11 +250,11 @@ void TimeLineCells::drawContent()
     {
         if ( m_eType == TIMELINE_CELL_TYPE::Tracks )
         {
-            layer->paintTrack( painter, this, m_offsetX, getLayerY( mEditor->layers()->currentLayerIndex() ) + getMouseMoveY(), width() - m_offsetX, getLayerHeight(), true, frameSize );
+            paintTrackRow( painter, layer, getLayerY( currentLayerIndex ) + getMouseMoveY(), true );
         }
         if ( m_eType == TIMELINE_CELL_TYPE::Layers )
         {
-            layer->paintLabel( painter, this, 0, getLayerY( mEditor->layers()->currentLayerIndex() ) + getMouseMoveY(), width() - 1, getLayerHeight(), true, mEditor->allLayers() );
+            layer->paintLabel( painter, this, 0, getLayerY( currentLayerIndex ) + getMouseMoveY(), width() - 1, getLayerHeight(), true, mEditor->allLayers() );
         }
         painter.setPen( Qt::black );
         painter.drawRect( 0, getLayerY( getLayerNumber( endY ) ) - 1, width(), 2 );
@@ -222,21 +263,14 @@ void TimeLineCells::drawContent()
     {
         if ( m_eType == TIMELINE_CELL_TYPE::Tracks )
         {
-            layer->paintTrack( painter,
-                               this,
-                               m_offsetX,
-                               getLayerY( mEditor->layers()->currentLayerIndex() ),
-                               width() - m_offsetX,
-                               getLayerHeight(),
-                               true,
-                               frameSize );
+            paintTrackRow( painter, layer, getLayerY( currentLayerIndex ), true );
         }
         if ( m_eType == TIMELINE_CELL_TYPE::Layers )
         {
             layer->paintLabel( painter,
                                this, 
                                0, 
-                               getLayerY( mEditor->layers()->currentLayerIndex() ),
+                               getLayerY( currentLayerIndex ),
                                width() - 1,
                                getLayerHeight(),
                                true,
@@ -313,6 +347,40 @@ void TimeLineCells::drawContent()
     }
 }
 
+void TimeLineCells::paintTrackRow( QPainter& painter, Layer* layer, int y, bool selected )
+{
+    // The track is drawn from one pixel above y, hence the extra line
+    QSize rowSize( width() + 1, getLayerHeight() + 1 );
+
+    TrackRow& row = mTrackRows[ layer->id() ];
+    bool isValid = row.revision == layer->revision()
+        && row.frameOffset == frameOffset
+        && row.frameSize == frameSize
+        && row.selected == selected
+        && row.visible == layer->visible()
+        && row.pixmap.size() == rowSize;
+
+    if ( !isValid )
+    {
+        if ( row.pixmap.size() != rowSize )
+        {
+            row.pixmap = QPixmap( rowSize );
+        }
+        row.pixmap.fill( Qt::transparent );
+
+        QPainter rowPainter( &row.pixmap );
+        layer->paintTrack( rowPainter, this, m_offsetX, 1, width() - m_offsetX, getLayerHeight(), selected, frameSize );
+
+        row.revision = layer->revision();
+        row.frameOffset = frameOffset;
+        row.frameSize = frameSize;
+        row.selected = selected;
+        row.visible = layer->visible();
+    }
+
+    painter.drawPixmap( 0, y - 1, row.pixmap );
+}
+
 void TimeLineCells::paintOnionSkin( QPainter& painter )
 {
     Layer* layer = mEditor->layers()->currentLayer();
@@ -617,9 +685,16 @@ void TimeLineCells::mouseMoveEvent( QMouseEvent* event )
                             movingFrames        = true;
 
                             int offset = frameNumber - lastFrameNumber;
+                            bool hadFirstFrame = currentLayer->keyExists(1);
                             currentLayer->moveSelectedFrames(offset);
 
-                            mEditor->updateCurrentFrame();
+                            // If the first frame moved away, we need to create a new first frame
+                            if ( hadFirstFrame && !currentLayer->keyExists(1) )
+                            {
+                                currentLayer->addNewEmptyKeyAt(1);
+                            }
+
+                            mEditor->getScribbleArea()->updateAllFrames();
 
                         }
                         else if ( canBoxSelect ){
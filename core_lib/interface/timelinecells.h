@@ -20,6 +20,9 @@ GNU General Public License for more details.
 
 #include <QWidget>
 #include <QString>
+#include <QHash>
+#include <QPixmap>
+#include <QImage>
 
 
 class TimeLine;
@@ -27,6 +30,7 @@ class QPaintEvent;
 class QMouseEvent;
 class QResizeEvent;
 class Editor;
+class Layer;
 class PreferenceManager;
 enum class SETTING;
 
@@ -55,6 +59,9 @@ public:
     int getFrameSize() { return frameSize; }
     void clearCache() { if ( m_pCache ) delete m_pCache; m_pCache = new QPixmap( size() ); }
 
+    // Null when thumbnails are off, the cells are too small, or it isn't rendered yet
+    QImage keyFrameThumbnail( Layer* layer, int framePos );
+
 Q_SIGNALS:
     void mouseMovedY(int);
     void lengthChanged(int);
@@ -69,6 +76,7 @@ public slots:
 
 protected:
     void drawContent();
+    void paintTrackRow(QPainter& painter, Layer* layer, int y, bool selected);
     void paintOnionSkin(QPainter& painter);
     void paintEvent(QPaintEvent* event);
     void resizeEvent(QResizeEvent* event);
@@ -79,6 +87,7 @@ protected:
 
 private slots:
     void loadSetting(SETTING setting);
+    void thumbnailUpdated(int layerId);
 
 private:
     TimeLine* timeLine;
@@ -88,8 +97,23 @@ private:
     TIMELINE_CELL_TYPE m_eType;
 
     QPixmap* m_pCache;
+
+    // Pre-drawn track of each layer, by layer id
+    struct TrackRow
+    {
+        QPixmap pixmap;
+        int revision = -1;
+        int frameOffset = -1;
+        int frameSize = -1;
+        bool selected = false;
+        bool visible = false;
+    };
+    QHash< int, TrackRow > mTrackRows;
     bool drawFrameNumber;
     bool shortScrub;
+    bool showThumbnails;
+    bool isRedrawScheduled = false;
+    const static int minThumbnailFrameSize = 10;
     int frameLength;
     int frameSize;
     int fontSize;
@@ -186,19 +186,7 @@ LayerSound* LayerManager::createSoundLayer( const QString& strLayerName )
 
 int LayerManager::LastFrameAtFrame( int frameIndex )
 {
-    Object* pObj = editor()->object();
-    for ( int i = frameIndex; i >= 0; i -= 1 )
-    {
-        for ( int layerIndex = 0; layerIndex < pObj->getLayerCount(); ++layerIndex )
-        {
-            auto pLayer = pObj->getLayer( layerIndex );
-            if ( pLayer->keyExists( i ) )
-            {
-                return i;
-            }
-        }
-    }
-    return -1;
+    return editor()->object()->getLastKeyFramePositionAt( frameIndex );
 }
 
 int LayerManager::firstKeyFrameIndex()
@@ -221,19 +209,7 @@ int LayerManager::firstKeyFrameIndex()
 
 int LayerManager::lastKeyFrameIndex()
 {
-    int maxPosition = 0;
-
-    for ( int i = 0; i < editor()->object()->getLayerCount(); ++i )
-    {
-        Layer* pLayer = editor()->object()->getLayer( i );
-
-        int position = pLayer->getMaxKeyFramePosition();
-        if ( position > maxPosition )
-        {
-            maxPosition = position;
-        }
-    }
-    return maxPosition;
+    return editor()->object()->getMaxKeyFramePosition();
 }
 
 int LayerManager::count()
@@ -263,18 +239,12 @@ bool LayerManager::deleteCurrentLayer()
 
 int LayerManager::projectLength()
 {
-    int maxFrame = -1;
-
     Object* pObject = editor()->object();
-    for ( int i = 0; i < pObject->getLayerCount(); i++ )
+    if ( pObject->getLayerCount() == 0 )
     {
-        int frame = pObject->getLayer( i )->getMaxKeyFramePosition();
-        if ( frame > maxFrame )
-        {
-            maxFrame = frame;
-        }
+        return -1;
     }
-    return maxFrame;
+    return pObject->getMaxKeyFramePosition();
 }
 
 void LayerManager::layerUpdated(int layerId)
@@ -17,10 +17,12 @@ GNU General Public License for more details.
 
 #include "playbackmanager.h"
 
+#include <algorithm>
 #include <QTimer>
 #include "object.h"
 #include "editor.h"
 #include "layersound.h"
+#include "layercamera.h"
 #include "layermanager.h"
 #include "soundmanager.h"
 #include "soundclip.h"
@@ -47,6 +49,9 @@ Status PlaybackManager::load( Object* o )
     mMarkOutFrame     = e->getMarkOutFrameNumber();
     mFps              = e->getFrameRate();
 
+    mIsSoundTimelineDirty = true;
+    mPlayingClips.clear();
+
     return Status::OK;
 }
 
@@ -78,6 +83,12 @@ void PlaybackManager::play()
         editor()->scrubTo( mStartFrame );
     }
 
+    // The camera views of the frames to play, looked up on every repaint
+    for ( LayerCamera* camera : object()->getLayersByType< LayerCamera >() )
+    {
+        camera->cacheViews( mStartFrame, mEndFrame );
+    }
+
     mTimer->setInterval( 1000.0f / mFps );
     mTimer->start();
 
@@ -91,6 +102,11 @@ void PlaybackManager::stop()
 {
     mTimer->stop();
     stopSounds();
+
+    for ( LayerCamera* camera : object()->getLayersByType< LayerCamera >() )
+    {
+        camera->clearCachedViews();
+    }
     emit playStateChanged(false);
 }
 
@@ -112,6 +128,7 @@ void PlaybackManager::setFps( int fps )
                 soundLayer->updateFrameLengths(mFps);
             }
         }
+        mIsSoundTimelineDirty = true;
     }
 }
 
@@ -123,63 +140,73 @@ void PlaybackManager::playSounds( int frame )
         return;
     }
 
-    std::vector< LayerSound* > kSoundLayers;
-    for ( int i = 0; i < object()->getLayerCount(); ++i )
+    updateSoundTimeline();
+
+    // The clips that are over have stopped by themselves
+    mPlayingClips.erase( std::remove_if( mPlayingClips.begin(), mPlayingClips.end(), [ frame ]( SoundClip* clip )
     {
-        Layer* layer = object()->getLayer( i );
-        if ( layer->type() == Layer::SOUND )
+        return clip->pos() + clip->length() <= frame;
+    } ), mPlayingClips.end() );
+
+    mClipsToPlay.clear();
+    if (mCheckForSoundsHalfway)
+    {
+        // Check for sounds which we should start playing from part-way through.
+        mSoundTimeline.clipsCovering( frame, mClipsToPlay );
+        for ( SoundClip* clip : mClipsToPlay )
         {
-            kSoundLayers.push_back( static_cast< LayerSound* >( layer ) );
+            clip->playFromPosition(frame, mFps);
         }
-    }
 
-    for ( LayerSound* layer : kSoundLayers )
+        // Set flag to false, since this check should only be done when
+        // starting play-back.
+        mCheckForSoundsHalfway = false;
+    }
+    else
     {
-        if (mCheckForSoundsHalfway)
+        mSoundTimeline.clipsStartingAt( frame, mClipsToPlay );
+        for ( SoundClip* clip : mClipsToPlay )
         {
-            // Check for sounds which we should start playing from part-way through.
-            if ( layer->keyExistsWhichCovers( frame ) )
-            {
-                KeyFrame* key = layer->getKeyFrameWhichCovers( frame );
-                SoundClip* clip = static_cast< SoundClip* >( key );
-
-                clip->playFromPosition(frame, mFps);
-            }
-
-            // Set flag to false, since this check should only be done when
-            // starting play-back.
-            mCheckForSoundsHalfway = false;
+            clip->play();
         }
-        else if ( layer->keyExists( frame ) )
-        {
-            KeyFrame* key = layer->getKeyFrameAt( frame );
-            SoundClip* clip = static_cast< SoundClip* >( key );
+    }
 
-            clip->play();
+    // A loop shorter than a clip starts it again while it's still listed
+    for ( SoundClip* clip : mClipsToPlay )
+    {
+        if ( std::find( mPlayingClips.begin(), mPlayingClips.end(), clip ) == mPlayingClips.end() )
+        {
+            mPlayingClips.push_back( clip );
         }
     }
 }
 
 void PlaybackManager::stopSounds()
 {
-    std::vector< LayerSound* > kSoundLayers;
-    for ( int i = 0; i < object()->getLayerCount(); ++i )
+    // Clips removed since the last tick aren't there to stop anymore
+    updateSoundTimeline();
+
+    for ( SoundClip* clip : mPlayingClips )
     {
-        Layer* layer = object()->getLayer( i );
-        if ( layer->type() == Layer::SOUND )
-        {
-            kSoundLayers.push_back( static_cast< LayerSound* >( layer ) );
-        }
+        clip->stop();
     }
+    mPlayingClips.clear();
+}
 
-    for ( LayerSound* layer : kSoundLayers )
+void PlaybackManager::updateSoundTimeline()
+{
+    if ( !mIsSoundTimelineDirty && mSoundTimeline.isUpToDate( object() ) )
     {
-        layer->foreachKeyFrame( []( KeyFrame* key )
-        {
-            SoundClip* clip = static_cast< SoundClip* >( key );
-            clip->stop();
-        } );
+        return;
     }
+
+    mSoundTimeline.build( object() );
+    mIsSoundTimelineDirty = false;
+
+    mPlayingClips.erase( std::remove_if( mPlayingClips.begin(), mPlayingClips.end(), [ this ]( SoundClip* clip )
+    {
+        return !mSoundTimeline.contains( clip );
+    } ), mPlayingClips.end() );
 }
 
 void PlaybackManager::timerTick()
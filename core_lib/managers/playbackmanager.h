@@ -18,9 +18,12 @@ GNU General Public License for more details.
 #ifndef PLAYBACKMANAGER_H
 #define PLAYBACKMANAGER_H
 
+#include <vector>
 #include "basemanager.h"
+#include "soundtimeline.h"
 
 class QTimer;
+class SoundClip;
 
 
 class PlaybackManager : public BaseManager
@@ -54,6 +57,9 @@ public:
     void setRangedEndFrame( int frame ) { mMarkOutFrame = frame; }
     void enableSound( bool b );
 
+    // A sound clip changed length, the clips are looked up again
+    void soundClipsChanged() { mIsSoundTimelineDirty = true; }
+
 Q_SIGNALS:
     void fpsChanged( int fps );
     void loopStateChanged( bool b );
@@ -65,6 +71,7 @@ private:
     
     void playSounds( int frame );
     void stopSounds();
+    void updateSoundTimeline();
 
     int mStartFrame = 1;
     int mEndFrame = 60;
@@ -81,6 +88,11 @@ private:
     QTimer* mTimer = nullptr;
 
     bool mCheckForSoundsHalfway = false;
+
+    SoundTimeline mSoundTimeline;
+    bool mIsSoundTimelineDirty = true;
+    std::vector< SoundClip* > mPlayingClips; // started and not over yet
+    std::vector< SoundClip* > mClipsToPlay;
 };
 
 #endif // PLAYBACKMANAGER_H
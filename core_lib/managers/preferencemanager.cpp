@@ -67,6 +67,9 @@ void PreferenceManager::loadPrefs()
     set( SETTING::HIGH_RESOLUTION,          settings.value( SETTING_HIGH_RESOLUTION,        true ).toBool() );
     set( SETTING::SHADOW,                   settings.value( SETTING_SHADOW,                 false ).toBool() );
     set( SETTING::QUICK_SIZING,             settings.value( SETTING_QUICK_SIZING,           true ).toBool() );
+    set( SETTING::EYEDROPPER_SAMPLE_SIZE,   settings.value( SETTING_EYEDROPPER_SAMPLE_SIZE, 1 ).toInt() );
+    set( SETTING::EYEDROPPER_ALL_LAYERS,    settings.value( SETTING_EYEDROPPER_ALL_LAYERS,  false ).toBool() );
+    set( SETTING::PERFORMANCE_HUD,          settings.value( SETTING_PERFORMANCE_HUD,        false ).toBool() );
 
     set( SETTING::WINDOW_OPACITY,           settings.value( SETTING_WINDOW_OPACITY,         0 ).toInt() );
     set( SETTING::CURVE_SMOOTHING,          settings.value( SETTING_CURVE_SMOOTHING,        20 ).toInt() );
@@ -78,6 +81,8 @@ void PreferenceManager::loadPrefs()
     // Files
     set( SETTING::AUTO_SAVE,                settings.value( SETTING_AUTO_SAVE,              true ).toBool() );
     set( SETTING::AUTO_SAVE_NUMBER,         settings.value( SETTING_AUTO_SAVE_NUMBER,       20 ).toInt() );
+    set( SETTING::BITMAP_MEMORY_LIMIT,      settings.value( SETTING_BITMAP_MEMORY_LIMIT,    2048 ).toInt() );
+    set( SETTING::EMBED_THUMBNAILS,         settings.value( SETTING_EMBED_THUMBNAILS,       true ).toBool() );
 
     // Timeline
     //
@@ -86,6 +91,7 @@ void PreferenceManager::loadPrefs()
     set( SETTING::TIMELINE_SIZE,            settings.value( SETTING_TIMELINE_SIZE,          240 ).toInt() );
     set( SETTING::DRAW_LABEL,               settings.value( SETTING_DRAW_LABEL,             false ).toBool() );
     set( SETTING::LABEL_FONT_SIZE,          settings.value( SETTING_LABEL_FONT_SIZE,        12 ).toInt() );
+    set( SETTING::TIMELINE_THUMBNAILS,      settings.value( SETTING_TIMELINE_THUMBNAILS,    true ).toBool() );
 
     // Onion Skin
     //
@@ -198,6 +204,15 @@ void PreferenceManager::set( SETTING option, int value )
     case SETTING::AUTO_SAVE_NUMBER:
         settings.setValue ( SETTING_AUTO_SAVE_NUMBER, value );
         break;
+    case SETTING::BITMAP_MEMORY_LIMIT:
+        if (value < 0) { value = 0; }
+        settings.setValue ( SETTING_BITMAP_MEMORY_LIMIT, value );
+        break;
+    case SETTING::EYEDROPPER_SAMPLE_SIZE:
+        if (value < 1) { value = 1; }
+        else if (value > 31) { value = 31; }
+        settings.setValue ( SETTING_EYEDROPPER_SAMPLE_SIZE, value );
+        break;
     case SETTING::FRAME_SIZE:
         if (value < 4) { value = 4; }
         else if (value > 20) { value = 20; }
@@ -309,6 +324,18 @@ void PreferenceManager::set( SETTING option, bool value )
     case SETTING::LAYOUT_LOCK:
         settings.setValue( SETTING_LAYOUT_LOCK, value );
         break;
+    case SETTING::PERFORMANCE_HUD:
+        settings.setValue( SETTING_PERFORMANCE_HUD, value );
+        break;
+    case SETTING::TIMELINE_THUMBNAILS:
+        settings.setValue( SETTING_TIMELINE_THUMBNAILS, value );
+        break;
+    case SETTING::EMBED_THUMBNAILS:
+        settings.setValue( SETTING_EMBED_THUMBNAILS, value );
+        break;
+    case SETTING::EYEDROPPER_ALL_LAYERS:
+        settings.setValue( SETTING_EYEDROPPER_ALL_LAYERS, value );
+        break;
     default:
         Q_ASSERT( false );
         break;
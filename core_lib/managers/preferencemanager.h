@@ -60,6 +60,12 @@ enum class SETTING
     MULTILAYER_ONION,
     LANGUAGE,
     LAYOUT_LOCK,
+    PERFORMANCE_HUD,
+    BITMAP_MEMORY_LIMIT,
+    TIMELINE_THUMBNAILS,
+    EMBED_THUMBNAILS,
+    EYEDROPPER_SAMPLE_SIZE,
+    EYEDROPPER_ALL_LAYERS,
     COUNT, // COUNT must always be the last one.
 };
 
@@ -147,12 +147,28 @@ Status SoundManager::loadSound( SoundClip* soundClip, QString strSoundFile )
 void SoundManager::onDurationChanged( SoundPlayer* player, int64_t duration )
 {
     SoundClip* clip = player->clip();
+    clip->setDuration( duration );
 
-    double fps = static_cast< double >( editor()->fps() );
+    // Through its layer, so the views drawing the clip know it has a new length
+    LayerSound* clipLayer = nullptr;
+    Object* obj = editor()->object();
+    for ( int i = 0; i < obj->getLayerCount() && clipLayer == nullptr; ++i )
+    {
+        Layer* layer = obj->getLayer( i );
+        if ( layer->type() == Layer::SOUND && layer->getKeyFrameAt( clip->pos() ) == clip )
+        {
+            clipLayer = static_cast< LayerSound* >( layer );
+        }
+    }
 
-    double frameLength = duration * fps / 1000.0;
-    clip->setLength( frameLength );
-    clip->setDuration( duration );
+    if ( clipLayer != nullptr )
+    {
+        clipLayer->updateClipLength( clip, editor()->fps() );
+    }
+    else
+    {
+        clip->updateLength( editor()->fps() ); // not in a layer yet
+    }
 
     emit soundClipDurationChanged();
 }
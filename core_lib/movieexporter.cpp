@@ -27,6 +27,7 @@ GNU General Public License for more details.
 #include "layercamera.h"
 #include "layersound.h"
 #include "soundclip.h"
+#include "util.h"
 
 #define IMAGE_FILENAME "/test_img_%05d.png"
 
@@ -314,6 +315,8 @@ Status MovieExporter::generateImageSequence(
 	{
 		cameraLayer = obj->getLayersByType< LayerCamera >().front();
 	}
+	cameraLayer->cacheViews( frameStart, frameEnd );
+	OnScopeExit( cameraLayer->clearCachedViews() );
 
 	for ( int currentFrame = frameStart; currentFrame <= frameEnd; currentFrame++ )
 	{
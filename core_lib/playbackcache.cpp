@@ -0,0 +1,337 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "playbackcache.h"
+
+#include <climits>
+#include <QTimer>
+#include "object.h"
+#include "layer.h"
+#include "keyframe.h"
+#include "tracer.h"
+
+
+PlaybackCache::PlaybackCache( QObject* parent ) : QObject( parent )
+    , mLog( "PlaybackCache" )
+{
+    ENABLE_DEBUG_LOG( mLog, false );
+
+    // Wait for the user to pause before warming up, so drawing isn't slowed down.
+    mIdleTimer = new QTimer( this );
+    mIdleTimer->setSingleShot( true );
+    mIdleTimer->setInterval( 500 );
+    connect( mIdleTimer, &QTimer::timeout, this, [this] { mWarmUpTimer->start(); } );
+
+    // A zero interval timer fires whenever the event loop has nothing else to do.
+    mWarmUpTimer = new QTimer( this );
+    mWarmUpTimer->setInterval( 0 );
+    connect( mWarmUpTimer, &QTimer::timeout, this, &PlaybackCache::warmUpTick );
+}
+
+PlaybackCache::~PlaybackCache()
+{
+}
+
+void PlaybackCache::setRenderState( Object* object, int layerIndex, QTransform view, QSize canvasSize, RenderOptions options )
+{
+    if ( object != mObject || canvasSize != mCanvasSize )
+    {
+        clear();
+    }
+    mObject = object;
+    mLayerIndex = layerIndex;
+    mView = view;
+    mCanvasSize = canvasSize;
+    mOptions = options;
+
+    updateScale();
+}
+
+void PlaybackCache::setRange( int startFrame, int endFrame )
+{
+    mStartFrame = std::max( startFrame, 1 );
+    mEndFrame = std::max( endFrame, mStartFrame );
+
+    updateScale();
+}
+
+void PlaybackCache::setMemoryBudget( qint64 bytes )
+{
+    mMemoryBudget = bytes;
+    clear();
+    updateScale();
+}
+
+bool PlaybackCache::find( int frame, QPixmap& pixmap ) const
+{
+    auto it = mFrames.find( frame );
+    if ( it == mFrames.end() )
+    {
+        return false;
+    }
+    pixmap = it->second;
+    return true;
+}
+
+bool PlaybackCache::insert( int frame, const QPixmap& canvas )
+{
+    if ( frame < mStartFrame || frame > mEndFrame || mFrames.count( frame ) > 0 )
+    {
+        return false;
+    }
+    if ( canvas.size() != mCanvasSize )
+    {
+        return false; // rendered with another state, e.g. in the middle of a resize
+    }
+
+    if ( mScale < 1.0 )
+    {
+        return store( frame, canvas.scaled( mCanvasSize * mScale, Qt::IgnoreAspectRatio, Qt::FastTransformation ) );
+    }
+    return store( frame, canvas );
+}
+
+void PlaybackCache::invalidate( int startFrame, int endFrame )
+{
+    auto first = mFrames.lower_bound( startFrame );
+    auto last = mFrames.upper_bound( endFrame );
+    for ( auto it = first; it != last; ++it )
+    {
+        qint64 key = it->second.cacheKey();
+        if ( --mPixmapRefCount[ key ] == 0 )
+        {
+            mPixmapRefCount.remove( key );
+            mMemoryUsage -= bytesOf( it->second );
+        }
+    }
+    mFrames.erase( first, last );
+
+    mCursor = std::max( startFrame, mStartFrame );
+    scheduleWarmUp();
+}
+
+void PlaybackCache::invalidateKeyFrameSpan( Layer* layer, int frame )
+{
+    Q_ASSERT( layer );
+
+    // A key frame shows on screen from its position up to the next key of the same layer.
+    KeyFrame* key = layer->getLastKeyFrameAtPosition( frame );
+    int startFrame = ( key != nullptr ) ? key->pos() : 1;
+    int nextFrame = layer->getNextKeyFramePosition( startFrame );
+    int endFrame = ( nextFrame > startFrame ) ? nextFrame - 1 : INT_MAX;
+
+    // The current layer is also visible as onion skin on the neighbouring frames.
+    bool isOnionOn = mOptions.bPrevOnionSkin || mOptions.bNextOnionSkin;
+    if ( isOnionOn && mObject != nullptr && layer == mObject->getLayer( mLayerIndex ) )
+    {
+        if ( mOptions.bIsOnionAbsolute )
+        {
+            for ( int i = 0; i < mOptions.nNextOnionSkinCount; ++i )
+            {
+                startFrame = layer->getPreviousKeyFramePosition( startFrame );
+            }
+            for ( int i = 0; i < mOptions.nPrevOnionSkinCount && endFrame != INT_MAX; ++i )
+            {
+                int next = layer->getNextKeyFramePosition( endFrame + 1 );
+                endFrame = ( next > endFrame + 1 ) ? next - 1 : INT_MAX;
+            }
+        }
+        else
+        {
+            startFrame -= mOptions.nNextOnionSkinCount;
+            if ( endFrame != INT_MAX )
+            {
+                endFrame += mOptions.nPrevOnionSkinCount;
+            }
+        }
+    }
+
+    invalidate( startFrame, endFrame );
+}
+
+void PlaybackCache::clear()
+{
+    mFrames.clear();
+    mPixmapRefCount.clear();
+    mMemoryUsage = 0;
+    mCursor = mStartFrame;
+}
+
+void PlaybackCache::scheduleWarmUp()
+{
+    mWarmUpTimer->stop();
+    if ( !mIsHeld )
+    {
+        mIdleTimer->start();
+    }
+}
+
+void PlaybackCache::startWarmUp( int fromFrame )
+{
+    mCursor = qBound( mStartFrame, fromFrame, mEndFrame );
+    mIdleTimer->stop();
+    if ( !mIsHeld )
+    {
+        mWarmUpTimer->start();
+    }
+}
+
+void PlaybackCache::holdWarmUp( bool hold )
+{
+    mIsHeld = hold;
+    if ( hold )
+    {
+        mIdleTimer->stop();
+        mWarmUpTimer->stop();
+    }
+    else
+    {
+        scheduleWarmUp();
+    }
+}
+
+bool PlaybackCache::isComplete() const
+{
+    auto first = mFrames.lower_bound( mStartFrame );
+    auto last = mFrames.upper_bound( mEndFrame );
+    return std::distance( first, last ) == ( mEndFrame - mStartFrame + 1 );
+}
+
+void PlaybackCache::warmUpTick()
+{
+    if ( mIsHeld || mObject == nullptr || mCanvasSize.isEmpty() )
+    {
+        mWarmUpTimer->stop();
+        return;
+    }
+
+    // Frames that look exactly like the previous one are free, keep going until one needs rendering.
+    int frame = nextFrameToRender();
+    while ( frame > 0 && canReusePreviousFrame( frame ) )
+    {
+        store( frame, mFrames[ frame - 1 ] );
+        frame = nextFrameToRender();
+    }
+
+    if ( frame < 0 || mMemoryUsage >= mMemoryBudget )
+    {
+        qCDebug( mLog ) << "Warm-up done." << mFrames.size() << "frames," << mMemoryUsage / 1024 << "KB";
+        mWarmUpTimer->stop();
+        return;
+    }
+
+    if ( !renderFrame( frame ) )
+    {
+        // The budget is too short for one more frame, rendering it again wouldn't help
+        qCDebug( mLog ) << "Warm-up stopped, out of memory budget." << mFrames.size() << "frames," << mMemoryUsage / 1024 << "KB";
+        mWarmUpTimer->stop();
+        return;
+    }
+    mCursor = frame + 1;
+}
+
+int PlaybackCache::nextFrameToRender() const
+{
+    for ( int frame = mCursor; frame <= mEndFrame; ++frame )
+    {
+        if ( mFrames.count( frame ) == 0 )
+        {
+            return frame;
+        }
+    }
+    for ( int frame = mStartFrame; frame < mCursor; ++frame )
+    {
+        if ( mFrames.count( frame ) == 0 )
+        {
+            return frame;
+        }
+    }
+    return -1;
+}
+
+bool PlaybackCache::canReusePreviousFrame( int frame ) const
+{
+    if ( frame <= mStartFrame || mFrames.count( frame - 1 ) == 0 )
+    {
+        return false;
+    }
+
+    // Onion skins may differ from one frame to the next, even without a new key.
+    if ( mOptions.bPrevOnionSkin || mOptions.bNextOnionSkin )
+    {
+        return false;
+    }
+
+    for ( int i = 0; i < mObject->getLayerCount(); ++i )
+    {
+        if ( mObject->getLayer( i )->keyExists( frame ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PlaybackCache::renderFrame( int frame )
+{
+    TRACE_SCOPE( "PlaybackCache::renderFrame" );
+
+    QSize size = mCanvasSize * mScale;
+
+    QPixmap canvas( size );
+    mRenderer.setCanvas( &canvas );
+    mRenderer.setViewTransform( mView * QTransform::fromScale( mScale, mScale ) );
+    mRenderer.setOptions( mOptions );
+    mRenderer.paint( mObject, mLayerIndex, frame, QRect( QPoint( 0, 0 ), size ) );
+
+    return store( frame, canvas );
+}
+
+bool PlaybackCache::store( int frame, const QPixmap& pixmap )
+{
+    qint64 key = pixmap.cacheKey();
+    if ( !mPixmapRefCount.contains( key ) )
+    {
+        qint64 bytes = bytesOf( pixmap );
+        if ( mMemoryUsage + bytes > mMemoryBudget )
+        {
+            return false;
+        }
+        mMemoryUsage += bytes;
+    }
+    mPixmapRefCount[ key ] += 1;
+    mFrames[ frame ] = pixmap;
+    return true;
+}
+
+void PlaybackCache::updateScale()
+{
+    // Drop to half resolution (a quarter of the memory) when the range doesn't fit.
+    qint64 frameBytes = qint64( mCanvasSize.width() ) * mCanvasSize.height() * 4;
+    qint64 frameCount = mEndFrame - mStartFrame + 1;
+    qreal scale = ( frameBytes * frameCount > mMemoryBudget ) ? 0.5 : 1.0;
+
+    if ( scale != mScale )
+    {
+        clear();
+        mScale = scale;
+    }
+}
+
+qint64 PlaybackCache::bytesOf( const QPixmap& pixmap ) const
+{
+    return qint64( pixmap.width() ) * pixmap.height() * pixmap.depth() / 8;
+}
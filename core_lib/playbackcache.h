@@ -0,0 +1,104 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef PLAYBACKCACHE_H
+#define PLAYBACKCACHE_H
+
+#include <map>
+#include <QObject>
+#include <QHash>
+#include <QPixmap>
+#include <QTransform>
+#include "canvasrenderer.h"
+#include "log.h"
+
+class QTimer;
+class Object;
+class Layer;
+
+
+// Keeps fully composited canvases of the playback range so that
+// looping playback only has to blit a pixmap per frame.
+//
+// Frames are rendered ahead of time while the event loop is idle, one frame
+// per tick, so that input and the playback timer are never blocked for long.
+// If the whole range does not fit in the memory budget at full resolution,
+// frames are kept at half resolution and scaled up when displayed.
+class PlaybackCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlaybackCache( QObject* parent = 0 );
+    virtual ~PlaybackCache();
+
+    void setRenderState( Object* object, int layerIndex, QTransform view, QSize canvasSize, RenderOptions options );
+    void setRange( int startFrame, int endFrame );
+    void setMemoryBudget( qint64 bytes );
+
+    bool find( int frame, QPixmap& pixmap ) const;
+    bool insert( int frame, const QPixmap& canvas );
+
+    void invalidate( int startFrame, int endFrame );
+    void invalidateKeyFrameSpan( Layer* layer, int frame );
+    void clear();
+
+    void scheduleWarmUp();
+    void startWarmUp( int fromFrame );
+    void holdWarmUp( bool hold );
+
+    qint64 memoryUsage() const { return mMemoryUsage; }
+    qint64 memoryBudget() const { return mMemoryBudget; }
+    int    cachedFrameCount() const { return static_cast< int >( mFrames.size() ); }
+    qreal  scale() const { return mScale; }
+    bool   isComplete() const;
+
+private:
+    void warmUpTick();
+    int  nextFrameToRender() const;
+    bool canReusePreviousFrame( int frame ) const;
+    bool renderFrame( int frame );
+    bool store( int frame, const QPixmap& pixmap ); // false when the frame doesn't fit in the budget
+    void updateScale();
+    qint64 bytesOf( const QPixmap& pixmap ) const;
+
+    Object*       mObject = nullptr;
+    int           mLayerIndex = 0;
+    QTransform    mView;
+    QSize         mCanvasSize;
+    RenderOptions mOptions;
+
+    int mStartFrame = 1;
+    int mEndFrame = 1;
+    int mCursor = 1;
+
+    qreal  mScale = 1.0;
+    qint64 mMemoryBudget = 256 * 1024 * 1024;
+    qint64 mMemoryUsage = 0;
+
+    std::map< int, QPixmap > mFrames;
+    QHash< qint64, int > mPixmapRefCount; // pixmaps shared by held frames are counted once
+
+    CanvasRenderer mRenderer;
+
+    QTimer* mIdleTimer = nullptr;
+    QTimer* mWarmUpTimer = nullptr;
+    bool mIsHeld = false;
+
+    QLoggingCategory mLog;
+};
+
+#endif // PLAYBACKCACHE_H
@@ -0,0 +1,49 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "backgroundsaver.h"
+
+
+BackgroundSaver::BackgroundSaver( QObject* parent ) : QThread( parent )
+{
+}
+
+BackgroundSaver::~BackgroundSaver()
+{
+    // Never leave a half written file behind
+    wait();
+}
+
+bool BackgroundSaver::save( const ProjectSnapshot& snapshot, const QString& fileName )
+{
+    if ( isRunning() )
+    {
+        return false;
+    }
+    mSnapshot = snapshot;
+    mFileName = fileName;
+    mStatus = Status::OK;
+    ++mSaveId;
+    start( QThread::LowPriority );
+    return true;
+}
+
+void BackgroundSaver::run()
+{
+    mStatus = mSnapshot.writePCLX( mFileName );
+    mSnapshot = ProjectSnapshot();
+    emit saveFinished( mSaveId );
+}
@@ -0,0 +1,56 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef BACKGROUNDSAVER_H
+#define BACKGROUNDSAVER_H
+
+#include <QThread>
+#include "projectsnapshot.h"
+#include "pencilerror.h"
+
+
+// Writes a project snapshot on a worker thread, one save at a time.
+// saveFinished() is emitted with the id of the save when the file is written,
+// see status(). The id tells a queued signal of an earlier save from the current one.
+class BackgroundSaver : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit BackgroundSaver( QObject* parent = nullptr );
+    ~BackgroundSaver();
+
+    // Returns false if the previous save is still running
+    bool save( const ProjectSnapshot& snapshot, const QString& fileName );
+
+    int     saveId() const { return mSaveId; } // of the last save started
+    QString fileName() const { return mFileName; }
+    Status  status() const { return mStatus; }
+
+signals:
+    void saveFinished( int saveId );
+
+protected:
+    void run() override;
+
+private:
+    ProjectSnapshot mSnapshot;
+    QString mFileName;
+    Status mStatus = Status::OK;
+    int mSaveId = 0;
+};
+
+#endif // BACKGROUNDSAVER_H
@@ -0,0 +1,411 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "binaryprojectfile.h"
+
+#include <cstring>
+#include <algorithm>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QImage>
+#include "bitmapimage.h"
+#include "vectorimage.h"
+
+
+static const char    PCLB_MAGIC[ 4 ] = { 'P', 'C', 'L', 'B' };
+static const quint32 PCLB_VERSION = 2; // 2: bitmap chunks tag their pixel format
+static const int     PCLB_HEADER_SIZE = 16;
+static const int     PCLB_ALIGNMENT = 16;
+static const int     PCLB_TILE_SIZE = 256;
+static const int     PCLB_COMPRESSION_LEVEL = 1; // favour speed, the tiles are raw pixels
+
+namespace
+{
+    void setUpStream( QDataStream& stream )
+    {
+        stream.setByteOrder( QDataStream::LittleEndian );
+        stream.setFloatingPointPrecision( QDataStream::SinglePrecision );
+    }
+
+    struct BitmapChunkHeader
+    {
+        qint32 x = 0, y = 0, width = 0, height = 0, tileSize = 0;
+        quint32 tileCount = 0;
+        quint32 format = QImage::Format_ARGB32_Premultiplied; // the only format of version 1 files
+    };
+    const int BITMAP_HEADER_SIZE = 7 * 4;
+    const int TILE_ENTRY_SIZE = 2 * 4;
+
+    bool readBitmapHeader( QDataStream& in, quint32 version, BitmapChunkHeader& header )
+    {
+        in >> header.x >> header.y >> header.width >> header.height >> header.tileSize >> header.tileCount;
+        if ( version >= 2 )
+        {
+            in >> header.format;
+        }
+        return in.status() == QDataStream::Ok
+            && ( header.format == QImage::Format_ARGB32 || header.format == QImage::Format_ARGB32_Premultiplied );
+    }
+
+    int tileCountOf( int length, int tileSize )
+    {
+        return ( length + tileSize - 1 ) / tileSize;
+    }
+}
+
+
+BinaryProjectFile::BinaryProjectFile()
+{
+}
+
+BinaryProjectFile::~BinaryProjectFile()
+{
+    // closing the file also unmaps it
+}
+
+bool BinaryProjectFile::isBinaryProject( const QString& fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+    QByteArray magic = file.read( sizeof( PCLB_MAGIC ) );
+    return magic == QByteArray( PCLB_MAGIC, sizeof( PCLB_MAGIC ) );
+}
+
+Status BinaryProjectFile::create( const QString& fileName )
+{
+    QStringList debugDetails = QStringList() << "BinaryProjectFile::create" << QString( "fileName = " ).append( fileName );
+
+    mChunks.clear();
+    mOutput.reset( new QSaveFile( fileName ) );
+    if ( !mOutput->open( QIODevice::WriteOnly ) )
+    {
+        return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails << mOutput->errorString() );
+    }
+
+    // The header is filled in by commit(), once the index offset is known
+    mOutput->write( QByteArray( PCLB_HEADER_SIZE, '\0' ) );
+    return Status::OK;
+}
+
+Status BinaryProjectFile::addChunk( ChunkType type, int layerId, int frame, const QString& name, const QByteArray& data )
+{
+    Q_ASSERT( mOutput );
+
+    qint64 padding = ( PCLB_ALIGNMENT - mOutput->pos() % PCLB_ALIGNMENT ) % PCLB_ALIGNMENT;
+    mOutput->write( QByteArray( static_cast< int >( padding ), '\0' ) );
+
+    Chunk chunk;
+    chunk.type = type;
+    chunk.layerId = layerId;
+    chunk.frame = frame;
+    chunk.name = name;
+    chunk.offset = static_cast< quint64 >( mOutput->pos() );
+    chunk.size = static_cast< quint64 >( data.size() );
+
+    if ( mOutput->write( data ) != data.size() )
+    {
+        return Status( Status::FAIL, QStringList() << "BinaryProjectFile::addChunk" << mOutput->errorString() );
+    }
+    mChunks.push_back( chunk );
+    return Status::OK;
+}
+
+Status BinaryProjectFile::addBitmap( int layerId, int frame, BitmapImage* bitmapImage )
+{
+    // Keep the pixels as they are, premultiplying the straight alpha of
+    // png-loaded frames would round the colour of semi-transparent pixels
+    QImage image = *bitmapImage->image();
+    if ( !image.isNull() && image.format() != QImage::Format_ARGB32_Premultiplied )
+    {
+        image = image.convertToFormat( QImage::Format_ARGB32 );
+    }
+
+    BitmapChunkHeader header;
+    header.x = bitmapImage->topLeft().x();
+    header.y = bitmapImage->topLeft().y();
+    header.width = image.width();
+    header.height = image.height();
+    header.tileSize = PCLB_TILE_SIZE;
+    header.format = image.isNull() ? QImage::Format_ARGB32_Premultiplied : image.format();
+
+    int tilesX = tileCountOf( header.width, PCLB_TILE_SIZE );
+    int tilesY = tileCountOf( header.height, PCLB_TILE_SIZE );
+    header.tileCount = static_cast< quint32 >( tilesX * tilesY );
+
+    // Compress every tile on its own, fully transparent tiles are left empty
+    std::vector< QByteArray > tiles( header.tileCount );
+    QByteArray pixels;
+    for ( int ty = 0; ty < tilesY; ++ty )
+    {
+        for ( int tx = 0; tx < tilesX; ++tx )
+        {
+            int left = tx * PCLB_TILE_SIZE;
+            int top = ty * PCLB_TILE_SIZE;
+            int w = std::min( PCLB_TILE_SIZE, header.width - left );
+            int h = std::min( PCLB_TILE_SIZE, header.height - top );
+
+            int rowBytes = w * 4;
+            pixels.resize( rowBytes * h );
+            bool isEmpty = true;
+            for ( int row = 0; row < h; ++row )
+            {
+                const QRgb* src = reinterpret_cast< const QRgb* >( image.constScanLine( top + row ) ) + left;
+                std::memcpy( pixels.data() + row * rowBytes, src, rowBytes );
+                for ( int i = 0; i < w && isEmpty; ++i )
+                {
+                    isEmpty = ( src[ i ] == 0 );
+                }
+            }
+            if ( !isEmpty )
+            {
+                tiles[ ty * tilesX + tx ] = qCompress( pixels, PCLB_COMPRESSION_LEVEL );
+            }
+        }
+    }
+
+    QByteArray data;
+    QDataStream out( &data, QIODevice::WriteOnly );
+    setUpStream( out );
+    out << header.x << header.y << header.width << header.height << header.tileSize << header.tileCount << header.format;
+
+    quint32 offset = BITMAP_HEADER_SIZE + header.tileCount * TILE_ENTRY_SIZE;
+    for ( const QByteArray& tile : tiles )
+    {
+        out << offset << static_cast< quint32 >( tile.size() );
+        offset += tile.size();
+    }
+    for ( const QByteArray& tile : tiles )
+    {
+        out.writeRawData( tile.constData(), tile.size() );
+    }
+
+    return addChunk( BITMAP, layerId, frame, QString(), data );
+}
+
+Status BinaryProjectFile::addVector( int layerId, int frame, const VectorImage* vectorImage )
+{
+    QByteArray data;
+    QDataStream out( &data, QIODevice::WriteOnly );
+    setUpStream( out );
+    vectorImage->writeBinary( out );
+
+    return addChunk( VECTOR, layerId, frame, QString(), data );
+}
+
+Status BinaryProjectFile::commit()
+{
+    Q_ASSERT( mOutput );
+    QStringList debugDetails = QStringList() << "BinaryProjectFile::commit";
+
+    qint64 padding = ( PCLB_ALIGNMENT - mOutput->pos() % PCLB_ALIGNMENT ) % PCLB_ALIGNMENT;
+    mOutput->write( QByteArray( static_cast< int >( padding ), '\0' ) );
+    quint64 indexOffset = static_cast< quint64 >( mOutput->pos() );
+
+    QDataStream out( mOutput.get() );
+    setUpStream( out );
+    out << static_cast< quint32 >( mChunks.size() );
+    for ( const Chunk& chunk : mChunks )
+    {
+        out << chunk.type << chunk.layerId << chunk.frame << chunk.name << chunk.offset << chunk.size;
+    }
+
+    mOutput->seek( 0 );
+    out.writeRawData( PCLB_MAGIC, sizeof( PCLB_MAGIC ) );
+    out << PCLB_VERSION << indexOffset;
+
+    bool ok = ( out.status() == QDataStream::Ok ) && mOutput->commit();
+    if ( !ok )
+    {
+        debugDetails << mOutput->errorString();
+    }
+    mOutput.reset();
+
+    return ok ? Status::OK : Status( Status::FAIL, debugDetails );
+}
+
+Status BinaryProjectFile::open( const QString& fileName )
+{
+    QStringList debugDetails = QStringList() << "BinaryProjectFile::open" << QString( "fileName = " ).append( fileName );
+
+    mChunks.clear();
+    mVersion = 0;
+    mInput.reset( new QFile( fileName ) );
+    if ( !mInput->open( QIODevice::ReadOnly ) )
+    {
+        return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails );
+    }
+
+    mDataSize = mInput->size();
+    mData = mInput->map( 0, mDataSize );
+    if ( mData == nullptr )
+    {
+        mBuffer = mInput->readAll();
+        mData = reinterpret_cast< const uchar* >( mBuffer.constData() );
+    }
+
+    QByteArray header = QByteArray::fromRawData( reinterpret_cast< const char* >( mData ), static_cast< int >( std::min< qint64 >( mDataSize, PCLB_HEADER_SIZE ) ) );
+    if ( header.size() < PCLB_HEADER_SIZE || !header.startsWith( QByteArray( PCLB_MAGIC, sizeof( PCLB_MAGIC ) ) ) )
+    {
+        return Status( Status::ERROR_INVALID_PENCIL_FILE, debugDetails << "Not a binary project" );
+    }
+
+    QDataStream in( header );
+    setUpStream( in );
+    in.skipRawData( sizeof( PCLB_MAGIC ) );
+    quint32 version = 0;
+    quint64 indexOffset = 0;
+    in >> version >> indexOffset;
+    if ( version > PCLB_VERSION || indexOffset >= static_cast< quint64 >( mDataSize ) )
+    {
+        return Status( Status::ERROR_INVALID_PENCIL_FILE, debugDetails << QString( "version = %1" ).arg( version ) );
+    }
+    mVersion = version;
+
+    QByteArray index = QByteArray::fromRawData( reinterpret_cast< const char* >( mData + indexOffset ), static_cast< int >( mDataSize - indexOffset ) );
+    QDataStream indexStream( index );
+    setUpStream( indexStream );
+
+    quint32 count = 0;
+    indexStream >> count;
+    for ( quint32 i = 0; i < count && indexStream.status() == QDataStream::Ok; ++i )
+    {
+        Chunk chunk;
+        indexStream >> chunk.type >> chunk.layerId >> chunk.frame >> chunk.name >> chunk.offset >> chunk.size;
+        if ( chunk.offset + chunk.size > indexOffset )
+        {
+            return Status( Status::ERROR_INVALID_PENCIL_FILE, debugDetails << QString( "Chunk %1 is out of bounds" ).arg( i ) );
+        }
+        mChunks.push_back( chunk );
+    }
+
+    if ( indexStream.status() != QDataStream::Ok )
+    {
+        return Status( Status::ERROR_INVALID_PENCIL_FILE, debugDetails << "Corrupted index" );
+    }
+    return Status::OK;
+}
+
+QByteArray BinaryProjectFile::chunkData( const Chunk& chunk ) const
+{
+    Q_ASSERT( mData != nullptr );
+    return QByteArray::fromRawData( reinterpret_cast< const char* >( mData + chunk.offset ), static_cast< int >( chunk.size ) );
+}
+
+QImage BinaryProjectFile::readBitmapTile( const Chunk& chunk, int tileIndex ) const
+{
+    QByteArray data = chunkData( chunk );
+    QDataStream in( data );
+    setUpStream( in );
+
+    BitmapChunkHeader header;
+    if ( !readBitmapHeader( in, mVersion, header ) || tileIndex < 0 || static_cast< quint32 >( tileIndex ) >= header.tileCount )
+    {
+        return QImage();
+    }
+
+    int tilesX = tileCountOf( header.width, header.tileSize );
+    int left = ( tileIndex % tilesX ) * header.tileSize;
+    int top = ( tileIndex / tilesX ) * header.tileSize;
+    int w = std::min( header.tileSize, header.width - left );
+    int h = std::min( header.tileSize, header.height - top );
+
+    QImage tile( w, h, static_cast< QImage::Format >( header.format ) );
+    tile.fill( Qt::transparent );
+
+    in.skipRawData( tileIndex * TILE_ENTRY_SIZE );
+    quint32 offset = 0, size = 0;
+    in >> offset >> size;
+    if ( size == 0 || offset + size > static_cast< quint32 >( data.size() ) )
+    {
+        return tile;
+    }
+
+    QByteArray pixels = qUncompress( reinterpret_cast< const uchar* >( data.constData() + offset ), static_cast< int >( size ) );
+    int rowBytes = w * 4;
+    if ( pixels.size() != rowBytes * h )
+    {
+        return tile;
+    }
+    for ( int row = 0; row < h; ++row )
+    {
+        std::memcpy( tile.scanLine( row ), pixels.constData() + row * rowBytes, rowBytes );
+    }
+    return tile;
+}
+
+BitmapImage* BinaryProjectFile::readBitmap( const Chunk& chunk ) const
+{
+    QByteArray data = chunkData( chunk );
+    QDataStream in( data );
+    setUpStream( in );
+
+    BitmapChunkHeader header;
+    if ( !readBitmapHeader( in, mVersion, header ) || header.width <= 0 || header.height <= 0 || header.tileSize <= 0 )
+    {
+        return new BitmapImage( QRect( header.x, header.y, 0, 0 ), QImage() );
+    }
+
+    QImage image( header.width, header.height, static_cast< QImage::Format >( header.format ) );
+    image.fill( Qt::transparent );
+
+    int tilesX = tileCountOf( header.width, header.tileSize );
+    for ( quint32 i = 0; i < header.tileCount; ++i )
+    {
+        quint32 offset = 0, size = 0;
+        in >> offset >> size;
+        if ( size == 0 || offset + size > static_cast< quint32 >( data.size() ) )
+        {
+            continue;
+        }
+
+        int left = ( i % tilesX ) * header.tileSize;
+        int top = ( i / tilesX ) * header.tileSize;
+        int w = std::min( header.tileSize, header.width - left );
+        int h = std::min( header.tileSize, header.height - top );
+        int rowBytes = w * 4;
+
+        QByteArray pixels = qUncompress( reinterpret_cast< const uchar* >( data.constData() + offset ), static_cast< int >( size ) );
+        if ( pixels.size() != rowBytes * h )
+        {
+            continue;
+        }
+        for ( int row = 0; row < h; ++row )
+        {
+            QRgb* dst = reinterpret_cast< QRgb* >( image.scanLine( top + row ) ) + left;
+            std::memcpy( dst, pixels.constData() + row * rowBytes, rowBytes );
+        }
+    }
+
+    return new BitmapImage( QRect( header.x, header.y, header.width, header.height ), image );
+}
+
+Status BinaryProjectFile::readVector( const Chunk& chunk, VectorImage* vectorImage ) const
+{
+    QByteArray data = chunkData( chunk );
+    QDataStream in( data );
+    setUpStream( in );
+    vectorImage->readBinary( in );
+
+    if ( in.status() != QDataStream::Ok )
+    {
+        return Status( Status::FAIL, QStringList() << "BinaryProjectFile::readVector" << QString( "frame = %1" ).arg( chunk.frame ) );
+    }
+    return Status::OK;
+}
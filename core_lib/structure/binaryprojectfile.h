@@ -0,0 +1,97 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef BINARYPROJECTFILE_H
+#define BINARYPROJECTFILE_H
+
+#include <memory>
+#include <vector>
+#include <QString>
+#include <QByteArray>
+#include "pencilerror.h"
+
+class QFile;
+class QSaveFile;
+class QImage;
+class BitmapImage;
+class VectorImage;
+
+
+// The binary project format (*.pclb), an alternative to the zipped xml + png.
+//
+//   header   "PCLB", version, offset of the index
+//   chunks   one per key frame, plus main.xml, the palette and the sound files
+//   index    type, layer id, frame, name, offset and size of every chunk
+//
+// Bitmap chunks hold raw ARGB tiles in the pixel format of the frame
+// (straight or premultiplied alpha, tagged in the chunk header), compressed
+// one by one with fast zlib (no png on top of zip), empty tiles take no
+// space and any tile can be decoded on its own. Vector chunks hold the curves as packed float arrays.
+// Chunks are 16 bytes aligned and the file is memory mapped when read.
+class BinaryProjectFile
+{
+public:
+    enum ChunkType
+    {
+        MAIN_XML = 1,
+        PALETTE  = 2,
+        BITMAP   = 3,
+        VECTOR   = 4,
+        SOUND    = 5,
+    };
+
+    struct Chunk
+    {
+        quint32 type;
+        qint32  layerId;
+        qint32  frame;
+        QString name;
+        quint64 offset;
+        quint64 size;
+    };
+
+    BinaryProjectFile();
+    ~BinaryProjectFile();
+
+    static bool isBinaryProject( const QString& fileName );
+
+    // Writing, nothing replaces the file until commit() succeeds
+    Status create( const QString& fileName );
+    Status addChunk( ChunkType type, int layerId, int frame, const QString& name, const QByteArray& data );
+    Status addBitmap( int layerId, int frame, BitmapImage* bitmapImage );
+    Status addVector( int layerId, int frame, const VectorImage* vectorImage );
+    Status commit();
+
+    // Reading
+    Status open( const QString& fileName );
+    const std::vector< Chunk >& chunks() const { return mChunks; }
+    QByteArray chunkData( const Chunk& chunk ) const; // valid while the file is open
+    BitmapImage* readBitmap( const Chunk& chunk ) const;
+    Status readVector( const Chunk& chunk, VectorImage* vectorImage ) const;
+    QImage readBitmapTile( const Chunk& chunk, int tileIndex ) const;
+
+private:
+    std::unique_ptr< QSaveFile > mOutput;
+    std::unique_ptr< QFile > mInput;
+    QByteArray mBuffer; // when the file can't be mapped
+    const uchar* mData = nullptr;
+    qint64 mDataSize = 0;
+    quint32 mVersion = 0;
+
+    std::vector< Chunk > mChunks;
+};
+
+#endif // BINARYPROJECTFILE_H
@@ -0,0 +1,229 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "camerapath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <QtMath>
+
+
+namespace
+{
+// Keeps log() finite for views scaled down to nothing
+const qreal MIN_SCALE = 1e-6;
+}
+
+void CameraPath::setKeys( std::vector< std::pair< int, QTransform > > keys )
+{
+    std::sort( keys.begin(), keys.end(), []( const std::pair< int, QTransform >& a,
+                                             const std::pair< int, QTransform >& b )
+    {
+        return a.first < b.first;
+    } );
+
+    mKeys.clear();
+    mKeys.reserve( keys.size() );
+    for ( const auto& k : keys )
+    {
+        Key key;
+        key.frame = k.first;
+        key.view = k.second;
+        key.pose = decompose( k.second, key.isFlipped );
+
+        // Turn the short way round to the next key
+        if ( !mKeys.empty() )
+        {
+            const qreal previous = mKeys.back().pose[ 2 ];
+            key.pose[ 2 ] -= 2 * M_PI * std::round( ( key.pose[ 2 ] - previous ) / ( 2 * M_PI ) );
+        }
+        mKeys.push_back( key );
+    }
+
+    mHasLastView = false;
+    fillCache();
+}
+
+void CameraPath::setInterpolation( Interpolation interpolation )
+{
+    if ( mInterpolation != interpolation )
+    {
+        mInterpolation = interpolation;
+        mHasLastView = false;
+        fillCache();
+    }
+}
+
+QTransform CameraPath::view( int frame )
+{
+    if ( frame >= mCacheFirst && frame <= mCacheLast )
+    {
+        return mCache[ frame - mCacheFirst ];
+    }
+    if ( !mHasLastView || frame != mLastFrame )
+    {
+        mLastView = interpolate( frame );
+        mLastFrame = frame;
+        mHasLastView = true;
+    }
+    return mLastView;
+}
+
+void CameraPath::cacheRange( int firstFrame, int lastFrame )
+{
+    mCacheFirst = firstFrame;
+    mCacheLast = lastFrame;
+    fillCache();
+}
+
+void CameraPath::clearCache()
+{
+    mCacheFirst = 0;
+    mCacheLast = -1;
+    mCache.clear();
+    mCache.shrink_to_fit();
+}
+
+void CameraPath::fillCache()
+{
+    mCache.clear();
+    if ( mCacheLast < mCacheFirst )
+    {
+        return;
+    }
+    mCache.reserve( mCacheLast - mCacheFirst + 1 );
+    for ( int frame = mCacheFirst; frame <= mCacheLast; ++frame )
+    {
+        mCache.push_back( interpolate( frame ) );
+    }
+}
+
+CameraPath::Pose CameraPath::decompose( const QTransform& view, bool& isFlipped )
+{
+    // The view maps a canvas point p to ( p - centre ) * M, M rotates by
+    // angle, scales by scaleX and scaleY and shears x along y
+    const qreal angle = std::atan2( view.m12(), view.m11() );
+    const qreal c = std::cos( angle );
+    const qreal s = std::sin( angle );
+    const qreal scaleX = std::max( std::hypot( view.m11(), view.m12() ), MIN_SCALE );
+    const qreal scaleY = -view.m21() * s + view.m22() * c;
+    const qreal shear = ( view.m21() * c + view.m22() * s ) / scaleX;
+
+    QPointF centre;
+    bool isInvertible = false;
+    QTransform inverse = view.inverted( &isInvertible );
+    if ( isInvertible )
+    {
+        centre = inverse.map( QPointF( 0, 0 ) );
+    }
+
+    isFlipped = ( scaleY < 0 );
+    return Pose { { centre.x(), centre.y(), angle, std::log( scaleX ),
+                    std::log( std::max( std::abs( scaleY ), MIN_SCALE ) ), shear } };
+}
+
+QTransform CameraPath::compose( const Pose& pose, bool isFlipped )
+{
+    const qreal c = std::cos( pose[ 2 ] );
+    const qreal s = std::sin( pose[ 2 ] );
+    const qreal scaleX = std::exp( pose[ 3 ] );
+    const qreal scaleY = isFlipped ? -std::exp( pose[ 4 ] ) : std::exp( pose[ 4 ] );
+    const qreal shear = pose[ 5 ];
+
+    const qreal m11 = scaleX * c;
+    const qreal m12 = scaleX * s;
+    const qreal m21 = shear * scaleX * c - scaleY * s;
+    const qreal m22 = shear * scaleX * s + scaleY * c;
+    const qreal x = pose[ 0 ];
+    const qreal y = pose[ 1 ];
+    return QTransform( m11, m12, m21, m22, -( x * m11 + y * m21 ), -( x * m12 + y * m22 ) );
+}
+
+CameraPath::Pose CameraPath::tangent( size_t i ) const
+{
+    // Catmull-Rom, from the keys on either side, spaced as they are on the timeline
+    const size_t before = ( i > 0 ) ? i - 1 : i;
+    const size_t after = ( i + 1 < mKeys.size() ) ? i + 1 : i;
+    const qreal frames = mKeys[ after ].frame - mKeys[ before ].frame;
+
+    Pose result;
+    for ( size_t c = 0; c < result.size(); ++c )
+    {
+        result[ c ] = ( frames > 0 ) ? ( mKeys[ after ].pose[ c ] - mKeys[ before ].pose[ c ] ) / frames : 0;
+    }
+    return result;
+}
+
+QTransform CameraPath::interpolate( int frame ) const
+{
+    if ( mKeys.empty() )
+    {
+        return QTransform();
+    }
+    if ( frame <= mKeys.front().frame )
+    {
+        return mKeys.front().view;
+    }
+    if ( frame >= mKeys.back().frame )
+    {
+        return mKeys.back().view;
+    }
+
+    auto next = std::upper_bound( mKeys.begin(), mKeys.end(), frame, []( int f, const Key& key )
+    {
+        return f < key.frame;
+    } );
+    const size_t i = static_cast< size_t >( next - mKeys.begin() ) - 1;
+    const Key& key1 = mKeys[ i ];
+    const Key& key2 = mKeys[ i + 1 ];
+    if ( key1.frame == frame )
+    {
+        return key1.view;
+    }
+
+    const qreal frames = key2.frame - key1.frame;
+    qreal t = ( frame - key1.frame ) / frames;
+
+    Pose pose;
+    if ( mInterpolation == SPLINE )
+    {
+        // Cubic Hermite between the two keys
+        const Pose m1 = tangent( i );
+        const Pose m2 = tangent( i + 1 );
+        const qreal t2 = t * t;
+        const qreal t3 = t2 * t;
+        const qreal h00 = 2 * t3 - 3 * t2 + 1;
+        const qreal h10 = t3 - 2 * t2 + t;
+        const qreal h01 = -2 * t3 + 3 * t2;
+        const qreal h11 = t3 - t2;
+        for ( size_t c = 0; c < pose.size(); ++c )
+        {
+            pose[ c ] = h00 * key1.pose[ c ] + h10 * frames * m1[ c ] + h01 * key2.pose[ c ] + h11 * frames * m2[ c ];
+        }
+    }
+    else
+    {
+        if ( mInterpolation == EASE )
+        {
+            t = t * t * ( 3 - 2 * t );
+        }
+        for ( size_t c = 0; c < pose.size(); ++c )
+        {
+            pose[ c ] = key1.pose[ c ] + ( key2.pose[ c ] - key1.pose[ c ] ) * t;
+        }
+    }
+    return compose( pose, key1.isFlipped );
+}
@@ -0,0 +1,89 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <array>
+#include <utility>
+#include <vector>
+#include <QTransform>
+
+
+// The view of a camera at every frame, from the views of its key frames.
+// Each key view is taken apart into where the camera looks, its rotation,
+// scale and shear, which are interpolated on their own and put back
+// together. Lerping the matrices instead shrinks the picture half way
+// through a rotation.
+//
+// Before the first key and after the last one the camera doesn't move.
+// The views of a range of frames can be worked out ahead, for playback and
+// export, looking one up is then an index into an array.
+class CameraPath
+{
+public:
+    enum Interpolation
+    {
+        LINEAR = 0,
+        EASE   = 1, // slows down into and out of every key
+        SPLINE = 2, // smooth curve through all the keys
+    };
+
+    // The frames and views of the key frames, in any order
+    void setKeys( std::vector< std::pair< int, QTransform > > keys );
+    void setInterpolation( Interpolation interpolation );
+    Interpolation interpolation() const { return mInterpolation; }
+
+    QTransform view( int frame );
+
+    // Works out the views from firstFrame to lastFrame now, and again
+    // whenever the keys or the interpolation change
+    void cacheRange( int firstFrame, int lastFrame );
+    void clearCache();
+
+private:
+    // x and y of the looked at canvas point, rotation, log of the scales, shear
+    typedef std::array< qreal, 6 > Pose;
+
+    struct Key
+    {
+        int frame;
+        QTransform view;
+        Pose pose;
+        bool isFlipped; // mirrored, which can't be interpolated
+    };
+
+    static Pose decompose( const QTransform& view, bool& isFlipped );
+    static QTransform compose( const Pose& pose, bool isFlipped );
+
+    QTransform interpolate( int frame ) const;
+    Pose tangent( size_t i ) const; // change per frame at key i, for the spline
+    void fillCache();
+
+    std::vector< Key > mKeys; // by frame
+    Interpolation mInterpolation = LINEAR;
+
+    int mCacheFirst = 0;
+    int mCacheLast = -1;
+    std::vector< QTransform > mCache;
+
+    // Repaints ask for the same frame again and again
+    int mLastFrame = 0;
+    QTransform mLastView;
+    bool mHasLastView = false;
+};
+
+#endif // CAMERAPATH_H
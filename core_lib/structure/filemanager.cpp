@@ -17,10 +17,20 @@ GNU General Public License for more details.
 
 
 #include "filemanager.h"
+#include <QBuffer>
+#include <QDirIterator>
 #include "pencildef.h"
-#include "JlCompress.h"
 #include "fileformat.h"
 #include "object.h"
+#include "pclxreader.h"
+#include "binaryprojectfile.h"
+#include "projectsnapshot.h"
+#include "layerbitmap.h"
+#include "layervector.h"
+#include "layersound.h"
+#include "bitmapimage.h"
+#include "vectorimage.h"
+#include "tracer.h"
 
 
 FileManager::FileManager( QObject *parent ) : QObject( parent ),
@@ -29,8 +39,18 @@ FileManager::FileManager( QObject *parent ) : QObject( parent ),
     ENABLE_DEBUG_LOG( mLog, true );
 }
 
+namespace
+{
+    QString attributeOf( const QXmlStreamAttributes& attributes, const QString& name, const QString& defaultValue = QString() )
+    {
+        return attributes.hasAttribute( name ) ? attributes.value( name ).toString() : defaultValue;
+    }
+}
+
 Object* FileManager::load( QString strFileName )
 {
+    TRACE_SCOPE( "FileManager::load" );
+
     if ( !QFile::exists( strFileName ) )
     {
         qCDebug( mLog ) << "ERROR - File doesn't exist.";
@@ -43,11 +63,22 @@ Object* FileManager::load( QString strFileName )
     obj->setFilePath( strFileName );
     obj->createWorkingDir();
 
+    if ( BinaryProjectFile::isBinaryProject( strFileName ) )
+    {
+        qCDebug( mLog ) << "Recognized Binary Pencil File Format (*.pclb) !";
+        return loadBinary( obj, strFileName );
+    }
+
     QString strMainXMLFile;	
     QString strDataFolder;
 
     // Test file format: new zipped .pclx or old .pcl?
-    bool oldFormat = isOldForamt( strFileName );
+    PclxReader archive;
+    Status st = archive.open( strFileName );
+    bool oldFormat = ( st.code() == Status::NOT_SUPPORTED );
+
+    QScopedPointer< QIODevice > mainXML;
+    QByteArray mainXMLData;
 
     if ( oldFormat )
     {
@@ -55,15 +86,37 @@ Object* FileManager::load( QString strFileName )
 
         strMainXMLFile = strFileName;
         strDataFolder  = strMainXMLFile + "." + PFF_OLD_DATA_DIR;
+
+        mainXML.reset( new QFile( strMainXMLFile ) );
     }
     else
     {
         qCDebug( mLog ) << "Recognized New zipped Pencil File Format (*.pclx) !";
 
-        unzip( strFileName, obj->workingDir() );
+        if ( !st.ok() )
+        {
+            delete obj;
+            return cleanUpWithErrorCode( st );
+        }
+
+        // Images and vector frames are read from memory, only the other files go to the working folder
+        removePFFTmpDirectory( obj->workingDir() );
+        obj->createWorkingDir();
+        mstrLastTempFolder = obj->workingDir();
+
+        st = archive.extractFiles( obj->workingDir() );
+        if ( !st.ok() )
+        {
+            delete obj;
+            return cleanUpWithErrorCode( st );
+        }
 
         strMainXMLFile = QDir( obj->workingDir() ).filePath( PFF_XML_FILE_NAME );
         strDataFolder  = QDir( obj->workingDir() ).filePath( PFF_DATA_DIR );
+
+        mainXMLData = archive.entry( PFF_XML_FILE_NAME );
+        mainXML.reset( new QBuffer( &mainXMLData ) );
+        obj->setArchive( &archive );
     }
 
     qDebug() << "XML=" << strMainXMLFile;
@@ -73,121 +126,124 @@ Object* FileManager::load( QString strFileName )
     obj->setDataDir( strDataFolder );
     obj->setMainXMLFile( strMainXMLFile );
 
-    QFile file( strMainXMLFile );
-    if ( !file.open( QFile::ReadOnly ) )
+    if ( !mainXML->open( QIODevice::ReadOnly ) )
     {
+        delete obj;
         return cleanUpWithErrorCode( Status::ERROR_FILE_CANNOT_OPEN );
     }
 
-    qCDebug( mLog ) << "Checking main XML file...";
-    QDomDocument xmlDoc;
-    if ( !xmlDoc.setContent( &file ) )
+    // Create object.
+    qCDebug( mLog ) << "Start to load object..";
+
+    loadPalette( obj );
+
+    st = loadMainXML( obj, mainXML.data() );
+    obj->setArchive( nullptr );
+
+    if ( !st.ok() )
     {
-        return cleanUpWithErrorCode( Status::ERROR_INVALID_XML_FILE );
+        delete obj;
+        return cleanUpWithErrorCode( st );
     }
 
-    QDomDocumentType type = xmlDoc.doctype();
-    if ( !( type.name() == "PencilDocument" || type.name() == "MyObject" ) )
+    verifyObject( obj );
+    
+    return obj;
+}
+
+Status FileManager::loadMainXML( Object* object, QIODevice* device )
+{
+    qCDebug( mLog ) << "Checking main XML file...";
+
+    // Parsed straight into the object, no dom tree is built for the file
+    QXmlStreamReader xmlStream( device );
+    QString docType;
+    while ( xmlStream.readNext() != QXmlStreamReader::StartElement )
     {
-        return cleanUpWithErrorCode( Status::ERROR_INVALID_PENCIL_FILE );
+        if ( xmlStream.atEnd() )
+        {
+            return Status( Status::ERROR_INVALID_XML_FILE, QStringList() << xmlStream.errorString() );
+        }
+        if ( xmlStream.isDTD() )
+        {
+            docType = xmlStream.dtdName().toString();
+        }
     }
 
-    QDomElement root = xmlDoc.documentElement();
-    if ( root.isNull() )
+    if ( !( docType == "PencilDocument" || docType == "MyObject" ) )
     {
-        return cleanUpWithErrorCode( Status::ERROR_INVALID_PENCIL_FILE );
+        return Status::ERROR_INVALID_PENCIL_FILE;
     }
-    
-    // Create object.
-    qCDebug( mLog ) << "Start to load object..";
-
-    loadPalette( obj );
 
     bool ok = true;
-    
-    if ( root.tagName() == "document" )
+    if ( xmlStream.name() == "document" )
     {
-        ok = loadObject( obj, root );
+        ok = loadObject( object, xmlStream );
     }
-    else if ( root.tagName() == "object" || root.tagName() == "MyOject" ) // old Pencil format (<=0.4.3)
+    else if ( xmlStream.name() == "object" || xmlStream.name() == "MyOject" ) // old Pencil format (<=0.4.3)
     {
-        ok = loadObjectOldWay( obj, root );
+        ok = loadObjectOldWay( object, xmlStream );
     }
 
-    if ( !ok )
+    if ( xmlStream.hasError() )
     {
-        delete obj;
-        return cleanUpWithErrorCode( Status::ERROR_INVALID_PENCIL_FILE );
+        return Status( Status::ERROR_INVALID_XML_FILE, QStringList() << xmlStream.errorString() );
     }
-    
-    verifyObject( obj );
-    
-    return obj;
+    return ok ? Status::OK : Status::ERROR_INVALID_PENCIL_FILE;
 }
 
-bool FileManager::loadObject( Object* object, const QDomElement& root )
+bool FileManager::loadObject( Object* object, QXmlStreamReader& xmlStream )
 {
-    QDomElement e = root.firstChildElement( "object" );
-    if ( e.isNull() )
-    {
-        return false;
-    }
-    
+    bool hasObject = false;
     bool isOK = true;
-    for ( QDomNode node = root.firstChild(); !node.isNull(); node = node.nextSibling() )
+    while ( xmlStream.readNextStartElement() )
     {
-        QDomElement element = node.toElement(); // try to convert the node to an element.
-        if ( element.isNull() )
-        { 
-            continue;
-        }
-
-        if ( element.tagName() == "object" )
+        if ( xmlStream.name() == "object" )
         {
             qCDebug( mLog ) << "Load object";
-			isOK = object->loadXML( element, [this] ( float f )
-			{
-				emit progressUpdated( f );
-			} );
+            hasObject = true;
+            isOK = object->loadXML( xmlStream, [this] ( float f )
+            {
+                emit progressUpdated( f );
+            } );
         }
-        else if ( element.tagName() == "editor" || element.tagName() == "projectdata" )
+        else if ( xmlStream.name() == "editor" || xmlStream.name() == "projectdata" )
         {
-            ObjectData* projectData = loadProjectData( element );
+            ObjectData* projectData = loadProjectData( xmlStream );
             object->setData( projectData );
         }
         else
         {
-            Q_ASSERT( false );
+            xmlStream.skipCurrentElement();
         }
-        //progress = std::min( progress + 10, 100 );
-        //emit progressValueChanged( progress );
     }
 
-    return isOK;
+    return hasObject && isOK;
 }
 
-bool FileManager::loadObjectOldWay( Object* object, const QDomElement& root )
+bool FileManager::loadObjectOldWay( Object* object, QXmlStreamReader& xmlStream )
 {
-	return object->loadXML( root, [this]( float f )
-	{
-		emit progressUpdated( f );
-	} );
-}
-
-bool FileManager::isOldForamt( const QString& fileName )
-{
-    QStringList zippedFileList = JlCompress::getFileList( fileName );
-    return ( zippedFileList.empty() );
+    return object->loadXML( xmlStream, [this]( float f )
+    {
+        emit progressUpdated( f );
+    } );
 }
 
 Status FileManager::save( Object* object, QString strFileName )
 {
+    TRACE_SCOPE( "FileManager::save" );
+
     QStringList debugDetails = QStringList() << "FileManager::save" << QString( "strFileName = " ).append( strFileName );
     if ( object == nullptr )
     {
         return Status( Status::INVALID_ARGUMENT, debugDetails << "object parameter is null" );
     }
 
+    if ( strFileName.endsWith( PFF_BINARY_EXTENSION ) )
+    {
+        return saveBinary( object, strFileName );
+    }
+
     QFileInfo fileInfo( strFileName );
     if ( fileInfo.isDir() )
     { 
@@ -206,31 +262,34 @@ Status FileManager::save( Object* object, QString strFileName )
                        tr( "The file path you have specified (\"%1\") cannot be written to, so the file cannot be saved. Please make sure that you have sufficient permissions to save to that location and try again." ).arg( fileInfo.absoluteFilePath() ) );
     }
 
-    QString strTempWorkingFolder;
-    QString strMainXMLFile;
-    QString strDataFolder;
-
     bool isOldFile = strFileName.endsWith( PFF_OLD_EXTENSION );
-    if ( isOldFile )
-    {
-        qCDebug( mLog ) << "Save in Old Pencil File Format (*.pcl) !";
-
-        strMainXMLFile = strFileName;
-        strDataFolder = strMainXMLFile + "." + PFF_OLD_DATA_DIR;
-    }
-    else
+    if ( !isOldFile )
     {
         qCDebug( mLog ) << "Save in New zipped Pencil File Format (*.pclx) !";
 
-        strTempWorkingFolder = object->workingDir();
-        Q_ASSERT( QDir( strTempWorkingFolder ).exists() );
-        debugDetails << QString( "strTempWorkingFolder = " ).append( strTempWorkingFolder );
+        // Zipped straight from memory, the working folder is left as it is
+        ProjectSnapshot snapshot;
+        Status st = createSnapshot( object, snapshot );
+        if ( st.ok() )
+        {
+            st = snapshot.writePCLX( strFileName );
+        }
+        if ( !st.ok() )
+        {
+            return Status( st.code(), debugDetails << st.detailsList(), st.title(), st.description() );
+        }
+
+        object->setFilePath( strFileName );
+        object->setModified( false );
 
-        qCDebug( mLog ) << "Temp Folder=" << strTempWorkingFolder;
-        strMainXMLFile = QDir( strTempWorkingFolder ).filePath( PFF_XML_FILE_NAME );
-        strDataFolder = QDir( strTempWorkingFolder ).filePath( PFF_OLD_DATA_DIR );
+        return Status::OK;
     }
 
+    qCDebug( mLog ) << "Save in Old Pencil File Format (*.pcl) !";
+
+    QString strMainXMLFile = strFileName;
+    QString strDataFolder = strMainXMLFile + "." + PFF_OLD_DATA_DIR;
+
     QFileInfo dataInfo( strDataFolder );
     if ( !dataInfo.exists() )
     {
@@ -240,25 +299,13 @@ Status FileManager::save( Object* object, QString strFileName )
         if( !dir.mkpath( strDataFolder ) )
         {
             debugDetails << QString( "dir.absolutePath() = %1" ).arg( dir.absolutePath() );
-            if( isOldFile ) {
-                return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails, tr( "Cannot Create Data Directory" ), tr( "Cannot create the data directory at \"%1\". Please make sure that you have sufficient permissions to save to that location and try again. Alternatively try saving as pclx format." ).arg( strDataFolder ) );
-            }
-            else {
-                return Status( Status::FAIL, debugDetails, tr("Internal Error"), tr( "Cannot create the data directory at temporary location \"%1\". Please make sure that you have sufficient permissions to save to that location and try again. Alternatively try saving as pcl format." ).arg( strDataFolder ) );
-            }
+            return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails, tr( "Cannot Create Data Directory" ), tr( "Cannot create the data directory at \"%1\". Please make sure that you have sufficient permissions to save to that location and try again. Alternatively try saving as pclx format." ).arg( strDataFolder ) );
         }
     }
     if( !dataInfo.isDir() )
     {
         debugDetails << QString( "dataInfo.absoluteFilePath() = ").append(dataInfo.absoluteFilePath());
-        if( isOldFile )
-        {
-            return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails, tr( "Cannot Create Data Directory" ), tr( "Cannot use the path \"%1\" as a data directory since that currently points to a file. Please move or delete that file and try again. Alternatively try saving with the pclx format." ).arg( dataInfo.absoluteFilePath() ) );
-        }
-        else
-        {
-            return Status( Status::FAIL, debugDetails, tr( "Internal Error" ), tr( "Cannot use the data directory at temporary location \"%1\" since it is a file. Please move or delete that file and try again. Alternatively try saving with the pcl format." ).arg( dataInfo.absoluteFilePath() ) );
-        }
+        return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails, tr( "Cannot Create Data Directory" ), tr( "Cannot use the path \"%1\" as a data directory since that currently points to a file. Please move or delete that file and try again. Alternatively try saving with the pclx format." ).arg( dataInfo.absoluteFilePath() ) );
     }
 
     // save data
@@ -317,6 +364,101 @@ Status FileManager::save( Object* object, QString strFileName )
         return Status::ERROR_FILE_CANNOT_OPEN;
     }
 
+    QDomDocument xmlDoc = createMainXML( object );
+
+    const int IndentSize = 2;
+
+    QTextStream out( file.data() );
+    xmlDoc.save( out, IndentSize );
+
+    object->setFilePath( strFileName );
+    object->setModified( false );
+
+    return Status::OK;
+}
+
+Status FileManager::createSnapshot( Object* object, ProjectSnapshot& snapshot )
+{
+    TRACE_SCOPE( "FileManager::createSnapshot" );
+
+    QStringList debugDetails = QStringList() << "FileManager::createSnapshot";
+    const QString dataPrefix = QString( PFF_DATA_DIR ) + "/";
+
+    const int IndentSize = 2;
+    snapshot.addFile( PFF_XML_FILE_NAME, createMainXML( object ).toByteArray( IndentSize ) );
+
+    QByteArray paletteData;
+    QBuffer paletteBuffer( &paletteData );
+    paletteBuffer.open( QIODevice::WriteOnly );
+    object->exportPalette( &paletteBuffer );
+    paletteBuffer.close();
+    snapshot.addFile( dataPrefix + PFF_PALETTE_FILE, paletteData );
+
+    for ( int i = 0; i < object->getLayerCount(); ++i )
+    {
+        Layer* layer = object->getLayer( i );
+        if ( layer->type() == Layer::BITMAP )
+        {
+            LayerBitmap* layerBitmap = static_cast< LayerBitmap* >( layer );
+            layer->foreachKeyFrame( [&]( KeyFrame* key )
+            {
+                BitmapImage* bitmapImage = static_cast< BitmapImage* >( key );
+                QString entryName = dataPrefix + layerBitmap->fileName( key->pos() );
+                if ( bitmapImage->hasEncodedImage() )
+                {
+                    snapshot.addFile( entryName, bitmapImage->encodedImage() );
+                }
+                else if ( !bitmapImage->image()->isNull() )
+                {
+                    snapshot.addImage( entryName, *bitmapImage->image() );
+                }
+            } );
+        }
+        else if ( layer->type() == Layer::VECTOR )
+        {
+            LayerVector* layerVector = static_cast< LayerVector* >( layer );
+            Status st = Status::OK;
+            layer->foreachKeyFrame( [&]( KeyFrame* key )
+            {
+                QByteArray data;
+                QBuffer buffer( &data );
+                buffer.open( QIODevice::WriteOnly );
+                Status keySt = static_cast< VectorImage* >( key )->write( &buffer );
+                if ( !keySt.ok() )
+                {
+                    st = keySt;
+                }
+                snapshot.addFile( dataPrefix + layerVector->fileName( key->pos() ), data );
+            } );
+            if ( !st.ok() )
+            {
+                debugDetails << QString( "- Layer[%1] failed to save" ).arg( i ) << st.detailsList();
+                return Status( Status::FAIL, debugDetails, tr( "Internal Error" ), tr( "An internal error occurred while trying to save the file. Some or all of your file may not have saved." ) );
+            }
+        }
+    }
+
+    // Everything else in the working folder, e.g. the sound clips
+    QDir workingDir( object->workingDir() );
+    QDirIterator it( workingDir.path(), QDir::Files, QDirIterator::Subdirectories );
+    while ( it.hasNext() )
+    {
+        QString filePath = it.next();
+        QString entryName = workingDir.relativeFilePath( filePath );
+        bool isWrittenAbove = ( entryName == PFF_XML_FILE_NAME || entryName == dataPrefix + PFF_PALETTE_FILE );
+        bool isKeyFrameFile = entryName.startsWith( dataPrefix ) && ( entryName.endsWith( ".png" ) || entryName.endsWith( ".vec" ) );
+        bool isScratchFile = ( entryName == PFF_SCRATCH_FILE );
+        if ( !isWrittenAbove && !isKeyFrameFile && !isScratchFile )
+        {
+            snapshot.addFileFromDisk( entryName, filePath );
+        }
+    }
+
+    return Status::OK;
+}
+
+QDomDocument FileManager::createMainXML( Object* object )
+{
     QDomDocument xmlDoc( "PencilDocument" );
     QDomElement root = xmlDoc.createElement( "document" );
     QDomProcessingInstruction encoding = xmlDoc.createProcessingInstruction("xml", "version=\"1.0\" encoding=\"UTF-8\"");
@@ -333,51 +475,207 @@ Status FileManager::save( Object* object, QString strFileName )
     root.appendChild( objectElement );
     qCDebug( mLog ) << "Save Object Node";
 
+    return xmlDoc;
+}
+
+Status FileManager::saveBinary( Object* object, QString strFileName )
+{
+    QStringList debugDetails = QStringList() << "FileManager::saveBinary" << QString( "strFileName = " ).append( strFileName );
+    if ( object == nullptr )
+    {
+        return Status( Status::INVALID_ARGUMENT, debugDetails << "object parameter is null" );
+    }
+
+    BinaryProjectFile binaryFile;
+    STATUS_CHECK( binaryFile.create( strFileName ) );
+
+    // Bitmap and vector frames get their own chunks, the xml only describes the layers
+    QDomDocument xmlDoc = createMainXML( object );
+    QDomElement objectElement = xmlDoc.documentElement().firstChildElement( "object" );
+    for ( QDomElement layerElement = objectElement.firstChildElement( "layer" );
+          !layerElement.isNull();
+          layerElement = layerElement.nextSiblingElement( "layer" ) )
+    {
+        int type = layerElement.attribute( "type" ).toInt();
+        if ( type == Layer::BITMAP || type == Layer::VECTOR )
+        {
+            while ( !layerElement.firstChildElement( "image" ).isNull() )
+            {
+                layerElement.removeChild( layerElement.firstChildElement( "image" ) );
+            }
+        }
+    }
+
     const int IndentSize = 2;
+    STATUS_CHECK( binaryFile.addChunk( BinaryProjectFile::MAIN_XML, 0, 0, PFF_XML_FILE_NAME, xmlDoc.toByteArray( IndentSize ) ) );
 
-    QTextStream out( file.data() );
-    xmlDoc.save( out, IndentSize );
+    QByteArray paletteData;
+    QBuffer paletteBuffer( &paletteData );
+    paletteBuffer.open( QIODevice::WriteOnly );
+    object->exportPalette( &paletteBuffer );
+    paletteBuffer.close();
+    STATUS_CHECK( binaryFile.addChunk( BinaryProjectFile::PALETTE, 0, 0, PFF_PALETTE_FILE, paletteData ) );
 
-    if ( !isOldFile )
+    Status st = Status::OK;
+    for ( int i = 0; i < object->getLayerCount() && st.ok(); ++i )
     {
-        qCDebug( mLog ) << "Now compressing data to PFF - PCLX ...";
+        Layer* layer = object->getLayer( i );
+        layer->foreachKeyFrame( [&]( KeyFrame* key )
+        {
+            if ( !st.ok() )
+            {
+                return;
+            }
 
-        bool ok = JlCompress::compressDir( strFileName, strTempWorkingFolder );
-        if ( !ok )
+            switch ( layer->type() )
+            {
+            case Layer::BITMAP:
+                st = binaryFile.addBitmap( layer->id(), key->pos(), static_cast< BitmapImage* >( key ) );
+                break;
+            case Layer::VECTOR:
+                st = binaryFile.addVector( layer->id(), key->pos(), static_cast< VectorImage* >( key ) );
+                break;
+            case Layer::SOUND:
+            {
+                QFile soundFile( key->fileName() );
+                if ( !soundFile.open( QIODevice::ReadOnly ) )
+                {
+                    st = Status( Status::ERROR_FILE_CANNOT_OPEN, QStringList() << QString( "Can't read the sound file %1" ).arg( key->fileName() ),
+                                 tr( "Cannot Read Sound File" ),
+                                 tr( "The sound file \"%1\" can't be read, so the sound clip can't be saved. Please make sure the file exists and try again." ).arg( key->fileName() ) );
+                    break;
+                }
+                QString name = QFileInfo( key->fileName() ).fileName();
+                st = binaryFile.addChunk( BinaryProjectFile::SOUND, layer->id(), key->pos(), name, soundFile.readAll() );
+                break;
+            }
+            default:
+                break;
+            }
+        } );
+    }
+    if ( !st.ok() )
+    {
+        if ( !st.description().isEmpty() )
         {
-            return Status::FAIL;
+            st.setDetailsList( debugDetails << st.detailsList() );
+            return st;
         }
-
-        qCDebug( mLog ) << "Compressed. File saved.";
+        return Status( Status::FAIL, debugDetails << st.detailsList(), tr( "Internal Error" ), tr( "An internal error occurred while trying to save the file. Some or all of your file may not have saved." ) );
     }
 
+    STATUS_CHECK( binaryFile.commit() );
+
     object->setFilePath( strFileName );
     object->setModified( false );
 
     return Status::OK;
 }
 
-ObjectData* FileManager::loadProjectData( const QDomElement& docElem )
+Object* FileManager::loadBinary( Object* obj, QString strFileName )
 {
-    ObjectData* data = new ObjectData;
-    if ( docElem.isNull() )
+    BinaryProjectFile binaryFile;
+    Status st = binaryFile.open( strFileName );
+    if ( !st.ok() )
     {
-        return data;
+        delete obj;
+        return cleanUpWithErrorCode( st );
     }
 
-    QDomNode tag = docElem.firstChild();
+    // Only the sound clips need to be on disk
+    removePFFTmpDirectory( obj->workingDir() );
+    obj->createWorkingDir();
+    mstrLastTempFolder = obj->workingDir();
 
-    while ( !tag.isNull() )
+    QString strDataFolder = QDir( obj->workingDir() ).filePath( PFF_DATA_DIR );
+    obj->setDataDir( strDataFolder );
+    obj->setMainXMLFile( QDir( obj->workingDir() ).filePath( PFF_XML_FILE_NAME ) );
+
+    QByteArray mainXML;
+    QByteArray paletteData;
+    for ( const BinaryProjectFile::Chunk& chunk : binaryFile.chunks() )
     {
-        QDomElement element = tag.toElement(); // try to convert the node to an element.
-        if ( element.isNull() )
+        if ( chunk.type == BinaryProjectFile::MAIN_XML )
         {
-            continue;
+            mainXML = binaryFile.chunkData( chunk );
         }
-        
-        extractProjectData( element, data );
-     
-        tag = tag.nextSibling();
+        else if ( chunk.type == BinaryProjectFile::PALETTE )
+        {
+            paletteData = binaryFile.chunkData( chunk );
+        }
+        else if ( chunk.type == BinaryProjectFile::SOUND )
+        {
+            QFile soundFile( QDir( strDataFolder ).filePath( QFileInfo( chunk.name ).fileName() ) );
+            if ( !soundFile.open( QIODevice::WriteOnly ) || soundFile.write( binaryFile.chunkData( chunk ) ) < 0 )
+            {
+                delete obj;
+                return cleanUpWithErrorCode( Status::ERROR_FILE_CANNOT_OPEN );
+            }
+        }
+    }
+
+    QBuffer paletteBuffer( &paletteData );
+    if ( !paletteBuffer.open( QIODevice::ReadOnly ) || !obj->importPalette( &paletteBuffer ) )
+    {
+        obj->loadDefaultPalette();
+    }
+
+    QBuffer mainXMLBuffer( &mainXML );
+    mainXMLBuffer.open( QIODevice::ReadOnly );
+    st = loadMainXML( obj, &mainXMLBuffer );
+    if ( !st.ok() )
+    {
+        delete obj;
+        return cleanUpWithErrorCode( st );
+    }
+
+    // The layers are loaded without key frames, fill them from the chunks
+    QHash< int, Layer* > layers;
+    for ( int i = 0; i < obj->getLayerCount(); ++i )
+    {
+        layers.insert( obj->getLayer( i )->id(), obj->getLayer( i ) );
+    }
+
+    const int chunkCount = static_cast< int >( binaryFile.chunks().size() );
+    for ( int i = 0; i < chunkCount; ++i )
+    {
+        const BinaryProjectFile::Chunk& chunk = binaryFile.chunks()[ i ];
+        Layer* layer = layers.value( chunk.layerId );
+        if ( chunk.type == BinaryProjectFile::BITMAP && layer != nullptr && layer->type() == Layer::BITMAP )
+        {
+            BitmapImage* bitmapImage = binaryFile.readBitmap( chunk );
+            bitmapImage->setPos( chunk.frame );
+            layer->loadKey( bitmapImage );
+        }
+        else if ( chunk.type == BinaryProjectFile::VECTOR && layer != nullptr && layer->type() == Layer::VECTOR )
+        {
+            VectorImage* vectorImage = new VectorImage;
+            vectorImage->setPos( chunk.frame );
+            vectorImage->setObject( obj );
+            st = binaryFile.readVector( chunk, vectorImage );
+            if ( !st.ok() )
+            {
+                delete vectorImage;
+                delete obj;
+                return cleanUpWithErrorCode( st );
+            }
+            layer->loadKey( vectorImage );
+        }
+        emit progressUpdated( float( i + 1 ) / chunkCount );
+    }
+
+    verifyObject( obj );
+
+    return obj;
+}
+
+ObjectData* FileManager::loadProjectData( QXmlStreamReader& xmlStream )
+{
+    ObjectData* data = new ObjectData;
+    while ( xmlStream.readNextStartElement() )
+    {
+        extractProjectData( xmlStream.name().toString(), xmlStream.attributes(), data );
+        xmlStream.skipCurrentElement();
     }
     return data;
 }
@@ -445,58 +743,57 @@ QDomElement FileManager::saveProjectData( ObjectData* data, QDomDocument& xmlDoc
 	return rootTag;
 }
 
-void FileManager::extractProjectData( const QDomElement& element, ObjectData* data )
+void FileManager::extractProjectData( const QString& strName, const QXmlStreamAttributes& attributes, ObjectData* data )
 {
     Q_ASSERT( data );
 
-    QString strName = element.tagName();
     if ( strName == "currentFrame" )
     {
-        data->setCurrentFrame( element.attribute( "value" ).toInt() );
+        data->setCurrentFrame( attributeOf( attributes, "value" ).toInt() );
     }
     else  if ( strName == "currentColor" )
     {
-        int r = element.attribute( "r", "255" ).toInt();
-        int g = element.attribute( "g", "255" ).toInt();
-        int b = element.attribute( "b", "255" ).toInt();
-        int a = element.attribute( "a", "255" ).toInt();
+        int r = attributeOf( attributes, "r", "255" ).toInt();
+        int g = attributeOf( attributes, "g", "255" ).toInt();
+        int b = attributeOf( attributes, "b", "255" ).toInt();
+        int a = attributeOf( attributes, "a", "255" ).toInt();
 
         data->setCurrentColor( QColor( r, g, b, a ) );
     }
     else if ( strName == "currentLayer" )
     {
-        data->setCurrentLayer( element.attribute( "value", "0" ).toInt() );
+        data->setCurrentLayer( attributeOf( attributes, "value", "0" ).toInt() );
     }
     else if ( strName == "currentView" )
     {
-        double m11 = element.attribute( "m11", "1" ).toDouble();
-        double m12 = element.attribute( "m12", "0" ).toDouble();
-        double m21 = element.attribute( "m21", "0" ).toDouble();
-        double m22 = element.attribute( "m22", "1" ).toDouble();
-        double dx = element.attribute( "dx", "0" ).toDouble();
-        double dy = element.attribute( "dy", "0" ).toDouble();
+        double m11 = attributeOf( attributes, "m11", "1" ).toDouble();
+        double m12 = attributeOf( attributes, "m12", "0" ).toDouble();
+        double m21 = attributeOf( attributes, "m21", "0" ).toDouble();
+        double m22 = attributeOf( attributes, "m22", "1" ).toDouble();
+        double dx = attributeOf( attributes, "dx", "0" ).toDouble();
+        double dy = attributeOf( attributes, "dy", "0" ).toDouble();
         
         data->setCurrentView( QTransform( m11, m12, m21, m22, dx, dy ) );
     }
     else if ( strName == "fps" || strName == "currentFps" )
     {
-        data->setFrameRate( element.attribute( "value", "12" ).toInt() );
+        data->setFrameRate( attributeOf( attributes, "value", "12" ).toInt() );
     }
     else if ( strName == "isLoop" )
     {
-        data->setLooping ( element.attribute( "value", "false" ) == "true" );
+        data->setLooping ( attributeOf( attributes, "value", "false" ) == "true" );
     }
     else if ( strName == "isRangedPlayback" )
     {
-        data->setRangedPlayback( ( element.attribute( "value", "false" ) == "true" ) );
+        data->setRangedPlayback( ( attributeOf( attributes, "value", "false" ) == "true" ) );
     }
     else if ( strName == "markInFrame" )
     {
-        data->setMarkInFrameNumber( element.attribute( "value", "0" ).toInt() );
+        data->setMarkInFrameNumber( attributeOf( attributes, "value", "0" ).toInt() );
     }
     else if ( strName == "markOutFrame" )
     {
-        data->setMarkOutFrameNumber( element.attribute( "value", "15" ).toInt() );
+        data->setMarkOutFrameNumber( attributeOf( attributes, "value", "15" ).toInt() );
     }
 }
 
@@ -511,25 +808,27 @@ bool FileManager::loadPalette( Object* obj )
 {
     qCDebug( mLog ) << "Load Palette..";
 
-    QString paletteFilePath = obj->dataDir() + "/" + PFF_PALETTE_FILE;
-    if ( !obj->importPalette( paletteFilePath ) )
+    bool ok = false;
+    const PclxReader* archive = obj->archive();
+    if ( archive != nullptr && archive->containsDataFile( PFF_PALETTE_FILE ) )
+    {
+        QByteArray data = archive->dataFile( PFF_PALETTE_FILE );
+        QBuffer buffer( &data );
+        ok = buffer.open( QIODevice::ReadOnly ) && obj->importPalette( &buffer );
+    }
+    else
+    {
+        QString paletteFilePath = obj->dataDir() + "/" + PFF_PALETTE_FILE;
+        ok = obj->importPalette( paletteFilePath );
+    }
+
+    if ( !ok )
     {
         obj->loadDefaultPalette();
     }
     return true;
 }
 
-void FileManager::unzip( const QString& strZipFile, const QString& strUnzipTarget )
-{
-    // --removes an old decompression directory first  - better approach
-    removePFFTmpDirectory( strUnzipTarget );
-
-    // --creates a new decompression directory
-    JlCompress::extractDir( strZipFile, strUnzipTarget );
-
-    mstrLastTempFolder = strUnzipTarget;
-}
-
 QList<ColourRef> FileManager::loadPaletteFile( QString strFilename )
 {
     QFileInfo fileInfo( strFilename );
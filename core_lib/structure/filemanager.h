@@ -22,6 +22,7 @@ GNU General Public License for more details.
 #include <QObject>
 #include <QString>
 #include <QDomElement>
+#include <QXmlStreamReader>
 #include "log.h"
 #include "pencildef.h"
 #include "pencilerror.h"
@@ -29,6 +30,7 @@ GNU General Public License for more details.
 
 class Object;
 class ObjectData;
+class ProjectSnapshot;
 
 
 class FileManager : public QObject
@@ -41,6 +43,9 @@ public:
     Object* load( QString strFilenNme );
     Status  save( Object*, QString strFileName );
 
+    // Captures what save() would write to a pclx, to write it on another thread
+    Status  createSnapshot( Object*, ProjectSnapshot& snapshot );
+
     QList<ColourRef> loadPaletteFile( QString strFilename );
     Status error() { return mError; }
     Status verifyObject( Object* obj );
@@ -49,17 +54,19 @@ Q_SIGNALS:
     void progressUpdated( float );
 
 private:
-    void unzip( const QString& strZipFile, const QString& strUnzipTarget );
-    
-    bool loadObject( Object*, const QDomElement& root );
-    bool loadObjectOldWay( Object*, const QDomElement& root );
-    bool isOldForamt( const QString& fileName );
+    Status loadMainXML( Object*, QIODevice* device );
+    bool loadObject( Object*, QXmlStreamReader& xmlStream );
+    bool loadObjectOldWay( Object*, QXmlStreamReader& xmlStream );
     bool loadPalette( Object* );
     
-    ObjectData* loadProjectData( const QDomElement& element );
+    Object* loadBinary( Object*, QString strFileName );
+    Status  saveBinary( Object*, QString strFileName );
+    QDomDocument createMainXML( Object* );
+
+    ObjectData* loadProjectData( QXmlStreamReader& xmlStream );
     QDomElement saveProjectData( ObjectData*, QDomDocument& xmlDoc );
 
-    void extractProjectData( const QDomElement& element, ObjectData* data );
+    void extractProjectData( const QString& strName, const QXmlStreamAttributes& attributes, ObjectData* data );
 
 
 
@@ -38,7 +38,7 @@ public:
     int length() { return mLength; }
     void setLength( int len )  { mLength = len; }
     
-    void modification() { mIsModified = true; }
+    virtual void modification() { mIsModified = true; }
     void setModified( bool b ) { mIsModified = b; }
     bool isModified() { return mIsModified; };
    
@@ -15,6 +15,7 @@ GNU General Public License for more details.
 
 */
 
+#include <algorithm>
 #include <climits>
 #include <cassert>
 #include <QtDebug>
@@ -27,13 +28,6 @@ GNU General Public License for more details.
 #include "timeline.h"
 #include "timelinecells.h"
 
-// Used to sort the selected frames list
-//
-bool sortAsc(int left, int right)
-{
-    return left < right;
-}
-
 Layer::Layer( Object* pObject, LAYER_TYPE eType ) : QObject( pObject )
 {
     mObject = pObject;
@@ -203,6 +197,7 @@ bool Layer::addKeyFrame( int position, KeyFrame* pKeyFrame )
 
     pKeyFrame->setPos( position );
     mKeyFrames.insert( std::make_pair( position, pKeyFrame ) );
+    keyFramesChanged();
 
     return true;
 }
@@ -212,8 +207,10 @@ bool Layer::removeKeyFrame( int position )
     auto frame = getKeyFrameWhichCovers(position);
     if(frame)
     {
+        mSelectedFrames.erase(frame->pos());
         mKeyFrames.erase(frame->pos());
         delete frame;
+        keyFramesChanged();
     }
 
     return true;
@@ -290,6 +287,7 @@ bool Layer::swapKeyFrames( int position1, int position2 ) //Current behaviour, n
 		addNewEmptyKeyAt( position2 );
     }
 
+    keyFramesChanged();
     return true;
 }
 
@@ -302,6 +300,7 @@ bool Layer::loadKey( KeyFrame* pKey )
         mKeyFrames.erase( it );
     }
     mKeyFrames.insert( std::make_pair( pKey->pos(), pKey ) );
+    keyFramesChanged();
     return true;
 }
 
@@ -368,16 +367,32 @@ void Layer::paintFrames( QPainter& painter, TimeLineCells* cells, int y, int hei
 
     //qDebug() << "LayerType:" << ( int )( meType );
 
-    for ( auto pair : mKeyFrames )
+    const QBrush selectedKeyBrush( QColor( 60, 60, 60 ) );
+    const QBrush keyBrush( QColor( 60, 60, 60, 120 ) );
+
+    int recTop = y + 1;
+    int recHeight = height - 4;
+
+    // Only visit the key frames in the visible columns
+    int firstVisibleFrame = cells->getFrameNumber( 0 );
+    int lastVisibleFrame = cells->getFrameNumber( cells->width() );
+
+    for ( auto it = mKeyFrames.lower_bound( lastVisibleFrame ); it != mKeyFrames.end(); ++it )
     {
-        int framePos = pair.first;
-        
+        int framePos = it->first;
+        KeyFrame* key = it->second;
+
+        if ( framePos + key->length() <= firstVisibleFrame )
+        {
+            // Sound clips are the only key frames longer than one frame,
+            // an earlier clip may still reach the visible columns.
+            if ( meType != SOUND ) break;
+            continue;
+        }
+
         int recLeft = cells->getFrameX( framePos ) - frameSize + 2;
-        int recTop = y + 1;
         int recWidth = frameSize - 2;
-        int recHeight = height - 4;
 
-        KeyFrame* key = pair.second;
         if ( key->length() > 1 )  
         {
             // This is especially for sound clip.
@@ -385,16 +400,29 @@ void Layer::paintFrames( QPainter& painter, TimeLineCells* cells, int y, int hei
             recWidth = frameSize * key->length() - 2;
         }
 
-        if ( pair.second->isSelected() )
+        if ( key->isSelected() )
         {
-            painter.setBrush( QColor( 60, 60, 60 ) );
+            painter.setBrush( selectedKeyBrush );
         }
         else if ( selected )
         {
-            painter.setBrush( QColor( 60, 60, 60, 120 ) );
+            painter.setBrush( keyBrush );
         }
 
         painter.drawRect( recLeft, recTop, recWidth, recHeight );
+
+        QImage thumbnail = cells->keyFrameThumbnail( this, framePos );
+        if ( !thumbnail.isNull() )
+        {
+            // Inside the border, which still shows the selection
+            QRect inside( recLeft + 1, recTop + 1, recWidth - 1, recHeight - 1 );
+            QRect thumbnailRect( QPoint( 0, 0 ), thumbnail.size().scaled( inside.size(), Qt::KeepAspectRatio ) );
+            thumbnailRect.moveCenter( inside.center() );
+
+            painter.fillRect( thumbnailRect, Qt::white );
+            painter.setRenderHint( QPainter::SmoothPixmapTransform );
+            painter.drawImage( thumbnailRect, thumbnail );
+        }
     }
 }
 
@@ -438,8 +466,6 @@ void Layer::paintLabel( QPainter& painter, TimeLineCells* cells, int x, int y, i
 void Layer::paintSelection( QPainter& painter, int x, int y, int width, int height )
 {
     QLinearGradient linearGrad( QPointF( 0, y ), QPointF( 0, y + height ) );
-    QSettings settings( PENCIL2D, PENCIL2D );
-    QString style = settings.value( "style" ).toString();
     linearGrad.setColorAt( 0, QColor( 255, 255, 255, 128 ) );
     linearGrad.setColorAt( 0.50, QColor( 255, 255, 255, 64 ) );
     linearGrad.setColorAt( 1, QColor( 255, 255, 255, 0 ) );
@@ -488,6 +514,12 @@ void Layer::editProperties()
     }
 }
 
+void Layer::keyFramesChanged()
+{
+    ++mRevision;
+    mObject->invalidateKeyFrameIndex();
+}
+
 void Layer::setUpdated()
 {
     mObject->setLayerUpdated(mId);
@@ -508,7 +540,7 @@ bool Layer::isFrameSelected(int position)
     KeyFrame *keyFrame = getKeyFrameWhichCovers(position);
     if(keyFrame)
     {
-        return mSelectedFrames_byLast.contains(keyFrame->pos());
+        return keyFrame->isSelected();
     }
     else
     {
@@ -522,30 +554,18 @@ void Layer::setFrameSelected(int position, bool isSelected)
     if (keyFrame != nullptr) {
         int startPosition = keyFrame->pos();
 
-        if (isSelected && !mSelectedFrames_byLast.contains(startPosition)) {
-
-            // Add the selected frame to the lists
-            //
-            mSelectedFrames_byLast.insert(0, startPosition);
-            mSelectedFrames_byPosition.append(startPosition);
-
-            // We need to keep the list of selected frames sorted
-            // in order to easily handle their movement
-            //
-            qSort(mSelectedFrames_byPosition.begin(), mSelectedFrames_byPosition.end(), sortAsc);
-
+        if (isSelected) {
+            mSelectedFrames.insert(startPosition);
+            mLastSelectedFrame = startPosition;
         }
-        else if (!isSelected){
-
-            // Remove the selected frame from the lists
-            //
-            int iLast = mSelectedFrames_byLast.indexOf(startPosition);
-            mSelectedFrames_byLast.removeAt(iLast);
-
-            int iPos = mSelectedFrames_byPosition.indexOf(startPosition);
-            mSelectedFrames_byPosition.removeAt(iPos);
+        else {
+            mSelectedFrames.erase(startPosition);
+            if (mLastSelectedFrame == startPosition) {
+                mLastSelectedFrame = mSelectedFrames.empty() ? -1 : *mSelectedFrames.rbegin();
+            }
         }
         keyFrame->setSelected(isSelected);
+        ++mRevision;
     }
 }
 
@@ -562,8 +582,8 @@ void Layer::toggleFrameSelected(int position, bool allowMultiple)
 
 void Layer::extendSelectionTo(int position)
 {
-    if (mSelectedFrames_byLast.count() > 0 ) {
-        int lastSelected = mSelectedFrames_byLast[0];
+    if (mLastSelectedFrame > 0) {
+        int lastSelected = mLastSelectedFrame;
         int startPos;
         int endPos;
 
@@ -576,11 +596,25 @@ void Layer::extendSelectionTo(int position)
             endPos = lastSelected;
         }
 
-        int i = startPos;
-        while (i <= endPos) {
-            setFrameSelected(i, true);
-            i++;
+        // Only visit the key frames in the range rather than every frame of it.
+        // The key covering startPos may begin before it (e.g. a sound clip).
+        //
+        setFrameSelected(startPos, true);
+
+        auto first = mKeyFrames.lower_bound(endPos); // highest key <= endPos
+        auto last = mKeyFrames.lower_bound(startPos);
+        for (auto it = first; it != last; ++it) {
+            if (it->first > startPos) {
+                it->second->setSelected(true);
+                mSelectedFrames.insert(it->first);
+            }
+        }
+
+        // The last frame of the range becomes the last selected one
+        if (first != last && first->first > startPos) {
+            mLastSelectedFrame = first->first;
         }
+        ++mRevision;
     }
 }
 
@@ -602,106 +636,243 @@ void Layer::selectAllFramesAfter( int position )
 
 void Layer::deselectAll()
 {
-    mSelectedFrames_byLast.clear();
-    mSelectedFrames_byPosition.clear();
+    mSelectedFrames.clear();
+    mLastSelectedFrame = -1;
 
     for ( auto pair : mKeyFrames )
     {
         pair.second->setSelected(false);
     }
+    ++mRevision;
 }
 
-bool Layer::moveSelectedFrames(int offset)
+bool Layer::moveSelectedFrames( int offset, std::vector< KeyFrameMove >* moves )
 {
+    if ( offset == 0 || mSelectedFrames.empty() )
+    {
+        return false;
+    }
 
-    if (offset != 0 && mSelectedFrames_byPosition.count() > 0) {
+    std::vector< int > selectedFrames;
+    selectedFrames.reserve( mSelectedFrames.size() );
+    for ( int position : mSelectedFrames )
+    {
+        if ( keyExists( position ) )
+        {
+            selectedFrames.push_back( position );
+        }
+    }
+    if ( selectedFrames.empty() )
+    {
+        return false;
+    }
 
-        // If we are moving to the right we start moving selected frames from the highest (right) to the lowest (left)
-        int indexInSelection = mSelectedFrames_byPosition.count() - 1;
-        int step = -1;
+    int firstSelected = selectedFrames.front();
+    int lastSelected = selectedFrames.back();
 
-        if (offset < 0) {
+    // Check if we are not moving out of the timeline
+    if ( firstSelected + offset < 1 )
+    {
+        return false;
+    }
 
-            // If we are moving to the left we start moving selected frames from the lowest (left) to the highest (right)
-            indexInSelection = 0;
-            step = 1;
+    // The selected frames land at their position + offset, and the other frames
+    // keep their order while sliding into the slots left free.
+    // Only the frames between the first selected one and the furthest landing slot are affected.
+    int windowStart = std::min( firstSelected, firstSelected + offset );
+    int windowEnd = std::max( lastSelected, lastSelected + offset );
 
-            // Check if we are not moving out of the timeline
-            if (mSelectedFrames_byPosition[0] + offset < 1) {
-                return false;
-            }
+    std::vector< int > unselectedFrames;
+    auto first = mKeyFrames.lower_bound( windowEnd );
+    auto last = mKeyFrames.lower_bound( windowStart - 1 );
+    for ( auto it = first; it != last; ++it )
+    {
+        if ( mSelectedFrames.count( it->first ) == 0 )
+        {
+            unselectedFrames.push_back( it->first );
         }
+    }
+    std::reverse( unselectedFrames.begin(), unselectedFrames.end() );
 
+    std::vector< KeyFrameMove > frameMoves;
+    frameMoves.reserve( selectedFrames.size() + unselectedFrames.size() );
 
-        while ( indexInSelection > -1 && indexInSelection < mSelectedFrames_byPosition.count() ) {
+    for ( int position : selectedFrames )
+    {
+        frameMoves.push_back( KeyFrameMove{ position, position + offset } );
+    }
+
+    size_t selectedBefore = 0; // selected frames before the current one
+    size_t targetsBefore = 0;  // landing slots taken before the current one
+    for ( int position : unselectedFrames )
+    {
+        while ( selectedBefore < selectedFrames.size() && selectedFrames[ selectedBefore ] < position )
+        {
+            ++selectedBefore;
+        }
+
+        // The n-th unselected slot of the window goes to its n-th free slot
+        int rank = position - windowStart - static_cast< int >( selectedBefore );
+        int target = windowStart + rank + static_cast< int >( targetsBefore );
+        while ( targetsBefore < selectedFrames.size() && selectedFrames[ targetsBefore ] + offset <= target )
+        {
+            ++targetsBefore;
+            target = windowStart + rank + static_cast< int >( targetsBefore );
+        }
+
+        if ( target != position )
+        {
+            frameMoves.push_back( KeyFrameMove{ position, target } );
+        }
+    }
+
+    if ( !applyKeyFrameMoves( frameMoves ) )
+    {
+        return false;
+    }
 
-            int fromPos = mSelectedFrames_byPosition[indexInSelection];
-            int toPos = fromPos + offset;
+    if ( moves != nullptr )
+    {
+        moves->insert( moves->end(), frameMoves.begin(), frameMoves.end() );
+    }
+    return true;
+}
 
-            // Get the frame to move
-            KeyFrame *selectedFrame = getKeyFrameAt(fromPos);
+bool Layer::insertFrames( int position, int count, std::vector< KeyFrameMove >* moves )
+{
+    if ( position < 1 || count <= 0 )
+    {
+        return false;
+    }
 
-            if (selectedFrame != nullptr) {
+    std::vector< KeyFrameMove > frameMoves;
+    auto last = mKeyFrames.lower_bound( position - 1 );
+    for ( auto it = mKeyFrames.begin(); it != last; ++it )
+    {
+        frameMoves.push_back( KeyFrameMove{ it->first, it->first + count } );
+    }
 
-                mKeyFrames.erase(fromPos);
+    if ( !applyKeyFrameMoves( frameMoves ) )
+    {
+        return false;
+    }
 
-                // Slide back every frame between fromPos to toPos
-                // to avoid having 2 frames in the same position
-                //
-                bool isBetween = true;
-                int targetPosition = fromPos;
+    if ( moves != nullptr )
+    {
+        moves->insert( moves->end(), frameMoves.begin(), frameMoves.end() );
+    }
+    return true;
+}
 
-                while (isBetween) {
+bool Layer::rippleDeleteFrames( int position, int count, std::vector< KeyFrameMove >* moves )
+{
+    if ( position < 1 || count <= 0 )
+    {
+        return false;
+    }
 
-                    int framePosition = targetPosition - step;
+    // Key frames starting inside the removed range are deleted
+    auto first = mKeyFrames.lower_bound( position + count - 1 );
+    auto last = mKeyFrames.lower_bound( position - 1 );
+    for ( auto it = first; it != last; ++it )
+    {
+        mSelectedFrames.erase( it->first );
+        delete it->second;
+    }
+    mKeyFrames.erase( first, last );
+    keyFramesChanged();
 
-                    KeyFrame *frame = getKeyFrameAt(framePosition);
+    // and the following ones close the gap
+    std::vector< KeyFrameMove > frameMoves;
+    auto end = mKeyFrames.lower_bound( position - 1 );
+    for ( auto it = mKeyFrames.begin(); it != end; ++it )
+    {
+        frameMoves.push_back( KeyFrameMove{ it->first, it->first - count } );
+    }
 
-                    if (frame != nullptr) {
-                        mKeyFrames.erase(framePosition);
+    if ( !applyKeyFrameMoves( frameMoves ) )
+    {
+        return false;
+    }
 
-                        frame->setPos(targetPosition);
-                        mKeyFrames.insert( std::make_pair( targetPosition, frame ) );
-                    }
+    if ( moves != nullptr )
+    {
+        moves->insert( moves->end(), frameMoves.begin(), frameMoves.end() );
+    }
+    return true;
+}
 
-                    targetPosition = targetPosition - step;
-                    if (fromPos < toPos && (targetPosition < fromPos || targetPosition >= toPos)) {
-                        isBetween = false;
-                    }
-                    if (fromPos > toPos && (targetPosition > fromPos || targetPosition <= toPos)) {
-                        isBetween = false;
-                    }
-                }
+bool Layer::applyKeyFrameMoves( const std::vector< KeyFrameMove >& moves )
+{
+    if ( moves.empty() )
+    {
+        return true;
+    }
 
-                // If the first frame is moving, we need to create a new first frame
-                if (fromPos == 1) {
-                    addNewEmptyKeyAt(1);
-                }
+    // Take all the moving key frames out first, so they can freely trade places.
+    std::vector< std::pair< int, KeyFrame* > > movingKeys;
+    movingKeys.reserve( moves.size() );
 
-                // Update the position of the selected frame
-                selectedFrame->setPos(toPos);
-                mKeyFrames.insert( std::make_pair( toPos, selectedFrame ) );
-            }
+    auto putBack = [this, &movingKeys, &moves]
+    {
+        for ( size_t i = 0; i < movingKeys.size(); ++i )
+        {
+            mKeyFrames.insert( std::make_pair( moves[ i ].fromPosition, movingKeys[ i ].second ) );
+        }
+    };
 
-            indexInSelection = indexInSelection + step;
+    for ( const KeyFrameMove& move : moves )
+    {
+        auto it = mKeyFrames.find( move.fromPosition );
+        if ( it == mKeyFrames.end() || move.toPosition < 1 )
+        {
+            putBack();
+            return false;
         }
+        movingKeys.push_back( std::make_pair( move.toPosition, it->second ) );
+        mKeyFrames.erase( it );
+    }
 
+    // Two key frames can't end up at the same position
+    std::vector< int > targets;
+    targets.reserve( movingKeys.size() );
+    for ( auto& pair : movingKeys )
+    {
+        targets.push_back( pair.first );
+    }
+    std::sort( targets.begin(), targets.end() );
+    for ( size_t i = 0; i < targets.size(); ++i )
+    {
+        bool isTaken = ( i > 0 && targets[ i ] == targets[ i - 1 ] ) || keyExists( targets[ i ] );
+        if ( isTaken )
+        {
+            putBack();
+            return false;
+        }
+    }
 
-        // Update selection lists
-        //
-        for (int i=0; i<mSelectedFrames_byPosition.count(); i++) {
-            mSelectedFrames_byPosition[i] = mSelectedFrames_byPosition[i] + offset;
+    std::vector< int > selectedTargets;
+    for ( const KeyFrameMove& move : moves )
+    {
+        if ( mSelectedFrames.erase( move.fromPosition ) > 0 )
+        {
+            selectedTargets.push_back( move.toPosition );
         }
-        for (int i=0; i<mSelectedFrames_byLast.count(); i++) {
-            mSelectedFrames_byLast[i] = mSelectedFrames_byLast[i] + offset;
+        if ( mLastSelectedFrame == move.fromPosition )
+        {
+            mLastSelectedFrame = move.toPosition;
         }
-
-        return true;
     }
-    else {
-        return false;
+    mSelectedFrames.insert( selectedTargets.begin(), selectedTargets.end() );
+
+    for ( auto& pair : movingKeys )
+    {
+        pair.second->setPos( pair.first );
+        mKeyFrames.insert( pair );
     }
 
+    keyFramesChanged();
+    return true;
 }
 
 bool isLayerPaintable( Layer* layer )
@@ -18,6 +18,8 @@ GNU General Public License for more details.
 #define LAYER_H
 
 #include <map>
+#include <set>
+#include <vector>
 #include <functional>
 #include <QString>
 #include <QPainter>
@@ -29,6 +31,14 @@ class Object;
 class TimeLineCells;
 class Status;
 
+// A key frame changing position in a timeline edit.
+// Applying the moves with from and to swapped reverts the edit.
+struct KeyFrameMove
+{
+    int fromPosition;
+    int toPosition;
+};
+
 class Layer : public QObject
 {
     Q_OBJECT
@@ -70,6 +80,7 @@ public:
 
     virtual Status saveKeyFrame( KeyFrame*, QString path ) = 0;
     virtual void loadDomElement( QDomElement element, QString dataDirPath ) = 0;
+    virtual void loadDomElement( QXmlStreamReader& xmlStream, QString dataDirPath ) = 0;
     virtual QDomElement createDomElement( QDomDocument& doc ) = 0;
     
     bool keyExists( int position );
@@ -104,7 +115,12 @@ public:
     void selectAllFramesAfter( int position );
     void deselectAll();
 
-    bool moveSelectedFrames( int offset );
+    // Timeline edits, the repositioned key frames are appended to `moves` if given.
+    // No key frame is created or deleted by a move, so `moves` alone reverts it.
+    bool moveSelectedFrames( int offset, std::vector< KeyFrameMove >* moves = nullptr );
+    bool insertFrames( int position, int count, std::vector< KeyFrameMove >* moves = nullptr );
+    bool rippleDeleteFrames( int position, int count, std::vector< KeyFrameMove >* moves = nullptr );
+    bool applyKeyFrameMoves( const std::vector< KeyFrameMove >& moves );
     
     Status save( QString dataFolder );
 
@@ -123,22 +139,27 @@ public:
 
     void setUpdated();
 
+    // Increased whenever key frames are added, moved, removed, resized or (de)selected,
+    // so views can tell whether what they drew of this layer is still valid.
+    int revision() const { return mRevision; }
+
 protected:
     void setId( int LayerId ) { mId = LayerId; }
+    void keyFramesChanged();
 
 private:
     LAYER_TYPE meType = UNDEFINED;
     Object* mObject   = nullptr;
     int mId           = 0;
+    int mRevision     = 0;
 
     std::map<int, KeyFrame*, std::greater<int>> mKeyFrames;
 
-    // We need to keep track of selected frames ordered by last selected
-    // and by position.
-    // Both should be pre-sorted on each selection for optimization purpose when moving frames.
+    // Selected key frames sorted by position, used to handle frames movements on the timeline.
+    // The last selected one is the anchor of range selections.
     //
-    QList<int> mSelectedFrames_byLast; // Used to hadle selection range (based on last selected
-    QList<int> mSelectedFrames_byPosition; // Used to handle frames movements on the timeline
+    std::set<int> mSelectedFrames;
+    int mLastSelectedFrame = -1;
 };
 
 bool isLayerPaintable( Layer* );
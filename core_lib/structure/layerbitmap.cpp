@@ -18,6 +18,8 @@ GNU General Public License for more details.
 #include "keyframe.h"
 #include "bitmapimage.h"
 #include "layerbitmap.h"
+#include "object.h"
+#include "pclxreader.h"
 
 
 LayerBitmap::LayerBitmap( Object* object ) : Layer( object, Layer::BITMAP )
@@ -49,6 +51,13 @@ void LayerBitmap::loadImageAtFrame( QString path, QPoint topLeft, int frameNumbe
     loadKey( pKeyFrame );
 }
 
+void LayerBitmap::loadImageAtFrame( const QByteArray& encodedImage, QPoint topLeft, int frameNumber )
+{
+    BitmapImage* pKeyFrame = new BitmapImage( encodedImage, topLeft );
+    pKeyFrame->setPos( frameNumber );
+    loadKey( pKeyFrame );
+}
+
 Status LayerBitmap::saveKeyFrame( KeyFrame* pKeyFrame, QString path )
 {
     QStringList debugInfo = QStringList() << "LayerBitmap::saveKeyFrame" << QString( "pKeyFrame.pos() = %1" ).arg( pKeyFrame->pos() ) << QString( "path = %1" ).arg( path );
@@ -57,6 +66,18 @@ Status LayerBitmap::saveKeyFrame( KeyFrame* pKeyFrame, QString path )
     QString theFileName = fileName( pKeyFrame->pos() );
     QString strFilePath = QDir( path ).filePath( theFileName );
     debugInfo << QString( "strFilePath = " ).arg( strFilePath );
+
+    if ( pBitmapImage->hasEncodedImage() )
+    {
+        // Untouched since it was loaded, the png data can be written as is
+        QFile file( strFilePath );
+        if ( !file.open( QFile::WriteOnly ) || file.write( pBitmapImage->encodedImage() ) < 0 )
+        {
+            return Status( Status::FAIL, debugInfo << QString( "pBitmapImage could not be saved" ) );
+        }
+        return Status::OK;
+    }
+
     if ( !pBitmapImage->image()->save( strFilePath ) && !pBitmapImage->image()->isNull() )
     {
         return Status( Status::FAIL, debugInfo << QString( "pBitmapImage could not be saved" ) );
@@ -115,16 +136,63 @@ void LayerBitmap::loadDomElement( QDomElement element, QString dataDirPath )
         {
             if ( imageElement.tagName() == "image" )
             {
-                QString path = dataDirPath + "/" + imageElement.attribute( "src" ); // the file is supposed to be in the data directory
-                //qDebug() << "LAY_BITMAP  dataDirPath=" << dataDirPath << "   ;path=" << path;  //added for debugging puproses
-                QFileInfo fi( path );
-                if ( !fi.exists() ) path = imageElement.attribute( "src" );
+                QString src = imageElement.attribute( "src" );
                 int position = imageElement.attribute( "frame" ).toInt();
                 int x = imageElement.attribute( "topLeftX" ).toInt();
                 int y = imageElement.attribute( "topLeftY" ).toInt();
-                loadImageAtFrame( path, QPoint( x, y ), position );
+
+                const PclxReader* archive = ( object() != nullptr ) ? object()->archive() : nullptr;
+                if ( archive != nullptr && archive->containsDataFile( src ) )
+                {
+                    loadImageAtFrame( archive->dataFile( src ), QPoint( x, y ), position );
+                }
+                else
+                {
+                    QString path = dataDirPath + "/" + src; // the file is supposed to be in the data directory
+                    //qDebug() << "LAY_BITMAP  dataDirPath=" << dataDirPath << "   ;path=" << path;  //added for debugging puproses
+                    QFileInfo fi( path );
+                    if ( !fi.exists() ) path = src;
+                    loadImageAtFrame( path, QPoint( x, y ), position );
+                }
             }
         }
         imageTag = imageTag.nextSibling();
     }
 }
+
+void LayerBitmap::loadDomElement( QXmlStreamReader& xmlStream, QString dataDirPath )
+{
+    QXmlStreamAttributes attributes = xmlStream.attributes();
+    if ( attributes.hasAttribute( "id" ) )
+    {
+        setId( attributes.value( "id" ).toInt() );
+    }
+    mName = attributes.value( "name" ).toString();
+    mVisible = ( attributes.value( "visibility" ).toInt() == 1 );
+
+    const PclxReader* archive = ( object() != nullptr ) ? object()->archive() : nullptr;
+    while ( xmlStream.readNextStartElement() )
+    {
+        if ( xmlStream.name() == "image" )
+        {
+            QXmlStreamAttributes imageAttributes = xmlStream.attributes();
+            QString src = imageAttributes.value( "src" ).toString();
+            int position = imageAttributes.value( "frame" ).toInt();
+            int x = imageAttributes.value( "topLeftX" ).toInt();
+            int y = imageAttributes.value( "topLeftY" ).toInt();
+
+            if ( archive != nullptr && archive->containsDataFile( src ) )
+            {
+                loadImageAtFrame( archive->dataFile( src ), QPoint( x, y ), position );
+            }
+            else
+            {
+                QString path = dataDirPath + "/" + src; // the file is supposed to be in the data directory
+                QFileInfo fi( path );
+                if ( !fi.exists() ) path = src;
+                loadImageAtFrame( path, QPoint( x, y ), position );
+            }
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
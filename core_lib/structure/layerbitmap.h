@@ -31,9 +31,11 @@ public:
 
     // method from layerImage
     void loadImageAtFrame( QString strFilePath, QPoint topLeft, int frameNumber );
+    void loadImageAtFrame( const QByteArray& encodedImage, QPoint topLeft, int frameNumber );
 
     QDomElement createDomElement( QDomDocument& doc ) override;
     void loadDomElement( QDomElement element, QString dataDirPath ) override;
+    void loadDomElement( QXmlStreamReader& xmlStream, QString dataDirPath ) override;
 
     BitmapImage* getBitmapImageAtFrame( int frameNumber );
     BitmapImage* getLastBitmapImageAtFrame( int frameNumber, int increment );
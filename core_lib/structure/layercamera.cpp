@@ -17,6 +17,7 @@ GNU General Public License for more details.
 
 #include <QLineEdit>
 #include <QSpinBox>
+#include <QComboBox>
 #include <QLabel>
 #include <QPushButton>
 #include <QHBoxLayout>
@@ -48,6 +49,15 @@ CameraPropertiesDialog::CameraPropertiesDialog(QString name, int width, int heig
     sizeLayout->addWidget(widthBox);
     sizeLayout->addWidget(heightBox);
 
+    QLabel* interpolationLabel = new QLabel(tr("Camera motion:"));
+    interpolationBox = new QComboBox();
+    interpolationBox->addItem(tr("Linear"), CameraPath::LINEAR);
+    interpolationBox->addItem(tr("Ease in and out"), CameraPath::EASE);
+    interpolationBox->addItem(tr("Smooth"), CameraPath::SPLINE);
+    QHBoxLayout* interpolationLayout = new QHBoxLayout();
+    interpolationLayout->addWidget(interpolationLabel);
+    interpolationLayout->addWidget(interpolationBox);
+
     QPushButton* okButton = new QPushButton(tr("Ok"));
     QPushButton* cancelButton = new QPushButton(tr("Cancel"));
     QHBoxLayout* buttonLayout = new QHBoxLayout();
@@ -57,7 +67,8 @@ CameraPropertiesDialog::CameraPropertiesDialog(QString name, int width, int heig
     QGridLayout* layout = new QGridLayout();
     layout->addLayout(nameLayout, 0, 0);
     layout->addLayout(sizeLayout, 1, 0);
-    layout->addLayout(buttonLayout, 2, 0);
+    layout->addLayout(interpolationLayout, 2, 0);
+    layout->addLayout(buttonLayout, 3, 0);
     setLayout(layout);
     connect(okButton, SIGNAL(pressed()), this, SLOT(accept()));
     connect(cancelButton, SIGNAL(pressed()), this, SLOT(reject()));
@@ -97,6 +108,16 @@ void CameraPropertiesDialog::setHeight(int height)
     heightBox->setValue(height);
 }
 
+CameraPath::Interpolation CameraPropertiesDialog::getInterpolation()
+{
+    return static_cast< CameraPath::Interpolation >(interpolationBox->currentData().toInt());
+}
+
+void CameraPropertiesDialog::setInterpolation(CameraPath::Interpolation interpolation)
+{
+    interpolationBox->setCurrentIndex(interpolationBox->findData(interpolation));
+}
+
 // ------
 
 LayerCamera::LayerCamera( Object* object ) : Layer( object, Layer::CAMERA )
@@ -122,54 +143,32 @@ Camera* LayerCamera::getLastCameraAtFrame(int frameNumber, int increment)
 
 QTransform LayerCamera::getViewAtFrame(int frameNumber)
 {
-    if ( keyFrameCount() == 0 )
-    {
-        return QTransform();
-    }
-
-    Camera* camera1 = static_cast< Camera* >( getLastKeyFrameAtPosition( frameNumber ) );
+    updatePath();
+    return mPath.view(frameNumber);
+}
 
-    int nextFrame = getNextKeyFramePosition( frameNumber );
-	Camera* camera2 = static_cast< Camera* >( getLastKeyFrameAtPosition( nextFrame ) );
+void LayerCamera::cacheViews(int firstFrame, int lastFrame)
+{
+    updatePath();
+    mPath.cacheRange(firstFrame, lastFrame);
+}
 
-    if (camera1 == NULL && camera2 == NULL)
-    {
-        return QTransform();
-    }
-    else if (camera1 == NULL && camera2 != NULL)
-    {
-        return camera2->view;
-    }
-    else if (camera2 == NULL && camera1 != NULL)
+void LayerCamera::updatePath()
+{
+    if (mPathRevision == revision())
     {
-        return camera1->view;
+        return;
     }
 
-	if ( camera1 == camera2 )
-	{
-		return camera1->view;
-	}
-
-    int frame1 = camera1->pos();
-    int frame2 = camera2->pos();
-    
-    // linear interpolation
-    qreal c2 = ( frameNumber - frame1 + 0.0 ) / ( frame2 - frame1 );
-    qreal c1 = 1.0 - c2;
-    //qDebug() << ">> -- " << c1 << c2;
-
-    auto interpolation = [=]( double f1, double f2 ) -> double
+    std::vector< std::pair< int, QTransform > > keys;
+    keys.reserve(keyFrameCount());
+    foreachKeyFrame( [&keys]( KeyFrame* pKeyFrame )
     {
-        return f1 * c1 + f2 * c2;
-    };
-
-    return QTransform( interpolation( camera1->view.m11(), camera2->view.m11() ),
-                       interpolation( camera1->view.m12(), camera2->view.m12() ),
-                       interpolation( camera1->view.m21(), camera2->view.m21() ),
-                       interpolation( camera1->view.m22(), camera2->view.m22() ),
-                       interpolation( camera1->view.dx(),  camera2->view.dx() ),
-                       interpolation( camera1->view.dy(),  camera2->view.dy() ) );
-   
+        Camera* camera = static_cast< Camera* >( pKeyFrame );
+        keys.push_back( std::make_pair( camera->pos(), camera->view ) );
+    } );
+    mPath.setKeys(keys);
+    mPathRevision = revision();
 }
 
 QRect LayerCamera::getViewRect()
@@ -212,11 +211,13 @@ void LayerCamera::editProperties()
     dialog->setName(mName);
     dialog->setWidth(viewRect.width());
     dialog->setHeight(viewRect.height());
+    dialog->setInterpolation(interpolation());
     int result = dialog->exec();
     if (result == QDialog::Accepted)
     {
         mName = dialog->getName();
         viewRect = QRect(-dialog->getWidth()/2, -dialog->getHeight()/2, dialog->getWidth(), dialog->getHeight());
+        setInterpolation(dialog->getInterpolation());
 
         setUpdated();
     }
@@ -231,6 +232,7 @@ QDomElement LayerCamera::createDomElement( QDomDocument& doc )
     layerTag.setAttribute("type", type());
     layerTag.setAttribute("width", viewRect.width());
     layerTag.setAttribute("height", viewRect.height());
+    layerTag.setAttribute("interpolation", interpolation());
 
     foreachKeyFrame( [&]( KeyFrame* pKeyFrame )
     {
@@ -260,6 +262,7 @@ void LayerCamera::loadDomElement(QDomElement element, QString dataDirPath)
     int width = element.attribute( "width" ).toInt();
     int height = element.attribute( "height" ).toInt();
     viewRect = QRect( -width / 2, -height / 2, width, height );
+    setInterpolation( static_cast< CameraPath::Interpolation >( qBound( 0, element.attribute( "interpolation", "0" ).toInt(), 2 ) ) );
 
     QDomNode imageTag = element.firstChild();
     while (!imageTag.isNull())
@@ -284,3 +287,36 @@ void LayerCamera::loadDomElement(QDomElement element, QString dataDirPath)
         imageTag = imageTag.nextSibling();
     }
 }
+
+void LayerCamera::loadDomElement(QXmlStreamReader& xmlStream, QString dataDirPath)
+{
+    Q_UNUSED(dataDirPath);
+
+    QXmlStreamAttributes attributes = xmlStream.attributes();
+    mName = attributes.value("name").toString();
+    mVisible = true;
+
+    int width = attributes.value( "width" ).toInt();
+    int height = attributes.value( "height" ).toInt();
+    viewRect = QRect( -width / 2, -height / 2, width, height );
+    setInterpolation( static_cast< CameraPath::Interpolation >( qBound( 0, attributes.value( "interpolation" ).toInt(), 2 ) ) );
+
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() == "camera")
+        {
+            QXmlStreamAttributes cameraAttributes = xmlStream.attributes();
+            int frame = cameraAttributes.value("frame").toInt();
+
+            qreal m11 = cameraAttributes.value("m11").toDouble();
+            qreal m12 = cameraAttributes.value("m12").toDouble();
+            qreal m21 = cameraAttributes.value("m21").toDouble();
+            qreal m22 = cameraAttributes.value("m22").toDouble();
+            qreal dx = cameraAttributes.value("dx").toDouble();
+            qreal dy = cameraAttributes.value("dy").toDouble();
+
+            loadImageAtFrame( frame, QTransform( m11, m12, m21, m22, dx, dy ) );
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
@@ -20,9 +20,11 @@ GNU General Public License for more details.
 #include <QList>
 #include <QDialog>
 #include "layer.h"
+#include "camerapath.h"
 
 class QLineEdit;
 class QSpinBox;
+class QComboBox;
 class Camera;
 
 class CameraPropertiesDialog : public QDialog
@@ -37,9 +39,12 @@ public:
     void setWidth(int);
     int getHeight();
     void setHeight(int);
+    CameraPath::Interpolation getInterpolation();
+    void setInterpolation(CameraPath::Interpolation);
 protected:
     QLineEdit* nameBox;
     QSpinBox* widthBox, *heightBox;
+    QComboBox* interpolationBox;
 };
 
 class LayerCamera : public Layer
@@ -59,11 +64,19 @@ public:
     void editProperties() override;
     QDomElement createDomElement(QDomDocument& doc) override;
     void loadDomElement(QDomElement element, QString dataDirPath) override;
+    void loadDomElement(QXmlStreamReader& xmlStream, QString dataDirPath) override;
 
     Camera* getCameraAtFrame(int frameNumber);
     Camera* getLastCameraAtFrame(int frameNumber, int increment);
     QTransform getViewAtFrame(int frameNumber);
 
+    // Works out the views of the frames ahead, before playing or exporting them
+    void cacheViews(int firstFrame, int lastFrame);
+    void clearCachedViews() { mPath.clearCache(); }
+
+    CameraPath::Interpolation interpolation() { return mPath.interpolation(); }
+    void setInterpolation(CameraPath::Interpolation interpolation) { mPath.setInterpolation(interpolation); }
+
     QRect getViewRect();
     QSize getViewSize();
 
@@ -72,6 +85,12 @@ protected:
 
     QRect viewRect;
     CameraPropertiesDialog* dialog;
+
+private:
+    void updatePath();
+
+    CameraPath mPath;
+    int mPathRevision = -1; // of the key frames mPath was made of
 };
 
 #endif
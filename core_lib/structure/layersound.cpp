@@ -55,11 +55,30 @@ Status LayerSound::loadSoundClipAtFrame( const QString& sSoundClipName,
 
 void LayerSound::updateFrameLengths(int fps)
 {
-    foreachKeyFrame( [&fps] (KeyFrame* pKeyFrame)
+    bool isChanged = false;
+    foreachKeyFrame( [&fps, &isChanged] (KeyFrame* pKeyFrame)
     {
         auto soundClip = dynamic_cast<SoundClip *>(pKeyFrame);
+        int oldLength = soundClip->length();
         soundClip->updateLength(fps);
+        isChanged = isChanged || soundClip->length() != oldLength;
     } );
+
+    // The timeline draws the clips as long as they are
+    if ( isChanged )
+    {
+        keyFramesChanged();
+    }
+}
+
+void LayerSound::updateClipLength( SoundClip* clip, int fps )
+{
+    int oldLength = clip->length();
+    clip->updateLength( fps );
+    if ( clip->length() != oldLength )
+    {
+        keyFramesChanged();
+    }
 }
 
 QDomElement LayerSound::createDomElement( QDomDocument& doc )
@@ -124,6 +143,35 @@ void LayerSound::loadDomElement( QDomElement element, QString dataDirPath )
     }
 }
 
+void LayerSound::loadDomElement( QXmlStreamReader& xmlStream, QString dataDirPath )
+{
+    QXmlStreamAttributes attributes = xmlStream.attributes();
+    if ( attributes.hasAttribute( "id" ) )
+    {
+        setId( attributes.value( "id" ).toInt() );
+    }
+    mName = attributes.value( "name" ).toString();
+    mVisible = ( attributes.value( "visibility" ).toInt() == 1 );
+
+    while ( xmlStream.readNextStartElement() )
+    {
+        if ( xmlStream.name() == "sound" )
+        {
+            QXmlStreamAttributes soundAttributes = xmlStream.attributes();
+            const QString soundFile = soundAttributes.value( "src" ).toString();
+            const QString sSoundClipName = soundAttributes.hasAttribute( "name" ) ? soundAttributes.value( "name" ).toString() : "My Sound Clip";
+
+            // the file is supposed to be in the data directory
+            const QString sFullPath = QDir( dataDirPath ).filePath( soundFile );
+
+            int position = soundAttributes.value( "frame" ).toInt();
+            Status st = loadSoundClipAtFrame( sSoundClipName, sFullPath, position );
+            Q_ASSERT( st.ok() );
+        }
+        xmlStream.skipCurrentElement();
+    }
+}
+
 Status LayerSound::saveKeyFrame( KeyFrame*, QString path )
 {
     Q_UNUSED(path)
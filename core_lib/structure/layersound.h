@@ -21,6 +21,8 @@ GNU General Public License for more details.
 #include "keyframe.h"
 #include "layer.h"
 
+class SoundClip;
+
 class LayerSound : public Layer
 {
     Q_OBJECT
@@ -30,10 +32,13 @@ public:
     ~LayerSound();
     QDomElement createDomElement(QDomDocument& doc) override;
     void loadDomElement(QDomElement element, QString dataDirPath) override;
+    void loadDomElement(QXmlStreamReader& xmlStream, QString dataDirPath) override;
 
     Status loadSoundClipAtFrame( const QString& sSoundClipName, const QString& filePathString, int frame );
 
     void updateFrameLengths(int fps);
+    // Once the duration of clip, one of the key frames of this layer, is known
+    void updateClipLength( SoundClip* clip, int fps );
 
     // These functions will be removed later.
     // Don't use them!!
@@ -16,7 +16,10 @@ GNU General Public License for more details.
 */
 #include "layervector.h"
 #include "vectorimage.h"
+#include "object.h"
+#include "pclxreader.h"
 #include <QtDebug>
+#include <QBuffer>
 
 LayerVector::LayerVector(Object* object) : Layer( object, Layer::VECTOR )
 {
@@ -95,6 +98,22 @@ void LayerVector::loadImageAtFrame(QString path, int frameNumber)
     addKeyFrame( frameNumber, vecImg );
 }
 
+void LayerVector::loadImageAtFrame(QByteArray data, int frameNumber)
+{
+    if ( keyExists( frameNumber ) )
+    {
+        removeKeyFrame( frameNumber );
+    }
+    VectorImage* vecImg = new VectorImage;
+    vecImg->setPos( frameNumber );
+    vecImg->setObject( object() );
+
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+    vecImg->read( &buffer );
+    addKeyFrame( frameNumber, vecImg );
+}
+
 Status LayerVector::saveKeyFrame( KeyFrame* pKeyFrame, QString path )
 {
     QStringList debugInfo = QStringList() << "LayerVector::saveKeyFrame" << QString( "pKeyFrame.pos() = %1" ).arg( pKeyFrame->pos() ) << QString( "path = " ).append( path );
@@ -166,7 +185,13 @@ void LayerVector::loadDomElement(QDomElement element, QString dataDirPath)
         {
             if (imageElement.tagName() == "image")
             {
-                if (!imageElement.attribute("src").isNull())
+                const PclxReader* archive = ( object() != nullptr ) ? object()->archive() : nullptr;
+                if (!imageElement.attribute("src").isNull() && archive != nullptr && archive->containsDataFile(imageElement.attribute("src")))
+                {
+                    int position = imageElement.attribute("frame").toInt();
+                    loadImageAtFrame( archive->dataFile(imageElement.attribute("src")), position );
+                }
+                else if (!imageElement.attribute("src").isNull())
                 {
                     QString path =  dataDirPath +"/" + imageElement.attribute("src"); // the file is supposed to be in the data directory
                     QFileInfo fi(path);
@@ -186,6 +211,50 @@ void LayerVector::loadDomElement(QDomElement element, QString dataDirPath)
     }
 }
 
+void LayerVector::loadDomElement(QXmlStreamReader& xmlStream, QString dataDirPath)
+{
+    QXmlStreamAttributes attributes = xmlStream.attributes();
+    if ( attributes.hasAttribute( "id" ) )
+    {
+        setId( attributes.value( "id" ).toInt() );
+    }
+    mName = attributes.value("name").toString();
+    mVisible = (attributes.value("visibility") == "1");
+
+    const PclxReader* archive = ( object() != nullptr ) ? object()->archive() : nullptr;
+    while (xmlStream.readNextStartElement())
+    {
+        if (xmlStream.name() != "image")
+        {
+            xmlStream.skipCurrentElement();
+            continue;
+        }
+
+        QXmlStreamAttributes imageAttributes = xmlStream.attributes();
+        QString src = imageAttributes.value("src").toString();
+        int position = imageAttributes.value("frame").toInt();
+        if (!src.isEmpty() && archive != nullptr && archive->containsDataFile(src))
+        {
+            loadImageAtFrame( archive->dataFile(src), position );
+            xmlStream.skipCurrentElement();
+        }
+        else if (!src.isEmpty())
+        {
+            QString path = dataDirPath + "/" + src; // the file is supposed to be in the data directory
+            QFileInfo fi(path);
+            if (!fi.exists()) path = src;
+            loadImageAtFrame( path, position );
+            xmlStream.skipCurrentElement();
+        }
+        else
+        {
+            // the curves are stored inline, in old files
+            addNewEmptyKeyAt( position );
+            getVectorImageAtFrame( position )->loadDomElement(xmlStream);
+        }
+    }
+}
+
 VectorImage* LayerVector::getVectorImageAtFrame( int frameNumber )
 {
     return static_cast< VectorImage* >( getKeyFrameAt( frameNumber ) );
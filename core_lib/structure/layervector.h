@@ -32,9 +32,11 @@ public:
 
     // method from layerImage
     void loadImageAtFrame(QString strFileName, int);
+    void loadImageAtFrame(QByteArray data, int);
 
     QDomElement createDomElement(QDomDocument& doc) override;
     void loadDomElement(QDomElement element,  QString dataDirPath) override;
+    void loadDomElement(QXmlStreamReader& xmlStream, QString dataDirPath) override;
 
     VectorImage* getVectorImageAtFrame(int frameNumber);
     VectorImage* getLastVectorImageAtFrame(int frameNumber, int increment);
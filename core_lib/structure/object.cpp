@@ -15,6 +15,7 @@ GNU General Public License for more details.
 
 */
 
+#include <algorithm>
 #include <QDomDocument>
 #include <QTextStream>
 #include <QMessageBox>
@@ -22,6 +23,7 @@ GNU General Public License for more details.
 #include <QApplication>
 
 #include "object.h"
+#include "keyframe.h"
 #include "layer.h"
 #include "layerbitmap.h"
 #include "layervector.h"
@@ -139,6 +141,52 @@ bool Object::loadXML( QDomElement docElem, ProgressCallback progress )
     return true;
 }
 
+// Reads the object element the reader is positioned on, layer by layer
+bool Object::loadXML( QXmlStreamReader& xmlStream, ProgressCallback progress )
+{
+    if ( !xmlStream.isStartElement() )
+    {
+        return false;
+    }
+
+    const QString dataDirPath = mDataDirPath;
+    QIODevice* device = xmlStream.device();
+
+    while ( xmlStream.readNextStartElement() )
+    {
+        if ( xmlStream.name() != "layer" )
+        {
+            xmlStream.skipCurrentElement();
+            continue;
+        }
+
+        Layer* layer = nullptr;
+        switch ( xmlStream.attributes().value( "type" ).toInt() )
+        {
+        case Layer::BITMAP: layer = addNewBitmapLayer(); break;
+        case Layer::VECTOR: layer = addNewVectorLayer(); break;
+        case Layer::SOUND:  layer = addNewSoundLayer(); break;
+        case Layer::CAMERA: layer = addNewCameraLayer(); break;
+        default: break;
+        }
+
+        if ( layer != nullptr )
+        {
+            layer->loadDomElement( xmlStream, dataDirPath );
+        }
+        else
+        {
+            xmlStream.skipCurrentElement();
+        }
+
+        if ( device != nullptr && device->size() > 0 )
+        {
+            progress( float( device->pos() ) / device->size() );
+        }
+    }
+    return !xmlStream.hasError();
+}
+
 LayerBitmap* Object::addNewBitmapLayer()
 {
     LayerBitmap* layerBitmap = new LayerBitmap( this );
@@ -285,6 +333,7 @@ void Object::deleteLayer( int i )
     {
         disconnect( mLayers[ i ], 0, 0, 0 ); // disconnect the layer from this object
         delete mLayers.takeAt( i );
+        invalidateKeyFrameIndex();
     }
 }
 
@@ -297,6 +346,7 @@ void Object::deleteLayer( Layer* layer )
         disconnect( layer, 0, 0, 0 );
         delete layer;
         mLayers.erase( it );
+        invalidateKeyFrameIndex();
     }
 }
 
@@ -352,13 +402,18 @@ bool Object::savePalette( QString filePath )
 
 bool Object::exportPalette( QString filePath )
 {
-    QFile* file = new QFile( filePath );
-    if ( !file->open( QFile::WriteOnly | QFile::Text ) )
+    QFile file( filePath );
+    if ( !file.open( QFile::WriteOnly | QFile::Text ) )
     {
         //QMessageBox::warning(this, "Warning", "Cannot write file");
         return false;
     }
-    QTextStream out( file );
+    return exportPalette( &file );
+}
+
+bool Object::exportPalette( QIODevice* device )
+{
+    QTextStream out( device );
 
     QDomDocument doc( "PencilPalette" );
     QDomElement root = doc.createElement( "palette" );
@@ -383,15 +438,19 @@ bool Object::exportPalette( QString filePath )
 
 bool Object::importPalette( QString filePath )
 {
-    QFile* file = new QFile( filePath );
-    if ( !file->open( QFile::ReadOnly ) )
+    QFile file( filePath );
+    if ( !file.open( QFile::ReadOnly ) )
     {
         //QMessageBox::warning(this, "Warning", "Cannot read file");
         return false;
     }
+    return importPalette( &file );
+}
 
+bool Object::importPalette( QIODevice* device )
+{
     QDomDocument doc;
-    doc.setContent( file );
+    doc.setContent( device );
 
     mPalette.clear();
     QDomElement docElem = doc.documentElement();
@@ -474,16 +533,21 @@ void Object::paintImage( QPainter& painter, int frameNumber,
             if ( layer->type() == Layer::BITMAP )
             {
                 LayerBitmap* layerBitmap = ( LayerBitmap* )layer;
-                layerBitmap->getLastBitmapImageAtFrame( frameNumber, 0 )->paintImage( painter );
+                BitmapImage* bitmapImage = layerBitmap->getLastBitmapImageAtFrame( frameNumber, 0 );
+                if ( bitmapImage != nullptr )
+                {
+                    bitmapImage->paintImage( painter );
+                }
             }
             // paints the vector images
             if ( layer->type() == Layer::VECTOR )
             {
                 LayerVector* layerVector = ( LayerVector* )layer;
-                layerVector->getLastVectorImageAtFrame( frameNumber, 0 )->paintImage( painter,
-                                                                                      false,
-                                                                                      false,
-                                                                                      antialiasing );
+                VectorImage* vectorImage = layerVector->getLastVectorImageAtFrame( frameNumber, 0 );
+                if ( vectorImage != nullptr )
+                {
+                    vectorImage->paintImage( painter, false, false, antialiasing );
+                }
             }
         }
     }
@@ -714,3 +778,48 @@ void Object::setLayerUpdated(int layerId)
 {
     emit layerChanged(layerId);
 }
+
+int Object::getLastKeyFramePositionAt( int frame )
+{
+    updateKeyFrameIndex();
+
+    // the last position <= frame
+    auto it = std::upper_bound( mKeyFrameIndex.begin(), mKeyFrameIndex.end(), frame );
+    if ( it == mKeyFrameIndex.begin() )
+    {
+        return -1;
+    }
+    return *( it - 1 );
+}
+
+int Object::getMaxKeyFramePosition()
+{
+    updateKeyFrameIndex();
+
+    if ( mKeyFrameIndex.empty() )
+    {
+        return 0;
+    }
+    return mKeyFrameIndex.back();
+}
+
+void Object::updateKeyFrameIndex()
+{
+    if ( !mKeyFrameIndexDirty )
+    {
+        return;
+    }
+
+    mKeyFrameIndex.clear();
+    for ( Layer* layer : mLayers )
+    {
+        layer->foreachKeyFrame( [this]( KeyFrame* key )
+        {
+            mKeyFrameIndex.push_back( key->pos() );
+        } );
+    }
+    std::sort( mKeyFrameIndex.begin(), mKeyFrameIndex.end() );
+    mKeyFrameIndex.erase( std::unique( mKeyFrameIndex.begin(), mKeyFrameIndex.end() ), mKeyFrameIndex.end() );
+
+    mKeyFrameIndexDirty = false;
+}
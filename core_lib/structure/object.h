@@ -18,6 +18,7 @@ GNU General Public License for more details.
 #define OBJECT_H
 
 #include <memory>
+#include <vector>
 #include <QObject>
 #include <QList>
 #include <QColor>
@@ -28,6 +29,8 @@ GNU General Public License for more details.
 #include "objectdata.h"
 
 class QProgressDialog;
+class QIODevice;
+class PclxReader;
 class LayerBitmap;
 class LayerVector;
 class LayerCamera;
@@ -92,8 +95,13 @@ public:
     QString mainXMLFile() const { return mMainXMLFile; }
     void    setMainXMLFile( QString file ){ mMainXMLFile = file; }
 
+    // The archive being loaded, layers read their key frames from it rather than from the data dir
+    const PclxReader* archive() const { return mArchive; }
+    void setArchive( const PclxReader* archive ) { mArchive = archive; }
+
     QDomElement saveXML( QDomDocument& doc );
 	bool loadXML( QDomElement element, ProgressCallback progress = [] (float){} );
+    bool loadXML( QXmlStreamReader& xmlStream, ProgressCallback progress = [] (float){} );
 
     void paintImage( QPainter& painter, int frameNumber, bool background, bool antialiasing ) const;
 
@@ -112,7 +120,9 @@ public:
     void renameColour( int i, QString text );
     int getColourCount() { return mPalette.size(); }
     bool importPalette( QString filePath );
+    bool importPalette( QIODevice* device );
     bool exportPalette( QString filePath );
+    bool exportPalette( QIODevice* device );
     bool savePalette( QString filePath );
 
     void loadDefaultPalette();
@@ -162,20 +172,31 @@ public:
 
     void setLayerUpdated(int layerId);
 
+    // Key frame positions of all layers merged together.
+    // Layers invalidate it whenever their key frames change, it's rebuilt on the next query.
+    void invalidateKeyFrameIndex() { mKeyFrameIndexDirty = true; }
+    int  getLastKeyFramePositionAt( int frame );
+    int  getMaxKeyFramePosition();
+
 Q_SIGNALS:
     void layerChanged( int layerId );
 
 private:
     int getMaxLayerID();
+    void updateKeyFrameIndex();
 
     QString mFilePath;       //< where this object come from. (empty if new project)
     QString mWorkingDirPath; //< the folder that pclx will uncompress to.
     QString mDataDirPath;    //< the folder which contains all bitmap & vector image & sound files.
     QString mMainXMLFile;    //< the location of main.xml
+    const PclxReader* mArchive = nullptr; //< only set while loading a pclx
 
     QList< Layer* > mLayers;
     bool modified = false;
 
+    std::vector< int > mKeyFrameIndex; // sorted, no duplicates
+    bool mKeyFrameIndexDirty = true;
+
     QList< ColourRef > mPalette;
 
     std::unique_ptr< ObjectData > mEditorState;
@@ -0,0 +1,133 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "pclxreader.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include "quazip.h"
+#include "quazipfile.h"
+#include "fileformat.h"
+
+
+Status PclxReader::open( const QString& fileName )
+{
+    QStringList debugDetails = QStringList() << "PclxReader::open" << QString( "fileName = " ).append( fileName );
+
+    mEntries.clear();
+
+    QuaZip zip( fileName );
+    if ( !zip.open( QuaZip::mdUnzip ) )
+    {
+        return Status( Status::NOT_SUPPORTED, debugDetails << "Not a zip archive" );
+    }
+
+    // Entries are read in the order they are stored, so the archive is never seeked back
+    QuaZipFile zipFile( &zip );
+    for ( bool more = zip.goToFirstFile(); more; more = zip.goToNextFile() )
+    {
+        QString entryName = zip.getCurrentFileName();
+        if ( entryName.endsWith( '/' ) )
+        {
+            continue; // a folder
+        }
+
+        if ( !zipFile.open( QIODevice::ReadOnly ) )
+        {
+            return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails << QString( "Cannot open entry %1" ).arg( entryName ) );
+        }
+        QByteArray data = zipFile.readAll();
+        zipFile.close();
+
+        // The checksum is verified on close
+        if ( zipFile.getZipError() != UNZ_OK )
+        {
+            return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails << QString( "Corrupted entry %1" ).arg( entryName ) );
+        }
+        mEntries.insert( entryName, data );
+    }
+    zip.close();
+
+    if ( mEntries.isEmpty() )
+    {
+        return Status( Status::NOT_SUPPORTED, debugDetails << "Empty archive" );
+    }
+    return Status::OK;
+}
+
+Status PclxReader::extractFiles( const QString& targetDir )
+{
+    QStringList debugDetails = QStringList() << "PclxReader::extractFiles" << QString( "targetDir = " ).append( targetDir );
+
+    QDir dir( targetDir );
+    for ( auto it = mEntries.begin(); it != mEntries.end(); )
+    {
+        if ( isReadFromMemory( it.key() ) )
+        {
+            ++it;
+            continue;
+        }
+
+        QString filePath = dir.filePath( it.key() );
+        QDir().mkpath( QFileInfo( filePath ).absolutePath() );
+
+        QFile file( filePath );
+        if ( !file.open( QIODevice::WriteOnly ) || file.write( it.value() ) != it.value().size() )
+        {
+            return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails << QString( "Cannot write %1" ).arg( filePath ) );
+        }
+        it = mEntries.erase( it );
+    }
+    return Status::OK;
+}
+
+bool PclxReader::containsDataFile( const QString& fileName ) const
+{
+    return contains( QString( PFF_DATA_DIR ) + "/" + fileName );
+}
+
+QByteArray PclxReader::dataFile( const QString& fileName ) const
+{
+    return entry( QString( PFF_DATA_DIR ) + "/" + fileName );
+}
+
+QByteArray PclxReader::readEntry( const QString& fileName, const QString& entryName )
+{
+    QuaZip zip( fileName );
+    if ( !zip.open( QuaZip::mdUnzip ) || !zip.setCurrentFile( entryName ) )
+    {
+        return QByteArray();
+    }
+
+    QuaZipFile zipFile( &zip );
+    if ( !zipFile.open( QIODevice::ReadOnly ) )
+    {
+        return QByteArray();
+    }
+    QByteArray data = zipFile.readAll();
+    zipFile.close();
+
+    return ( zipFile.getZipError() == UNZ_OK ) ? data : QByteArray();
+}
+
+bool PclxReader::isReadFromMemory( const QString& entryName ) const
+{
+    // These are loaded by the object and written back in full on save.
+    // Anything else, sound clips in particular, is only copied on save and must stay on disk.
+    QString suffix = QFileInfo( entryName ).suffix().toLower();
+    return ( suffix == "xml" || suffix == "png" || suffix == "vec" );
+}
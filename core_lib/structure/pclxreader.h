@@ -0,0 +1,56 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef PCLXREADER_H
+#define PCLXREADER_H
+
+#include <QHash>
+#include <QByteArray>
+#include <QStringList>
+#include "pencilerror.h"
+
+
+// Reads a zipped project (*.pclx) straight from the archive, in a single pass.
+//
+// The entries are kept in memory by file name, so main.xml, the palette and
+// the key frames can be parsed without extracting them to disk first.
+// Bitmap key frames keep their png data and decode it when first needed.
+// Only the files that must exist on disk (e.g. sound clips) are extracted.
+class PclxReader
+{
+public:
+    // Returns NOT_SUPPORTED if the file is not a zip archive (old *.pcl format)
+    Status open( const QString& fileName );
+    Status extractFiles( const QString& targetDir );
+
+    bool contains( const QString& entryName ) const { return mEntries.contains( entryName ); }
+    QByteArray entry( const QString& entryName ) const { return mEntries.value( entryName ); }
+    QStringList entryNames() const { return mEntries.keys(); }
+
+    // Files of the data folder, by the name used in main.xml
+    bool containsDataFile( const QString& fileName ) const;
+    QByteArray dataFile( const QString& fileName ) const;
+
+    // Reads a single entry without going through the rest of the archive
+    static QByteArray readEntry( const QString& fileName, const QString& entryName );
+
+private:
+    bool isReadFromMemory( const QString& entryName ) const;
+
+    QHash< QString, QByteArray > mEntries;
+};
+
+#endif // PCLXREADER_H
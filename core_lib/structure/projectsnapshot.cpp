@@ -0,0 +1,110 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "projectsnapshot.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QBuffer>
+#include "quazip.h"
+#include "quazipfile.h"
+#include "tracer.h"
+
+
+void ProjectSnapshot::addFile( const QString& entryName, const QByteArray& data )
+{
+    Entry entry;
+    entry.name = entryName;
+    entry.data = data;
+    mEntries.push_back( entry );
+}
+
+void ProjectSnapshot::addImage( const QString& entryName, const QImage& image )
+{
+    Entry entry;
+    entry.name = entryName;
+    entry.image = image;
+    mEntries.push_back( entry );
+}
+
+void ProjectSnapshot::addFileFromDisk( const QString& entryName, const QString& filePath )
+{
+    Entry entry;
+    entry.name = entryName;
+    entry.filePath = filePath;
+    mEntries.push_back( entry );
+}
+
+Status ProjectSnapshot::writePCLX( const QString& fileName ) const
+{
+    TRACE_SCOPE( "ProjectSnapshot::writePCLX" );
+
+    QStringList debugDetails = QStringList() << "ProjectSnapshot::writePCLX" << QString( "fileName = " ).append( fileName );
+    const QString errorTitle = QObject::tr( "Internal Error" );
+    const QString errorDescription = QObject::tr( "An internal error occurred while trying to save the file. Some or all of your file may not have saved." );
+
+    // QSaveFile only replaces the previous file once everything is written
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        return Status( Status::ERROR_FILE_CANNOT_OPEN, debugDetails << file.errorString(), errorTitle, errorDescription );
+    }
+
+    QuaZip zip( &file );
+    zip.setAutoClose( false );
+    if ( !zip.open( QuaZip::mdCreate ) )
+    {
+        return Status( Status::FAIL, debugDetails << QString( "zip error = %1" ).arg( zip.getZipError() ), errorTitle, errorDescription );
+    }
+
+    for ( const Entry& entry : mEntries )
+    {
+        QByteArray data = entry.data;
+        if ( !entry.image.isNull() )
+        {
+            QBuffer buffer( &data );
+            buffer.open( QIODevice::WriteOnly );
+            entry.image.save( &buffer, "PNG" );
+        }
+        else if ( !entry.filePath.isEmpty() )
+        {
+            QFile sourceFile( entry.filePath );
+            if ( !sourceFile.open( QIODevice::ReadOnly ) )
+            {
+                return Status( Status::FAIL, debugDetails << QString( "Cannot read " ).append( entry.filePath ), errorTitle, errorDescription );
+            }
+            data = sourceFile.readAll();
+        }
+
+        QuaZipFile zipFile( &zip );
+        if ( !zipFile.open( QIODevice::WriteOnly, QuaZipNewInfo( entry.name ) ) || zipFile.write( data ) != data.size() )
+        {
+            return Status( Status::FAIL, debugDetails << QString( "Cannot write " ).append( entry.name ), errorTitle, errorDescription );
+        }
+        zipFile.close();
+        if ( zipFile.getZipError() != UNZ_OK )
+        {
+            return Status( Status::FAIL, debugDetails << QString( "Cannot write " ).append( entry.name ), errorTitle, errorDescription );
+        }
+    }
+
+    zip.close();
+    if ( zip.getZipError() != UNZ_OK || !file.commit() )
+    {
+        return Status( Status::FAIL, debugDetails << file.errorString(), errorTitle, errorDescription );
+    }
+    return Status::OK;
+}
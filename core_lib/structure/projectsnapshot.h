@@ -0,0 +1,57 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef PROJECTSNAPSHOT_H
+#define PROJECTSNAPSHOT_H
+
+#include <vector>
+#include <QString>
+#include <QByteArray>
+#include <QImage>
+#include "pencilerror.h"
+
+
+// The content of a zipped project (*.pclx), frozen at one point in time.
+//
+// It is taken on the gui thread and can be written on any other thread while
+// the user keeps drawing. Nothing is encoded when it is taken: bitmap frames
+// share their pixels with the key frames (QImage is copy-on-write, a new
+// stroke detaches the key frame) and are only compressed to png when written,
+// frames that were never decoded keep the png data they were loaded from.
+class ProjectSnapshot
+{
+public:
+    void addFile( const QString& entryName, const QByteArray& data );
+    void addImage( const QString& entryName, const QImage& image );
+    void addFileFromDisk( const QString& entryName, const QString& filePath );
+
+    int  entryCount() const { return static_cast< int >( mEntries.size() ); }
+
+    // The archive is written next to the file and renamed over it once complete
+    Status writePCLX( const QString& fileName ) const;
+
+private:
+    struct Entry
+    {
+        QString    name;
+        QByteArray data;
+        QImage     image; // encoded to png when written
+        QString    filePath; // read when written
+    };
+    std::vector< Entry > mEntries;
+};
+
+#endif // PROJECTSNAPSHOT_H
@@ -0,0 +1,151 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "soundtimeline.h"
+
+#include <algorithm>
+#include <climits>
+#include "object.h"
+#include "layersound.h"
+#include "soundclip.h"
+
+
+void SoundTimeline::build( Object* object )
+{
+    clear();
+
+    for ( int i = 0; i < object->getLayerCount(); ++i )
+    {
+        Layer* layer = object->getLayer( i );
+        if ( layer->type() != Layer::SOUND )
+        {
+            continue;
+        }
+
+        LayerSound* soundLayer = static_cast< LayerSound* >( layer );
+        mLayerRevisions.push_back( std::make_pair( soundLayer, soundLayer->revision() ) );
+
+        soundLayer->foreachKeyFrame( [ this ]( KeyFrame* key )
+        {
+            SoundClip* clip = static_cast< SoundClip* >( key );
+            // Until the duration is known the clip is one frame long
+            Span span = { clip->pos(), clip->pos() + std::max( clip->length(), 1 ), clip };
+            mSpans.push_back( span );
+            mClipsByAddress.push_back( clip );
+        } );
+    }
+
+    // Stable, clips starting together keep the order of the layers
+    std::stable_sort( mSpans.begin(), mSpans.end(), []( const Span& a, const Span& b )
+    {
+        return a.start < b.start;
+    } );
+    mReach.resize( mSpans.size() );
+    buildReach( 0, clipCount() );
+
+    std::sort( mClipsByAddress.begin(), mClipsByAddress.end() );
+}
+
+void SoundTimeline::clear()
+{
+    mSpans.clear();
+    mReach.clear();
+    mClipsByAddress.clear();
+    mLayerRevisions.clear();
+}
+
+bool SoundTimeline::isUpToDate( Object* object ) const
+{
+    // Only the layers are looked at, not their clips
+    size_t soundLayerCount = 0;
+    for ( int i = 0; i < object->getLayerCount(); ++i )
+    {
+        Layer* layer = object->getLayer( i );
+        if ( layer->type() != Layer::SOUND )
+        {
+            continue;
+        }
+        if ( soundLayerCount >= mLayerRevisions.size() ||
+             mLayerRevisions[ soundLayerCount ].first != layer ||
+             mLayerRevisions[ soundLayerCount ].second != layer->revision() )
+        {
+            return false;
+        }
+        soundLayerCount++;
+    }
+    return soundLayerCount == mLayerRevisions.size();
+}
+
+bool SoundTimeline::contains( SoundClip* clip ) const
+{
+    return std::binary_search( mClipsByAddress.begin(), mClipsByAddress.end(), clip );
+}
+
+void SoundTimeline::clipsStartingAt( int frame, std::vector< SoundClip* >& clips ) const
+{
+    auto first = std::lower_bound( mSpans.begin(), mSpans.end(), frame, []( const Span& span, int f )
+    {
+        return span.start < f;
+    } );
+    for ( auto it = first; it != mSpans.end() && it->start == frame; ++it )
+    {
+        clips.push_back( it->clip );
+    }
+}
+
+void SoundTimeline::clipsCovering( int frame, std::vector< SoundClip* >& clips ) const
+{
+    findCovering( 0, clipCount(), frame, clips );
+}
+
+int SoundTimeline::buildReach( int begin, int end )
+{
+    if ( begin >= end )
+    {
+        return INT_MIN;
+    }
+    int middle = begin + ( end - begin ) / 2;
+    int reach = std::max( mSpans[ middle ].end,
+                          std::max( buildReach( begin, middle ), buildReach( middle + 1, end ) ) );
+    mReach[ middle ] = reach;
+    return reach;
+}
+
+void SoundTimeline::findCovering( int begin, int end, int frame, std::vector< SoundClip* >& clips ) const
+{
+    if ( begin >= end )
+    {
+        return;
+    }
+    int middle = begin + ( end - begin ) / 2;
+    if ( mReach[ middle ] <= frame )
+    {
+        return; // all of this subtree is over by then
+    }
+
+    findCovering( begin, middle, frame, clips );
+
+    // The spans after the middle one start later still
+    const Span& span = mSpans[ middle ];
+    if ( span.start <= frame )
+    {
+        if ( frame < span.end )
+        {
+            clips.push_back( span.clip );
+        }
+        findCovering( middle + 1, end, frame, clips );
+    }
+}
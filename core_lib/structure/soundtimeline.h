@@ -0,0 +1,69 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef SOUNDTIMELINE_H
+#define SOUNDTIMELINE_H
+
+#include <utility>
+#include <vector>
+
+class Object;
+class LayerSound;
+class SoundClip;
+
+
+// The spans of the sound clips of all the sound layers of an object, for
+// playback to find the clips of a frame without going through every layer
+// and clip. The spans are kept sorted by their first frame, which makes an
+// implicit balanced tree: the middle span of each range is the root of it,
+// and knows how far the spans below it reach.
+//
+// The index is built once and stays valid until the sound layers or their
+// key frames change, which isUpToDate() tells from the layer revisions.
+// A clip changing length doesn't change the revision, the owner has to build
+// again when a duration is known or the frame rate changes.
+class SoundTimeline
+{
+public:
+    void build( Object* object );
+    void clear();
+    bool isUpToDate( Object* object ) const;
+
+    int  clipCount() const { return static_cast< int >( mSpans.size() ); }
+    bool contains( SoundClip* clip ) const;
+
+    // The clips are appended to `clips`, sorted by their first frame
+    void clipsStartingAt( int frame, std::vector< SoundClip* >& clips ) const;
+    void clipsCovering( int frame, std::vector< SoundClip* >& clips ) const;
+
+private:
+    struct Span
+    {
+        int start;
+        int end; // the frame after the clip
+        SoundClip* clip;
+    };
+
+    int  buildReach( int begin, int end );
+    void findCovering( int begin, int end, int frame, std::vector< SoundClip* >& clips ) const;
+
+    std::vector< Span > mSpans;
+    std::vector< int > mReach; // the largest end of the spans in the subtree of each span
+    std::vector< SoundClip* > mClipsByAddress;
+    std::vector< std::pair< LayerSound*, int > > mLayerRevisions;
+};
+
+#endif // SOUNDTIMELINE_H
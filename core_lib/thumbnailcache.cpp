@@ -0,0 +1,425 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "thumbnailcache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <QTimer>
+#include <QThread>
+#include <QRunnable>
+#include <QBuffer>
+#include <QImageReader>
+#include <QPainter>
+#include "object.h"
+#include "layer.h"
+#include "layercamera.h"
+#include "bitmapimage.h"
+#include "vectorimage.h"
+#include "pclxreader.h"
+#include "fileformat.h"
+#include "util.h"
+#include "tracer.h"
+
+
+namespace
+{
+struct BitmapThumbnailJob
+{
+    int        layerId = 0;
+    int        framePos = 0;
+    int        generation = 0;
+    QImage     image;        // a mip level, or the image itself
+    QByteArray encodedImage; // or the file data of an image that was never decoded
+    QRectF     targetRect;   // in thumbnail coordinates
+    QSize      size;
+};
+
+class BitmapThumbnailTask : public QRunnable
+{
+public:
+    BitmapThumbnailTask( QObject* cache, const BitmapThumbnailJob& job ) : mCache( cache ), mJob( job ) {}
+    void run() override;
+
+private:
+    QObject* mCache;
+    BitmapThumbnailJob mJob;
+};
+
+void BitmapThumbnailTask::run()
+{
+    TRACE_SCOPE( "BitmapThumbnailTask::run" );
+
+    QSize scaledSize = mJob.targetRect.size().toSize().expandedTo( QSize( 1, 1 ) );
+
+    QImage source = mJob.image;
+    if ( !mJob.encodedImage.isEmpty() )
+    {
+        // Decoded straight to the thumbnail size, the key frame itself stays encoded
+        QBuffer buffer( &mJob.encodedImage );
+        QImageReader reader( &buffer );
+        reader.setScaledSize( scaledSize );
+        source = reader.read();
+    }
+    else if ( !source.isNull() && source.size() != scaledSize )
+    {
+        source = source.scaled( scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+    }
+
+    QImage thumbnail( mJob.size, QImage::Format_ARGB32_Premultiplied );
+    thumbnail.fill( Qt::transparent );
+    if ( !source.isNull() )
+    {
+        QPainter painter( &thumbnail );
+        painter.setRenderHint( QPainter::SmoothPixmapTransform );
+        painter.drawImage( mJob.targetRect, source );
+    }
+
+    QMetaObject::invokeMethod( mCache, "bitmapThumbnailRendered", Qt::QueuedConnection,
+                               Q_ARG( int, mJob.layerId ),
+                               Q_ARG( int, mJob.framePos ),
+                               Q_ARG( int, mJob.generation ),
+                               Q_ARG( QImage, thumbnail ) );
+}
+}
+
+
+ThumbnailCache::ThumbnailCache( QObject* parent ) : QObject( parent )
+    , mLog( "ThumbnailCache" )
+{
+    ENABLE_DEBUG_LOG( mLog, false );
+
+    // Leave some cores to the gui thread and the playback cache
+    mPool.setMaxThreadCount( std::max( QThread::idealThreadCount() / 2, 1 ) );
+
+    mTickTimer = new QTimer( this );
+    mTickTimer->setInterval( 0 );
+    connect( mTickTimer, &QTimer::timeout, this, &ThumbnailCache::renderTick );
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    // The tasks post their results back to this object
+    mPool.clear();
+    mPool.waitForDone();
+}
+
+void ThumbnailCache::setObject( Object* object )
+{
+    if ( object != mObject )
+    {
+        clear();
+        mObject = object;
+    }
+}
+
+void ThumbnailCache::setThumbnailWidth( int width )
+{
+    if ( width != mThumbnailWidth )
+    {
+        clear();
+        mThumbnailWidth = std::max( width, 1 );
+    }
+}
+
+QSize ThumbnailCache::thumbnailSize() const
+{
+    // The aspect ratio of the camera
+    QRect viewRect = cameraViewRect();
+    int height = mThumbnailWidth * viewRect.height() / std::max( viewRect.width(), 1 );
+    return QSize( mThumbnailWidth, std::max( height, 1 ) );
+}
+
+QImage ThumbnailCache::thumbnail( Layer* layer, int framePos )
+{
+    Q_ASSERT( layer );
+    if ( mObject == nullptr || ( layer->type() != Layer::BITMAP && layer->type() != Layer::VECTOR ) )
+    {
+        return QImage();
+    }
+
+    KeyFrame* key = layer->getKeyFrameAt( framePos );
+    if ( key == nullptr )
+    {
+        return QImage();
+    }
+
+    qint64 entryKey = entryKeyOf( layer->id(), framePos );
+    Entry& entry = mEntries[ entryKey ];
+    if ( entry.key != key )
+    {
+        entry.isUpToDate = false; // moved here, or replaced, e.g. by an undo
+    }
+    if ( !entry.isUpToDate )
+    {
+        enqueue( entryKey, entry );
+    }
+    return entry.image;
+}
+
+void ThumbnailCache::invalidate( Layer* layer, int frame )
+{
+    Q_ASSERT( layer );
+
+    KeyFrame* key = layer->getLastKeyFrameAtPosition( frame );
+    if ( key == nullptr )
+    {
+        return;
+    }
+
+    // Only the thumbnails asked for are kept up to date, the outdated one stays on show meanwhile
+    qint64 entryKey = entryKeyOf( layer->id(), key->pos() );
+    auto it = mEntries.find( entryKey );
+    if ( it != mEntries.end() )
+    {
+        enqueue( entryKey, it.value() );
+    }
+}
+
+void ThumbnailCache::clear()
+{
+    // Running tasks still finish, their results are dropped
+    mEntries.clear();
+    mQueue.clear();
+    mTickTimer->stop();
+}
+
+QImage ThumbnailCache::filmstrip( int frameCount )
+{
+    TRACE_SCOPE( "ThumbnailCache::filmstrip" );
+
+    if ( mObject == nullptr || frameCount < 1 )
+    {
+        return QImage();
+    }
+    int lastFrame = mObject->getMaxKeyFramePosition();
+    if ( lastFrame < 1 )
+    {
+        return QImage();
+    }
+    frameCount = std::min( frameCount, lastFrame );
+
+    QSize size = thumbnailSize();
+    QImage strip( size.width() * frameCount, size.height(), QImage::Format_ARGB32_Premultiplied );
+    strip.fill( Qt::white );
+
+    QPainter painter( &strip );
+    painter.setRenderHint( QPainter::SmoothPixmapTransform );
+
+    bool isEmpty = true;
+    for ( int i = 0; i < frameCount; ++i )
+    {
+        // Spread over the whole animation, the first and the last frames included
+        int frame = ( frameCount > 1 ) ? 1 + ( lastFrame - 1 ) * i / ( frameCount - 1 ) : 1;
+        QRect cell( QPoint( size.width() * i, 0 ), size );
+
+        for ( int l = 0; l < mObject->getLayerCount(); ++l )
+        {
+            Layer* layer = mObject->getLayer( l );
+            KeyFrame* key = layer->visible() ? layer->getLastKeyFrameAtPosition( frame ) : nullptr;
+            if ( key == nullptr )
+            {
+                continue;
+            }
+
+            // Missing ones are queued, they'll be there for the next save
+            QImage image = thumbnail( layer, key->pos() );
+            if ( !image.isNull() )
+            {
+                painter.drawImage( cell, image );
+                isEmpty = false;
+            }
+        }
+    }
+    painter.end();
+
+    return isEmpty ? QImage() : strip;
+}
+
+QImage ThumbnailCache::readFilmstrip( const QString& projectPath )
+{
+    if ( !projectPath.endsWith( PFF_EXTENSION, Qt::CaseInsensitive ) )
+    {
+        return QImage();
+    }
+    return QImage::fromData( PclxReader::readEntry( projectPath, PFF_FILMSTRIP_FILE ) );
+}
+
+qint64 ThumbnailCache::memoryUsage() const
+{
+    qint64 bytes = 0;
+    for ( const Entry& entry : mEntries )
+    {
+        bytes += entry.image.byteCount();
+    }
+    return bytes;
+}
+
+void ThumbnailCache::bitmapThumbnailRendered( int layerId, int framePos, int generation, QImage thumbnail )
+{
+    mRunningCount -= 1;
+    store( layerId, framePos, generation, thumbnail );
+
+    if ( !mQueue.isEmpty() )
+    {
+        mTickTimer->start();
+    }
+}
+
+void ThumbnailCache::renderTick()
+{
+    TRACE_SCOPE( "ThumbnailCache::renderTick" );
+
+    const int maxRunningCount = mPool.maxThreadCount() * 2;
+
+    // A bitmap thumbnail only costs a snapshot here, keep going until a vector one is rendered
+    while ( !mQueue.isEmpty() && mRunningCount < maxRunningCount && mObject != nullptr )
+    {
+        qint64 entryKey = mQueue.takeFirst();
+        auto it = mEntries.find( entryKey );
+        if ( it == mEntries.end() )
+        {
+            continue;
+        }
+
+        Entry& entry = it.value();
+        entry.isQueued = false;
+
+        int layerId = static_cast< int >( entryKey >> 32 );
+        int framePos = static_cast< int >( quint32( entryKey ) );
+        Layer* layer = findLayer( layerId );
+        KeyFrame* key = ( layer != nullptr ) ? layer->getKeyFrameAt( framePos ) : nullptr;
+        if ( key == nullptr )
+        {
+            mEntries.erase( it ); // removed since
+            continue;
+        }
+
+        entry.key = key;
+        entry.isUpToDate = true;
+        entry.generation = ++mGeneration;
+
+        if ( layer->type() == Layer::BITMAP )
+        {
+            startBitmapThumbnail( layer, key, entry.generation );
+            continue;
+        }
+
+        store( layerId, framePos, entry.generation, renderVectorThumbnail( key ) );
+        return;
+    }
+
+    mTickTimer->stop();
+    qCDebug( mLog ) << mEntries.size() << "thumbnails," << memoryUsage() / 1024 << "KB," << pendingCount() << "pending";
+}
+
+void ThumbnailCache::startBitmapThumbnail( Layer* layer, KeyFrame* key, int generation )
+{
+    BitmapImage* bitmapImage = static_cast< BitmapImage* >( key );
+    QTransform transform = thumbnailTransform();
+
+    BitmapThumbnailJob job;
+    job.layerId = layer->id();
+    job.framePos = key->pos();
+    job.generation = generation;
+    job.size = thumbnailSize();
+    job.targetRect = transform.mapRect( QRectF( bitmapImage->bounds() ) );
+
+    // Copy-on-write, the next stroke detaches the key frame from the snapshot
+    if ( bitmapImage->hasEncodedImage() )
+    {
+        job.encodedImage = bitmapImage->encodedImage();
+    }
+    else if ( !bitmapImage->bounds().isEmpty() )
+    {
+        job.image = bitmapImage->builtMipmap( std::sqrt( std::abs( transform.determinant() ) ) );
+    }
+
+    mPool.start( new BitmapThumbnailTask( this, job ) );
+    mRunningCount += 1;
+}
+
+QImage ThumbnailCache::renderVectorThumbnail( KeyFrame* key )
+{
+    TRACE_SCOPE( "ThumbnailCache::renderVectorThumbnail" );
+
+    QImage thumbnail( thumbnailSize(), QImage::Format_ARGB32_Premultiplied );
+    thumbnail.fill( Qt::transparent );
+
+    QPainter painter( &thumbnail );
+    painter.setWorldTransform( thumbnailTransform() );
+    painter.setRenderHint( QPainter::Antialiasing );
+    static_cast< VectorImage* >( key )->paintImage( painter, false, false, true );
+    painter.end();
+
+    return thumbnail;
+}
+
+void ThumbnailCache::store( int layerId, int framePos, int generation, const QImage& thumbnail )
+{
+    auto it = mEntries.find( entryKeyOf( layerId, framePos ) );
+    if ( it == mEntries.end() || it->generation != generation )
+    {
+        return; // changed again, or cleared, while it was rendered
+    }
+    it->image = thumbnail;
+    emit thumbnailUpdated( layerId, framePos );
+}
+
+void ThumbnailCache::enqueue( qint64 entryKey, Entry& entry )
+{
+    entry.isUpToDate = false;
+    entry.generation = ++mGeneration; // drops the result of a render still running
+    if ( !entry.isQueued )
+    {
+        entry.isQueued = true;
+        mQueue.append( entryKey );
+    }
+    if ( !mTickTimer->isActive() )
+    {
+        mTickTimer->start();
+    }
+}
+
+Layer* ThumbnailCache::findLayer( int layerId ) const
+{
+    for ( int i = 0; i < mObject->getLayerCount(); ++i )
+    {
+        Layer* layer = mObject->getLayer( i );
+        if ( layer->id() == layerId )
+        {
+            return layer;
+        }
+    }
+    return nullptr;
+}
+
+QRect ThumbnailCache::cameraViewRect() const
+{
+    // Old .pcl files may not have a camera layer
+    std::vector< LayerCamera* > cameras;
+    if ( mObject != nullptr )
+    {
+        cameras = mObject->getLayersByType< LayerCamera >();
+    }
+    return cameras.empty() ? QRect( QPoint( -320, -240 ), QSize( 640, 480 ) ) : cameras.front()->getViewRect();
+}
+
+QTransform ThumbnailCache::thumbnailTransform() const
+{
+    // Camera moves are left out, a key frame looks the same wherever it is on the timeline
+    return RectMapTransform( QRectF( cameraViewRect() ), QRectF( QPointF( 0, 0 ), thumbnailSize() ) );
+}
@@ -0,0 +1,106 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QImage>
+#include <QTransform>
+#include <QThreadPool>
+#include "log.h"
+
+class QTimer;
+class Object;
+class Layer;
+class KeyFrame;
+
+
+// Small previews of the key frames, for the timeline and the filmstrip saved in projects.
+//
+// Asking for a thumbnail never renders it: missing and outdated ones are queued
+// and the one at hand (possibly out of date, or null) is returned right away.
+// Bitmap key frames are only snapshotted on the gui thread (QImage is copy-on-write)
+// and scaled down on worker threads, from a mip level when there is one.
+// Painting a vector image isn't thread safe, those are rendered while the event
+// loop is idle, one per tick. thumbnailUpdated() is emitted as they come in.
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThumbnailCache( QObject* parent = 0 );
+    virtual ~ThumbnailCache();
+
+    void setObject( Object* object );
+    void setThumbnailWidth( int width );
+    QSize thumbnailSize() const;
+
+    QImage thumbnail( Layer* layer, int framePos );
+    void   invalidate( Layer* layer, int frame ); // the key frame showing at this frame has changed
+    void   clear();
+
+    // The frames of the project side by side, composited from the thumbnails at hand
+    QImage filmstrip( int frameCount = 8 );
+    static QImage readFilmstrip( const QString& projectPath );
+
+    int    pendingCount() const { return mQueue.size() + mRunningCount; }
+    qint64 memoryUsage() const;
+
+signals:
+    void thumbnailUpdated( int layerId, int framePos );
+
+private slots:
+    void bitmapThumbnailRendered( int layerId, int framePos, int generation, QImage thumbnail );
+
+private:
+    struct Entry
+    {
+        QImage    image;
+        KeyFrame* key = nullptr;     // the key frame it shows
+        int       generation = 0;    // results of other renders are dropped
+        bool      isUpToDate = false; // rendered, or being rendered, from the current content
+        bool      isQueued = false;
+    };
+
+    void   renderTick();
+    void   startBitmapThumbnail( Layer* layer, KeyFrame* key, int generation );
+    QImage renderVectorThumbnail( KeyFrame* key );
+    void   store( int layerId, int framePos, int generation, const QImage& thumbnail );
+    void   enqueue( qint64 entryKey, Entry& entry );
+    Layer* findLayer( int layerId ) const;
+    QRect  cameraViewRect() const;
+    QTransform thumbnailTransform() const;
+
+    static qint64 entryKeyOf( int layerId, int framePos ) { return ( qint64( layerId ) << 32 ) | quint32( framePos ); }
+
+    Object* mObject = nullptr;
+    int mThumbnailWidth = 64;
+
+    QHash< qint64, Entry > mEntries; // by layer id and key frame position
+    QList< qint64 > mQueue;
+    int mGeneration = 0;
+    int mRunningCount = 0;
+
+    QThreadPool mPool;
+    QTimer* mTickTimer = nullptr;
+
+    QLoggingCategory mLog;
+};
+
+#endif // THUMBNAILCACHE_H
@@ -339,10 +339,8 @@ void BrushTool::drawStroke()
 
         int rad = qRound( brushWidth ) / 2 + 2;
 
-        //continously update buffer to update stroke behind grid.
-        mScribbleArea->paintBitmapBufferRect(rect);
-
-        mScribbleArea->refreshBitmap( rect, rad );
+        // Composited into the layer on screen, the key frame only gets it on release
+        mScribbleArea->updateBitmapBuffer( rect, rad );
 
           // Line visualizer
           // for debugging
@@ -234,10 +234,8 @@ void EraserTool::drawStroke()
 
         int rad = qRound( brushWidth ) / 2 + 2;
 
-        //continously update buffer to update stroke behind grid.
-        mScribbleArea->paintBitmapBufferRect(rect);
-
-        mScribbleArea->refreshBitmap( rect, rad );
+        // Composited into the layer on screen, the key frame only gets it on release
+        mScribbleArea->updateBitmapBuffer( rect, rad );
     }
     else if ( layer->type() == Layer::VECTOR )
     {
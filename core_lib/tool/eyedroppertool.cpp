@@ -16,6 +16,7 @@ GNU General Public License for more details.
 */
 
 #include "eyedroppertool.h"
+#include <QtMath>
 #include <QPainter>
 #include <QPixmap>
 #include <QBitmap>
@@ -25,12 +26,19 @@ GNU General Public License for more details.
 #include "layervector.h"
 #include "layerbitmap.h"
 #include "colormanager.h"
+#include "colorsampler.h"
 #include "object.h"
 #include "editor.h"
 #include "layermanager.h"
 #include "scribblearea.h"
 
 
+namespace
+{
+// Enough for the colours of a picture, the cursors are made again past it
+const int MAX_CACHED_CURSORS = 256;
+}
+
 EyedropperTool::EyedropperTool(QObject *parent) :
     BaseTool(parent)
 {
@@ -46,6 +54,9 @@ void EyedropperTool::loadSettings()
 
 QCursor EyedropperTool::cursor()
 {
+    // Asked for when the scribble area sets the cursor of the tool
+    mCursorColour = 0;
+
     if ( mEditor->preference()->isOn( SETTING::TOOL_CURSOR ) )
     {
         return QCursor(QPixmap(":icons/eyedropper.png"), 0, 15);
@@ -58,13 +69,16 @@ QCursor EyedropperTool::cursor()
 
 QCursor EyedropperTool::cursor(const QColor colour)
 {
-    QPixmap icon(":icons/eyedropper.png");
+    if (mIcon.isNull())
+    {
+        mIcon = QPixmap(":icons/eyedropper.png");
+    }
 
     QPixmap pixmap(32, 32);
     pixmap.fill(Qt::transparent);
 
     QPainter painter(&pixmap);
-    painter.drawPixmap(0, 0, icon);
+    painter.drawPixmap(0, 0, mIcon);
     painter.setPen(QPen(Qt::black, 1, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
     painter.setBrush(colour);
     painter.drawRect(16, 16, 15, 15);
@@ -85,23 +99,9 @@ void EyedropperTool::mouseReleaseEvent(QMouseEvent *event)
 
     if (event->button() == Qt::LeftButton)
     {
-        if (layer->type() == Layer::BITMAP)
-        {
-            BitmapImage* targetImage = ((LayerBitmap *)layer)->getLastBitmapImageAtFrame( mEditor->currentFrame(), 0);
-            //QColor pickedColour = targetImage->pixel(getLastPoint().x(), getLastPoint().y());
-            QColor pickedColour;
-            pickedColour.setRgba( targetImage->pixel( getLastPoint().x(), getLastPoint().y() ) );
-            int transp = 255 - pickedColour.alpha();
-            pickedColour.setRed( pickedColour.red() + transp );
-            pickedColour.setGreen( pickedColour.green() + transp );
-            pickedColour.setBlue( pickedColour.blue() + transp );
-            if (pickedColour.alpha() != 0)
-            {
-                mEditor->color()->setColor(pickedColour);
-            }
-        }
-        else if (layer->type() == Layer::VECTOR)
+        if (layer->type() == Layer::VECTOR && !mEditor->preference()->isOn(SETTING::EYEDROPPER_ALL_LAYERS))
         {
+            // The palette colour of the area, not how it looks
             VectorImage *vectorImage = ((LayerVector *)layer)->getLastVectorImageAtFrame(mEditor->currentFrame(), 0);
             int colourNumber = vectorImage->getColourNumber(getLastPoint());
             if (colourNumber != -1)
@@ -109,6 +109,14 @@ void EyedropperTool::mouseReleaseEvent(QMouseEvent *event)
                 mEditor->color()->setColorNumber(colourNumber);
             }
         }
+        else
+        {
+            QColor pickedColour = sampleColour(getLastPixel(), getLastPoint());
+            if (pickedColour.isValid())
+            {
+                mEditor->color()->setColor(pickedColour);
+            }
+        }
     }
 }
 
@@ -116,46 +124,73 @@ void EyedropperTool::mouseMoveEvent(QMouseEvent *event)
 {
     Q_UNUSED(event);
 
+    updateCursor(sampleColour(getCurrentPixel(), getCurrentPoint()));
+}
+
+QColor EyedropperTool::sampleColour(QPointF pixel, QPointF point)
+{
     Layer* layer = mEditor->layers()->currentLayer();
-    if (layer == NULL) { return; }
+    if (layer == NULL) { return QColor(); }
 
-    if (layer->type() == Layer::BITMAP)
+    const int size = mEditor->preference()->getInt(SETTING::EYEDROPPER_SAMPLE_SIZE);
+    const QPoint screenPixel(qFloor(pixel.x()), qFloor(pixel.y()));
+
+    QRgb sample;
+    if (mEditor->preference()->isOn(SETTING::EYEDROPPER_ALL_LAYERS))
     {
-        BitmapImage *targetImage = ((LayerBitmap *)layer)->getLastBitmapImageAtFrame(mEditor->currentFrame(), 0);
-        if (targetImage->contains(getCurrentPoint()))
-        {
-            QColor pickedColour;
-            //pickedColour.setRgba(targetImage->pixel(getCurrentPoint().x(), getCurrentPoint().y()));
-            pickedColour.setRgba( targetImage->pixel( getCurrentPoint().x(), getCurrentPoint().y() ) );
-            int transp = 255 - pickedColour.alpha();
-            pickedColour.setRed( pickedColour.red() + transp );
-            pickedColour.setGreen( pickedColour.green() + transp );
-            pickedColour.setBlue( pickedColour.blue() + transp );
-            if (pickedColour.alpha() != 0)
-            {
-                mScribbleArea->setCursor(cursor(pickedColour));
-            }
-            else
-            {
-                mScribbleArea->setCursor(cursor());
-            }
-        }
-        else
-        {
-            mScribbleArea->setCursor(cursor());
-        }
+        sample = ColorSampler::average(mScribbleArea->canvasImage(), screenPixel, size);
     }
-    if (layer->type() == Layer::VECTOR)
+    else if (layer->type() == Layer::BITMAP)
     {
+        BitmapImage* targetImage = ((LayerBitmap *)layer)->getLastBitmapImageAtFrame(mEditor->currentFrame(), 0);
+        if (targetImage == NULL) { return QColor(); }
+        const QPoint canvasPixel(qFloor(point.x()), qFloor(point.y()));
+        sample = ColorSampler::average(*targetImage->image(), canvasPixel - targetImage->topLeft(), size);
+    }
+    else if (layer->type() == Layer::VECTOR)
+    {
+        // The raster the canvas is painted with, instead of looking for the area under the point
         VectorImage *vectorImage = ((LayerVector *)layer)->getLastVectorImageAtFrame(mEditor->currentFrame(), 0);
-        int colourNumber = vectorImage->getColourNumber(getCurrentPoint());
-        if (colourNumber != -1)
-        {
-            mScribbleArea->setCursor(cursor(mEditor->object()->getColour(colourNumber).colour));
-        }
-        else
+        if (vectorImage == NULL) { return QColor(); }
+        sample = ColorSampler::average(mScribbleArea->vectorRaster(vectorImage), screenPixel, size);
+    }
+    else
+    {
+        return QColor();
+    }
+
+    if (qAlpha(sample) == 0)
+    {
+        return QColor();
+    }
+    // Premultiplied, adding the transparency gives the colour over white
+    int transp = 255 - qAlpha(sample);
+    return QColor(qRed(sample) + transp, qGreen(sample) + transp, qBlue(sample) + transp, qAlpha(sample));
+}
+
+void EyedropperTool::updateCursor(const QColor& colour)
+{
+    QRgb rgba = colour.isValid() ? colour.rgba() : 0;
+    if (rgba == mCursorColour)
+    {
+        return;
+    }
+
+    if (rgba == 0)
+    {
+        mScribbleArea->setCursor(cursor());
+        return;
+    }
+
+    auto it = mColourCursors.find(rgba);
+    if (it == mColourCursors.end())
+    {
+        if (mColourCursors.size() >= MAX_CACHED_CURSORS)
         {
-            mScribbleArea->setCursor(cursor());
+            mColourCursors.clear();
         }
+        it = mColourCursors.insert(rgba, cursor(colour));
     }
+    mScribbleArea->setCursor(it.value());
+    mCursorColour = rgba;
 }
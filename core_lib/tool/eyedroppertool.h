@@ -18,6 +18,8 @@ GNU General Public License for more details.
 #ifndef EYEDROPPERTOOL_H
 #define EYEDROPPERTOOL_H
 
+#include <QHash>
+#include <QPixmap>
 #include "basetool.h"
 
 
@@ -34,6 +36,16 @@ public:
     void mousePressEvent( QMouseEvent* ) override;
     void mouseReleaseEvent( QMouseEvent* ) override;
     void mouseMoveEvent( QMouseEvent* ) override;
+
+private:
+    // The colour at a point, averaged over the sample size of the preferences,
+    // from the current layer or all of them. Invalid where there is nothing to pick.
+    QColor sampleColour( QPointF pixel, QPointF point );
+    void updateCursor( const QColor& colour );
+
+    QPixmap mIcon;
+    QHash< QRgb, QCursor > mColourCursors;
+    QRgb mCursorColour = 0; // shown on the scribble area, 0 for the plain cursor
 };
 
 #endif // EYEDROPPERTOOL_H
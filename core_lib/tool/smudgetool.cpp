@@ -16,6 +16,7 @@ GNU General Public License for more details.
 */
 
 #include <QPixmap>
+#include <QtMath>
 #include "editor.h"
 #include "scribblearea.h"
 
@@ -217,6 +218,7 @@ void SmudgeTool::mouseReleaseEvent(QMouseEvent *event)
                 int curveNumber = mScribbleArea->vectorSelection.curve.at(k);
                 vectorImage->m_curves[curveNumber].smoothCurve();
             }
+            vectorImage->modification();
             mScribbleArea->setModified(mEditor->layers()->currentLayerIndex(), mEditor->currentFrame());
         }
     }
@@ -266,6 +268,7 @@ void SmudgeTool::drawStroke()
     if (layer == NULL) { return; }
 
     BitmapImage *targetImage = ((LayerBitmap *)layer)->getLastBitmapImageAtFrame(mEditor->currentFrame(), 0);
+    if (targetImage == NULL) { return; }
     StrokeTool::drawStroke();
     QList<QPointF> p = m_pStrokeManager->interpolateStroke();
 
@@ -284,6 +287,10 @@ void SmudgeTool::drawStroke()
     QPointF a = mLastBrushPoint;
     QPointF b = getCurrentPoint();
 
+    // Grown once for the whole segment rather than by each dab
+    int margin = qCeil(brushWidth / 2.0) + 1;
+    targetImage->extend(QRectF(a, b).normalized().adjusted(-margin, -margin, margin, margin).toAlignedRect());
+
 
     if (toolMode == 0) // liquify hard (default)
     {
@@ -309,9 +316,8 @@ void SmudgeTool::drawStroke()
                 mLastBrushPoint = targetPoint;
             }
             sourcePoint = targetPoint;
-            mScribbleArea->refreshBitmap(rect, rad);
-            mScribbleArea->paintBitmapBuffer();
         }
+        updateCanvas(rect, rad);
     }
     else // liquify smooth
     {
@@ -337,8 +343,18 @@ void SmudgeTool::drawStroke()
                 mLastBrushPoint = targetPoint;
             }
             sourcePoint = targetPoint;
-            mScribbleArea->refreshBitmap(rect, rad);
-            mScribbleArea->paintBitmapBuffer();
         }
+        updateCanvas(rect, rad);
+    }
+}
+
+// The dabs smudge the key frame in place, the canvas is redrawn once for all of them
+void SmudgeTool::updateCanvas(const QRect& rect, int rad)
+{
+    if (rect.isEmpty())
+    {
+        return;
     }
+    QRect updatedRect = mEditor->view()->mapCanvasToScreen(QRectF(rect).adjusted(-rad, -rad, rad, rad)).toAlignedRect();
+    mScribbleArea->paintBitmapBufferRect(updatedRect);
 }
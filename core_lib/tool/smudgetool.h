@@ -44,6 +44,8 @@ public:
     void setPressure( const bool pressure );
 
 private:
+    void updateCanvas(const QRect& rect, int rad);
+
     QPointF mLastBrushPoint;
 };
 
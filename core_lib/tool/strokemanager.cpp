@@ -24,10 +24,27 @@
 #include <QDebug>
 #include <QLineF>
 #include <QPainterPath>
+#include <QtMath>
 #include "strokemanager.h"
 #include "object.h"
 
 
+namespace
+{
+const qreal RESAMPLE_STEP = 2.0; // pixels
+
+// Uniform Catmull-Rom, from p1 at t = 0 to p2 at t = 1
+QPointF catmullRom( QPointF p0, QPointF p1, QPointF p2, QPointF p3, qreal t )
+{
+    qreal t2 = t * t;
+    qreal t3 = t2 * t;
+    return 0.5 * ( 2 * p1
+                   + ( p2 - p0 ) * t
+                   + ( 2 * p0 - 5 * p1 + 4 * p2 - p3 ) * t2
+                   + ( 3 * p1 - p0 - 3 * p2 + p3 ) * t3 );
+}
+}
+
 StrokeManager::StrokeManager()
 {
     m_timeshot = 0;
@@ -37,7 +54,6 @@ StrokeManager::StrokeManager()
     mMeanPressure = 0;
 
     reset();
-    connect(&timer, &QTimer::timeout, this, &StrokeManager::interpolatePollAndPaint);
 }
 
 void StrokeManager::reset()
@@ -45,9 +61,10 @@ void StrokeManager::reset()
     mStrokeStarted = false;
     pressureQueue.clear();
     strokeQueue.clear();
+    mSplineSamples.clear();
+    mSplineSegment = 0;
     pressure = 0.0f;
     hasTangent = false;
-    timer.stop();
     mInpolLevel = -1;
 }
 
@@ -89,6 +106,11 @@ void StrokeManager::mousePressEvent(QMouseEvent* event)
     mLastPixel = getEventPosition( event );
     mCurrentPixel = getEventPosition( event );
 
+    StrokeSample sample;
+    sample.pos = mCurrentPixel;
+    sample.pressure = mTabletPressure;
+    mSplineSamples.append( sample );
+
     mStrokeStarted = true;
 
 }
@@ -120,8 +142,11 @@ void StrokeManager::setInpolLevel(int level)
 
 void StrokeManager::mouseMoveEvent(QMouseEvent* event)
 {
-    QPointF pos = getEventPosition(event);
+    moveTo( getEventPosition( event ) );
+}
 
+void StrokeManager::moveTo(QPointF pos)
+{
     // only applied to drawing tools.
     if (mInpolLevel != -1){
         smoothMousePos(pos);
@@ -134,6 +159,59 @@ void StrokeManager::mouseMoveEvent(QMouseEvent* event)
     }
 }
 
+void StrokeManager::queueMoveEvent(QMouseEvent* event)
+{
+    StrokeSample sample;
+    sample.pos = getEventPosition( event );
+    sample.pressure = mTabletPressure;
+
+    // A pen held still keeps reporting, only its pressure changes
+    if ( !mSplineSamples.isEmpty() && mSplineSamples.last().pos == sample.pos )
+    {
+        if ( mSplineSamples.size() > mSplineSegment + 1 )
+        {
+            mSplineSamples.last().pressure = sample.pressure;
+            return;
+        }
+    }
+    mSplineSamples.append( sample );
+}
+
+QList<StrokeSample> StrokeManager::takeResampledMoves()
+{
+    QList<StrokeSample> result;
+
+    // The segment to the newest sample is taken right away, with the tangent
+    // it has if the stroke ends there. It may bend a little at that sample
+    // once the next one is known, the position stays continuous.
+    const int last = mSplineSamples.size() - 1;
+    for ( ; mSplineSegment < last; ++mSplineSegment )
+    {
+        const StrokeSample& s0 = mSplineSamples.at( qMax( mSplineSegment - 1, 0 ) );
+        const StrokeSample& s1 = mSplineSamples.at( mSplineSegment );
+        const StrokeSample& s2 = mSplineSamples.at( mSplineSegment + 1 );
+        const StrokeSample& s3 = mSplineSamples.at( qMin( mSplineSegment + 2, last ) );
+
+        int steps = qMax( 1, qCeil( QLineF( s1.pos, s2.pos ).length() / RESAMPLE_STEP ) );
+        for ( int i = 1; i <= steps; ++i )
+        {
+            qreal t = qreal( i ) / steps;
+            StrokeSample sample;
+            sample.pos = catmullRom( s0.pos, s1.pos, s2.pos, s3.pos, t );
+            sample.pressure = s1.pressure + ( s2.pressure - s1.pressure ) * t;
+            result.append( sample );
+        }
+    }
+
+    // The sample before the next segment is all that is needed of the past
+    if ( mSplineSegment > 1 )
+    {
+        mSplineSamples.erase( mSplineSamples.begin(), mSplineSamples.begin() + ( mSplineSegment - 1 ) );
+        mSplineSegment = 1;
+    }
+    return result;
+}
+
 void StrokeManager::smoothMousePos(QPointF pos)
 {
 
@@ -163,6 +241,7 @@ void StrokeManager::smoothMousePos(QPointF pos)
         strokeQueue.push_back( smoothPos );
     } else if (mInpolLevel == 2 ) {
 
+        pollElapsed();
         smoothPos = QPointF( ( pos.x() + mLastInterpolated.x() ) / 2.0, ( pos.y() + mLastInterpolated.y() ) / 2.0 );
 
         mLastInterpolated = mCurrentPixel;
@@ -216,10 +295,6 @@ QPointF StrokeManager::interpolateStart(QPointF firstPoint)
 
             // last interpolated stroke should always be firstPoint
             mLastInterpolated = firstPoint;
-
-            // draw and poll each millisecond
-            timer.setInterval(sampleSize);
-            timer.start();
         } else if (mInpolLevel == 0) {
             // Clear queue
             strokeQueue.clear();
@@ -239,13 +314,24 @@ void StrokeManager::interpolatePoll()
     strokeQueue.enqueue(mLastInterpolated);
 }
 
-void StrokeManager::interpolatePollAndPaint()
+// Catches up with the samples the mean interpolation would have taken every
+// POLL_INTERVAL since the last time, there is no need to poll while idle
+void StrokeManager::pollElapsed()
 {
-    //qDebug() <<"inpol:" << mInpolLevel << "strokes"<< strokeQueue;
-    if (!strokeQueue.isEmpty())
+    if ( mInpolLevel != 2 || strokeQueue.isEmpty() )
+    {
+        return;
+    }
+
+    int polls = ( mSingleshotTime.elapsed() - previousTime ) / POLL_INTERVAL;
+    previousTime += polls * POLL_INTERVAL;
+
+    // After as many polls as the queue is long, more change nothing
+    polls = qMin( polls, strokeQueue.size() );
+    for ( int i = 0; i < polls; i++ )
     {
         interpolatePoll();
-        interpolateStroke();
+        meanInpolOp( QList<QPointF>(), 0, 0, 0 );
     }
 }
 
@@ -265,6 +351,7 @@ QList<QPointF> StrokeManager::interpolateStroke()
     }
     else if (mInpolLevel == 2){
 
+        pollElapsed();
         result = meanInpolOp(result, x, y, pressure);
 
     } else if (mInpolLevel == 0) {
@@ -377,8 +464,6 @@ QList<QPointF> StrokeManager::meanInpolOp(QList<QPointF> points, qreal x, qreal
 
 void StrokeManager::interpolateEnd()
 {
-    // Stop timer
-    timer.stop();
     if (mInpolLevel == 2) {
         if (!strokeQueue.isEmpty())
         {
@@ -24,11 +24,17 @@ GNU General Public License for more details.
 #include <QPoint>
 #include <time.h>
 #include <QTabletEvent>
-#include <QTimer>
 #include <QTime>
 #include "object.h"
 #include "assert.h"
 
+// A position of the pen, as reported or resampled from the reports
+struct StrokeSample
+{
+    QPointF pos;        // in scribble area pixels
+    qreal   pressure = 1.0;
+};
+
 class StrokeManager : public QObject
 {
 public:
@@ -38,6 +44,13 @@ public:
     void mousePressEvent(QMouseEvent* event);
     void mouseMoveEvent(QMouseEvent* event);
     void mouseReleaseEvent(QMouseEvent* event);
+    void moveTo(QPointF pos); // as a mouse move to pos
+
+    // The moves of a stroke can be queued as they come, and taken once per
+    // frame: a Catmull-Rom spline through them, sampled every couple of pixels
+    void queueMoveEvent(QMouseEvent* event);
+    bool hasQueuedMoves() const { return mSplineSamples.size() > mSplineSegment + 1; }
+    QList<StrokeSample> takeResampledMoves();
     void setPressure(float pressure);
     void setInpolLevel(int level);
 
@@ -48,7 +61,6 @@ public:
     QList<QPointF> interpolateStroke();
     void interpolatePoll();
     QPointF interpolateStart(QPointF firstPoint);
-    void interpolatePollAndPaint();
     void interpolateEnd();
     void smoothMousePos(QPointF pos);
     QList<QPointF> meanInpolOp( QList<QPointF> points, qreal x, qreal y, qreal pressure );
@@ -64,8 +76,10 @@ public:
 private:
 
     static const int STROKE_QUEUE_LENGTH = 3; // 4 points for cubic bezier
+    static const int POLL_INTERVAL = 5; // ms, between the samples of the mean interpolation
 
     void reset();
+    void pollElapsed();
 
     QPointF getEventPosition(QMouseEvent *);
 
@@ -73,7 +87,9 @@ private:
     QQueue<QPointF> strokeQueue;
     QQueue<qreal> pressureQueue;
 
-    QTimer timer;
+    // The last resampled segment and the queued samples after it
+    QList<StrokeSample> mSplineSamples;
+    int mSplineSegment = 0; // first sample of the segments not resampled yet
 
     QTime mSingleshotTime;
     QPointF mLastPressPixel2 = { 0, 0 };
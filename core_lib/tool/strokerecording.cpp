@@ -0,0 +1,336 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "strokerecording.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QMouseEvent>
+#include <QTabletEvent>
+#include "editor.h"
+#include "scribblearea.h"
+#include "layer.h"
+#include "layermanager.h"
+#include "toolmanager.h"
+#include "colormanager.h"
+#include "viewmanager.h"
+
+
+namespace
+{
+const int RECORDING_VERSION = 1;
+
+QJsonObject propertiesToJson( const Properties& p )
+{
+    QJsonObject o;
+    o[ "width" ] = p.width;
+    o[ "feather" ] = p.feather;
+    o[ "pressure" ] = p.pressure;
+    o[ "invisibility" ] = p.invisibility;
+    o[ "preserveAlpha" ] = p.preserveAlpha;
+    o[ "vectorMerge" ] = p.vectorMergeEnabled;
+    o[ "bezier" ] = p.bezier_state;
+    o[ "useFeather" ] = p.useFeather;
+    o[ "useAA" ] = p.useAA;
+    o[ "inpolLevel" ] = p.inpolLevel;
+    o[ "tolerance" ] = p.tolerance;
+    o[ "useFillContour" ] = p.useFillContour;
+    return o;
+}
+
+Properties propertiesFromJson( const QJsonObject& o )
+{
+    Properties p;
+    p.width = o[ "width" ].toDouble( p.width );
+    p.feather = o[ "feather" ].toDouble( p.feather );
+    p.pressure = o[ "pressure" ].toBool( p.pressure );
+    p.invisibility = o[ "invisibility" ].toInt( p.invisibility );
+    p.preserveAlpha = o[ "preserveAlpha" ].toInt( p.preserveAlpha );
+    p.vectorMergeEnabled = o[ "vectorMerge" ].toBool( p.vectorMergeEnabled );
+    p.bezier_state = o[ "bezier" ].toBool( p.bezier_state );
+    p.useFeather = o[ "useFeather" ].toBool( p.useFeather );
+    p.useAA = o[ "useAA" ].toInt( p.useAA );
+    p.inpolLevel = o[ "inpolLevel" ].toInt( p.inpolLevel );
+    p.tolerance = o[ "tolerance" ].toDouble( p.tolerance );
+    p.useFillContour = o[ "useFillContour" ].toBool( p.useFillContour );
+    return p;
+}
+
+bool isTabletEvent( QEvent::Type type )
+{
+    return type == QEvent::TabletPress || type == QEvent::TabletMove || type == QEvent::TabletRelease;
+}
+
+bool isMouseEvent( QEvent::Type type )
+{
+    return type == QEvent::MouseButtonPress || type == QEvent::MouseMove || type == QEvent::MouseButtonRelease;
+}
+
+// Events are arrays rather than objects, recordings of long sessions get large
+const int EVENT_FIELD_COUNT = 10;
+
+QJsonArray eventToJson( const RecordedInputEvent& e )
+{
+    return QJsonArray{ e.type, double( e.time ), e.pos.x(), e.pos.y(), e.pressure,
+                       e.button, e.buttons, e.modifiers, e.device, e.pointerType };
+}
+
+// False if the array isn't a mouse or tablet press, move or release,
+// the replay would send anything else to the scribble area as a mouse event
+bool eventFromJson( const QJsonArray& a, RecordedInputEvent& e )
+{
+    if ( a.size() < EVENT_FIELD_COUNT )
+    {
+        return false;
+    }
+    QEvent::Type type = static_cast< QEvent::Type >( a[ 0 ].toInt() );
+    if ( !isTabletEvent( type ) && !isMouseEvent( type ) )
+    {
+        return false;
+    }
+
+    e.type = type;
+    e.time = qint64( a[ 1 ].toDouble() );
+    e.pos = QPointF( a[ 2 ].toDouble(), a[ 3 ].toDouble() );
+    e.pressure = a[ 4 ].toDouble();
+    e.button = a[ 5 ].toInt();
+    e.buttons = a[ 6 ].toInt();
+    e.modifiers = a[ 7 ].toInt();
+    e.device = a[ 8 ].toInt();
+    e.pointerType = a[ 9 ].toInt();
+    return true;
+}
+}
+
+
+int StrokeRecording::eventCount() const
+{
+    int count = 0;
+    for ( const RecordedStroke& stroke : strokes )
+    {
+        count += stroke.events.size();
+    }
+    return count;
+}
+
+Status StrokeRecording::save( const QString& fileName ) const
+{
+    QJsonArray strokeArray;
+    for ( const RecordedStroke& stroke : strokes )
+    {
+        QJsonObject s;
+        s[ "tool" ] = int( stroke.tool );
+        s[ "properties" ] = propertiesToJson( stroke.properties );
+        s[ "colour" ] = stroke.colour.name( QColor::HexArgb );
+        s[ "layerType" ] = stroke.layerType;
+        s[ "view" ] = QJsonObject{ { "x", stroke.viewTranslation.x() },
+                                   { "y", stroke.viewTranslation.y() },
+                                   { "rotation", stroke.viewRotation },
+                                   { "scale", stroke.viewScale },
+                                   { "flipHorizontal", stroke.isFlipHorizontal },
+                                   { "flipVertical", stroke.isFlipVertical },
+                                   { "width", stroke.canvasSize.width() },
+                                   { "height", stroke.canvasSize.height() } };
+
+        QJsonArray eventArray;
+        for ( const RecordedInputEvent& e : stroke.events )
+        {
+            eventArray.append( eventToJson( e ) );
+        }
+        s[ "events" ] = eventArray;
+        strokeArray.append( s );
+    }
+
+    QJsonObject root;
+    root[ "version" ] = RECORDING_VERSION;
+    root[ "strokes" ] = strokeArray;
+
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        return Status( Status::ERROR_FILE_CANNOT_OPEN, QStringList( fileName ) );
+    }
+    QByteArray data = QJsonDocument( root ).toJson( QJsonDocument::Compact );
+    if ( file.write( data ) != data.size() || !file.flush() )
+    {
+        return Status( Status::FAIL, QStringList( fileName ) << file.errorString() );
+    }
+    return Status::OK;
+}
+
+Status StrokeRecording::load( const QString& fileName )
+{
+    QFile file( fileName );
+    if ( !file.exists() )
+    {
+        return Status( Status::FILE_NOT_FOUND, QStringList( fileName ) );
+    }
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        return Status( Status::ERROR_FILE_CANNOT_OPEN, QStringList( fileName ) );
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson( file.readAll(), &error );
+    QJsonObject root = document.object();
+    if ( error.error != QJsonParseError::NoError || root[ "version" ].toInt() != RECORDING_VERSION )
+    {
+        return Status( Status::NOT_SUPPORTED, QStringList( fileName ) << error.errorString() );
+    }
+
+    QList< RecordedStroke > loadedStrokes;
+    QJsonArray strokeArray = root[ "strokes" ].toArray();
+    for ( int i = 0; i < strokeArray.size(); ++i )
+    {
+        QJsonObject s = strokeArray[ i ].toObject();
+        QJsonObject view = s[ "view" ].toObject();
+
+        RecordedStroke stroke;
+        stroke.tool = static_cast< ToolType >( s[ "tool" ].toInt() );
+        stroke.properties = propertiesFromJson( s[ "properties" ].toObject() );
+        stroke.colour = QColor( s[ "colour" ].toString() );
+        stroke.layerType = s[ "layerType" ].toInt();
+        stroke.viewTranslation = QPointF( view[ "x" ].toDouble(), view[ "y" ].toDouble() );
+        stroke.viewRotation = view[ "rotation" ].toDouble();
+        stroke.viewScale = view[ "scale" ].toDouble( 1.0 );
+        stroke.isFlipHorizontal = view[ "flipHorizontal" ].toBool();
+        stroke.isFlipVertical = view[ "flipVertical" ].toBool();
+        stroke.canvasSize = QSize( view[ "width" ].toInt(), view[ "height" ].toInt() );
+
+        for ( const QJsonValue& eventValue : s[ "events" ].toArray() )
+        {
+            RecordedInputEvent e;
+            if ( !eventFromJson( eventValue.toArray(), e ) )
+            {
+                return Status( Status::ERROR_INVALID_PENCIL_FILE, QStringList( fileName )
+                               << QString( "Invalid event %1 in stroke %2" ).arg( stroke.events.size() ).arg( i ) );
+            }
+            stroke.events.append( e );
+        }
+
+        if ( stroke.tool > INVALID_TOOL && stroke.tool < TOOL_TYPE_COUNT && !stroke.events.isEmpty() )
+        {
+            loadedStrokes.append( stroke );
+        }
+    }
+    strokes = loadedStrokes;
+    return Status::OK;
+}
+
+
+StrokeRecorder::StrokeRecorder( Editor* editor, ScribbleArea* scribbleArea, QObject* parent ) : QObject( parent )
+{
+    mEditor = editor;
+    mScribbleArea = scribbleArea;
+}
+
+StrokeRecorder::~StrokeRecorder()
+{
+    stop();
+}
+
+void StrokeRecorder::start()
+{
+    stop();
+
+    mRecording = StrokeRecording();
+    mIsInStroke = false;
+    mIsRecording = true;
+    mClock.start();
+    mScribbleArea->installEventFilter( this );
+}
+
+void StrokeRecorder::stop()
+{
+    if ( mIsRecording )
+    {
+        mScribbleArea->removeEventFilter( this );
+        mIsRecording = false;
+    }
+}
+
+bool StrokeRecorder::eventFilter( QObject* watched, QEvent* event )
+{
+    QEvent::Type type = event->type();
+    if ( watched != mScribbleArea || !( isTabletEvent( type ) || isMouseEvent( type ) ) )
+    {
+        return false;
+    }
+
+    // Hovering doesn't draw, only strokes are kept
+    if ( !mIsInStroke )
+    {
+        if ( type != QEvent::TabletPress && type != QEvent::MouseButtonPress )
+        {
+            return false;
+        }
+        beginStroke();
+    }
+
+    RecordedInputEvent e;
+    e.type = type;
+    e.time = mClock.nsecsElapsed() / 1000;
+    if ( isTabletEvent( type ) )
+    {
+        QTabletEvent* tabletEvent = static_cast< QTabletEvent* >( event );
+        e.pos = tabletEvent->posF();
+        e.pressure = tabletEvent->pressure();
+        e.button = tabletEvent->button();
+        e.buttons = tabletEvent->buttons();
+        e.modifiers = tabletEvent->modifiers();
+        e.device = tabletEvent->device();
+        e.pointerType = tabletEvent->pointerType();
+    }
+    else
+    {
+        QMouseEvent* mouseEvent = static_cast< QMouseEvent* >( event );
+        e.pos = mouseEvent->localPos();
+        e.button = mouseEvent->button();
+        e.buttons = mouseEvent->buttons();
+        e.modifiers = mouseEvent->modifiers();
+    }
+    mRecording.strokes.last().events.append( e );
+
+    if ( type == QEvent::MouseButtonRelease )
+    {
+        mIsInStroke = false;
+    }
+    return false;
+}
+
+void StrokeRecorder::beginStroke()
+{
+    BaseTool* tool = mEditor->tools()->currentTool();
+    ViewManager* view = mEditor->view();
+    Layer* layer = mEditor->layers()->currentLayer();
+
+    RecordedStroke stroke;
+    stroke.tool = tool->type();
+    stroke.properties = tool->properties;
+    stroke.colour = mEditor->color()->frontColor();
+    stroke.layerType = ( layer != nullptr ) ? layer->type() : 0;
+    stroke.viewTranslation = view->translation();
+    stroke.viewRotation = view->rotation();
+    stroke.viewScale = view->scaling();
+    stroke.isFlipHorizontal = view->isFlipHorizontal();
+    stroke.isFlipVertical = view->isFlipVertical();
+    stroke.canvasSize = mScribbleArea->size();
+
+    mRecording.strokes.append( stroke );
+    mIsInStroke = true;
+}
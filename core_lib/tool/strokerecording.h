@@ -0,0 +1,109 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef STROKERECORDING_H
+#define STROKERECORDING_H
+
+#include <QObject>
+#include <QList>
+#include <QPointF>
+#include <QColor>
+#include <QSize>
+#include <QElapsedTimer>
+#include "basetool.h"
+#include "pencilerror.h"
+
+class QEvent;
+class Editor;
+class ScribbleArea;
+
+
+// A mouse or tablet event, as the scribble area received it
+struct RecordedInputEvent
+{
+    int     type = 0;           // QEvent::Type
+    qint64  time = 0;           // microseconds since the recording started
+    QPointF pos;                // in scribble area coordinates
+    qreal   pressure = 1.0;
+    int     button = Qt::NoButton;
+    int     buttons = Qt::NoButton;
+    int     modifiers = Qt::NoModifier;
+    int     device = 0;         // QTabletEvent::TabletDevice, tablet events only
+    int     pointerType = 0;    // QTabletEvent::PointerType, tablet events only
+};
+
+// The events from a press to its release, and what they were drawn with
+struct RecordedStroke
+{
+    ToolType   tool = PENCIL;
+    Properties properties;
+    QColor     colour;
+    int        layerType = 0;   // Layer::LAYER_TYPE
+
+    QPointF    viewTranslation;
+    float      viewRotation = 0.f;
+    float      viewScale = 1.f;
+    bool       isFlipHorizontal = false;
+    bool       isFlipVertical = false;
+    QSize      canvasSize;
+
+    QList< RecordedInputEvent > events;
+};
+
+struct StrokeRecording
+{
+    QList< RecordedStroke > strokes;
+
+    int eventCount() const;
+
+    Status save( const QString& fileName ) const;
+    Status load( const QString& fileName );
+};
+
+
+// Records the strokes drawn on the scribble area, for StrokeReplayer.
+// Mouse and tablet events are captured with an event filter, so what is
+// recorded is exactly what ScribbleArea gets, before StrokeManager sees it.
+class StrokeRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    StrokeRecorder( Editor* editor, ScribbleArea* scribbleArea, QObject* parent = 0 );
+    virtual ~StrokeRecorder();
+
+    void start();
+    void stop();
+    bool isRecording() const { return mIsRecording; }
+
+    const StrokeRecording& recording() const { return mRecording; }
+
+protected:
+    bool eventFilter( QObject* watched, QEvent* event ) override;
+
+private:
+    void beginStroke();
+
+    Editor* mEditor = nullptr;
+    ScribbleArea* mScribbleArea = nullptr;
+
+    StrokeRecording mRecording;
+    QElapsedTimer mClock;
+    bool mIsRecording = false;
+    bool mIsInStroke = false;
+};
+
+#endif // STROKERECORDING_H
@@ -0,0 +1,203 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "strokereplayer.h"
+
+#include <algorithm>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMouseEvent>
+#include <QTabletEvent>
+#include <QResizeEvent>
+#include "strokerecording.h"
+#include "editor.h"
+#include "scribblearea.h"
+#include "layer.h"
+#include "layermanager.h"
+#include "toolmanager.h"
+#include "colormanager.h"
+#include "viewmanager.h"
+#include "tracer.h"
+
+
+qint64 StrokeReplayReport::latencyPercentile( qreal percent ) const
+{
+    if ( latencies.empty() )
+    {
+        return 0;
+    }
+    std::vector< qint64 > sorted = latencies;
+    std::sort( sorted.begin(), sorted.end() );
+    size_t index = static_cast< size_t >( percent / 100 * ( sorted.size() - 1 ) + 0.5 );
+    return sorted[ std::min( index, sorted.size() - 1 ) ];
+}
+
+qreal StrokeReplayReport::dabsPerSecond() const
+{
+    return ( totalTime > 0 ) ? dabCount * 1000000.0 / totalTime : 0;
+}
+
+QString StrokeReplayReport::summary() const
+{
+    QStringList lines;
+    lines << QObject::tr( "Replayed %1 strokes, %2 events in %3 ms" )
+             .arg( strokeCount ).arg( eventCount ).arg( totalTime / 1000.0, 0, 'f', 1 );
+    if ( skippedStrokeCount > 0 )
+    {
+        lines << QObject::tr( "Skipped %1 strokes recorded on another kind of layer" ).arg( skippedStrokeCount );
+    }
+    lines << QObject::tr( "Latency per event: median %1 ms, 95% %2 ms, max %3 ms" )
+             .arg( latencyPercentile( 50 ) / 1000.0, 0, 'f', 2 )
+             .arg( latencyPercentile( 95 ) / 1000.0, 0, 'f', 2 )
+             .arg( latencyPercentile( 100 ) / 1000.0, 0, 'f', 2 );
+    lines << QObject::tr( "Brush dabs: %1, %2 per second" ).arg( dabCount ).arg( dabsPerSecond(), 0, 'f', 0 );
+    return lines.join( '\n' );
+}
+
+
+StrokeReplayer::StrokeReplayer( Editor* editor, ScribbleArea* scribbleArea )
+{
+    mEditor = editor;
+    mScribbleArea = scribbleArea;
+}
+
+Status StrokeReplayer::replay( const StrokeRecording& recording, StrokeReplayReport& report )
+{
+    TRACE_SCOPE( "StrokeReplayer::replay" );
+
+    report = StrokeReplayReport();
+    report.latencies.reserve( recording.eventCount() );
+
+    for ( const RecordedStroke& stroke : recording.strokes )
+    {
+        Layer* layer = mEditor->layers()->currentLayer();
+        if ( layer == nullptr || layer->type() != stroke.layerType || !layer->mVisible )
+        {
+            report.skippedStrokeCount++;
+            continue;
+        }
+
+        // Headless, take the size of the recording. Otherwise keep the
+        // canvas where it is on screen and move the events instead.
+        QSize size = mScribbleArea->size();
+        if ( !mScribbleArea->isVisible() && stroke.canvasSize.isValid() && stroke.canvasSize != size )
+        {
+            mScribbleArea->resize( stroke.canvasSize );
+            QResizeEvent resizeEvent( stroke.canvasSize, size );
+            QCoreApplication::sendEvent( mScribbleArea, &resizeEvent );
+            size = stroke.canvasSize;
+        }
+        QPointF offset;
+        if ( stroke.canvasSize.isValid() )
+        {
+            offset = QPointF( size.width() - stroke.canvasSize.width(), size.height() - stroke.canvasSize.height() ) / 2;
+        }
+
+        applySettings( stroke );
+
+        int dabsBefore = mScribbleArea->dabCount();
+        qint64 startTime = stroke.events.first().time;
+        QElapsedTimer strokeClock;
+        strokeClock.start();
+
+        for ( const RecordedInputEvent& e : stroke.events )
+        {
+            while ( mIsRealTime && strokeClock.nsecsElapsed() / 1000 < e.time - startTime )
+            {
+                QCoreApplication::processEvents( QEventLoop::AllEvents, 1 );
+            }
+
+            QElapsedTimer eventClock;
+            eventClock.start();
+
+            sendEvent( e, offset );
+            // Along with the repaints and timers the event caused
+            QCoreApplication::processEvents( QEventLoop::ExcludeUserInputEvents );
+
+            qint64 latency = eventClock.nsecsElapsed() / 1000;
+            report.latencies.push_back( latency );
+            report.totalTime += latency;
+        }
+
+        report.dabCount += mScribbleArea->dabCount() - dabsBefore;
+        report.eventCount += stroke.events.size();
+        report.strokeCount++;
+    }
+
+    if ( report.strokeCount == 0 && report.skippedStrokeCount > 0 )
+    {
+        return Status( Status::ERROR_INVALID_LAYER_TYPE, QStringList(),
+                       QObject::tr( "Nothing replayed" ),
+                       QObject::tr( "The strokes were recorded on another kind of layer than the current one." ) );
+    }
+    return Status::OK;
+}
+
+void StrokeReplayer::applySettings( const RecordedStroke& stroke )
+{
+    ToolManager* tools = mEditor->tools();
+    tools->setCurrentTool( stroke.tool );
+
+    // Through the tool manager so that the tool options follow,
+    // skipping what the tool doesn't have
+    const Properties& p = stroke.properties;
+    if ( p.width >= 0 ) tools->setWidth( p.width );
+    if ( p.feather >= 0 ) tools->setFeather( p.feather );
+    if ( p.invisibility >= 0 ) tools->setInvisibility( p.invisibility > 0 );
+    if ( p.preserveAlpha >= 0 ) tools->setPreserveAlpha( p.preserveAlpha > 0 );
+    if ( p.useAA >= 0 ) tools->setAA( p.useAA );
+    if ( p.inpolLevel >= 0 ) tools->setInpolLevel( p.inpolLevel );
+    if ( p.tolerance >= 0 ) tools->setTolerance( int( p.tolerance ) );
+    tools->setPressure( p.pressure );
+    tools->currentTool()->properties = p;
+
+    if ( stroke.colour.isValid() )
+    {
+        mEditor->color()->setColor( stroke.colour );
+    }
+
+    ViewManager* view = mEditor->view();
+    view->resetView();
+    view->flipHorizontal( stroke.isFlipHorizontal );
+    view->flipVertical( stroke.isFlipVertical );
+    view->scale( stroke.viewScale );
+    view->rotate( stroke.viewRotation );
+    view->translate( stroke.viewTranslation );
+}
+
+void StrokeReplayer::sendEvent( const RecordedInputEvent& e, QPointF offset )
+{
+    QEvent::Type type = static_cast< QEvent::Type >( e.type );
+    QPointF pos = e.pos + offset;
+    Qt::MouseButton button = static_cast< Qt::MouseButton >( e.button );
+    Qt::MouseButtons buttons = Qt::MouseButtons( QFlag( e.buttons ) );
+    Qt::KeyboardModifiers modifiers = Qt::KeyboardModifiers( QFlag( e.modifiers ) );
+
+    if ( type == QEvent::TabletPress || type == QEvent::TabletMove || type == QEvent::TabletRelease )
+    {
+        QPointF globalPos = mScribbleArea->mapToGlobal( QPoint( 0, 0 ) ) + pos;
+        QTabletEvent event( type, pos, globalPos, e.device, e.pointerType, e.pressure,
+                            0, 0, 0, 0, 0, modifiers, 0, button, buttons );
+        QCoreApplication::sendEvent( mScribbleArea, &event );
+    }
+    else
+    {
+        // Tablet events are ignored by the scribble area, the mouse events
+        // Qt made of them were recorded right after
+        QMouseEvent event( type, pos, button, buttons, modifiers );
+        QCoreApplication::sendEvent( mScribbleArea, &event );
+    }
+}
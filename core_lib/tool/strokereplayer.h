@@ -0,0 +1,73 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef STROKEREPLAYER_H
+#define STROKEREPLAYER_H
+
+#include <vector>
+#include <QString>
+#include <QPointF>
+#include "pencilerror.h"
+
+class Editor;
+class ScribbleArea;
+struct StrokeRecording;
+struct RecordedStroke;
+struct RecordedInputEvent;
+
+
+struct StrokeReplayReport
+{
+    int    strokeCount = 0;
+    int    skippedStrokeCount = 0; // recorded on another kind of layer
+    int    eventCount = 0;
+    int    dabCount = 0;
+    qint64 totalTime = 0;          // microseconds spent handling the events
+
+    // Microseconds from sending each event until the application was idle again
+    std::vector< qint64 > latencies;
+
+    qint64  latencyPercentile( qreal percent ) const;
+    qreal   dabsPerSecond() const;
+    QString summary() const;
+};
+
+// Replays a StrokeRecording on the current layer and frame: the recorded tool
+// settings are restored and the events sent to the scribble area, which goes
+// through StrokeManager and the tools as if they came from the mouse or tablet.
+//
+// By default the events are sent as fast as they are handled, to time them.
+// The scribble area doesn't need to be shown, replays run headless too.
+class StrokeReplayer
+{
+public:
+    StrokeReplayer( Editor* editor, ScribbleArea* scribbleArea );
+
+    // Waits for the time the events were recorded at, instead of replaying at full speed
+    void setRealTime( bool b ) { mIsRealTime = b; }
+
+    Status replay( const StrokeRecording& recording, StrokeReplayReport& report );
+
+private:
+    void applySettings( const RecordedStroke& stroke );
+    void sendEvent( const RecordedInputEvent& e, QPointF offset );
+
+    Editor* mEditor = nullptr;
+    ScribbleArea* mScribbleArea = nullptr;
+    bool mIsRealTime = false;
+};
+
+#endif // STROKEREPLAYER_H
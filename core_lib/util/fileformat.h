@@ -25,9 +25,13 @@ GNU General Public License for more details.
 #define PFF_OLD_BIG_LETTER_EXTENSION	"PCL"
 #define PFF_EXTENSION				    ".pclx"
 #define PFF_BIG_LETTER_EXTENSION	    "PCLX"
+#define PFF_BINARY_EXTENSION        ".pclb"
 
-#define PFF_OPEN_ALL_FILE_FILTER	QObject::tr( "All Pencil Files PCLX & PCL(*.pclx *.pcl);;Pencil Animation File PCLX(*.pclx);;Old Pencil Animation File PCL(*.pcl);;Any files (*)" )
-#define PFF_SAVE_ALL_FILE_FILTER	QObject::tr( "Pencil Animation File PCLX(*.pclx);;Old Pencil Animation File PCL(*.pcl)" )
+#define PFF_OPEN_ALL_FILE_FILTER	QObject::tr( "All Pencil Files PCLX & PCL & PCLB(*.pclx *.pcl *.pclb);;Pencil Animation File PCLX(*.pclx);;Old Pencil Animation File PCL(*.pcl);;Binary Pencil Animation File PCLB(*.pclb);;Any files (*)" )
+#define PFF_SAVE_ALL_FILE_FILTER	QObject::tr( "Pencil Animation File PCLX(*.pclx);;Old Pencil Animation File PCL(*.pcl);;Binary Pencil Animation File PCLB(*.pclb)" )
+
+#define PFF_INPUT_RECORDING_EXTENSION   ".pinput"
+#define PFF_INPUT_RECORDING_FILTER      QObject::tr( "Pencil2D Input Recording (*.pinput)" )
 
 
 #define PFF_OLD_DATA_DIR 		"data"
@@ -36,6 +40,8 @@ GNU General Public License for more details.
 #define PFF_TMP_COMPRESS_EXT 	".Y2xC"
 #define PFF_TMP_DECOMPRESS_EXT 	".Y2xD"
 #define PFF_PALETTE_FILE        "palette.xml"
+#define PFF_SCRATCH_FILE        "keyframes.swap"
+#define PFF_FILMSTRIP_FILE      "thumbnails/filmstrip.png"
 
 
 bool removePFFTmpDirectory (const QString& dirName);
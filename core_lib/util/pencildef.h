@@ -164,6 +164,12 @@ enum BackgroundStyle
 #define SETTING_DRAW_LABEL          "DrawLabel"
 #define SETTING_QUICK_SIZING        "QuickSizing"
 #define SETTING_LAYOUT_LOCK         "LayoutLock"
+#define SETTING_PERFORMANCE_HUD     "PerformanceHud"
+#define SETTING_BITMAP_MEMORY_LIMIT "BitmapMemoryLimit"
+#define SETTING_TIMELINE_THUMBNAILS "TimelineThumbnails"
+#define SETTING_EMBED_THUMBNAILS    "EmbedThumbnails"
+#define SETTING_EYEDROPPER_SAMPLE_SIZE "EyedropperSampleSize"
+#define SETTING_EYEDROPPER_ALL_LAYERS  "EyedropperAllLayers"
 
 #define SETTING_ANTIALIAS        "Antialiasing"
 #define SETTING_SHOW_GRID        "ShowGrid"
@@ -0,0 +1,132 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#include "tracer.h"
+
+#include <QFile>
+#include <QThread>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QCoreApplication>
+
+static const size_t TRACE_BUFFER_SIZE = 64 * 1024;
+
+
+Tracer* Tracer::instance()
+{
+    static Tracer tracer;
+    return &tracer;
+}
+
+Tracer::Tracer()
+{
+    mClock.start();
+}
+
+void Tracer::setEnabled( bool b )
+{
+    QMutexLocker locker( &mMutex );
+    if ( b && mSamples.empty() )
+    {
+        mSamples.resize( TRACE_BUFFER_SIZE );
+    }
+    mEnabled = b;
+}
+
+void Tracer::addSample( const char* name, qint64 startUs, qint64 durationUs )
+{
+    qint64 threadId = static_cast< qint64 >( reinterpret_cast< quintptr >( QThread::currentThreadId() ) );
+
+    QMutexLocker locker( &mMutex );
+    if ( mSamples.empty() )
+    {
+        return;
+    }
+
+    mSamples[ mNextSample ] = TraceSample{ name, startUs, durationUs, threadId };
+
+    mNextSample += 1;
+    if ( mNextSample == mSamples.size() )
+    {
+        mNextSample = 0;
+        mIsFull = true;
+    }
+}
+
+void Tracer::clear()
+{
+    QMutexLocker locker( &mMutex );
+    mNextSample = 0;
+    mIsFull = false;
+}
+
+std::vector< TraceSample > Tracer::samples() const
+{
+    QMutexLocker locker( &mMutex );
+
+    std::vector< TraceSample > result;
+    if ( mIsFull )
+    {
+        result.insert( result.end(), mSamples.begin() + mNextSample, mSamples.end() );
+    }
+    result.insert( result.end(), mSamples.begin(), mSamples.begin() + mNextSample );
+    return result;
+}
+
+Status Tracer::exportChromeTrace( const QString& filePath ) const
+{
+    QJsonArray events;
+    for ( const TraceSample& sample : samples() )
+    {
+        QJsonObject event;
+        event[ "name" ] = QString::fromLatin1( sample.name );
+        event[ "ph" ] = QStringLiteral( "X" ); // complete event, with a duration
+        event[ "ts" ] = static_cast< double >( sample.startUs );
+        event[ "dur" ] = static_cast< double >( sample.durationUs );
+        event[ "pid" ] = static_cast< double >( QCoreApplication::applicationPid() );
+        event[ "tid" ] = static_cast< double >( sample.threadId );
+        events.append( event );
+    }
+
+    QJsonObject root;
+    root[ "traceEvents" ] = events;
+    root[ "displayTimeUnit" ] = QStringLiteral( "ms" );
+
+    QFile file( filePath );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        return Status( Status::ERROR_FILE_CANNOT_OPEN, QStringList() << "Tracer::exportChromeTrace" << filePath );
+    }
+    file.write( QJsonDocument( root ).toJson( QJsonDocument::Compact ) );
+    return Status::OK;
+}
+
+
+ScopedTrace::ScopedTrace( const char* name ) : mName( name )
+{
+    Tracer* tracer = Tracer::instance();
+    mStartUs = tracer->isEnabled() ? tracer->now() : -1;
+}
+
+ScopedTrace::~ScopedTrace()
+{
+    if ( mStartUs >= 0 )
+    {
+        Tracer* tracer = Tracer::instance();
+        tracer->addSample( mName, mStartUs, tracer->now() - mStartUs );
+    }
+}
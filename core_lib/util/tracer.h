@@ -0,0 +1,83 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <vector>
+#include <QMutex>
+#include <QElapsedTimer>
+#include "pencilerror.h"
+
+
+struct TraceSample
+{
+    const char* name; // a string literal, never freed
+    qint64 startUs;
+    qint64 durationUs;
+    qint64 threadId;
+};
+
+// Collects timings of the hot paths into a fixed size ring buffer,
+// which can be saved in the Chrome trace-event format (chrome://tracing).
+// Disabled by default, a disabled tracer costs one bool test per scope.
+class Tracer
+{
+public:
+    static Tracer* instance();
+
+    void setEnabled( bool b );
+    bool isEnabled() const { return mEnabled.load( std::memory_order_relaxed ); }
+
+    qint64 now() const { return mClock.nsecsElapsed() / 1000; }
+    void addSample( const char* name, qint64 startUs, qint64 durationUs );
+    void clear();
+
+    std::vector< TraceSample > samples() const; // oldest first
+    Status exportChromeTrace( const QString& filePath ) const;
+
+private:
+    Tracer();
+
+    std::atomic< bool > mEnabled { false }; // read without the lock by every traced scope
+    QElapsedTimer mClock;
+
+    mutable QMutex mMutex;
+    std::vector< TraceSample > mSamples;
+    size_t mNextSample = 0;
+    bool mIsFull = false;
+};
+
+
+class ScopedTrace
+{
+public:
+    explicit ScopedTrace( const char* name );
+    ~ScopedTrace();
+
+private:
+    const char* mName;
+    qint64 mStartUs;
+};
+
+#define TRACE_CONCAT_( a, b ) a##b
+#define TRACE_CONCAT( a, b ) TRACE_CONCAT_( a, b )
+
+// Times the rest of the enclosing scope
+#define TRACE_SCOPE( name ) ScopedTrace TRACE_CONCAT( traceScope_, __LINE__ )( name )
+
+#endif // TRACER_H
@@ -9,7 +9,9 @@ SUBDIRS = \ # sub-project names
     quazip \
     core_lib \
     app \
-    tests
+    render \
+    tests \
+    benchmarks
 
 # build the project sequentially as listed in SUBDIRS !
 CONFIG += ordered
@@ -19,14 +21,18 @@ zlib.subdir     = 3rdlib/zlib
 quazip.subdir   = 3rdlib/quazip
 core_lib.subdir = core_lib
 app.subdir      = app
+render.subdir   = render
 tests.subdir    = tests
+benchmarks.subdir = benchmarks
 #l10n.subdir     = translations
 
 # what subproject depends on others
 quazip.depends   = zlib
 core_lib.depends = quazip
 app.depends      = core_lib
+render.depends   = core_lib
 tests.depends    = core_lib
+benchmarks.depends = core_lib
 
 TRANSLATIONS += translations/pencil.ts \
                 translations/Language.cs.ts \
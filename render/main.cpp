@@ -0,0 +1,240 @@
+/*
+
+Pencil - Traditional Animation Software
+Copyright (C) 2012-2017 Matthew Chiawen Chang
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+*/
+
+// pencil2d-render renders image sequences of pencil projects without a display:
+//
+//   pencil2d-render -o out/shot --frames 1-48 --format png,jpg shot.pclx
+//   pencil2d-render -o out --camera Close --scale 0.5 --list projects.txt
+
+#include <iostream>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QMutex>
+#include "batchrenderer.h"
+#include "tracer.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+
+namespace
+{
+QString tr( const char* text )
+{
+    return QCoreApplication::translate( "pencil2d-render", text );
+}
+
+// "12" "1-48" or "10-" (up to the last key frame)
+bool parseFrameRange( const QString& text, int& startFrame, int& endFrame )
+{
+    QStringList parts = text.split( '-' );
+    bool ok = false;
+    startFrame = parts[ 0 ].toInt( &ok );
+    if ( !ok || parts.size() > 2 )
+    {
+        return false;
+    }
+    if ( parts.size() == 1 )
+    {
+        endFrame = startFrame;
+        return true;
+    }
+    if ( parts[ 1 ].isEmpty() )
+    {
+        endFrame = -1;
+        return true;
+    }
+    endFrame = parts[ 1 ].toInt( &ok );
+    return ok && endFrame >= startFrame;
+}
+
+QStringList readProjectList( const QString& listPath )
+{
+    QStringList projects;
+    QFile file( listPath );
+    if ( file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        QTextStream stream( &file );
+        while ( !stream.atEnd() )
+        {
+            QString line = stream.readLine().trimmed();
+            if ( !line.isEmpty() && !line.startsWith( '#' ) )
+            {
+                projects << line;
+            }
+        }
+    }
+    return projects;
+}
+}
+
+
+int main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+    app.setOrganizationName( "Pencil2D" );
+    app.setOrganizationDomain( "pencil2d.org" );
+    app.setApplicationName( "Pencil2D" );
+    app.setApplicationVersion( APP_VERSION );
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription( tr( "Renders Pencil2D projects to image sequences, without a display." ) );
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument( "projects", tr( "Pencil2D projects to render." ), "[projects...]" );
+
+    QCommandLineOption listOption( "list", tr( "Also render the projects listed in <file>, one path per line." ), "file" );
+    QCommandLineOption outputOption( QStringList() << "o" << "output",
+                                     tr( "Prefix of the output frames, or the output folder when rendering several projects." ), "path" );
+    QCommandLineOption framesOption( "frames", tr( "Frames to render, e.g. 1-48, 12 or 10- (default: all)." ), "range" );
+    QCommandLineOption cameraOption( "camera", tr( "Name of the camera layer to render from (default: the first one)." ), "name" );
+    QCommandLineOption scaleOption( "scale", tr( "Scale of the frames relative to the camera size (default: 1)." ), "factor", "1" );
+    QCommandLineOption widthOption( "width", tr( "Width of the output frames, overrides the scale." ), "integer" );
+    QCommandLineOption heightOption( "height", tr( "Height of the output frames, overrides the scale." ), "integer" );
+    QCommandLineOption formatOption( "format", tr( "Comma separated image formats: png, jpg, tif or bmp (default: png)." ), "formats", "png" );
+    QCommandLineOption transparencyOption( "transparency", tr( "Render transparency when the format allows it." ) );
+    QCommandLineOption threadsOption( "threads", tr( "Number of render threads (default: one per core)." ), "integer" );
+    QCommandLineOption traceOption( "trace", tr( "Record rendering timings and save them to <trace_path> (Chrome trace format)." ), "trace_path" );
+
+    parser.addOption( listOption );
+    parser.addOption( outputOption );
+    parser.addOption( framesOption );
+    parser.addOption( cameraOption );
+    parser.addOption( scaleOption );
+    parser.addOption( widthOption );
+    parser.addOption( heightOption );
+    parser.addOption( formatOption );
+    parser.addOption( transparencyOption );
+    parser.addOption( threadsOption );
+    parser.addOption( traceOption );
+    parser.process( app );
+
+    QStringList projects = parser.positionalArguments();
+    if ( parser.isSet( listOption ) )
+    {
+        projects << readProjectList( parser.value( listOption ) );
+    }
+    if ( projects.isEmpty() )
+    {
+        cerr << qPrintable( tr( "Error: No input file specified." ) ) << endl;
+        return 1;
+    }
+    if ( !parser.isSet( outputOption ) )
+    {
+        cerr << qPrintable( tr( "Error: No output path specified." ) ) << endl;
+        return 1;
+    }
+
+    BatchRenderJob settings;
+    if ( parser.isSet( framesOption ) && !parseFrameRange( parser.value( framesOption ), settings.startFrame, settings.endFrame ) )
+    {
+        cerr << qPrintable( tr( "Error: invalid frame range '%1'." ).arg( parser.value( framesOption ) ) ) << endl;
+        return 1;
+    }
+
+    bool ok = false;
+    settings.scale = parser.value( scaleOption ).toDouble( &ok );
+    if ( !ok || settings.scale <= 0 )
+    {
+        cerr << qPrintable( tr( "Error: invalid scale '%1'." ).arg( parser.value( scaleOption ) ) ) << endl;
+        return 1;
+    }
+    if ( parser.isSet( widthOption ) || parser.isSet( heightOption ) )
+    {
+        settings.exportSize = QSize( parser.value( widthOption ).toInt(), parser.value( heightOption ).toInt() );
+        if ( settings.exportSize.isEmpty() )
+        {
+            cerr << qPrintable( tr( "Error: --width and --height must both be positive integers." ) ) << endl;
+            return 1;
+        }
+    }
+
+    settings.formats.clear();
+    for ( QString format : parser.value( formatOption ).split( ',', QString::SkipEmptyParts ) )
+    {
+        format = format.trimmed().toUpper();
+        if ( format == "JPEG" ) format = "JPG";
+        if ( format == "TIFF" ) format = "TIF";
+        if ( !QStringList{ "PNG", "JPG", "TIF", "BMP" }.contains( format ) )
+        {
+            cerr << qPrintable( tr( "Error: unsupported format '%1'." ).arg( format ) ) << endl;
+            return 1;
+        }
+        settings.formats << format;
+    }
+
+    settings.cameraName = parser.value( cameraOption );
+    settings.transparency = parser.isSet( transparencyOption );
+
+    // One project renders to the output prefix, several go to a folder, named after each project
+    QString outputPath = parser.value( outputOption );
+    std::vector< BatchRenderJob > jobs;
+    for ( const QString& project : projects )
+    {
+        BatchRenderJob job = settings;
+        job.projectPath = project;
+        job.outputPath = outputPath;
+        if ( projects.size() > 1 )
+        {
+            QDir().mkpath( outputPath );
+            job.outputPath = QDir( outputPath ).filePath( QFileInfo( project ).completeBaseName() + "_" );
+        }
+        jobs.push_back( job );
+    }
+
+    BatchRenderer renderer;
+    if ( parser.isSet( threadsOption ) )
+    {
+        renderer.setThreadCount( parser.value( threadsOption ).toInt() );
+    }
+
+    QString tracePath = parser.value( traceOption );
+    Tracer::instance()->setEnabled( !tracePath.isEmpty() );
+
+    cout << qPrintable( tr( "Rendering %1 project(s) on %2 thread(s)..." ).arg( jobs.size() ).arg( renderer.threadCount() ) ) << endl;
+
+    QMutex outputMutex;
+    Status st = renderer.run( jobs, [&outputMutex]( int done, int total )
+    {
+        QMutexLocker locker( &outputMutex );
+        cout << "\r" << done << " / " << total << std::flush;
+    } );
+    cout << endl;
+
+    if ( !tracePath.isEmpty() && !Tracer::instance()->exportChromeTrace( tracePath ).ok() )
+    {
+        cerr << qPrintable( tr( "Error: cannot write the trace to '%1'" ).arg( tracePath ) ) << endl;
+    }
+
+    if ( !st.ok() )
+    {
+        cerr << qPrintable( st.title() ) << endl;
+        for ( const QString& detail : st.detailsList() )
+        {
+            cerr << "  " << qPrintable( detail ) << endl;
+        }
+        return 1;
+    }
+
+    cout << qPrintable( tr( "Done." ) ) << endl;
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "test_beziercurve.h"
+#include "beziercurve.h"
+
+namespace
+{
+// origin (0,0), then vertices at (10,0), (20,0) and (30,0)
+BezierCurve createLine()
+{
+    BezierCurve curve( QList< QPointF >() << QPointF( 0, 0 ) << QPointF( 10, 0 ) << QPointF( 20, 0 ) << QPointF( 30, 0 ) );
+    for ( int i = 0; i < curve.getVertexSize(); i++ )
+    {
+        curve.setC1( i, QPointF( 10 * i + 3, 1 ) );
+        curve.setC2( i, QPointF( 10 * i + 7, -1 ) );
+    }
+    return curve;
+}
+}
+
+void TestBezierCurve::testAppendCubic()
+{
+    BezierCurve curve = createLine();
+
+    QCOMPARE( curve.getVertexSize(), 3 );
+    QCOMPARE( curve.getOrigin(), QPointF( 0, 0 ) );
+    QCOMPARE( curve.getVertex( -1 ), QPointF( 0, 0 ) );
+    QCOMPARE( curve.getC1( 1 ), QPointF( 13, 1 ) );
+    QCOMPARE( curve.getC2( 1 ), QPointF( 17, -1 ) );
+    QCOMPARE( curve.getVertex( 2 ), QPointF( 30, 0 ) );
+
+    // a section is its start vertex, c1, c2 and end vertex
+    const float* section = curve.getSection( 1 );
+    QCOMPARE( section[ 0 ], 10.f );
+    QCOMPARE( section[ 2 ], 13.f );
+    QCOMPARE( section[ 4 ], 17.f );
+    QCOMPARE( section[ 6 ], 20.f );
+}
+
+void TestBezierCurve::testRemoveVertex()
+{
+    BezierCurve first = createLine();
+    first.removeVertex( -1 );
+    QCOMPARE( first.getVertexSize(), 2 );
+    QCOMPARE( first.getOrigin(), QPointF( 10, 0 ) );
+    QCOMPARE( first.getC1( 0 ), QPointF( 13, 1 ) );
+
+    // the sections around a middle vertex are merged
+    BezierCurve middle = createLine();
+    middle.removeVertex( 0 );
+    QCOMPARE( middle.getVertexSize(), 2 );
+    QCOMPARE( middle.getC1( 0 ), QPointF( 3, 1 ) );
+    QCOMPARE( middle.getC2( 0 ), QPointF( 17, -1 ) );
+    QCOMPARE( middle.getVertex( 0 ), QPointF( 20, 0 ) );
+
+    BezierCurve last = createLine();
+    last.removeVertex( 2 );
+    QCOMPARE( last.getVertexSize(), 2 );
+    QCOMPARE( last.getVertex( 1 ), QPointF( 20, 0 ) );
+}
+
+void TestBezierCurve::testAddPoint()
+{
+    BezierCurve curve = createLine();
+    QPointF middle = curve.getPointOnCubic( 1, 0.5 );
+
+    curve.addPoint( 1, 0.5 );
+    QCOMPARE( curve.getVertexSize(), 4 );
+    QCOMPARE( curve.getVertex( 1 ), middle );
+    QCOMPARE( curve.getVertex( 0 ), QPointF( 10, 0 ) );
+    QCOMPARE( curve.getVertex( 2 ), QPointF( 20, 0 ) );
+    QCOMPARE( curve.getVertex( 3 ), QPointF( 30, 0 ) );
+}
+
+void TestBezierCurve::testSelectionSummary()
+{
+    BezierCurve curve = createLine();
+    QVERIFY( !curve.isPartlySelected() );
+    QVERIFY( !curve.isSelected() );
+
+    curve.setSelected( 1, true );
+    curve.setSelected( 1, true );
+    QVERIFY( curve.isPartlySelected() );
+    QVERIFY( !curve.isSelected() );
+
+    curve.removeVertex( 1 );
+    QVERIFY( !curve.isPartlySelected() );
+
+    curve.setSelected( true );
+    QVERIFY( curve.isSelected() );
+    curve.addPoint( 0, 0.5 );
+    QVERIFY( curve.isSelected() );
+
+    curve.setSelected( -1, false );
+    QVERIFY( curve.isPartlySelected() );
+    QVERIFY( !curve.isSelected() );
+}
+
+void TestBezierCurve::testSampleCubic()
+{
+    BezierCurve curve = createLine();
+
+    qreal xs[ BezierCurve::CUBIC_STEPS + 1 ];
+    qreal ys[ BezierCurve::CUBIC_STEPS + 1 ];
+    curve.sampleCubic( 2, xs, ys );
+
+    QCOMPARE( QPointF( xs[ 0 ], ys[ 0 ] ), curve.getVertex( 1 ) );
+    QCOMPARE( QPointF( xs[ BezierCurve::CUBIC_STEPS ], ys[ BezierCurve::CUBIC_STEPS ] ), curve.getVertex( 2 ) );
+    for ( int k = 0; k <= BezierCurve::CUBIC_STEPS; k++ )
+    {
+        QPointF p = curve.getPointOnCubic( 2, qreal( k ) / BezierCurve::CUBIC_STEPS );
+        QVERIFY( qAbs( p.x() - xs[ k ] ) < 1e-9 );
+        QVERIFY( qAbs( p.y() - ys[ k ] ) < 1e-9 );
+    }
+}
+
+void TestBezierCurve::testBinaryRoundTrip()
+{
+    BezierCurve curve = createLine();
+    curve.setColourNumber( 3 );
+
+    QByteArray data;
+    QDataStream out( &data, QIODevice::WriteOnly );
+    curve.writeBinary( out );
+
+    BezierCurve loaded;
+    QDataStream in( data );
+    loaded.readBinary( in );
+
+    QCOMPARE( loaded.getColourNumber(), 3 );
+    QCOMPARE( loaded.getVertexSize(), curve.getVertexSize() );
+    for ( int i = 0; i < curve.getVertexSize(); i++ )
+    {
+        QCOMPARE( loaded.getC1( i ), curve.getC1( i ) );
+        QCOMPARE( loaded.getC2( i ), curve.getC2( i ) );
+        QCOMPARE( loaded.getVertex( i ), curve.getVertex( i ) );
+        QCOMPARE( loaded.getPressure( i + 1 ), curve.getPressure( i + 1 ) );
+    }
+    QVERIFY( !loaded.isPartlySelected() );
+}
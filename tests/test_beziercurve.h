@@ -0,0 +1,20 @@
+#ifndef TESTBEZIERCURVE_H
+#define TESTBEZIERCURVE_H
+
+#include "AutoTest.h"
+
+class TestBezierCurve : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testAppendCubic();
+    void testRemoveVertex();
+    void testAddPoint();
+    void testSelectionSummary();
+    void testSampleCubic();
+    void testBinaryRoundTrip();
+};
+
+DECLARE_TEST( TestBezierCurve );
+
+#endif // TESTBEZIERCURVE_H
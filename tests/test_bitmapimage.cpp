@@ -1,5 +1,9 @@
 #include "test_bitmapimage.h"
 #include "bitmapimage.h"
+#include "bitmapresidency.h"
+#include "colorsampler.h"
+#include "smudgekernel.h"
+#include "strokerasterizer.h"
 
 void TestBitmapImage::initTestCase()
 {
@@ -38,3 +42,202 @@ void TestBitmapImage::testInitWithColorAndBoundary()
     QCOMPARE( b->width(), 30 );
     QCOMPARE( b->height(), 40 );
 }
+
+void TestBitmapImage::testPageOutAndIn()
+{
+    BitmapResidency* residency = BitmapResidency::instance();
+    residency->setScratchDir( QDir::tempPath() + "/Pencil2D/TestBitmapImage" );
+
+    BitmapImage b( QRect( 10, 20, 30, 40 ), Qt::red );
+    b.setPixel( 15, 25, qRgba( 0, 0, 255, 255 ) );
+
+    QVERIFY( residency->pageOut( &b ) );
+    QVERIFY( QFile::exists( residency->scratchFilePath() ) );
+    QCOMPARE( residency->stats().pagedOutBytes, qint64( 30 * 40 * 4 ) );
+    QCOMPARE( b.width(), 30 );
+
+    // Any access brings the image back
+    QCOMPARE( b.pixel( 15, 25 ), qRgba( 0, 0, 255, 255 ) );
+    QCOMPARE( b.pixel( 11, 21 ), QColor( Qt::red ).rgba() );
+    QCOMPARE( b.image()->size(), QSize( 30, 40 ) );
+    QCOMPARE( residency->stats().pagedOutCount, 0 );
+    QVERIFY( !QFile::exists( residency->scratchFilePath() ) );
+}
+
+void TestBitmapImage::testMipmapUpdate()
+{
+    BitmapImage b( QRect( 0, 0, 8, 8 ), Qt::transparent );
+
+    QCOMPARE( b.mipmap( 1.0 ).size(), QSize( 8, 8 ) );
+    QCOMPARE( b.mipmap( 0.5 ).size(), QSize( 4, 4 ) );
+    QCOMPARE( b.mipmap( 0.3 ).size(), QSize( 4, 4 ) );
+    QCOMPARE( b.mipmap( 0.25 ).size(), QSize( 2, 2 ) );
+    QCOMPARE( b.mipmap( 0.001 ).size(), QSize( 1, 1 ) );
+
+    // Changing a 2x2 block only resamples that block in every level
+    const QRgb red = qRgba( 255, 0, 0, 255 );
+    b.setPixel( 0, 0, red );
+    b.setPixel( 1, 0, red );
+    b.setPixel( 0, 1, red );
+    b.setPixel( 1, 1, red );
+
+    QImage level1 = b.mipmap( 0.5 );
+    QCOMPARE( reinterpret_cast< const QRgb* >( level1.constScanLine( 0 ) )[ 0 ], red );
+    QCOMPARE( reinterpret_cast< const QRgb* >( level1.constScanLine( 0 ) )[ 1 ], qRgba( 0, 0, 0, 0 ) );
+
+    QImage level2 = b.mipmap( 0.25 );
+    QCOMPARE( reinterpret_cast< const QRgb* >( level2.constScanLine( 0 ) )[ 0 ], qRgba( 64, 0, 0, 64 ) );
+}
+
+void TestBitmapImage::testSmudgePullsPixels()
+{
+    // Opaque red on the left half, transparent on the right
+    BitmapImage b( QRect( 0, 0, 16, 16 ), Qt::transparent );
+    b.drawRect( QRectF( 0, 0, 8, 16 ), Qt::NoPen, QBrush( Qt::red ), QPainter::CompositionMode_Source, false );
+    const QRect bounds = b.bounds();
+    const QRgb red = qRgba( 255, 0, 0, 255 );
+
+    SmudgeDab dab;
+    dab.from = QPointF( 6, 8 );
+    dab.to = QPointF( 10, 8 );
+    dab.radius = 3;
+    dab.strength = 1.0;
+    dab.softness = 0;
+    dab.isDisplacementWeighted = false;
+    b.smudge( dab );
+
+    // Inside the dab the pixels come from 4 pixels to the left
+    QCOMPARE( b.pixel( 10, 8 ), red );
+    QCOMPARE( b.pixel( 11, 8 ), red );
+    QCOMPARE( b.pixel( 12, 8 ), qRgba( 0, 0, 0, 0 ) );
+    // Outside of it nothing changes
+    QCOMPARE( b.pixel( 10, 12 ), qRgba( 0, 0, 0, 0 ) );
+    QCOMPARE( b.pixel( 5, 8 ), red );
+    QCOMPARE( b.bounds(), bounds );
+
+    // The image grows to the dab
+    BitmapImage c( QRect( 0, 0, 4, 4 ), Qt::transparent );
+    dab.from = QPointF( 8, 8 );
+    dab.to = QPointF( 8, 8 );
+    c.smudge( dab );
+    QVERIFY( c.bounds().contains( QRect( 5, 5, 6, 6 ) ) );
+}
+
+void TestBitmapImage::testSmudgeWeight()
+{
+    BitmapImage b( QRect( 0, 0, 16, 16 ), Qt::transparent );
+    b.drawRect( QRectF( 0, 0, 8, 16 ), Qt::NoPen, QBrush( Qt::red ), QPainter::CompositionMode_Source, false );
+
+    // Half strength blends half of the pulled pixel in
+    SmudgeDab dab;
+    dab.from = QPointF( 6, 8 );
+    dab.to = QPointF( 10, 8 );
+    dab.radius = 3;
+    dab.strength = 0.5;
+    dab.isDisplacementWeighted = false;
+    b.smudge( dab );
+    QCOMPARE( b.pixel( 10, 8 ), qRgba( 127, 0, 0, 127 ) );
+
+    // Liquify only moves a half weighted pixel half of the way: 9 is
+    // sampled at 7.25, three quarters red, and blended in by half
+    BitmapImage c( QRect( 0, 0, 16, 16 ), Qt::transparent );
+    c.drawRect( QRectF( 0, 0, 8, 16 ), Qt::NoPen, QBrush( Qt::red ), QPainter::CompositionMode_Source, false );
+    dab.from = QPointF( 6.5, 8 );
+    dab.isDisplacementWeighted = true;
+    c.smudge( dab );
+    QCOMPARE( c.pixel( 9, 8 ), qRgba( 95, 0, 0, 95 ) );
+    QCOMPARE( c.pixel( 10, 8 ), qRgba( 0, 0, 0, 0 ) );
+}
+
+void TestBitmapImage::testStrokeRasterizerAcrossTiles()
+{
+    // Dabs on tile corners, left and above the origin too, drawn
+    // the same as when they are drawn straight into the buffer
+    QList< StrokeDab > dabs;
+    for ( int i = 0; i < 12; ++i )
+    {
+        QPointF centre( -70 + i * 13.3, -20 + i * 7.1 );
+        StrokeDab dab;
+        dab.rect = QRectF( centre - QPointF( 9, 9 ), QSizeF( 18, 18 ) );
+        if ( i % 2 == 0 )
+        {
+            QRadialGradient gradient( centre, 9 );
+            gradient.setColorAt( 0.0, QColor( 0, 0, 255, 120 ) );
+            gradient.setColorAt( 1.0, QColor( 0, 0, 255, 0 ) );
+            dab.brush = gradient;
+            dab.mode = QPainter::CompositionMode_SourceOver;
+        }
+        else
+        {
+            dab.brush = QBrush( Qt::red );
+            dab.mode = QPainter::CompositionMode_Source;
+            dab.isAntialiased = true;
+        }
+        dabs.append( dab );
+    }
+
+    StrokeRasterizer rasterizer;
+    BitmapImage buffer;
+    for ( int i = 0; i < dabs.size(); ++i )
+    {
+        rasterizer.queueDab( dabs[ i ] );
+        if ( i % 5 == 0 )
+        {
+            rasterizer.submit();
+        }
+    }
+    QRect drawnRect = rasterizer.finish( &buffer );
+
+    BitmapImage expected;
+    for ( const StrokeDab& dab : dabs )
+    {
+        expected.drawEllipse( dab.rect, Qt::NoPen, dab.brush, dab.mode, dab.isAntialiased );
+    }
+
+    QVERIFY( !drawnRect.isEmpty() );
+    QRect comparedRect = drawnRect | expected.bounds();
+    for ( int y = comparedRect.top(); y <= comparedRect.bottom(); ++y )
+    {
+        for ( int x = comparedRect.left(); x <= comparedRect.right(); ++x )
+        {
+            QCOMPARE( buffer.pixel( x, y ), expected.pixel( x, y ) );
+        }
+    }
+
+    // Nothing is left over for the next stroke
+    rasterizer.clear();
+    BitmapImage next;
+    QVERIFY( rasterizer.finish( &next ).isEmpty() );
+}
+
+void TestBitmapImage::testColorSamplerAverage()
+{
+    // Left half opaque red, right half transparent
+    QImage image( 8, 8, QImage::Format_ARGB32_Premultiplied );
+    image.fill( Qt::transparent );
+    QPainter painter( &image );
+    painter.fillRect( QRect( 0, 0, 4, 8 ), Qt::red );
+    painter.end();
+
+    QCOMPARE( ColorSampler::average( image, QPoint( 1, 1 ), 1 ), qRgba( 255, 0, 0, 255 ) );
+    QCOMPARE( ColorSampler::average( image, QPoint( 5, 1 ), 1 ), qRgba( 0, 0, 0, 0 ) );
+
+    // 3 x 3 across the edge, one column in three is red
+    QCOMPARE( ColorSampler::average( image, QPoint( 4, 4 ), 3 ), qRgba( 85, 0, 0, 85 ) );
+
+    // Only the pixels inside the image count
+    QCOMPARE( ColorSampler::average( image, QPoint( 0, 0 ), 5 ), qRgba( 255, 0, 0, 255 ) );
+    QCOMPARE( ColorSampler::average( image, QPoint( -10, 0 ), 5 ), qRgba( 0, 0, 0, 0 ) );
+
+    // The widest rows don't carry into the next channel
+    QImage white( 300, 2, QImage::Format_ARGB32_Premultiplied );
+    white.fill( Qt::white );
+    QCOMPARE( ColorSampler::average( white, QPoint( 150, 1 ), ColorSampler::MAX_SIZE ), qRgba( 255, 255, 255, 255 ) );
+
+    // Straight alpha, as frames are when loaded from a PNG file
+    QImage straight( 2, 1, QImage::Format_ARGB32 );
+    straight.setPixel( 0, 0, qRgba( 255, 0, 0, 128 ) );
+    straight.setPixel( 1, 0, qRgba( 0, 0, 0, 0 ) );
+    QCOMPARE( ColorSampler::average( straight, QPoint( 0, 0 ), 1 ), qPremultiply( qRgba( 255, 0, 0, 128 ) ) );
+    QCOMPARE( ColorSampler::average( straight, QPoint( 1, 0 ), 3 ), qRgba( 64, 0, 0, 64 ) );
+}
@@ -13,6 +13,12 @@ private slots:
     void testInitImage();
     void testInitSize();
     void testInitWithColorAndBoundary();
+    void testPageOutAndIn();
+    void testMipmapUpdate();
+    void testSmudgePullsPixels();
+    void testSmudgeWeight();
+    void testStrokeRasterizerAcrossTiles();
+    void testColorSamplerAverage();
 };
 
 DECLARE_TEST( TestBitmapImage );
@@ -8,8 +8,18 @@
 #include "JlCompress.h"
 #include "fileformat.h"
 #include "filemanager.h"
+#include "binaryprojectfile.h"
+#include "projectsnapshot.h"
+#include "thumbnailcache.h"
 #include "util.h"
 #include "object.h"
+#include "layerbitmap.h"
+#include "bitmapimage.h"
+#include "layervector.h"
+#include "layersound.h"
+#include "soundclip.h"
+#include "vectorimage.h"
+#include "beziercurve.h"
 
 typedef std::shared_ptr< FileManager > FileManagerPtr;
 
@@ -272,3 +282,243 @@ void TestFileManager::testLoadPCLX()
     QVERIFY( layer->name() == "MyBitmapLayer" );
     QVERIFY( layer->id() == 5 );
 }
+
+void TestFileManager::testLoadPCLXWithoutExtracting()
+{
+    QTemporaryDir testDir( "PENCIL_TEST_XXXXXXXX" );
+    if ( !testDir.isValid() )
+    {
+        QFAIL( "bad." );
+    }
+
+    QFile theXML( testDir.path() + "/" + PFF_XML_FILE_NAME );
+    theXML.open( QIODevice::WriteOnly );
+
+    QTextStream fout( &theXML );
+    fout << "<!DOCTYPE PencilDocument><document>";
+    fout << "  <object>";
+    fout << "    <layer name='MyBitmapLayer' id='5' visibility='1' type='1' >";
+    fout << "      <image frame='1' topLeftY='20' src='005.001.png' topLeftX='10' />";
+    fout << "    </layer>";
+    fout << "  </object>";
+    fout << "</document>";
+    theXML.close();
+
+    QDir dir( testDir.path() );
+    dir.mkdir( PFF_DATA_DIR );
+    dir.cd( PFF_DATA_DIR );
+
+    QImage img( 16, 8, QImage::Format_ARGB32_Premultiplied );
+    img.fill( Qt::red );
+    img.save( dir.path() + "/005.001.png" );
+
+    QTemporaryFile tmpPCLX( "PENCIL_TEST_XXXXXXXX.pclx" );
+    tmpPCLX.open();
+    JlCompress::compressDir( tmpPCLX.fileName(), testDir.path() );
+
+    FileManager fm;
+    QScopedPointer< Object > o( fm.load( tmpPCLX.fileName() ) );
+    QVERIFY( fm.error().ok() );
+    QVERIFY( o->archive() == nullptr );
+
+    // nothing but the sound clips is written to the working folder
+    QVERIFY( !QFile::exists( QDir( o->workingDir() ).filePath( PFF_XML_FILE_NAME ) ) );
+    QVERIFY( !QFile::exists( QDir( o->dataDir() ).filePath( "005.001.png" ) ) );
+
+    // the bounds are known before the image is decoded
+    auto layer = static_cast< LayerBitmap* >( o->getLayer( 0 ) );
+    BitmapImage* bitmap = layer->getBitmapImageAtFrame( 1 );
+    QVERIFY( bitmap->hasEncodedImage() );
+    QCOMPARE( bitmap->bounds(), QRect( 10, 20, 16, 8 ) );
+
+    QCOMPARE( bitmap->image()->size(), QSize( 16, 8 ) );
+    QCOMPARE( bitmap->pixel( 10, 20 ), QColor( Qt::red ).rgba() );
+    QVERIFY( !bitmap->hasEncodedImage() );
+}
+
+void TestFileManager::testSaveLoadPCLB()
+{
+    QTemporaryDir testDir( "PENCIL_TEST_XXXXXXXX" );
+    if ( !testDir.isValid() )
+    {
+        QFAIL( "bad." );
+    }
+    QString fileName = testDir.path() + "/test" + PFF_BINARY_EXTENSION;
+    int curveSize = 0;
+
+    {
+        Object o;
+        o.init();
+
+        LayerBitmap* bitmapLayer = o.addNewBitmapLayer();
+        BitmapImage* bitmap = new BitmapImage( QRect( 10, 20, 300, 8 ), QColor( Qt::red ) );
+        bitmapLayer->addKeyFrame( 3, bitmap );
+
+        // straight alpha, as png-loaded frames are, must come back unrounded
+        QImage straight( 2, 1, QImage::Format_ARGB32 );
+        straight.setPixel( 0, 0, qRgba( 200, 100, 50, 77 ) );
+        straight.setPixel( 1, 0, qRgba( 1, 2, 3, 1 ) );
+        bitmapLayer->addKeyFrame( 4, new BitmapImage( QRect( 5, 6, 2, 1 ), straight ) );
+
+        LayerVector* vectorLayer = o.addNewVectorLayer();
+        VectorImage* vector = new VectorImage;
+        BezierCurve curve( QList< QPointF >() << QPointF( 0, 0 ) << QPointF( 10, 5 ) << QPointF( 20, 0 ) );
+        vector->addCurve( curve, 1.0, false );
+        vectorLayer->addKeyFrame( 2, vector );
+        curveSize = vector->getCurveSize( 0 );
+
+        FileManager fm;
+        QVERIFY( fm.save( &o, fileName ).ok() );
+    }
+    QVERIFY( BinaryProjectFile::isBinaryProject( fileName ) );
+
+    FileManager fm;
+    QScopedPointer< Object > o( fm.load( fileName ) );
+    QVERIFY( fm.error().ok() );
+    QCOMPARE( o->getLayerCount(), 5 );
+
+    auto bitmapLayer = static_cast< LayerBitmap* >( o->getLayer( 3 ) );
+    BitmapImage* bitmap = bitmapLayer->getBitmapImageAtFrame( 3 );
+    QVERIFY( bitmap != nullptr );
+    QCOMPARE( bitmap->bounds(), QRect( 10, 20, 300, 8 ) );
+    QCOMPARE( bitmap->pixel( 309, 27 ), QColor( Qt::red ).rgba() );
+    QCOMPARE( bitmap->image()->format(), QImage::Format_ARGB32_Premultiplied );
+
+    BitmapImage* straightBitmap = bitmapLayer->getBitmapImageAtFrame( 4 );
+    QVERIFY( straightBitmap != nullptr );
+    QCOMPARE( straightBitmap->image()->format(), QImage::Format_ARGB32 );
+    QCOMPARE( straightBitmap->pixel( 5, 6 ), qRgba( 200, 100, 50, 77 ) );
+    QCOMPARE( straightBitmap->pixel( 6, 6 ), qRgba( 1, 2, 3, 1 ) );
+
+    auto vectorLayer = static_cast< LayerVector* >( o->getLayer( 4 ) );
+    VectorImage* vector = vectorLayer->getVectorImageAtFrame( 2 );
+    QVERIFY( vector != nullptr );
+    QVERIFY( curveSize > 0 );
+    QCOMPARE( vector->getCurveSize( 0 ), curveSize );
+
+    // a sound clip that can't be read fails the save rather than going missing
+    {
+        Object o;
+        o.init();
+
+        SoundClip* clip = new SoundClip;
+        clip->setFileName( testDir.path() + "/missing.wav" );
+        o.addNewSoundLayer()->addKeyFrame( 1, clip );
+
+        FileManager fm;
+        Status st = fm.save( &o, testDir.path() + "/sound" + PFF_BINARY_EXTENSION );
+        QCOMPARE( st.code(), Status::ERROR_FILE_CANNOT_OPEN );
+        QVERIFY( st.details().contains( "missing.wav" ) );
+    }
+}
+
+void TestFileManager::testInlineVectorImage()
+{
+    QTemporaryFile tmpFile;
+    if ( !tmpFile.open() )
+    {
+        QFAIL( "temp file" );
+    }
+    QFile theXML( tmpFile.fileName() );
+    theXML.open( QIODevice::WriteOnly );
+
+    QTextStream fout( &theXML );
+    fout << "<!DOCTYPE PencilDocument><document>";
+    fout << "  <object>";
+    fout << "    <layer name='MyVectorLayer' id='7' visibility='1' type='2'>";
+    fout << "      <image frame='4'>";
+    fout << "        <curve width='2' feather='0' variableWidth='0' invisible='0' colourNumber='0'";
+    fout << "               originX='0' originY='0' originPressure='1'>";
+    fout << "          <segment c1x='1' c1y='1' c2x='2' c2y='2' vx='3' vy='3' pressure='1'/>";
+    fout << "          <segment c1x='4' c1y='4' c2x='5' c2y='5' vx='6' vy='6' pressure='1'/>";
+    fout << "        </curve>";
+    fout << "      </image>";
+    fout << "    </layer>";
+    fout << "    <layer name='MyBitmapLayer' id='8' visibility='0' type='1'></layer>";
+    fout << "  </object>";
+    fout << "</document>";
+    theXML.close();
+
+    FileManager fm;
+    QScopedPointer< Object > o( fm.load( theXML.fileName() ) );
+    QVERIFY( fm.error().ok() );
+    QCOMPARE( o->getLayerCount(), 2 );
+
+    auto layer = static_cast< LayerVector* >( o->getLayer( 0 ) );
+    QCOMPARE( layer->id(), 7 );
+    QCOMPARE( layer->name(), QString( "MyVectorLayer" ) );
+
+    VectorImage* vector = layer->getVectorImageAtFrame( 4 );
+    QVERIFY( vector != nullptr );
+    QCOMPARE( vector->getCurveSize( 0 ), 2 );
+
+    // the layer after the inline image is still read
+    QCOMPARE( o->getLayer( 1 )->id(), 8 );
+    QVERIFY( !o->getLayer( 1 )->visible() );
+}
+
+void TestFileManager::testSaveLoadPCLX()
+{
+    QTemporaryDir testDir( "PENCIL_TEST_XXXXXXXX" );
+    if ( !testDir.isValid() )
+    {
+        QFAIL( "bad." );
+    }
+    QString fileName = testDir.path() + "/test" + PFF_EXTENSION;
+
+    Object o;
+    o.init();
+    LayerBitmap* bitmapLayer = o.addNewBitmapLayer();
+    bitmapLayer->addKeyFrame( 2, new BitmapImage( QRect( 0, 0, 4, 4 ), QColor( Qt::blue ) ) );
+
+    // the snapshot keeps the pixels it was taken with
+    ProjectSnapshot snapshot;
+    FileManager fm;
+    QVERIFY( fm.createSnapshot( &o, snapshot ).ok() );
+    bitmapLayer->getBitmapImageAtFrame( 2 )->image()->fill( Qt::green );
+
+    QVERIFY( snapshot.writePCLX( fileName ).ok() );
+    QVERIFY( snapshot.writePCLX( fileName ).ok() ); // replaces the previous file
+
+    QScopedPointer< Object > loaded( fm.load( fileName ) );
+    QVERIFY( fm.error().ok() );
+    QCOMPARE( loaded->getLayerCount(), 4 );
+
+    auto layer = static_cast< LayerBitmap* >( loaded->getLayer( 3 ) );
+    QCOMPARE( layer->getBitmapImageAtFrame( 2 )->pixel( 1, 1 ), QColor( Qt::blue ).rgba() );
+}
+
+void TestFileManager::testFilmstripEntry()
+{
+    QTemporaryDir testDir( "PENCIL_TEST_XXXXXXXX" );
+    if ( !testDir.isValid() )
+    {
+        QFAIL( "bad." );
+    }
+    QString fileName = testDir.path() + "/test" + PFF_EXTENSION;
+
+    Object o;
+    o.init();
+    LayerBitmap* bitmapLayer = o.addNewBitmapLayer();
+    bitmapLayer->addKeyFrame( 1, new BitmapImage( QRect( 0, 0, 4, 4 ), QColor( Qt::blue ) ) );
+
+    QImage filmstrip( 64, 16, QImage::Format_ARGB32_Premultiplied );
+    filmstrip.fill( Qt::red );
+
+    ProjectSnapshot snapshot;
+    FileManager fm;
+    QVERIFY( fm.createSnapshot( &o, snapshot ).ok() );
+    snapshot.addImage( PFF_FILMSTRIP_FILE, filmstrip );
+    QVERIFY( snapshot.writePCLX( fileName ).ok() );
+
+    // read alone, without loading the project
+    QImage loadedFilmstrip = ThumbnailCache::readFilmstrip( fileName );
+    QCOMPARE( loadedFilmstrip.size(), QSize( 64, 16 ) );
+    QCOMPARE( loadedFilmstrip.pixel( 8, 8 ), QColor( Qt::red ).rgba() );
+
+    // and the project still loads as before
+    QScopedPointer< Object > loaded( fm.load( fileName ) );
+    QVERIFY( fm.error().ok() );
+    auto layer = static_cast< LayerBitmap* >( loaded->getLayer( 3 ) );
+    QCOMPARE( layer->getBitmapImageAtFrame( 1 )->pixel( 1, 1 ), QColor( Qt::blue ).rgba() );
+}
@@ -24,6 +24,11 @@ private slots:
 
     void testGeneratePCLX();
     void testLoadPCLX();
+    void testLoadPCLXWithoutExtracting();
+    void testSaveLoadPCLB();
+    void testInlineVectorImage();
+    void testSaveLoadPCLX();
+    void testFilmstripEntry();
 };
 
 DECLARE_TEST(TestFileManager)
@@ -5,6 +5,8 @@
 #include "layervector.h"
 #include "layercamera.h"
 #include "layersound.h"
+#include "soundclip.h"
+#include "soundtimeline.h"
 #include "object.h"
 #include "util.h"
 #include <memory>
@@ -195,3 +197,202 @@ void TestLayer::testNextKeyFramePosition()
     QCOMPARE( pLayer->getNextKeyFramePosition( 1 ), 5 );
     QCOMPARE( pLayer->getNextKeyFramePosition( 2 ), 5 );
 }
+
+void TestLayer::testExtendSelection()
+{
+    Layer* layer = m_pObject->addNewBitmapLayer();
+    OnScopeExit( m_pObject->deleteLayer( layer ) );
+
+    for ( int i = 2; i <= 1000; i += 2 )
+    {
+        layer->addNewEmptyKeyAt( i );
+    }
+
+    layer->setFrameSelected( 10, true );
+    layer->extendSelectionTo( 500 );
+    QCOMPARE( layer->isFrameSelected( 8 ), false );
+    QCOMPARE( layer->isFrameSelected( 10 ), true );
+    QCOMPARE( layer->isFrameSelected( 250 ), true );
+    QCOMPARE( layer->isFrameSelected( 500 ), true );
+    QCOMPARE( layer->isFrameSelected( 502 ), false );
+
+    layer->setFrameSelected( 250, false );
+    QCOMPARE( layer->isFrameSelected( 250 ), false );
+
+    layer->deselectAll();
+    QCOMPARE( layer->isFrameSelected( 10 ), false );
+    QCOMPARE( layer->isFrameSelected( 500 ), false );
+}
+
+void TestLayer::testMoveSelectedFrames()
+{
+    Layer* layer = m_pObject->addNewBitmapLayer();
+    OnScopeExit( m_pObject->deleteLayer( layer ) );
+
+    for ( int i = 2; i <= 5; ++i )
+    {
+        layer->addNewEmptyKeyAt( i );
+    }
+    KeyFrame* key2 = layer->getKeyFrameAt( 2 );
+    KeyFrame* key3 = layer->getKeyFrameAt( 3 );
+    KeyFrame* key4 = layer->getKeyFrameAt( 4 );
+
+    // 2 jumps over 3 and 4, which slide back by one
+    std::vector< KeyFrameMove > moves;
+    layer->setFrameSelected( 2, true );
+    QVERIFY( layer->moveSelectedFrames( 2, &moves ) );
+    QCOMPARE( layer->getKeyFrameAt( 2 ), key3 );
+    QCOMPARE( layer->getKeyFrameAt( 3 ), key4 );
+    QCOMPARE( layer->getKeyFrameAt( 4 ), key2 );
+    QCOMPARE( layer->isFrameSelected( 4 ), true );
+    QCOMPARE( static_cast< int >( moves.size() ), 3 );
+
+    // can't move before the first frame
+    QCOMPARE( layer->moveSelectedFrames( -4 ), false );
+
+    // undo
+    for ( KeyFrameMove& move : moves )
+    {
+        std::swap( move.fromPosition, move.toPosition );
+    }
+    QVERIFY( layer->applyKeyFrameMoves( moves ) );
+    QCOMPARE( layer->getKeyFrameAt( 2 ), key2 );
+    QCOMPARE( layer->getKeyFrameAt( 3 ), key3 );
+    QCOMPARE( layer->getKeyFrameAt( 4 ), key4 );
+    QCOMPARE( layer->isFrameSelected( 2 ), true );
+
+    // moving the first frame away leaves its slot empty, so the undo can put it back
+    layer->addNewEmptyKeyAt( 1 );
+    KeyFrame* key1 = layer->getKeyFrameAt( 1 );
+    for ( int i = 1; i <= 5; ++i )
+    {
+        layer->setFrameSelected( i, true );
+    }
+    moves.clear();
+    QVERIFY( layer->moveSelectedFrames( 3, &moves ) );
+    QCOMPARE( layer->keyExists( 1 ), false );
+    QCOMPARE( layer->getKeyFrameAt( 4 ), key1 );
+    QCOMPARE( static_cast< int >( moves.size() ), 5 );
+
+    for ( KeyFrameMove& move : moves )
+    {
+        std::swap( move.fromPosition, move.toPosition );
+    }
+    QVERIFY( layer->applyKeyFrameMoves( moves ) );
+    QCOMPARE( layer->getKeyFrameAt( 1 ), key1 );
+    QCOMPARE( layer->getKeyFrameAt( 2 ), key2 );
+    QCOMPARE( layer->keyExists( 6 ), false );
+}
+
+void TestLayer::testInsertAndRippleDelete()
+{
+    Layer* layer = m_pObject->addNewBitmapLayer();
+    OnScopeExit( m_pObject->deleteLayer( layer ) );
+
+    layer->addNewEmptyKeyAt( 5 );
+    layer->addNewEmptyKeyAt( 10 );
+
+    QVERIFY( layer->insertFrames( 5, 3 ) );
+    QCOMPARE( layer->keyExists( 1 ), true );
+    QCOMPARE( layer->keyExists( 5 ), false );
+    QCOMPARE( layer->keyExists( 8 ), true );
+    QCOMPARE( layer->keyExists( 13 ), true );
+
+    QVERIFY( layer->rippleDeleteFrames( 6, 4 ) );
+    QCOMPARE( layer->keyExists( 8 ), false );
+    QCOMPARE( layer->keyExists( 9 ), true );
+    QCOMPARE( layer->keyFrameCount(), 2 );
+    QCOMPARE( m_pObject->getMaxKeyFramePosition(), 9 );
+}
+
+void TestLayer::testSoundTimeline()
+{
+    Layer* dialogue = m_pObject->addNewSoundLayer();
+    OnScopeExit( m_pObject->deleteLayer( dialogue ) );
+    Layer* effects = m_pObject->addNewSoundLayer();
+    OnScopeExit( m_pObject->deleteLayer( effects ) );
+
+    auto addClip = []( Layer* layer, int position, int length )
+    {
+        SoundClip* clip = new SoundClip;
+        clip->setLength( length );
+        layer->addKeyFrame( position, clip );
+        return clip;
+    };
+    SoundClip* line1 = addClip( dialogue, 1, 20 );
+    SoundClip* line2 = addClip( dialogue, 30, 10 );
+    SoundClip* bang = addClip( effects, 5, 2 );
+    SoundClip* wind = addClip( effects, 10, 50 );
+
+    SoundTimeline timeline;
+    timeline.build( m_pObject );
+    QCOMPARE( timeline.clipCount(), 4 );
+    QVERIFY( timeline.isUpToDate( m_pObject ) );
+
+    std::vector< SoundClip* > clips;
+    timeline.clipsCovering( 6, clips );
+    QVERIFY( clips == std::vector< SoundClip* >( { line1, bang } ) );
+
+    clips.clear();
+    timeline.clipsCovering( 35, clips );
+    QVERIFY( clips == std::vector< SoundClip* >( { wind, line2 } ) );
+
+    clips.clear();
+    timeline.clipsCovering( 60, clips );
+    QVERIFY( clips.empty() );
+
+    timeline.clipsStartingAt( 30, clips );
+    QVERIFY( clips == std::vector< SoundClip* >( { line2 } ) );
+
+    // Editing the key frames of a sound layer outdates it
+    effects->removeKeyFrame( 5 );
+    QVERIFY( !timeline.isUpToDate( m_pObject ) );
+    timeline.build( m_pObject );
+    QVERIFY( !timeline.contains( bang ) );
+    QVERIFY( timeline.contains( wind ) );
+
+    // and so does a clip getting a new length, e.g. when the fps changes
+    wind->setDuration( 2000 );
+    int revision = effects->revision();
+    static_cast< LayerSound* >( effects )->updateFrameLengths( 12 );
+    QCOMPARE( wind->length(), 24 );
+    QVERIFY( effects->revision() != revision );
+    QVERIFY( !timeline.isUpToDate( m_pObject ) );
+
+    revision = effects->revision();
+    static_cast< LayerSound* >( effects )->updateFrameLengths( 12 );
+    QCOMPARE( effects->revision(), revision );
+}
+
+void TestLayer::testCameraInterpolation()
+{
+    LayerCamera camera( m_pObject );
+    camera.loadImageAtFrame( 1, QTransform() );
+    QTransform turned;
+    turned.rotate( 90 );
+    turned.translate( 100, 0 );
+    camera.loadImageAtFrame( 11, turned );
+
+    // Half way through the turn the picture keeps its size
+    QTransform half = camera.getViewAtFrame( 6 );
+    QVERIFY( qAbs( half.determinant() - 1.0 ) < 1e-9 );
+    QPointF xAxis = half.map( QPointF( 1, 0 ) ) - half.map( QPointF( 0, 0 ) );
+    QVERIFY( qAbs( xAxis.x() - xAxis.y() ) < 1e-9 );
+
+    // The keys are where they were, and the camera stays put outside of them
+    QCOMPARE( camera.getViewAtFrame( 11 ), turned );
+    QCOMPARE( camera.getViewAtFrame( 20 ), turned );
+    QCOMPARE( camera.getViewAtFrame( 0 ), QTransform() );
+
+    // The cached views are the same
+    camera.setInterpolation( CameraPath::SPLINE );
+    QTransform spline = camera.getViewAtFrame( 4 );
+    camera.cacheViews( 1, 11 );
+    QCOMPARE( camera.getViewAtFrame( 4 ), spline );
+
+    // A key added afterwards is taken into account
+    QTransform moved;
+    moved.translate( 50, 50 );
+    camera.loadImageAtFrame( 4, moved );
+    QCOMPARE( camera.getViewAtFrame( 4 ), moved );
+}
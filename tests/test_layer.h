@@ -35,6 +35,12 @@ private slots:
     void testPreviousKeyFramePosition();
     void testNextKeyFramePosition();
 
+    void testExtendSelection();
+    void testMoveSelectedFrames();
+    void testInsertAndRippleDelete();
+    void testSoundTimeline();
+    void testCameraInterpolation();
+
 
 private:
     Object* m_pObject = nullptr;
@@ -125,6 +125,30 @@ void TestObject::testMoveLayer()
 
 }
 
+void TestObject::testKeyFrameIndex()
+{
+    std::unique_ptr< Object > obj( new Object );
+
+    Layer* bitmapLayer = obj->addNewBitmapLayer();
+    Layer* vectorLayer = obj->addNewVectorLayer();
+    QCOMPARE( obj->getMaxKeyFramePosition(), 1 );
+
+    bitmapLayer->addNewEmptyKeyAt( 5 );
+    vectorLayer->addNewEmptyKeyAt( 12 );
+    QCOMPARE( obj->getMaxKeyFramePosition(), 12 );
+    QCOMPARE( obj->getLastKeyFramePositionAt( 0 ), -1 );
+    QCOMPARE( obj->getLastKeyFramePositionAt( 1 ), 1 );
+    QCOMPARE( obj->getLastKeyFramePositionAt( 7 ), 5 );
+    QCOMPARE( obj->getLastKeyFramePositionAt( 100 ), 12 );
+
+    vectorLayer->removeKeyFrame( 12 );
+    QCOMPARE( obj->getMaxKeyFramePosition(), 5 );
+
+    obj->deleteLayer( bitmapLayer );
+    QCOMPARE( obj->getMaxKeyFramePosition(), 1 );
+    QCOMPARE( obj->getLastKeyFramePositionAt( 7 ), 1 );
+}
+
 void TestObject::testLoadXML()
 {
     std::unique_ptr< Object > obj( new Object );
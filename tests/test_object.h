@@ -24,6 +24,7 @@ private slots:
 
     void testLayerID();
     void testMoveLayer();
+    void testKeyFrameIndex();
 
     void testLoadXML();
 
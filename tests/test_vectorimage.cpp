@@ -0,0 +1,137 @@
+#include "test_vectorimage.h"
+#include "vectorimage.h"
+#include "object.h"
+
+namespace
+{
+// Horizontal curves with 4 vertices, 10 apart
+void addCurves( VectorImage& image, int count )
+{
+    for ( int i = 0; i < count; i++ )
+    {
+        qreal y = image.m_curves.size() * 10;
+        BezierCurve curve( QList< QPointF >() << QPointF( 0, y ) << QPointF( 10, y ) << QPointF( 20, y ) << QPointF( 30, y ) );
+        image.addCurve( curve, 1.0, false );
+    }
+}
+
+void addArea( VectorImage& image, QList< int > curveNumbers )
+{
+    QList< AreaVertex > vertices;
+    for ( int curveNumber : curveNumbers )
+    {
+        vertices << AreaVertex( image.getCurveId( curveNumber ), -1 ) << AreaVertex( image.getCurveId( curveNumber ), 2 );
+    }
+    image.addArea( BezierArea( vertices, 0 ) );
+}
+}
+
+void TestVectorImage::testCurveIdsAreStable()
+{
+    VectorImage image;
+    addCurves( image, 3 );
+
+    CurveId first = image.getCurveId( 0 );
+    CurveId last = image.getCurveId( 2 );
+    QVERIFY( first != last );
+
+    image.setSelected( 0, true );
+    image.deleteSelection();
+    QCOMPARE( image.getCurveNumber( first ), -1 );
+    QCOMPARE( image.getCurveNumber( last ), 1 );
+
+    // a new curve can take the slot, but not the id
+    addCurves( image, 1 );
+    QCOMPARE( image.getCurveNumber( image.getCurveId( 2 ) ), 2 );
+    QVERIFY( image.getCurveId( 2 ) != first );
+    QCOMPARE( image.getCurveNumber( first ), -1 );
+}
+
+void TestVectorImage::testDeleteSelectionRemovesItsAreas()
+{
+    VectorImage image;
+    addCurves( image, 4 );
+    addArea( image, { 0, 1 } );
+    addArea( image, { 2, 3 } );
+    CurveId curve3 = image.getCurveId( 3 );
+
+    image.setSelected( 1, true );
+    image.deleteSelection();
+
+    QCOMPARE( image.m_curves.size(), 3 );
+    QCOMPARE( image.area.size(), 1 );
+    QVERIFY( image.area[ 0 ].mVertex.last().curve == curve3 );
+    QCOMPARE( image.getCurveNumber( curve3 ), 2 );
+}
+
+void TestVectorImage::testRemoveVertexSplitsAreaCurve()
+{
+    VectorImage image;
+    addCurves( image, 2 );
+    addArea( image, { 1 } );
+    CurveId curve1 = image.getCurveId( 1 );
+
+    // the part after the removed vertex becomes a new curve and the area follows
+    // it, the part before has a single point left and is removed
+    image.removeVertex( 1, 0 );
+    QCOMPARE( image.m_curves.size(), 2 );
+    QCOMPARE( image.area.size(), 1 );
+    QCOMPARE( image.getCurveNumber( curve1 ), -1 );
+
+    const QList< AreaVertex >& vertices = image.area[ 0 ].mVertex;
+    QCOMPARE( image.getCurveNumber( vertices.at( 1 ).curve ), 1 );
+    QCOMPARE( vertices.at( 1 ).vertexNumber, 1 );
+}
+
+void TestVectorImage::testAreasSaveCurveNumbers()
+{
+    VectorImage image;
+    addCurves( image, 3 );
+    addArea( image, { 2 } );
+    image.setSelected( 0, true );
+    image.deleteSelection();
+
+    QByteArray data;
+    QDataStream out( &data, QIODevice::WriteOnly );
+    image.writeBinary( out );
+
+    VectorImage loaded;
+    QDataStream in( data );
+    loaded.readBinary( in );
+
+    QCOMPARE( loaded.m_curves.size(), 2 );
+    QCOMPARE( loaded.area.size(), 1 );
+    QCOMPARE( loaded.getCurveNumber( loaded.area[ 0 ].mVertex.at( 0 ).curve ), 1 );
+    QCOMPARE( loaded.area[ 0 ].mVertex.at( 1 ).vertexNumber, 2 );
+}
+
+void TestVectorImage::testRasterFollowsChanges()
+{
+    std::unique_ptr< Object > object( new Object );
+    object->init();
+
+    VectorImage image;
+    image.setObject( object.get() );
+    addCurves( image, 4 );
+
+    QTransform view = QTransform::fromTranslate( 20, 10 ) * QTransform::fromScale( 2, 2 );
+    QSize size( 120, 100 );
+    QImage expected( size, QImage::Format_ARGB32_Premultiplied );
+    image.rasterImage( view, size, false, false, true );
+
+    // Moving a curve only paints around it again, to the same pixels as painting it all
+    image.setSelected( 1, true );
+    image.setSelectionTransformation( QTransform::fromTranslate( 3, 4 ) );
+    image.outputImage( &expected, view, false, false, true );
+    QCOMPARE( image.rasterImage( view, size, false, false, true ), expected );
+
+    BezierCurve curve( QList< QPointF >() << QPointF( 5, 2 ) << QPointF( 15, 25 ) << QPointF( 25, 2 ) );
+    image.addCurve( curve, 1.0, false );
+    image.outputImage( &expected, view, false, false, true );
+    QCOMPARE( image.rasterImage( view, size, false, false, true ), expected );
+
+    // Panned by whole pixels, what was in view is kept
+    QTransform panned = view * QTransform::fromTranslate( -7, 5 );
+    image.outputImage( &expected, panned, false, false, true );
+    QCOMPARE( image.rasterImage( panned, size, false, false, true ), expected );
+}
@@ -0,0 +1,19 @@
+#ifndef TESTVECTORIMAGE_H
+#define TESTVECTORIMAGE_H
+
+#include "AutoTest.h"
+
+class TestVectorImage : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testCurveIdsAreStable();
+    void testDeleteSelectionRemovesItsAreas();
+    void testRemoveVertexSplitsAreaCurve();
+    void testAreasSaveCurveNumbers();
+    void testRasterFollowsChanges();
+};
+
+DECLARE_TEST( TestVectorImage );
+
+#endif // TESTVECTORIMAGE_H
@@ -35,7 +35,9 @@ HEADERS += \
     test_layermanager.h \
     test_object.h \
     test_filemanager.h \
-    test_bitmapimage.h
+    test_bitmapimage.h \
+    test_beziercurve.h \
+    test_vectorimage.h
 
 SOURCES += \
     main.cpp \
@@ -43,7 +45,9 @@ SOURCES += \
     test_layermanager.cpp \
     test_object.cpp \
     test_filemanager.cpp \
-    test_bitmapimage.cpp
+    test_bitmapimage.cpp \
+    test_beziercurve.cpp \
+    test_vectorimage.cpp
 
 linux-* {
     LIBS += -lz